@@ -4,6 +4,7 @@
 #define ARRAY_H
 
 #include "Sequence.h"
+#include "SortingNetworks.h"
 #include "ArrayCommon.h"
 
 
@@ -31,14 +32,16 @@ namespace Collections
       {
       protected:
          int _size;
-         Ref<Common::InitializedBuffer<E> > _data;
+         Ref<Common::UninitializedBuffer<E> > _data;
 
-         
+         inline Array(int size, Ref<Common::UninitializedBuffer<E> > data)
+            : _size(size), _data(data) {}
 
       public:
 
          friend class Common::ArrayIterator<E>;
          friend class Common::ArrayBuilder<E, Array<E> >;
+         template <class U, class C> friend class Collections::ParallelArray;
       
          typedef E ElementType;
          typedef Common::ArrayIterator<E> Iterator;
@@ -46,9 +49,9 @@ namespace Collections
          template <class U> struct SwapElementType { typedef Array<U> C; };
 
          /// Construct an immutable array of size zero
-         //inline Array() : _size(0), _data(new Common::InitializedBuffer<E>()) {}
+         //inline Array() : _size(0), _data(new Common::UninitializedBuffer<E>()) {}
          inline Array(int initSize = 0) 
-            : _size(initSize), _data(new Common::InitializedBuffer<E>(initSize)) {}
+            : _size(initSize), _data(new Common::UninitializedBuffer<E>(initSize, initSize)) {}
 
          //////////////////////////////////////////////
          // Copy and Assignment, Reference Semantics //
@@ -61,6 +64,14 @@ namespace Collections
          /// _data == rhs._data
          inline Array& operator = (const Array& rhs)
          { _size = rhs._size; _data = rhs._data; return *this; }
+
+         /// Moves take over the data array without touching its reference
+         /// counter. The moved-from array is left empty.
+         inline Array(Array&& rhs) : _size(rhs._size), _data(std::move(rhs._data)) 
+         { rhs._size = 0; }
+
+         inline Array& operator = (Array&& rhs)
+         { _size = rhs._size; _data = std::move(rhs._data); rhs._size = 0; return *this; }
       
 
          ////////////////////////////////
@@ -84,7 +95,12 @@ namespace Collections
       
          virtual Array<E> Reverse() const;
 
-         friend Array<E> Sorted(const Array<E>& a);
+         /// Parallel bulk operations over this array, see Parallel.h. By
+         /// default uses one thread per hardware thread.
+         ParallelArray<E, Array<E> > Par(int threads = 0) const;
+
+         friend Array<E> Sorted<>(const Array<E>& a);
+         template <class U, class K> friend Array<U> SortedBy(const Array<U>& a, K key);
       };
 
 
@@ -115,20 +131,27 @@ namespace Collections
       /// O(n)                                                                        
       template <class E> inline Array<E> Array<E>::Reverse() const                           
       {                                                                               
-         Array<E> newArray(Size());                                                   
-         for (int i = 0; i < Size(); ++i) 
-            ((E*) *newArray._data)[i] = (*this)[Size()-i-1];
-         return newArray;                                                             
+         Builder builder(Size());
+         for (int i = Size()-1; i >= 0; --i) builder.AddElement((*this)[i]);
+         return builder.Result();
       }  
 
       template <class E> inline Array<E> Sorted(const Array<E>& a)
       {
          /// 1. Make a copy
-         /// 2. In-place quicksort the copy
-         typename Array<E>::Builder builder = a._clone(a.Size(), a.Size()); 
-         Array<E> sorted = builder.Result();
+         /// 2. In-place introsort the copy
+         Array<E> sorted(a.Size(), a._data->Clone(a.Size()));
          Common::SortInPlace(((E*)*sorted._data), 0, a.Size()-1);
          return sorted;
+      }
+
+      /// Stable radix sort by key(e), which must be arithmetic, for example
+      /// SortedBy(pairs, [] (const Pair<int, float>& p) { return p.first; })
+      template <class E, class K> inline Array<E> SortedBy(const Array<E>& a, K key)
+      {
+         Array<E> sorted(a.Size(), a._data->Clone(a.Size()));
+         Common::RadixSortBy(((E*)*sorted._data), a.Size(), key);
+         return sorted;
       }                                                                             
    } // namespace Immutable
 } // namespace Collections
@@ -6,6 +6,7 @@
 namespace Collections
 {
    template <class E> class Vector;
+   template <class E, class C> class ParallelArray;
 
    namespace Immutable
    {
@@ -14,6 +15,7 @@ namespace Collections
       template <class E> class LinkedList;
 
       template <class E> Immutable::Array<E> Sorted(const Immutable::Array<E>& a);
+      template <class E, class K> Immutable::Array<E> SortedBy(const Immutable::Array<E>& a, K key);
    }
 
    namespace Mutable
@@ -23,6 +25,9 @@ namespace Collections
       template <class E> class LinkedList;
 
       template <class E> Mutable::Array<E> Sorted(const Mutable::Array<E>& a);
+      template <class E> Mutable::Array<E>& SortInPlace(Mutable::Array<E>& a);
+      template <class E, class K> Mutable::Array<E> SortedBy(const Mutable::Array<E>& a, K key);
+      template <class E, class K> Mutable::Array<E>& SortInPlaceBy(Mutable::Array<E>& a, K key);
    }
 
 	namespace Common
@@ -47,7 +52,7 @@ namespace Collections
 
          int _i;      
          int _size;
-         Ref<Common::InitializedBuffer<E> > _data;
+         Ref<Common::UninitializedBuffer<E> > _data;
       
          inline ArrayIterator(const Mutable::Array<E>& a)   : _i(-1), _size(a._size), _data(a._data) {}
          inline ArrayIterator(const Immutable::Array<E>& a) : _i(-1), _size(a._size), _data(a._data) {}
@@ -84,8 +89,10 @@ namespace Collections
          friend Mutable::Array<E> Mutable::Sorted(const Mutable::Array<E>& a);
 
       public:
+         /// The array starts out with no elements, only room for them
          inline ArrayBuilder(int expectedSize = 1) 
-            : _array(max(expectedSize, 1)), _nextEmptyIndex(0), _complete(false)
+            : _array(0, new Common::UninitializedBuffer<E>(max(expectedSize, 1)))
+            , _nextEmptyIndex(0), _complete(false)
          { }
 
 
@@ -109,73 +116,641 @@ namespace Collections
             return *this; 
          }
 
-         inline void AddElement(E t) 
+         inline ArrayBuilder(ArrayBuilder&& rhs)
+            : _array(std::move(rhs._array)) 
+            , _nextEmptyIndex(rhs._nextEmptyIndex)
+            , _complete(rhs._complete) { rhs._complete = true; }
+
+         inline ArrayBuilder& operator = (ArrayBuilder&& rhs)
+         {  
+            _complete       = rhs._complete; 
+            _nextEmptyIndex = rhs._nextEmptyIndex; 
+            _array          = std::move(rhs._array);
+            rhs._complete   = true;
+            return *this; 
+         }
+
+         inline void AddElement(const E& t) 
          {
             assert(!_complete);
-            if (_nextEmptyIndex == _array.Size()) resize();
+            if (_nextEmptyIndex == _array._data->Capacity()) resize();
 
-            _array._data->Index(_nextEmptyIndex) = t;
+            _array._data->Append(t);
             _nextEmptyIndex++;         
          }
 
+         inline void AddElement(E&& t) 
+         {
+            assert(!_complete);
+            if (_nextEmptyIndex == _array._data->Capacity()) resize();
+
+            _array._data->Append(std::move(t));
+            _nextEmptyIndex++;         
+         }
+
+         /// The builder is spent afterwards, so the array is moved out rather
+         /// than copied, saving a reference count round trip
          inline C Result() 
          {
             /// Fix the recorded size of the underlying array to the actual number
             /// of elements added (we leave the allocation where it is)
-            assert(_nextEmptyIndex <= _array.Size());
+            assert(_nextEmptyIndex == _array._data->Size());
             _array._size = _nextEmptyIndex;
             _complete = true;
-            return _array;
+            return std::move(_array);
          }
 
       private:
 
-         // Allocate a new array, copy the values, double the size
+         /// Double the capacity. The buffer is normally ours alone and grows in
+         /// place, a copied builder has to take a private copy first.
          void resize()
          {
             assert(!_complete);
-            assert(_array.Size() > 0);
-            C _array2x = C(_array.Size() * 2);
-            for (int i = 0; i < _array._size; ++i)
-               ((E*)(*_array2x._data))[i] = ((E*)(*_array._data))[i];
-            _array = _array2x;
-            assert(_nextEmptyIndex < _array.Size()); 
+            const int newCapacity = 2 * _array._data->Capacity();
+            if (_array._data->RefCount() == 1) _array._data->Reserve(newCapacity);
+            else _array._data = _array._data->Clone(newCapacity);
+            assert(_nextEmptyIndex < _array._data->Capacity()); 
          }
       };
 
 
-      /// Helper functions for in-place quick sort
-      #define SWAP(a, b) { auto t = a; a = b; b = t; }
+      ///////////////////////////
+      // In-Place Introsort    //
+      ///////////////////////////
+
+      /// Quicksort with the guards that keep it O(n log n): partitions below
+      /// the cutoff are finished by insertion sort, pivots are the median of
+      /// three (or the ninther, the median of three medians, on large
+      /// partitions), and a partition that recurses deeper than 2*log2(n)
+      /// levels is finished by heapsort. Only the smaller side of a partition
+      /// is sorted recursively, so the stack depth is O(log n).
+      ///
+      /// Keys equal to the pivot are split off three way in the manner of
+      /// pdqsort: elements equal to the pivot always go to the right side,
+      /// so when a partition's pivot equals the element just before the
+      /// partition (which no element of the partition is less than), the
+      /// partition has many copies of that key. All of them are then moved
+      /// to the left in one linear pass and never looked at again, so inputs
+      /// with few distinct keys sort in O(n log k).
+      static const int SORT_INSERTION_CUTOFF = 24;
+      static const int SORT_NINTHER_THRESHOLD = 128;
+
+      /// Sorts [begin, end) by insertion
+      template <class E> inline void insertionSort(E * a, int begin, int end)
+      {
+         for (int i = begin + 1; i < end; ++i)
+         {
+            if (!(a[i] < a[i-1])) continue;
+            E t = std::move(a[i]);
+            int j = i;
+            do { a[j] = std::move(a[j-1]); --j; } while (j > begin && t < a[j-1]);
+            a[j] = std::move(t);
+         }
+      }
+
+      /// Orders a[i] <= a[j] <= a[k]
+      template <class E> inline void sort3(E * a, int i, int j, int k)
+      {
+         if (a[j] < a[i]) std::swap(a[i], a[j]);
+         if (a[k] < a[j])
+         {
+            std::swap(a[j], a[k]);
+            if (a[j] < a[i]) std::swap(a[i], a[j]);
+         }
+      }
+
+      template <class E> inline void siftDown(E * a, int begin, int root, int size)
+      {
+         E t = std::move(a[begin + root]);
+         for (int child = 2*root + 1; child < size; child = 2*root + 1)
+         {
+            if (child + 1 < size && a[begin + child] < a[begin + child + 1]) child++;
+            if (!(t < a[begin + child])) break;
+            a[begin + root] = std::move(a[begin + child]);
+            root = child;
+         }
+         a[begin + root] = std::move(t);
+      }
+
+      template <class E> void heapSort(E * a, int begin, int end)
+      {
+         const int size = end - begin;
+         for (int i = size/2 - 1; i >= 0; --i) siftDown(a, begin, i, size);
+         for (int last = size - 1; last > 0; --last)
+         {
+            std::swap(a[begin], a[begin + last]);
+            siftDown(a, begin, 0, last);
+         }
+      }
+
+      /// Partitions [begin, end) around the pivot in a[begin]: elements less
+      /// than it end up to its left, the rest to its right. Returns the
+      /// pivot's final position. Pivot selection guarantees an element not
+      /// less than the pivot somewhere after it, which guards the scans.
+      template <class E> int partitionRight(E * a, int begin, int end)
+      {
+         E pivot = std::move(a[begin]);
+         int first = begin, last = end;
+
+         while (a[++first] < pivot);
+         if (first - 1 == begin) while (first < last && !(a[--last] < pivot));
+         else                    while (!(a[--last] < pivot));
+
+         while (first < last)
+         {
+            std::swap(a[first], a[last]);
+            while (a[++first] < pivot);
+            while (!(a[--last] < pivot));
+         }
+
+         const int p = first - 1;
+         a[begin] = std::move(a[p]);
+         a[p] = std::move(pivot);
+         return p;
+      }
+
+      /// As above, but elements equal to the pivot go to its left. Only used
+      /// when nothing in the partition is less than the pivot, so the left
+      /// side ends up holding exactly the keys equal to it.
+      template <class E> int partitionLeft(E * a, int begin, int end)
+      {
+         E pivot = std::move(a[begin]);
+         int first = begin, last = end;
+
+         while (pivot < a[--last]);
+         if (last + 1 == end) while (first < last && !(pivot < a[++first]));
+         else                 while (!(pivot < a[++first]));
+
+         while (first < last)
+         {
+            std::swap(a[first], a[last]);
+            while (pivot < a[--last]);
+            while (!(pivot < a[++first]));
+         }
+
+         a[begin] = std::move(a[last]);
+         a[last] = std::move(pivot);
+         return last;
+      }
+
+      /// Partitions small enough to finish off go to the SIMD sorting networks
+      /// for the key types that have them (see SortingNetworks.h), and to
+      /// insertion sort otherwise
+      template <class E> inline void leafSort(E * a, int begin, int end, std::false_type)
+      { insertionSort(a, begin, end); }
+
+      template <class E> inline void leafSort(E * a, int begin, int end, std::true_type)
+      { SortingNetwork<E>::Sort(a + begin, end - begin); }
+
+      /// Sorts [begin, end). 'leftmost' is false when a[begin-1] exists and
+      /// no element of the range is less than it.
+      template <class E> void introSort(E * a, int begin, int end, int depthLimit, bool leftmost)
+      {
+         typedef std::integral_constant<bool, SortingNetwork<E>::Simd> Network;
+         const int cutoff = Network::value ? SORT_NETWORK_MAX + 1 : SORT_INSERTION_CUTOFF;
+
+         while (true)
+         {
+            const int size = end - begin;
+            if (size < cutoff) { leafSort(a, begin, end, Network()); return; }
+
+            /// Move the pivot to a[begin]
+            const int middle = begin + size/2;
+            if (size > SORT_NINTHER_THRESHOLD)
+            {
+               sort3(a, begin, middle, end - 1);
+               sort3(a, begin + 1, middle - 1, end - 2);
+               sort3(a, begin + 2, middle + 1, end - 3);
+               sort3(a, middle - 1, middle, middle + 1);
+               std::swap(a[begin], a[middle]);
+            }
+            else sort3(a, middle, begin, end - 1);
+
+            /// The pivot equals the element before the range, split off its run
+            if (!leftmost && !(a[begin-1] < a[begin]))
+            {
+               begin = partitionLeft(a, begin, end) + 1;
+               continue;
+            }
+
+            if (depthLimit-- == 0) { heapSort(a, begin, end); return; }
+
+            const int p = partitionRight(a, begin, end);
+            if (p - begin < end - p)
+            {
+               introSort(a, begin, p, depthLimit, leftmost);
+               begin = p + 1; leftmost = false;
+            }
+            else
+            {
+               introSort(a, p + 1, end, depthLimit, false);
+               end = p;
+            }
+         }
+      }
+
+      /// Sorts array[left, right], both inclusive, with operator <
       template <class E>
-      inline int partition(E * array, int left, int right, int pivotIndex)
+      inline void IntroSortInPlace(E * array, int left, int right)
+      {
+         if (right <= left) return;
+         int depthLimit = 0;
+         for (int n = right - left + 1; n > 1; n >>= 1) depthLimit += 2;
+         introSort(array, left, right + 1, depthLimit, true);
+      }
+
+
+      /// Sorts a[0, n) with operator <, meant for the many small arrays case.
+      /// Up to SORT_NETWORK_MAX int, unsigned int or float keys are sorted by
+      /// SIMD sorting network when built with ___SSE4.
+      template <class E> inline void SortSmall(E * a, int n)
+      {
+         typedef std::integral_constant<bool, SortingNetwork<E>::Simd> Network;
+         if (n <= SORT_NETWORK_MAX) leafSort(a, 0, n, Network());
+         else IntroSortInPlace(a, 0, n - 1);
+      }
+
+
+      ////////////////////////
+      // LSD Radix Sort     //
+      ////////////////////////
+
+      /// Maps an arithmetic key to an unsigned integer with the same order,
+      /// so it can be sorted one byte at a time. Signed integers have their
+      /// sign bit flipped. Floats flip the sign bit when positive and every
+      /// bit when negative, which orders them like operator < (with -0.0
+      /// before 0.0, and NaNs at the ends). bool is left to the comparison
+      /// sort, as it has no sign or unsigned counterpart to map through.
+      template <class T, class Enable = void> struct RadixKey
+      { static const bool Radix = false; };
+
+      template <class T> struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value
+         && !std::is_same<T, bool>::value && sizeof(T) <= 8>::type>
+      {
+         static const bool Radix = true;
+         typedef typename std::conditional<sizeof(T) <= 4, unsigned int, unsigned long long>::type Bits;
+         static const int Bytes = sizeof(T);
+
+         static inline Bits Get(T x)
+         {
+            typedef typename std::make_unsigned<T>::type U;
+            const U sign = std::is_signed<T>::value ? (U)((U)1 << (8*sizeof(T) - 1)) : (U)0;
+            return (Bits)(U)((U)x ^ sign);
+         }
+      };
+
+      template <> struct RadixKey<float>
+      {
+         static const bool Radix = true;
+         typedef unsigned int Bits;
+         static const int Bytes = 4;
+
+         static inline Bits Get(float x)
+         {
+            Bits b; memcpy(&b, &x, sizeof(b));
+            return b ^ ((b >> 31) ? 0xFFFFFFFFu : 0x80000000u);
+         }
+      };
+
+      template <> struct RadixKey<double>
+      {
+         static const bool Radix = true;
+         typedef unsigned long long Bits;
+         static const int Bytes = 8;
+
+         static inline Bits Get(double x)
+         {
+            Bits b; memcpy(&b, &x, sizeof(b));
+            return b ^ ((b >> 63) ? ~0ULL : (1ULL << 63));
+         }
+      };
+
+      /// Below this size the histograms cost more than they save
+      static const int RADIX_SORT_THRESHOLD = 256;
+
+      /// Stable sort of a[0, n) by key(a[i]), an arithmetic value, one byte
+      /// per pass from the least significant up. All histograms are counted
+      /// in a single pass over the input, and passes whose byte is the same
+      /// for every element are skipped, so keys in a narrow range cost fewer
+      /// passes. Elements move between 'a' and one auxiliary buffer of n
+      /// elements, and end up back in 'a'.
+      template <class E, class K> void RadixSortBy(E * a, int n, K key)
       {
-         assert(pivotIndex >= left && pivotIndex <= right);
-         const E pivotValue = array[pivotIndex];
-         SWAP(array[pivotIndex], array[right]);
-         int cursor = left;
-         for (int i = left; i < right; ++i)
+         typedef typename std::decay<decltype(key(std::declval<const E&>()))>::type Key;
+         typedef RadixKey<Key> Traits;
+         typedef typename Traits::Bits Bits;
+         static_assert(Traits::Radix, "RadixSortBy needs an arithmetic key");
+         const int B = Traits::Bytes;
+
+         if (n < 2) return;
+
+         int counts[B][256];
+         memset(counts, 0, sizeof(counts));
+         for (int i = 0; i < n; ++i)
          {
-            if (array[i] < pivotValue)
+            const Bits k = Traits::Get(key(a[i]));
+            for (int b = 0; b < B; ++b) counts[b][(k >> (8*b)) & 0xFF]++;
+         }
+
+         /// Skip the bytes every key has in common
+         const Bits first = Traits::Get(key(a[0]));
+         int passes[B], passCount = 0;
+         for (int b = 0; b < B; ++b)
+            if (counts[b][(first >> (8*b)) & 0xFF] != n) passes[passCount++] = b;
+         if (passCount == 0) return;
+
+         E * aux = (E*)malloc(n * sizeof(E));
+         bool auxConstructed = false;
+         E * src = a, * dst = aux;
+
+         for (int p = 0; p < passCount; ++p)
+         {
+            const int b = passes[p];
+            int offsets[256], sum = 0;
+            for (int d = 0; d < 256; ++d) { offsets[d] = sum; sum += counts[b][d]; }
+
+            const bool construct = dst == aux && !auxConstructed;
+            for (int i = 0; i < n; ++i)
             {
-               SWAP(array[i], array[cursor]);
-               cursor++;
+               const int d = (Traits::Get(key(src[i])) >> (8*b)) & 0xFF;
+               if (construct) new (&dst[offsets[d]++]) E(std::move(src[i]));
+               else dst[offsets[d]++] = std::move(src[i]);
             }
+            if (construct) auxConstructed = true;
+
+            E * t = src; src = dst; dst = t;
          }
-         SWAP(array[cursor], array[right]);
-         return cursor;
+
+         if (src == aux) for (int i = 0; i < n; ++i) a[i] = std::move(aux[i]);
+         if (auxConstructed && !std::is_trivially_destructible<E>::value)
+            for (int i = 0; i < n; ++i) aux[i].~E();
+         free(aux);
+      }
+
+      template <class E> struct IdentityKey
+      { inline const E& operator () (const E& e) const { return e; } };
+
+      /// Sorts by value with radix passes, for arithmetic element types
+      template <class E> inline void RadixSort(E * a, int n) { RadixSortBy(a, n, IdentityKey<E>()); }
+
+
+      /// Sorts array[left, right], both inclusive, with operator <. Large
+      /// arrays of arithmetic types are radix sorted, which orders them the
+      /// same way, everything else goes through introsort. Radix passes cost
+      /// the same whatever the input, so input that is already sorted is
+      /// spotted first (a random input gives up on the scan almost at once).
+      template <class E>
+      inline void sortInPlace(E * array, int left, int right, std::true_type)
+      {
+         if (right - left + 1 < RADIX_SORT_THRESHOLD) { IntroSortInPlace(array, left, right); return; }
+
+         int i = left;
+         while (i < right && !(array[i+1] < array[i])) ++i;
+         if (i < right) RadixSort(array + left, right - left + 1);
       }
+      template <class E>
+      inline void sortInPlace(E * array, int left, int right, std::false_type)
+      { IntroSortInPlace(array, left, right); }
+
       template <class E>
       inline void SortInPlace(E * array, int left, int right)
+      { sortInPlace(array, left, right, std::integral_constant<bool, RadixKey<E>::Radix>()); }
+
+
+      ////////////////////////////////
+      // Selection and Partial Sort //
+      ////////////////////////////////
+
+      /// Finding the k smallest elements, or the n-th, needs much less work
+      /// than sorting everything:
+      ///
+      ///    SelectInPlace       introselect, O(n) on average. Quickselect on a
+      ///                        median of three pivot, which only follows the
+      ///                        side holding the n-th element, falling back to
+      ///                        a heap after 2*log2(n) partitions so that the
+      ///                        worst case stays O(n log n)
+      ///    PartialSortInPlace  selects, then sorts the first k, O(n + k log k),
+      ///                        or for small k sorts the heap HeapSelect
+      ///                        leaves
+      ///    HeapSelect          a max-heap of the k smallest so far, which
+      ///                        each further element either fails to beat at
+      ///                        a single comparison or replaces the top of,
+      ///                        O(n log k) with O(k) memory. Used for streams
+      ///                        (see TopK.h) where the input cannot be moved.
+      ///
+      /// All of them take the comparator as a template parameter, so that it
+      /// inlines, with "smallest" meaning first in its order.
+      static const int SELECT_INSERTION_CUTOFF = 16;
+
+      template <class E, class F> inline void insertionSortWith(E * a, int begin, int end, F& lessThan)
+      {
+         for (int i = begin + 1; i < end; ++i)
+         {
+            if (!lessThan(a[i], a[i-1])) continue;
+            E t = std::move(a[i]);
+            int j = i;
+            do { a[j] = std::move(a[j-1]); --j; } while (j > begin && lessThan(t, a[j-1]));
+            a[j] = std::move(t);
+         }
+      }
+
+      template <class E, class F> inline void sort3With(E * a, int i, int j, int k, F& lessThan)
+      {
+         if (lessThan(a[j], a[i])) std::swap(a[i], a[j]);
+         if (lessThan(a[k], a[j]))
+         {
+            std::swap(a[j], a[k]);
+            if (lessThan(a[j], a[i])) std::swap(a[i], a[j]);
+         }
+      }
+
+      /// Max-heaps on a[0, size) in the comparator's order
+      template <class E, class F> inline void SiftDownWith(E * a, int root, int size, F& lessThan)
+      {
+         E t = std::move(a[root]);
+         for (int child = 2*root + 1; child < size; child = 2*root + 1)
+         {
+            if (child + 1 < size && lessThan(a[child], a[child + 1])) child++;
+            if (!lessThan(t, a[child])) break;
+            a[root] = std::move(a[child]);
+            root = child;
+         }
+         a[root] = std::move(t);
+      }
+
+      template <class E, class F> inline void SiftUpWith(E * a, int i, F& lessThan)
+      {
+         E t = std::move(a[i]);
+         while (i > 0 && lessThan(a[(i - 1)/2], t))
+         {
+            a[i] = std::move(a[(i - 1)/2]);
+            i = (i - 1)/2;
+         }
+         a[i] = std::move(t);
+      }
+
+      template <class E, class F> inline void MakeHeapWith(E * a, int size, F& lessThan)
+      { for (int i = size/2 - 1; i >= 0; --i) SiftDownWith(a, i, size, lessThan); }
+
+      /// Turns a max-heap into a sorted run
+      template <class E, class F> inline void SortHeapWith(E * a, int size, F& lessThan)
       {
-         if (right-left == 1 && array[right] < array[left]) { SWAP(array[left], array[right]); }
-         else if (left < right)
+         for (int last = size - 1; last > 0; --last)
          {
-            int pivotIndex = partition(array, left, right, (right+left) / 2);
-            SortInPlace(array, left, pivotIndex);
-            SortInPlace(array, pivotIndex+1, right);
-         }    
+            std::swap(a[0], a[last]);
+            SiftDownWith(a, 0, last, lessThan);
+         }
+      }
+
+      /// Leaves the k smallest of a[0, n) in a[0, k) as a max-heap, so a[0]
+      /// is the k-th smallest
+      template <class E, class F> void HeapSelect(E * a, int n, int k, F lessThan)
+      {
+         if (k <= 0) return;
+         MakeHeapWith(a, k, lessThan);
+         for (int i = k; i < n; ++i)
+         {
+            if (!lessThan(a[i], a[0])) continue;
+            std::swap(a[0], a[i]);
+            SiftDownWith(a, 0, k, lessThan);
+         }
+      }
+
+      /// Rearranges a[0, n) so that a[nth] holds what a sort would put there,
+      /// nothing before it is greater and nothing after it is less
+      template <class E, class F> void SelectInPlace(E * a, int n, int nth, F lessThan)
+      {
+         assert(nth >= 0 && nth < n);
+         int begin = 0, end = n;
+         int depthLimit = 0;
+         for (int m = n; m > 1; m >>= 1) depthLimit += 2;
+
+         while (end - begin >= SELECT_INSERTION_CUTOFF)
+         {
+            if (depthLimit-- == 0)
+            {
+               HeapSelect(a + begin, end - begin, nth - begin + 1, lessThan);
+               std::swap(a[begin], a[nth]);
+               return;
+            }
+
+            /// The median of three goes to a[begin+1], and the other two
+            /// bracket it at either end, which guards both scans
+            const int middle = begin + (end - begin)/2;
+            sort3With(a, begin, middle, end - 1, lessThan);
+            std::swap(a[middle], a[begin + 1]);
+            const E& pivot = a[begin + 1];
+
+            /// Hoare partition. Both scans stop on keys equal to the pivot,
+            /// which keeps runs of equal keys split evenly.
+            int i = begin + 1, j = end - 1;
+            while (true)
+            {
+               while (lessThan(a[++i], pivot));
+               while (lessThan(pivot, a[--j]));
+               if (i >= j) break;
+               std::swap(a[i], a[j]);
+            }
+            std::swap(a[begin + 1], a[j]);
+
+            if (j == nth) return;
+            if (nth < j) end = j;
+            else         begin = j + 1;
+         }
+         insertionSortWith(a, begin, end, lessThan);
+      }
+
+      /// Below n/PARTIAL_SORT_HEAP_RATIO the heap wins: on random input almost
+      /// every element fails against the top of the heap at one comparison,
+      /// where quickselect moves elements about on every partition
+      static const int PARTIAL_SORT_HEAP_RATIO = 128;
+
+      /// Sorts the k smallest of a[0, n) into a[0, k), the rest are left in
+      /// a[k, n) in no particular order
+      template <class E, class F> void PartialSortInPlace(E * a, int n, int k, F lessThan)
+      {
+         if (k > n) k = n;
+         if (k <= 0) return;
+         if (k < n / PARTIAL_SORT_HEAP_RATIO)
+         {
+            HeapSelect(a, n, k, lessThan);
+            SortHeapWith(a, k, lessThan);
+            return;
+         }
+
+         /// Once the k-th is in place only the ones before it need sorting
+         const int m = k < n ? k - 1 : n;
+         if (k < n) SelectInPlace(a, n, k - 1, lessThan);
+         MakeHeapWith(a, m, lessThan);
+         SortHeapWith(a, m, lessThan);
+      }
+
+      /// With operator <, the first k go through SortInPlace (introsort, or
+      /// radix sort for arithmetic types)
+      template <class E> void PartialSortInPlace(E * a, int n, int k)
+      {
+         if (k > n) k = n;
+         if (k <= 0) return;
+         if (k < n / PARTIAL_SORT_HEAP_RATIO) { PartialSortInPlace(a, n, k, OperatorLessThan<E>()); return; }
+
+         const int m = k < n ? k - 1 : n;
+         if (k < n) SelectInPlace(a, n, k - 1, OperatorLessThan<E>());
+         SortInPlace(a, 0, m - 1);
+      }
+
+
+      ///////////////////////
+      // Stable Merge Sort //
+      ///////////////////////
+
+      /// For when equal elements must keep their order and no radix key
+      /// applies. Runs of STABLE_SORT_RUN elements are insertion sorted in
+      /// place, then merged in passes that alternate between the array and a
+      /// scratch buffer of n elements. O(n log n), O(n) extra space.
+      static const int STABLE_SORT_RUN = 32;
+
+      /// Merges src[begin, middle) and src[middle, end) into dst[begin, end),
+      /// ties go to the left run
+      template <class E, class F>
+      inline void mergeWith(E * src, E * dst, int begin, int middle, int end, F& lessThan)
+      {
+         int i = begin, j = middle, o = begin;
+         while (i < middle && j < end)
+         {
+            if (lessThan(src[j], src[i])) dst[o++] = std::move(src[j++]);
+            else                          dst[o++] = std::move(src[i++]);
+         }
+         while (i < middle) dst[o++] = std::move(src[i++]);
+         while (j < end)    dst[o++] = std::move(src[j++]);
+      }
+
+      template <class E, class F> void StableSortInPlace(E * a, int n, F lessThan)
+      {
+         for (int b = 0; b < n; b += STABLE_SORT_RUN)
+            insertionSortWith(a, b, min(b + STABLE_SORT_RUN, n), lessThan);
+         if (n <= STABLE_SORT_RUN) return;
+
+         /// The scratch buffer is move constructed from the array, so the
+         /// first pass merges from it back into the array
+         E * aux = (E*)malloc(n * sizeof(E));
+         for (int i = 0; i < n; ++i) new (aux + i) E(std::move(a[i]));
+
+         E * src = aux, * dst = a;
+         for (int width = STABLE_SORT_RUN; width < n; width *= 2)
+         {
+            for (int begin = 0; begin < n; begin += 2*width)
+            {
+               const int middle = min(begin + width, n), end = min(begin + 2*width, n);
+               mergeWith(src, dst, begin, middle, end, lessThan);
+            }
+            std::swap(src, dst);
+         }
+         if (src != a) for (int i = 0; i < n; ++i) a[i] = std::move(src[i]);
+
+         for (int i = 0; i < n; ++i) aux[i].~E();
+         free(aux);
       }
-      #undef SWAP
 	}
 }
 
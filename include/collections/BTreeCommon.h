@@ -0,0 +1,666 @@
+#ifndef BTREE_COMMON_H
+#define BTREE_COMMON_H
+
+#include <stdint.h>
+#include <type_traits>
+
+#if defined(___SSE)
+#include <emmintrin.h>
+#endif
+
+#include "Map.h"
+#include "FlatCommon.h"
+#include "TreeCommon.h"
+
+/// A B+-tree keeps many keys to a node, so a lookup touches a handful of
+/// nodes where the binary trees touch one node per level, around 2 log2(n)
+/// of them for a treap, each one likely a cache miss. Every node holds about
+/// BTREE_NODE_BYTES of keys, a few cache lines, stored contiguously and
+/// searched with SIMD compares for int, unsigned int and float keys (when
+/// built with ___SSE), or a branchless binary search for anything else.
+///
+/// The elements all live in the leaves, in order, and each leaf links to
+/// the next, so iteration is a walk along the leaves with no stack. Inner
+/// nodes hold only separator keys and child indices: child i holds the keys
+/// below keys[i], child i+1 those from keys[i] up. Leaves and inner nodes
+/// live in two MemoryPools and refer to each other by index, like the nodes
+/// of the other node based containers.
+
+namespace Collections
+{
+   namespace Mutable
+   {
+      template <class E> class BTreeSet;
+      template <class K, class V> class BTreeMap;
+   }
+
+   namespace Common
+   {
+      /// Bytes of keys (and of a map's values) in a node
+      static const int BTREE_NODE_BYTES = 256;
+
+
+      ////////////////////
+      // In-Node Search //
+      ////////////////////
+
+      /// Index of the first of keys[0, n) that is not less than key, or n
+      template <class K, class Enable = void> struct BTreeSearch
+      {
+         static const bool Simd = false;
+         static inline int LowerBound(const K * keys, int n, const K& key)
+         { return FlatLowerBound(keys, n, key); }
+      };
+
+      #if defined(___SSE)
+      namespace BTreeSimd
+      {
+         /// Each comparer returns a 4 bit mask of which of the four keys at p
+         /// are less than the key it was made with
+         struct IntLess
+         {
+            __m128i k;
+            inline IntLess(int key) : k(_mm_set1_epi32(key)) {}
+            inline int Mask(const int * p) const
+            { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)p), k))); }
+         };
+
+         /// Flipping the sign bit orders unsigned keys as signed ones
+         struct UnsignedLess
+         {
+            __m128i k, bias;
+            inline UnsignedLess(unsigned int key)
+               : k(_mm_set1_epi32(int(key ^ 0x80000000u))), bias(_mm_set1_epi32(int(0x80000000u))) {}
+            inline int Mask(const unsigned int * p) const
+            {
+               const __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)p), bias);
+               return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(x, k)));
+            }
+         };
+
+         struct FloatLess
+         {
+            __m128 k;
+            inline FloatLess(float key) : k(_mm_set1_ps(key)) {}
+            inline int Mask(const float * p) const { return _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(p), k)); }
+         };
+
+         /// The keys are sorted, so the ones less than key are a prefix and
+         /// counting them gives the lower bound. Sixteen keys are compared per
+         /// step, with one branch, until a block is not entirely below key.
+         template <class K, class Less> inline int LowerBound(const K * keys, int n, const K& key)
+         {
+            const Less less(key);
+            int i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+               const int m = less.Mask(keys + i)           | less.Mask(keys + i + 4)  << 4 |
+                             less.Mask(keys + i + 8)  << 8 | less.Mask(keys + i + 12) << 12;
+               if (m != 0xFFFF) return i + __builtin_popcount(m);
+            }
+            for (; i + 4 <= n; i += 4)
+            {
+               const int m = less.Mask(keys + i);
+               if (m != 0xF) return i + __builtin_popcount(m);
+            }
+            while (i < n && keys[i] < key) i++;
+            return i;
+         }
+      }
+
+      template <> struct BTreeSearch<int>
+      {
+         static const bool Simd = true;
+         static inline int LowerBound(const int * keys, int n, int key)
+         { return BTreeSimd::LowerBound<int, BTreeSimd::IntLess>(keys, n, key); }
+      };
+
+      template <> struct BTreeSearch<unsigned int>
+      {
+         static const bool Simd = true;
+         static inline int LowerBound(const unsigned int * keys, int n, unsigned int key)
+         { return BTreeSimd::LowerBound<unsigned int, BTreeSimd::UnsignedLess>(keys, n, key); }
+      };
+
+      template <> struct BTreeSearch<float>
+      {
+         static const bool Simd = true;
+         static inline int LowerBound(const float * keys, int n, float key)
+         { return BTreeSimd::LowerBound<float, BTreeSimd::FloatLess>(keys, n, key); }
+      };
+      #endif // ___SSE
+
+
+      ///////////
+      // Nodes //
+      ///////////
+
+      /// A map's leaves keep their values in an array beside the keys, so
+      /// that the keys stay packed for the search. A set's leaves have none.
+      template <class V, int N> struct BTreeValues
+      {
+         V values[N];
+         inline void moveValue(int to, BTreeValues& from, int i) { values[to] = std::move(from.values[i]); }
+         inline void setValue(int i, const V * v) { values[i] = *v; }
+      };
+
+      template <int N> struct BTreeValues<void, N>
+      {
+         inline void moveValue(int, BTreeValues&, int) {}
+         inline void setValue(int, const void *) {}
+      };
+
+      template <class V> struct BTreeValueBytes { static const int Value = sizeof(V); };
+      template <> struct BTreeValueBytes<void> { static const int Value = 0; };
+
+      /// Slots in a node of Bytes per slot, at least four
+      template <int Bytes> struct BTreeCapacity
+      { static const int Value = BTREE_NODE_BYTES / Bytes > 4 ? BTREE_NODE_BYTES / Bytes : 4; };
+
+      template <class K, class V> struct BTreeLeaf
+         : public BTreeValues<V, BTreeCapacity<sizeof(K) + BTreeValueBytes<V>::Value>::Value>
+      {
+         static const int CAPACITY = BTreeCapacity<sizeof(K) + BTreeValueBytes<V>::Value>::Value;
+
+         int size, next;   //< next is the following leaf, or -1
+         K keys[CAPACITY];
+
+         inline BTreeLeaf() : size(0), next(-1) {}
+
+         /// Moves slot i of 'from' into slot 'to' of this leaf
+         inline void MoveSlot(int to, BTreeLeaf& from, int i)
+         { keys[to] = std::move(from.keys[i]); this->moveValue(to, from, i); }
+
+         inline void InsertSlot(int i, const K& key, const V * value)
+         {
+            for (int j = size; j > i; --j) MoveSlot(j, *this, j-1);
+            keys[i] = key; this->setValue(i, value);
+            size++;
+         }
+
+         inline void RemoveSlot(int i)
+         {
+            for (int j = i + 1; j < size; ++j) MoveSlot(j-1, *this, j);
+            size--;
+         }
+      };
+
+      template <class K> struct BTreeInner
+      {
+         static const int CAPACITY = BTreeCapacity<sizeof(K) + sizeof(int)>::Value;
+
+         int size;   //< Number of keys, there is one more child
+         K keys[CAPACITY];
+         int children[CAPACITY + 1];
+
+         inline BTreeInner() : size(0) {}
+
+         /// The child whose subtree would hold key
+         inline int ChildIndex(const K& key) const
+         {
+            const int i = BTreeSearch<K>::LowerBound(keys, size, key);
+            return i < size && !(key < keys[i]) ? i + 1 : i;
+         }
+      };
+
+
+      ///////////
+      // BTree //
+      ///////////
+
+      /// V is the value type of a map, or void for a set. Copies share the
+      /// node pools, the containers built on this have the reference
+      /// semantics of the other mutable containers.
+      template <class K, class V> class BTree
+      {
+      public:
+         typedef BTreeLeaf<K, V> Leaf;
+         typedef BTreeInner<K> Inner;
+
+         static const int LEAF_CAPACITY = Leaf::CAPACITY;
+         static const int INNER_CAPACITY = Inner::CAPACITY;
+
+         /// A node below a quarter full is merged with or refilled from a
+         /// neighbour after a removal. A quarter rather than a half leaves
+         /// room between the merge and split thresholds, so that alternating
+         /// insertions and removals do not split and merge the same node.
+         static const int LEAF_MIN = LEAF_CAPACITY / 4;
+         static const int INNER_MIN = INNER_CAPACITY / 4 > 1 ? INNER_CAPACITY / 4 : 1;
+
+         int _root, _height;   //< A tree of height 0 is a single leaf
+         Ref<MemoryPool<Leaf> > _leaves;
+         Ref<MemoryPool<Inner> > _inners;   //< Made on the first split
+
+      private:
+         int insert(int n, int height, const K& key, const V * value, bool replace, K& splitKey, int& splitNode);
+         bool remove(int n, int height, const K& key);
+         void rebalance(int parent, int c, int childHeight);
+
+         inline Leaf& leaf(int n) { return (*_leaves)[n]; }
+         inline const Leaf& leaf(int n) const { return (*_leaves)[n]; }
+         inline Inner& inner(int n) { return (*_inners)[n]; }
+         inline const Inner& inner(int n) const { return (*_inners)[n]; }
+
+         /// Returns a node's slot to its pool, unless some other container or
+         /// iterator shares the pool and may refer to it
+         template <class N> inline void release(MemoryPool<N>& pool, int n) { if (pool.RefCount() == 1) pool.Free(n); }
+
+      public:
+         inline BTree(int allocation = 1)
+            : _root(0), _height(0)
+            , _leaves(new MemoryPool<Leaf>(max(allocation / LEAF_CAPACITY + 1, 1)))
+         { _root = _leaves->Push(Leaf()); }
+
+         /// The leaf that would hold key, and the slot of key in it, or -1
+         void Find(const K& key, int& leafIndex, int& slot) const
+         {
+            int n = _root;
+            for (int h = _height; h > 0; --h) n = inner(n).children[inner(n).ChildIndex(key)];
+            const Leaf& l = leaf(n);
+            const int i = BTreeSearch<K>::LowerBound(l.keys, l.size, key);
+            leafIndex = n;
+            slot = i < l.size && !(key < l.keys[i]) ? i : -1;
+         }
+
+         /// The leftmost or rightmost leaf
+         int FirstLeaf() const
+         {
+            int n = _root;
+            for (int h = _height; h > 0; --h) n = inner(n).children[0];
+            return n;
+         }
+         int LastLeaf() const
+         {
+            int n = _root;
+            for (int h = _height; h > 0; --h) n = inner(n).children[inner(n).size];
+            return n;
+         }
+
+         /// Returns true if the key was added. A key already present keeps
+         /// its slot, and for a map takes the new value if 'replace' is set.
+         /// 'value' is ignored by sets.
+         bool Insert(const K& key, const V * value, bool replace);
+
+         /// Returns true if the key was present
+         bool Remove(const K& key);
+
+         /// Copies both pools, for the functional updates
+         inline BTree Clone() const
+         {
+            BTree b(*this);
+            b._leaves = _leaves->Clone();
+            if (_inners) b._inners = _inners->Clone();
+            return b;
+         }
+      };
+
+
+      ////////////
+      // Insert //
+      ////////////
+
+      template <class K, class V> bool BTree<K, V>::Insert(const K& key, const V * value, bool replace)
+      {
+         K splitKey; int splitNode = -1;
+         const bool added = insert(_root, _height, key, value, replace, splitKey, splitNode) != 0;
+         if (splitNode != -1)
+         {
+            /// The root split, so the tree grows a level
+            if (!_inners) _inners = new MemoryPool<Inner>(1);
+            Inner root;
+            root.size = 1;
+            root.keys[0] = splitKey;
+            root.children[0] = _root; root.children[1] = splitNode;
+            _root = _inners->Push(std::move(root));
+            _height++;
+         }
+         return added;
+      }
+
+      /// Inserts below node n, and if n had to split, returns the new right
+      /// hand node in splitNode and the smallest key under it in splitKey.
+      /// Pushing a node may move its pool, so nodes are looked up again
+      /// after every push rather than held by reference.
+      template <class K, class V>
+      int BTree<K, V>::insert(int n, int height, const K& key, const V * value, bool replace, K& splitKey, int& splitNode)
+      {
+         if (height == 0)
+         {
+            Leaf * l = &leaf(n);
+            const int i = BTreeSearch<K>::LowerBound(l->keys, l->size, key);
+            if (i < l->size && !(key < l->keys[i]))
+            {
+               if (replace) l->setValue(i, value);
+               return 0;
+            }
+            if (l->size < LEAF_CAPACITY) { l->InsertSlot(i, key, value); return 1; }
+
+            /// A full leaf splits in half, except that appending to the last
+            /// leaf starts a new one, so that ascending input fills leaves
+            const bool append = i == LEAF_CAPACITY && l->next == -1;
+            const int mid = append ? LEAF_CAPACITY : LEAF_CAPACITY / 2;
+            const int r = _leaves->Push(Leaf());
+            l = &leaf(n);
+            Leaf& right = leaf(r);
+            for (int j = mid; j < LEAF_CAPACITY; ++j) right.MoveSlot(j - mid, *l, j);
+            right.size = LEAF_CAPACITY - mid; l->size = mid;
+            right.next = l->next; l->next = r;
+
+            if (i < mid) l->InsertSlot(i, key, value);
+            else right.InsertSlot(i - mid, key, value);
+            splitKey = right.keys[0];
+            splitNode = r;
+            return 1;
+         }
+
+         const int c = inner(n).ChildIndex(key);
+         K childKey; int childSplit = -1;
+         const int added = insert(inner(n).children[c], height - 1, key, value, replace, childKey, childSplit);
+         if (childSplit == -1) return added;
+
+         Inner * node = &inner(n);
+         if (node->size < INNER_CAPACITY)
+         {
+            for (int j = node->size; j > c; --j) { node->keys[j] = std::move(node->keys[j-1]); node->children[j+1] = node->children[j]; }
+            node->keys[c] = childKey; node->children[c+1] = childSplit;
+            node->size++;
+            return added;
+         }
+
+         /// A full inner node gathers its keys and children with the new ones
+         /// and splits them around the middle key, which moves up
+         K keys[INNER_CAPACITY + 1];
+         int children[INNER_CAPACITY + 2];
+         for (int j = 0, k = 0; j <= INNER_CAPACITY; ++j)
+         {
+            if (j == c) keys[j] = childKey;
+            else keys[j] = std::move(node->keys[k++]);
+         }
+         for (int j = 0, k = 0; j <= INNER_CAPACITY + 1; ++j)
+            children[j] = j == c + 1 ? childSplit : node->children[k++];
+
+         const int mid = (INNER_CAPACITY + 1) / 2;
+         const int r = _inners->Push(Inner());
+         node = &inner(n);
+         Inner& right = inner(r);
+         node->size = mid;
+         for (int j = 0; j < mid; ++j) node->keys[j] = std::move(keys[j]);
+         for (int j = 0; j <= mid; ++j) node->children[j] = children[j];
+         right.size = INNER_CAPACITY - mid;
+         for (int j = 0; j < right.size; ++j) right.keys[j] = std::move(keys[mid + 1 + j]);
+         for (int j = 0; j <= right.size; ++j) right.children[j] = children[mid + 1 + j];
+
+         splitKey = std::move(keys[mid]);
+         splitNode = r;
+         return added;
+      }
+
+
+      ////////////
+      // Remove //
+      ////////////
+
+      template <class K, class V> bool BTree<K, V>::Remove(const K& key)
+      {
+         if (!remove(_root, _height, key)) return false;
+
+         /// A root left with a single child hands the tree to it
+         while (_height > 0 && inner(_root).size == 0)
+         {
+            const int old = _root;
+            _root = inner(old).children[0];
+            release(*_inners, old);
+            _height--;
+         }
+         return true;
+      }
+
+      template <class K, class V> bool BTree<K, V>::remove(int n, int height, const K& key)
+      {
+         if (height == 0)
+         {
+            Leaf& l = leaf(n);
+            const int i = BTreeSearch<K>::LowerBound(l.keys, l.size, key);
+            if (i == l.size || key < l.keys[i]) return false;
+            l.RemoveSlot(i);
+            return true;
+         }
+
+         const int c = inner(n).ChildIndex(key);
+         const int child = inner(n).children[c];
+         if (!remove(child, height - 1, key)) return false;
+
+         const int childSize = height == 1 ? leaf(child).size : inner(child).size;
+         if (childSize < (height == 1 ? LEAF_MIN : INNER_MIN)) rebalance(n, c, height - 1);
+         return true;
+      }
+
+      /// Child c of 'parent' has run low. It and a neighbour are merged if
+      /// they fit in one node, otherwise their contents are shared out evenly
+      /// between the two.
+      template <class K, class V> void BTree<K, V>::rebalance(int parent, int c, int childHeight)
+      {
+         Inner& p = inner(parent);
+         const int a = c > 0 ? c - 1 : c, b = a + 1;
+         if (b > p.size) return;   //< An only child, which only the root can have
+         const int ln = p.children[a], rn = p.children[b];
+
+         if (childHeight == 0)
+         {
+            Leaf& l = leaf(ln); Leaf& r = leaf(rn);
+            const int total = l.size + r.size;
+            if (total <= LEAF_CAPACITY)
+            {
+               for (int j = 0; j < r.size; ++j) l.MoveSlot(l.size + j, r, j);
+               l.size = total;
+               l.next = r.next;
+               r.size = 0;
+               release(*_leaves, rn);
+            }
+            else
+            {
+               const int half = total / 2;
+               if (l.size < half)
+               {
+                  const int k = half - l.size;
+                  for (int j = 0; j < k; ++j) l.MoveSlot(l.size + j, r, j);
+                  for (int j = k; j < r.size; ++j) r.MoveSlot(j - k, r, j);
+                  l.size += k; r.size -= k;
+               }
+               else
+               {
+                  const int k = l.size - half;
+                  for (int j = r.size - 1; j >= 0; --j) r.MoveSlot(j + k, r, j);
+                  for (int j = 0; j < k; ++j) r.MoveSlot(j, l, half + j);
+                  l.size -= k; r.size += k;
+               }
+               p.keys[a] = r.keys[0];
+               return;
+            }
+         }
+         else
+         {
+            Inner& l = inner(ln); Inner& r = inner(rn);
+            const int total = l.size + 1 + r.size;
+            if (total <= INNER_CAPACITY)
+            {
+               l.keys[l.size] = std::move(p.keys[a]);
+               for (int j = 0; j < r.size; ++j) l.keys[l.size + 1 + j] = std::move(r.keys[j]);
+               for (int j = 0; j <= r.size; ++j) l.children[l.size + 1 + j] = r.children[j];
+               l.size = total;
+               release(*_inners, rn);
+            }
+            else
+            {
+               /// Lay out both nodes' keys around the separator, and split
+               /// them again around the middle
+               K keys[2 * INNER_CAPACITY + 1];
+               int children[2 * INNER_CAPACITY + 2];
+               int k = 0, m = 0;
+               for (int j = 0; j < l.size; ++j) keys[k++] = std::move(l.keys[j]);
+               keys[k++] = std::move(p.keys[a]);
+               for (int j = 0; j < r.size; ++j) keys[k++] = std::move(r.keys[j]);
+               for (int j = 0; j <= l.size; ++j) children[m++] = l.children[j];
+               for (int j = 0; j <= r.size; ++j) children[m++] = r.children[j];
+
+               const int half = total / 2;
+               l.size = half;
+               for (int j = 0; j < half; ++j) l.keys[j] = std::move(keys[j]);
+               for (int j = 0; j <= half; ++j) l.children[j] = children[j];
+               p.keys[a] = std::move(keys[half]);
+               r.size = total - half - 1;
+               for (int j = 0; j < r.size; ++j) r.keys[j] = std::move(keys[half + 1 + j]);
+               for (int j = 0; j <= r.size; ++j) r.children[j] = children[half + 1 + j];
+               return;
+            }
+         }
+
+         /// The right node was merged away, drop its separator and link
+         for (int j = a + 1; j < p.size; ++j) { p.keys[j-1] = std::move(p.keys[j]); p.children[j] = p.children[j+1]; }
+         p.size--;
+      }
+
+
+      ///////////////
+      // Iterators //
+      ///////////////
+
+      /// Walks the leaves in order, through each leaf's link to the next
+      template <class K, class V> class BTreeCursor
+      {
+      protected:
+         typedef BTreeLeaf<K, V> Leaf;
+
+         Ref<MemoryPool<Leaf> > _leaves;
+         int _leaf, _slot;
+
+         inline BTreeCursor(const BTree<K, V>& tree)
+            : _leaves(tree._leaves), _leaf(tree.FirstLeaf()), _slot(0)
+         { if ((*_leaves)[_leaf].size == 0) _leaf = -1; }
+
+         /// Positioned at key, or exhausted if it is not present
+         inline BTreeCursor(const BTree<K, V>& tree, const K& key)
+            : _leaves(tree._leaves)
+         { tree.Find(key, _leaf, _slot); if (_slot == -1) _leaf = -1; }
+
+         inline const Leaf& leaf() const { return (*_leaves)[_leaf]; }
+
+         inline void advance()
+         {
+            if (++_slot == leaf().size) { _leaf = leaf().next; _slot = 0; }
+         }
+
+      public:
+         inline bool HasNext() const { return _leaf != -1; }
+
+         /// We provide an auto cast to bool operator, which signals if an
+         /// iterator points to a valid item or not, so that Contains() can be
+         /// used as if it returned a bool
+         inline operator bool() const { return HasNext(); }
+      };
+
+      template <class E> class BTreeSetIterator : public BTreeCursor<E, void>
+      {
+      protected:
+         friend class Mutable::BTreeSet<E>;
+
+         inline BTreeSetIterator(const BTree<E, void>& tree) : BTreeCursor<E, void>(tree) {}
+         inline BTreeSetIterator(const BTree<E, void>& tree, const E& e) : BTreeCursor<E, void>(tree, e) {}
+
+      public:
+         inline const E& Next()
+         {
+            assert(this->HasNext());
+            const E& e = this->leaf().keys[this->_slot];
+            this->advance();
+            return e;
+         }
+         inline const E& Peek() const { assert(this->HasNext()); return this->leaf().keys[this->_slot]; }
+      };
+
+      /// Map elements are assembled from the key and value arrays on the
+      /// fly, so Next() and Peek() return them by value
+      template <class K, class V> class BTreeMapIterator : public BTreeCursor<K, V>
+      {
+      protected:
+         friend class Mutable::BTreeMap<K, V>;
+
+         inline BTreeMapIterator(const BTree<K, V>& tree) : BTreeCursor<K, V>(tree) {}
+         inline BTreeMapIterator(const BTree<K, V>& tree, const K& key) : BTreeCursor<K, V>(tree, key) {}
+
+      public:
+         inline KeyValuePair<K, V> Next()
+         {
+            assert(this->HasNext());
+            KeyValuePair<K, V> e(this->leaf().keys[this->_slot], this->leaf().values[this->_slot]);
+            this->advance();
+            return e;
+         }
+         inline KeyValuePair<K, V> Peek() const
+         {
+            assert(this->HasNext());
+            return KeyValuePair<K, V>(this->leaf().keys[this->_slot], this->leaf().values[this->_slot]);
+         }
+      };
+
+
+      //////////////
+      // Builders //
+      //////////////
+
+      /// Builders insert as they go, keeping the first of any duplicates, as
+      /// the tree builders do. Ascending input, as from another sorted
+      /// container, fills each leaf before starting the next.
+      template <class E> class BTreeSetBuilder
+      {
+      private:
+         BTree<E, void> _tree;
+         int _size;
+
+         /// Flag goes true when the result has been returned and the
+         /// builder can no longer be used (it is disposable)
+         bool _complete;
+
+      public:
+         inline BTreeSetBuilder(int expectedSize = 1) : _tree(expectedSize), _size(0), _complete(false) {}
+
+         inline bool AddElement(const E& e)
+         {
+            assert(!_complete);
+            if (_tree.Insert(e, nullptr, false)) { _size++; return true; }
+            return false;
+         }
+
+         /// For the set algebra merges, which produce ascending elements
+         inline void Append(const E& e) { AddElement(e); }
+
+         inline int Size() const { return _size; }
+
+         inline Mutable::BTreeSet<E> Result()
+         { _complete = true; return Mutable::BTreeSet<E>(_size, std::move(_tree)); }
+      };
+
+      template <class K, class V> class BTreeMapBuilder
+      {
+      private:
+         BTree<K, V> _tree;
+         int _size;
+         bool _complete;
+
+      public:
+         inline BTreeMapBuilder(int expectedSize = 1) : _tree(expectedSize), _size(0), _complete(false) {}
+
+         inline bool AddElement(const KeyValuePair<K, V>& e)
+         {
+            assert(!_complete);
+            if (_tree.Insert(e.key, &e.value, false)) { _size++; return true; }
+            return false;
+         }
+
+         inline Mutable::BTreeMap<K, V> Result()
+         { _complete = true; return Mutable::BTreeMap<K, V>(_size, std::move(_tree)); }
+      };
+   }
+}
+
+#endif // BTREE_COMMON_H
@@ -4,6 +4,7 @@
 #include <assert.h>
 
 #include "Traversable.h"
+#include "View.h"
 
 #include "Sequence.h"
 #include "Array.h"
@@ -14,11 +15,22 @@
 #include "Set.h"
 #include "TreeSet.h"
 #include "MutableTreeSet.h"
+#include "FlatSet.h"
+#include "MutableBTreeSet.h"
+#include "HashSet.h"
+#include "MutableHashSet.h"
 
 #include "Map.h"
 #include "TreeMap.h"
 #include "MutableTreeMap.h"
+#include "FlatMap.h"
+#include "MutableBTreeMap.h"
+#include "HashMap.h"
+#include "MutableHashMap.h"
 
 #include "Vector.h"
+#include "TopK.h"
+#include "Scheduler.h"
+#include "Parallel.h"
 
 #endif
@@ -0,0 +1,315 @@
+#pragma once
+
+#ifndef FLAT_COMMON_H
+#define FLAT_COMMON_H
+
+#include "Traversable.h"
+#include "Map.h"
+#include "ArrayCommon.h"
+
+/// Flat containers keep their keys sorted in one contiguous buffer, with the
+/// values of a map in a parallel buffer of their own. Compared with the
+/// trees there are no nodes to chase: a lookup is a binary search over a
+/// packed array, iteration is a linear scan, and set algebra is a merge of
+/// two sorted runs. The price is that Insert and Remove copy the buffer, so
+/// flat containers suit data that is built in bulk and then mostly read.
+///
+/// Slices (Take, Drop, Tail, Init) share the buffer with the container they
+/// came from and cost O(1), as they do for Array.
+
+namespace Collections
+{
+   namespace Immutable
+   {
+      template <class E> class FlatSet;
+      template <class K, class V> class FlatMap;
+   }
+
+   namespace Common
+   {
+      ///////////////////
+      // Flat Searches //
+      ///////////////////
+
+      /// Index of the first of keys[0, n) that is not less than key, or n.
+      /// The loop has a fixed trip count of log2(n) and no branch on the
+      /// comparison, which compiles to a conditional move: the range halves
+      /// every step whatever the keys are, so there is nothing for the branch
+      /// predictor to get wrong. Both possible next probes are prefetched,
+      /// which hides most of the cache misses on large arrays.
+      ///
+      /// The keys stay in sorted order rather than an Eytzinger (breadth
+      /// first) layout, since iteration, slices and merges all need them
+      /// contiguous and in order.
+      template <class K> inline int FlatLowerBound(const K * keys, int n, const K& key)
+      {
+         if (n == 0) return 0;
+         const K * base = keys;
+         while (n > 1)
+         {
+            const int half = n / 2;
+            __builtin_prefetch(base + half / 2);
+            __builtin_prefetch(base + half + half / 2);
+            base = base[half] < key ? base + half : base;
+            n -= half;
+         }
+         return int(base - keys) + (*base < key);
+      }
+
+      /// Index of key in keys[0, n), or -1
+      template <class K> inline int FlatFind(const K * keys, int n, const K& key)
+      {
+         const int i = FlatLowerBound(keys, n, key);
+         return i < n && !(key < keys[i]) ? i : -1;
+      }
+
+      /// Drops all but the first of each run of equal elements from the
+      /// sorted range a[0, n), and returns the number left
+      template <class E> int FlatUnique(E * a, int n)
+      {
+         if (n < 2) return n;
+         int o = 1;
+         for (int i = 1; i < n; ++i)
+            if (a[o-1] < a[i])
+            {
+               if (o != i) a[o] = std::move(a[i]);
+               o++;
+            }
+         return o;
+      }
+
+      template <class K, class V> struct FlatKey
+      { inline const K& operator () (const KeyValuePair<K, V>& e) const { return e.key; } };
+
+      /// Sorts a[0, n) and drops all but the first added of each run of
+      /// equal elements, returning the number left. Equal map keys have to
+      /// keep the order they were added in, for the first of them to win, so
+      /// pairs are sorted stably: radix sort for arithmetic keys, merge sort
+      /// for the rest.
+      template <class E> int FlatSortUnique(E * a, int n)
+      {
+         SortInPlace(a, 0, n - 1);
+         return FlatUnique(a, n);
+      }
+
+      template <class K, class V> inline void flatSortByKey(KeyValuePair<K, V> * a, int n, std::true_type)
+      {
+         if (n < RADIX_SORT_THRESHOLD) StableSortInPlace(a, n, OperatorLessThan<KeyValuePair<K, V> >());
+         else RadixSortBy(a, n, FlatKey<K, V>());
+      }
+      template <class K, class V> inline void flatSortByKey(KeyValuePair<K, V> * a, int n, std::false_type)
+      { StableSortInPlace(a, n, OperatorLessThan<KeyValuePair<K, V> >()); }
+
+      template <class K, class V> int FlatSortUnique(KeyValuePair<K, V> * a, int n)
+      {
+         flatSortByKey(a, n, std::integral_constant<bool, RadixKey<K>::Radix>());
+         return FlatUnique(a, n);
+      }
+
+
+      ////////////////////
+      // Flat Iterators //
+      ////////////////////
+
+      template <class E> class FlatSetIterator
+      {
+      protected:
+         friend class Immutable::FlatSet<E>;
+
+         Ref<UninitializedBuffer<E> > _keys;
+         int _next, _end;
+
+         inline FlatSetIterator(const Ref<UninitializedBuffer<E> >& keys, int next, int end)
+            : _keys(keys), _next(next), _end(end) {}
+
+      public:
+         inline bool HasNext() const { return _next < _end; }
+         inline const E& Next() { assert(HasNext()); return _keys->Index(_next++); }
+         inline const E& Peek() const { assert(HasNext()); return _keys->Index(_next); }
+
+         /// Signals whether the iterator points at an element, so that
+         /// Contains() can be used as if it returned a bool
+         inline operator bool() const { return HasNext(); }
+      };
+
+      /// Map elements are assembled from the two buffers on the fly, so Next()
+      /// and Peek() return them by value
+      template <class K, class V> class FlatMapIterator
+      {
+      protected:
+         friend class Immutable::FlatMap<K, V>;
+
+         Ref<UninitializedBuffer<K> > _keys;
+         Ref<UninitializedBuffer<V> > _values;
+         int _next, _end;
+
+         inline FlatMapIterator(const Ref<UninitializedBuffer<K> >& keys,
+                                const Ref<UninitializedBuffer<V> >& values, int next, int end)
+            : _keys(keys), _values(values), _next(next), _end(end) {}
+
+      public:
+         inline bool HasNext() const { return _next < _end; }
+
+         inline KeyValuePair<K, V> Next()
+         {
+            assert(HasNext());
+            const int i = _next++;
+            return KeyValuePair<K, V>(_keys->Index(i), _values->Index(i));
+         }
+
+         inline KeyValuePair<K, V> Peek() const
+         { assert(HasNext()); return KeyValuePair<K, V>(_keys->Index(_next), _values->Index(_next)); }
+
+         inline operator bool() const { return HasNext(); }
+      };
+
+
+      ///////////////////
+      // Flat Builders //
+      ///////////////////
+
+      /// Builders take elements in any order. Input that arrives already in
+      /// strictly ascending order, as it does from another sorted container,
+      /// is detected as it is added and costs nothing more. Anything else is
+      /// sorted once in Result(), after which duplicates are dropped keeping
+      /// the first one added, as the tree builders do.
+      template <class E> class FlatBuffer
+      {
+      protected:
+         Ref<UninitializedBuffer<E> > _data;
+         bool _sorted;
+
+         /// Flag goes true when the result has been returned and the
+         /// builder can no longer be used (it is disposable)
+         bool _complete;
+
+         inline FlatBuffer(int expectedSize)
+            : _data(new UninitializedBuffer<E>(max(expectedSize, 1)))
+            , _sorted(true), _complete(false) {}
+
+         /// Double the capacity. The buffer is normally ours alone and grows
+         /// in place, a copied builder has to take a private copy first.
+         void resize()
+         {
+            const int newCapacity = 2 * _data->Capacity();
+            if (_data->RefCount() == 1) _data->Reserve(newCapacity);
+            else _data = _data->Clone(newCapacity);
+         }
+
+         template <class U> inline void add(U&& e)
+         {
+            assert(!_complete);
+            const int n = _data->Size();
+            if (n == _data->Capacity()) resize();
+            if (_sorted && n > 0 && !(_data->Index(n-1) < e)) _sorted = false;
+            _data->Append(std::forward<U>(e));
+         }
+
+         inline E * data() { return (E*)*_data; }
+      };
+
+      template <class E> class FlatSetBuilder : public FlatBuffer<E>
+      {
+      public:
+         inline FlatSetBuilder(int expectedSize = 1) : FlatBuffer<E>(expectedSize) {}
+
+         inline void AddElement(const E& e) { this->add(e); }
+         inline void AddElement(E&& e) { this->add(std::move(e)); }
+
+         Immutable::FlatSet<E> Result()
+         {
+            assert(!this->_complete);
+            this->_complete = true;
+
+            int n = this->_data->Size();
+            if (!this->_sorted) n = FlatSortUnique(this->data(), n);
+            return Immutable::FlatSet<E>(std::move(this->_data), 0, n);
+         }
+      };
+
+      template <class K, class V> class FlatMapBuilder : public FlatBuffer<KeyValuePair<K, V> >
+      {
+      private:
+         typedef KeyValuePair<K, V> E;
+
+      public:
+         inline FlatMapBuilder(int expectedSize = 1) : FlatBuffer<E>(expectedSize) {}
+
+         inline void AddElement(const E& e) { this->add(e); }
+         inline void AddElement(E&& e) { this->add(std::move(e)); }
+
+         Immutable::FlatMap<K, V> Result()
+         {
+            assert(!this->_complete);
+            this->_complete = true;
+
+            E * pairs = this->data();
+            int n = this->_data->Size();
+            if (!this->_sorted) n = FlatSortUnique(pairs, n);
+
+            /// Split the pairs into the key and value buffers
+            Ref<UninitializedBuffer<K> > keys = new UninitializedBuffer<K>(n);
+            Ref<UninitializedBuffer<V> > values = new UninitializedBuffer<V>(n);
+            for (int i = 0; i < n; ++i)
+            {
+               keys->Append(std::move(pairs[i].key));
+               values->Append(std::move(pairs[i].value));
+            }
+            this->_data = nullptr;
+            return Immutable::FlatMap<K, V>(std::move(keys), std::move(values), 0, n);
+         }
+      };
+
+
+      //////////////////
+      // Flat Merging //
+      //////////////////
+
+      /// Linear merges of the sorted ranges a[0, n) and b[0, m), appending the
+      /// result to out. Where both hold an equal element the one from 'a' is
+      /// kept.
+      enum FlatMergeOp { FLAT_UNION, FLAT_INTERSECTION, FLAT_DIFFERENCE };
+
+      template <FlatMergeOp Op, class K>
+      void FlatMerge(const K * a, int n, const K * b, int m, UninitializedBuffer<K>& out)
+      {
+         int i = 0, j = 0;
+         while (i < n && j < m)
+         {
+            if (a[i] < b[j])
+            {
+               if (Op != FLAT_INTERSECTION) { out.Append(a[i]); }
+               i++;
+            }
+            else if (b[j] < a[i])
+            {
+               if (Op == FLAT_UNION) { out.Append(b[j]); }
+               j++;
+            }
+            else
+            {
+               if (Op != FLAT_DIFFERENCE) { out.Append(a[i]); }
+               i++; j++;
+            }
+         }
+         if (Op != FLAT_INTERSECTION) for (; i < n; ++i) { out.Append(a[i]); }
+         if (Op == FLAT_UNION)        for (; j < m; ++j) { out.Append(b[j]); }
+      }
+
+      /// True if every element of a[0, n) is in b[0, m), O(n + m)
+      template <class K> bool FlatIncludes(const K * a, int n, const K * b, int m)
+      {
+         if (n > m) return false;
+         int j = 0;
+         for (int i = 0; i < n; ++i)
+         {
+            while (j < m && b[j] < a[i]) j++;
+            if (j == m || a[i] < b[j]) return false;
+            j++;
+         }
+         return true;
+      }
+   }
+}
+
+#endif // FLAT_COMMON_H
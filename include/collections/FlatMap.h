@@ -0,0 +1,187 @@
+#pragma once
+
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include "Map.h"
+#include "FlatSet.h"
+
+/////////////////////////////////////////
+// Class FlatMap <- Map <- Traversable //
+/////////////////////////////////////////
+
+namespace Collections
+{
+   namespace Immutable
+   {
+      template <class K, class V> struct FlatMapTraits
+      {
+         typedef Common::FlatMapIterator<K, V> Iterator;
+         typedef Common::FlatMapBuilder<K, V> Builder;
+         typedef FlatSet<K> SetType;
+      };
+
+      template <class K, class V>
+      class FlatMap : public Map<K, V, FlatMap<K, V>, FlatMapTraits<K, V> >
+      {
+      public:
+
+         friend class Common::FlatMapBuilder<K, V>;
+
+         template <class U> struct SwapElementType { typedef FlatMap<K, U> C; };
+
+         typedef Common::KeyValuePair<K, V> ElementType;
+         typedef Common::FlatMapIterator<K, V> Iterator;
+         typedef Common::FlatMapBuilder<K, V> Builder;
+
+         /// The set container that corresponds to the FlatMap<K, V> is FlatSet<K>
+         typedef FlatSet<K> SetType;
+
+      private:
+
+         typedef Common::UninitializedBuffer<K> KeyBuffer;
+         typedef Common::UninitializedBuffer<V> ValueBuffer;
+
+         /// The mappings are _keys[i] -> _values[i] for i in
+         /// [_offset, _offset + _size), with the keys in ascending order
+         Ref<KeyBuffer> _keys;
+         Ref<ValueBuffer> _values;
+         int _offset, _size;
+
+         inline FlatMap(const Ref<KeyBuffer>& keys, const Ref<ValueBuffer>& values, int offset, int size)
+            : _keys(keys), _values(values), _offset(offset), _size(size) {}
+         inline FlatMap(Ref<KeyBuffer>&& keys, Ref<ValueBuffer>&& values, int offset, int size)
+            : _keys(std::move(keys)), _values(std::move(values)), _offset(offset), _size(size) {}
+
+         inline const K * keys() const { return (const K*)*_keys + _offset; }
+         inline const V * values() const { return (const V*)*_values + _offset; }
+
+      public:
+
+         ///////////////////////////////////////////
+         // Copy Constructor, Reference Semantics //
+         ///////////////////////////////////////////
+
+         inline FlatMap() : _keys(new KeyBuffer()), _values(new ValueBuffer()), _offset(0), _size(0) {}
+
+         /// The buffers' reference counters are automatically incremented
+         inline FlatMap(const FlatMap& rhs)
+            : _keys(rhs._keys), _values(rhs._values), _offset(rhs._offset), _size(rhs._size) {}
+
+         //////////////////////////////////////////////
+         // Assignment Operator, Reference Semantics //
+         //////////////////////////////////////////////
+
+         inline FlatMap& operator = (const FlatMap& rhs)
+         {
+            _keys = rhs._keys; _values = rhs._values;
+            _offset = rhs._offset; _size = rhs._size;
+            return *this;
+         }
+
+         /// Moves take over the buffers without touching their reference
+         /// counters. The moved-from container may only be assigned to or destroyed.
+         inline FlatMap(FlatMap&& rhs)
+            : _keys(std::move(rhs._keys)), _values(std::move(rhs._values))
+            , _offset(rhs._offset), _size(rhs._size) { rhs._size = 0; }
+
+         inline FlatMap& operator = (FlatMap&& rhs)
+         {
+            _keys = std::move(rhs._keys); _values = std::move(rhs._values);
+            _offset = rhs._offset; _size = rhs._size;
+            rhs._size = 0;
+            return *this;
+         }
+
+
+         ////////////////////////////////
+         // Inherited From Traversable //
+         ////////////////////////////////
+
+         virtual int Size() const { return _size; }
+         virtual Iterator GetIterator() const { return Iterator(_keys, _values, _offset, _offset + _size); }
+
+         virtual ElementType Head() const
+         { assert(_size > 0); return ElementType(keys()[0], values()[0]); }
+         virtual ElementType Last() const
+         { assert(_size > 0); return ElementType(keys()[_size-1], values()[_size-1]); }
+
+         /// O(1), the slices share this map's buffers
+         virtual FlatMap Take(int n) const
+         { return FlatMap(_keys, _values, _offset, max(0, min(n, _size))); }
+         virtual FlatMap Drop(int n) const
+         { n = max(0, min(n, _size)); return FlatMap(_keys, _values, _offset + n, _size - n); }
+
+
+         ////////////////////////
+         // Inherited From Map //
+         ////////////////////////
+
+         /// O(log n)
+         virtual bool Contains(const K& key) const
+         { return Common::FlatFind(keys(), _size, key) != -1; }
+
+         /// O(log n)
+         virtual const V& GetOrElse(const K& key, const V& otherwise) const
+         {
+            const int i = Common::FlatFind(keys(), _size, key);
+            return i == -1 ? otherwise : values()[i];
+         }
+
+         virtual FlatMap Insert(const K& key, const V& value) const;
+         virtual FlatMap Remove(const K& key) const;
+
+         /// O(1), the set shares this map's key buffer
+         virtual SetType Keys() const { return SetType(_keys, _offset, _size); }
+      };
+
+
+      /// O(n). Updating the value of a key already present copies only the
+      /// values, the new map shares this map's keys (unless this map is a
+      /// slice that does not start at the front of them).
+      template <class K, class V> FlatMap<K, V>
+      FlatMap<K, V>::Insert(const K& key, const V& value) const
+      {
+         const K * k = keys();
+         const V * v = values();
+         const int i = Common::FlatLowerBound(k, _size, key);
+         const bool present = i < _size && !(key < k[i]);
+
+         if (present && _offset == 0)
+         {
+            Ref<ValueBuffer> newValues = new ValueBuffer(_size);
+            for (int j = 0; j < _size; ++j) newValues->Append(j == i ? value : v[j]);
+            return FlatMap(_keys, newValues, 0, _size);
+         }
+
+         const int n = present ? _size : _size + 1;
+         Ref<KeyBuffer> newKeys = new KeyBuffer(n);
+         Ref<ValueBuffer> newValues = new ValueBuffer(n);
+         for (int j = 0; j < i; ++j) { newKeys->Append(k[j]); newValues->Append(v[j]); }
+         newKeys->Append(key); newValues->Append(value);
+         for (int j = present ? i + 1 : i; j < _size; ++j) { newKeys->Append(k[j]); newValues->Append(v[j]); }
+         return FlatMap(std::move(newKeys), std::move(newValues), 0, n);
+      }
+
+      /// O(n), or O(1) for the first and last keys, which only need a slice
+      template <class K, class V> FlatMap<K, V>
+      FlatMap<K, V>::Remove(const K& key) const
+      {
+         const K * k = keys();
+         const V * v = values();
+         const int i = Common::FlatFind(k, _size, key);
+         if (i == -1) return *this;
+         if (i == 0) return Drop(1);
+         if (i == _size - 1) return Take(_size - 1);
+
+         Ref<KeyBuffer> newKeys = new KeyBuffer(_size - 1);
+         Ref<ValueBuffer> newValues = new ValueBuffer(_size - 1);
+         for (int j = 0; j < _size; ++j)
+            if (j != i) { newKeys->Append(k[j]); newValues->Append(v[j]); }
+         return FlatMap(std::move(newKeys), std::move(newValues), 0, _size - 1);
+      }
+
+   } // namespace Immutable
+} // namespace Collections
+
+#endif // FLAT_MAP_H
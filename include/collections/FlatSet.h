@@ -0,0 +1,186 @@
+#pragma once
+
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+#include "Set.h"
+#include "FlatCommon.h"
+
+/////////////////////////////////////////
+// Class FlatSet <- Set <- Traversable //
+/////////////////////////////////////////
+
+namespace Collections
+{
+   namespace Immutable
+   {
+      template <class E> struct FlatSetTraits
+      {
+         typedef Common::FlatSetIterator<E> Iterator;
+         typedef Common::FlatSetBuilder<E> Builder;
+      };
+
+      template <class E>
+      class FlatSet : public Set<E, FlatSet<E>, FlatSetTraits<E> >
+      {
+      public:
+
+         friend class Common::FlatSetBuilder<E>;
+         template <class K, class V> friend class FlatMap;
+
+         typedef E ElementType;
+         typedef Common::FlatSetIterator<E> Iterator;
+         typedef Common::FlatSetBuilder<E> Builder;
+         typedef Common::UninitializedBuffer<E> Buffer;
+
+         template <class U> struct SwapElementType { typedef FlatSet<U> C; };
+
+      private:
+
+         /// The elements are _keys[_offset, _offset + _size), in ascending order
+         Ref<Buffer> _keys;
+         int _offset, _size;
+
+         inline FlatSet(const Ref<Buffer>& keys, int offset, int size)
+            : _keys(keys), _offset(offset), _size(size) {}
+         inline FlatSet(Ref<Buffer>&& keys, int offset, int size)
+            : _keys(std::move(keys)), _offset(offset), _size(size) {}
+
+         inline const E * keys() const { return (const E*)*_keys + _offset; }
+
+         /// A set of the given elements, which are already sorted and unique
+         template <Common::FlatMergeOp Op> FlatSet merge(const FlatSet& set, int capacity) const
+         {
+            Ref<Buffer> result = new Buffer(capacity);
+            Common::FlatMerge<Op>(keys(), _size, set.keys(), set._size, *result);
+            const int n = result->Size();
+            return FlatSet(std::move(result), 0, n);
+         }
+
+      public:
+
+         ///////////////////////////////////////////
+         // Copy Constructor, Reference Semantics //
+         ///////////////////////////////////////////
+
+         inline FlatSet() : _keys(new Buffer()), _offset(0), _size(0) {}
+
+         /// The key buffer's reference counter is automatically incremented
+         inline FlatSet(const FlatSet& rhs)
+            : _keys(rhs._keys), _offset(rhs._offset), _size(rhs._size) {}
+
+         //////////////////////////////////////////////
+         // Assignment Operator, Reference Semantics //
+         //////////////////////////////////////////////
+
+         inline FlatSet& operator = (const FlatSet& rhs)
+         { _keys = rhs._keys; _offset = rhs._offset; _size = rhs._size; return *this; }
+
+         /// Moves take over the key buffer without touching its reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline FlatSet(FlatSet&& rhs)
+            : _keys(std::move(rhs._keys)), _offset(rhs._offset), _size(rhs._size) { rhs._size = 0; }
+
+         inline FlatSet& operator = (FlatSet&& rhs)
+         {
+            _keys = std::move(rhs._keys); _offset = rhs._offset; _size = rhs._size;
+            rhs._size = 0;
+            return *this;
+         }
+
+
+         ////////////////////////////////
+         // Inherited From Traversable //
+         ////////////////////////////////
+
+         virtual int Size() const { return _size; }
+         virtual Iterator GetIterator() const { return Iterator(_keys, _offset, _offset + _size); }
+
+         virtual E Head() const { assert(_size > 0); return keys()[0]; }
+         virtual E Last() const { assert(_size > 0); return keys()[_size-1]; }
+
+         /// O(1), the slices share this set's buffer
+         virtual FlatSet Take(int n) const { return FlatSet(_keys, _offset, max(0, min(n, _size))); }
+         virtual FlatSet Drop(int n) const
+         { n = max(0, min(n, _size)); return FlatSet(_keys, _offset + n, _size - n); }
+
+
+         ////////////////////////
+         // Inherited From Set //
+         ////////////////////////
+
+         /// O(log n)
+         virtual Iterator Contains(const E& element) const
+         {
+            const int i = Common::FlatFind(keys(), _size, element);
+            return i == -1 ? Iterator(_keys, 0, 0) : Iterator(_keys, _offset + i, _offset + _size);
+         }
+
+         /// O(n + m), the remaining set routines are linear merges
+         virtual bool IsSubsetOf(const FlatSet& set) const
+         { return Common::FlatIncludes(keys(), _size, set.keys(), set._size); }
+
+         virtual FlatSet Union(const FlatSet& set) const
+         {
+            if (set._size == 0) return *this;
+            if (_size == 0) return set;
+            return merge<Common::FLAT_UNION>(set, _size + set._size);
+         }
+
+         virtual FlatSet Intersection(const FlatSet& set) const
+         {
+            if (_size == 0 || set._size == 0) return FlatSet();
+            return merge<Common::FLAT_INTERSECTION>(set, min(_size, set._size));
+         }
+
+         virtual FlatSet Difference(const FlatSet& set) const
+         {
+            if (_size == 0 || set._size == 0) return *this;
+            return merge<Common::FLAT_DIFFERENCE>(set, _size);
+         }
+
+         virtual FlatSet Insert(const E& element) const;
+         virtual FlatSet Remove(const E& element) const;
+
+
+         ///////////////////
+         // Miscellaneous //
+         ///////////////////
+
+         /// O(1), the i-th smallest element
+         inline const E& operator [] (int i) const { assert(i >= 0 && i < _size); return keys()[i]; }
+      };
+
+
+      /// O(n), the elements are copied around the new one
+      template <class E> FlatSet<E> FlatSet<E>::Insert(const E& e) const
+      {
+         const E * k = keys();
+         const int i = Common::FlatLowerBound(k, _size, e);
+         if (i < _size && !(e < k[i])) return *this;
+
+         Ref<Buffer> result = new Buffer(_size + 1);
+         for (int j = 0; j < i; ++j) result->Append(k[j]);
+         result->Append(e);
+         for (int j = i; j < _size; ++j) result->Append(k[j]);
+         return FlatSet(std::move(result), 0, _size + 1);
+      }
+
+      /// O(n), or O(1) for the first and last elements, which only need a slice
+      template <class E> FlatSet<E> FlatSet<E>::Remove(const E& e) const
+      {
+         const E * k = keys();
+         const int i = Common::FlatFind(k, _size, e);
+         if (i == -1) return *this;
+         if (i == 0) return Drop(1);
+         if (i == _size - 1) return Take(_size - 1);
+
+         Ref<Buffer> result = new Buffer(_size - 1);
+         for (int j = 0; j < _size; ++j) if (j != i) result->Append(k[j]);
+         return FlatSet(std::move(result), 0, _size - 1);
+      }
+
+   } // namespace Immutable
+} // namespace Collections
+
+#endif // FLAT_SET_H
@@ -0,0 +1,299 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(___SSE4)
+#include <smmintrin.h>
+#endif
+
+/// The hash functions behind the hashed containers and the treaps'
+/// priorities. Common::Hash<K>::Of(key) gives a key's 64 bit hash, and is
+/// specialized for:
+///
+///    - integers and enums, by a multiply-xorshift mix of their bits
+///    - floating point numbers, with -0.0 hashing as 0.0
+///    - pointers, by address
+///    - Pair, and KeyValuePair by its key alone, as its == compares
+///    - std::string, by its bytes
+///    - Mathematics::Vector<T, N> of numbers, by its lanes' bytes, again
+///      with -0.0 folded into 0.0, so vertex positions can be keys
+///
+/// Any other key type can be used by specializing Hash for it, and, if its
+/// operator == does not give a bool, Common::KeyEqual too. Hash<K> must give
+/// equal keys equal hashes and spread them over all 64 bits.
+///
+/// Byte ranges go through Common::HashBytes(), a version of wyhash: eight
+/// bytes at a time are xored with a secret and multiplied 64 by 64 into
+/// 128 bits, whose halves are xored together, and anything under 17 bytes
+/// (a Vector3f, most short strings) takes two overlapping reads and a
+/// single such multiply.
+///
+/// Keys of 32 bits or fewer hash to two MurmurHash3 32 bit finalizers of
+/// the key, one for each half of the hash, rather than one 64 bit mix. That
+/// costs about the same for one key, and it lets HashBatch hash four keys
+/// to the SSE register, or eight to two, with the same results as one at a
+/// time.
+
+namespace Mathematics
+{
+   template <class T, int N> class Vector;
+}
+
+namespace Collections
+{
+   template <class A, class B> class Pair;
+
+   namespace Common
+   {
+      template <class A, class B> class KeyValuePair;
+
+      ////////////
+      // Mixing //
+      ////////////
+
+      /// The 64-bit finalizer from MurmurHash3, the same as the treaps'
+      /// priorities use, but keeping all 64 bits
+      inline uint64_t MixHash(uint64_t x)
+      {
+         x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+         x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+         x ^= x >> 33;
+         return x;
+      }
+
+      /// The 32-bit finalizer from MurmurHash3, a bijection
+      inline uint32_t MixHalf(uint32_t x)
+      {
+         x ^= x >> 16; x *= 0x85ebca6bu;
+         x ^= x >> 13; x *= 0xc2b2ae35u;
+         x ^= x >> 16;
+         return x;
+      }
+
+      /// A 64 bit hash of a 32 bit key, from two independent finalizers.
+      /// Each half is a bijection of the key, so no two keys share either.
+      static const uint32_t HASH_HALF_SEED = 0x9e3779b9u;
+      inline uint64_t MixHash32(uint32_t x)
+      { return (uint64_t(MixHalf(x)) << 32) | MixHalf(x ^ HASH_HALF_SEED); }
+
+      namespace HashBits
+      {
+         static const uint64_t SECRET[4] =
+         { 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL };
+
+         /// The 128 bit product of a and b, low half in a and high in b
+         inline void Multiply(uint64_t& a, uint64_t& b)
+         {
+         #if defined(__SIZEOF_INT128__)
+            const __uint128_t r = __uint128_t(a) * b;
+            a = uint64_t(r); b = uint64_t(r >> 64);
+         #else
+            const uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+            const uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+            const uint64_t t = hl + (ll >> 32), w = lh + uint32_t(t);
+            a = (w << 32) | uint32_t(ll);
+            b = hh + (t >> 32) + (w >> 32);
+         #endif
+         }
+
+         inline uint64_t Mix(uint64_t a, uint64_t b) { Multiply(a, b); return a ^ b; }
+
+         inline uint64_t Read8(const uint8_t * p) { uint64_t v; memcpy(&v, p, 8); return v; }
+         inline uint64_t Read4(const uint8_t * p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+         /// One to three bytes, each of them read
+         inline uint64_t Read3(const uint8_t * p, size_t n)
+         { return (uint64_t(p[0]) << 16) | (uint64_t(p[n >> 1]) << 8) | p[n - 1]; }
+      }
+
+      /// wyhash (final version 4) of n bytes
+      inline uint64_t HashBytes(const void * bytes, size_t n, uint64_t seed = 0)
+      {
+         using namespace HashBits;
+         const uint8_t * p = (const uint8_t*)bytes;
+         seed ^= Mix(seed ^ SECRET[0], SECRET[1]);
+
+         uint64_t a, b;
+         if (n <= 16)
+         {
+            if (n >= 4)
+            {
+               /// Two overlapping pairs of four byte reads cover 4 to 16 bytes
+               const size_t d = (n >> 3) << 2;
+               a = (Read4(p) << 32) | Read4(p + d);
+               b = (Read4(p + n - 4) << 32) | Read4(p + n - 4 - d);
+            }
+            else if (n > 0) { a = Read3(p, n); b = 0; }
+            else a = b = 0;
+         }
+         else
+         {
+            size_t i = n;
+            if (i > 48)
+            {
+               /// Three independent lanes of 16 bytes
+               uint64_t seed1 = seed, seed2 = seed;
+               do
+               {
+                  seed  = Mix(Read8(p)      ^ SECRET[1], Read8(p + 8)  ^ seed);
+                  seed1 = Mix(Read8(p + 16) ^ SECRET[2], Read8(p + 24) ^ seed1);
+                  seed2 = Mix(Read8(p + 32) ^ SECRET[3], Read8(p + 40) ^ seed2);
+                  p += 48; i -= 48;
+               }
+               while (i > 48);
+               seed ^= seed1 ^ seed2;
+            }
+            while (i > 16)
+            {
+               seed = Mix(Read8(p) ^ SECRET[1], Read8(p + 8) ^ seed);
+               i -= 16; p += 16;
+            }
+            a = Read8(p + i - 16);
+            b = Read8(p + i - 8);
+         }
+
+         a ^= SECRET[1]; b ^= seed;
+         Multiply(a, b);
+         return Mix(a ^ SECRET[0] ^ n, b ^ SECRET[1]);
+      }
+
+
+      //////////
+      // Hash //
+      //////////
+
+      template <class K, class Enable = void> struct Hash;
+
+      template <class K> struct Hash<K, typename std::enable_if<
+         (std::is_integral<K>::value || std::is_enum<K>::value) && sizeof(K) <= 4>::type>
+      { static inline uint64_t Of(K k) { return MixHash32(uint32_t(k)); } };
+
+      template <class K> struct Hash<K, typename std::enable_if<
+         (std::is_integral<K>::value || std::is_enum<K>::value) && (sizeof(K) > 4)>::type>
+      { static inline uint64_t Of(K k) { return MixHash(uint64_t(k)); } };
+
+      template <class K> struct Hash<K, typename std::enable_if<std::is_floating_point<K>::value>::type>
+      {
+         /// -0.0 == 0.0, so both must hash alike
+         static inline uint64_t Of(K k)
+         {
+            const double d = k == 0 ? 0.0 : double(k);
+            uint64_t bits; memcpy(&bits, &d, sizeof(bits));
+            return MixHash(bits);
+         }
+      };
+
+      template <class K> struct Hash<K*>
+      { static inline uint64_t Of(const K * k) { return MixHash(uint64_t(uintptr_t(k))); } };
+
+      template <class A, class B> struct Hash<Pair<A, B> >
+      {
+         static inline uint64_t Of(const Pair<A, B>& p)
+         { return MixHash(Hash<A>::Of(p.first) * 31 + Hash<B>::Of(p.second)); }
+      };
+
+      template <class A, class B> struct Hash<KeyValuePair<A, B> >
+      { static inline uint64_t Of(const KeyValuePair<A, B>& e) { return Hash<A>::Of(e.key); } };
+
+      template <> struct Hash<std::string>
+      { static inline uint64_t Of(const std::string& s) { return HashBytes(s.data(), s.size()); } };
+
+      template <class T, int N> struct Hash<Mathematics::Vector<T, N>, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+      {
+         static inline uint64_t Of(const Mathematics::Vector<T, N>& v)
+         {
+            T lanes[N];
+            for (int i = 0; i < N; ++i) lanes[i] = v[i] == T(0) ? T(0) : v[i];
+            return HashBytes(lanes, sizeof(lanes));
+         }
+      };
+
+      /// Whether Hash<K> has been specialized for K
+      template <class K, class Enable = void> struct HasHash : std::false_type {};
+      template <class K> struct HasHash<K, decltype(void(Hash<K>::Of(std::declval<const K&>())))> : std::true_type {};
+
+
+      //////////////
+      // KeyEqual //
+      //////////////
+
+      /// How the hashed containers compare keys: by operator ==, except for
+      /// the math Vectors, whose == gives a mask of lanes
+      template <class K, class Enable = void> struct KeyEqual
+      { static inline bool Of(const K& a, const K& b) { return a == b; } };
+
+      template <class T, int N> struct KeyEqual<Mathematics::Vector<T, N> >
+      {
+         static inline bool Of(const Mathematics::Vector<T, N>& a, const Mathematics::Vector<T, N>& b)
+         {
+            for (int i = 0; i < N; ++i) if (!(a[i] == b[i])) return false;
+            return true;
+         }
+      };
+
+
+      /////////////
+      // Batches //
+      /////////////
+
+      /// HashBatch<K, W>::Of(keys, hashes) hashes W = 4 or 8 keys at once,
+      /// to the same values as Hash<K>::Of. Keys of 32 bits go through SSE
+      /// registers when built with ___SSE4, a register of four keys per
+      /// finalizer, and the two registers of eight keys interleave. Other
+      /// keys are hashed one at a time.
+      template <class K, int W, class Enable = void> struct HashBatch
+      {
+         static_assert(W == 4 || W == 8, "Keys are hashed four or eight at a time");
+         static inline void Of(const K * keys, uint64_t * hashes)
+         { for (int i = 0; i < W; ++i) hashes[i] = Hash<K>::Of(keys[i]); }
+      };
+
+      #if defined(___SSE4)
+      namespace HashLanes
+      {
+         typedef __m128i Reg;
+
+         inline Reg MixHalf(Reg x)
+         {
+            x = _mm_xor_si128(x, _mm_srli_epi32(x, 16)); x = _mm_mullo_epi32(x, _mm_set1_epi32(int(0x85ebca6bu)));
+            x = _mm_xor_si128(x, _mm_srli_epi32(x, 13)); x = _mm_mullo_epi32(x, _mm_set1_epi32(int(0xc2b2ae35u)));
+            return _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+         }
+
+         /// Four keys to four hashes, the high halves from the keys and the
+         /// low halves from the seeded keys, as MixHash32
+         inline void MixHash32(const void * keys, uint64_t * hashes)
+         {
+            const Reg k = _mm_loadu_si128((const Reg*)keys);
+            const Reg hi = MixHalf(k), lo = MixHalf(_mm_xor_si128(k, _mm_set1_epi32(int(HASH_HALF_SEED))));
+            _mm_storeu_si128((Reg*)hashes, _mm_unpacklo_epi32(lo, hi));
+            _mm_storeu_si128((Reg*)(hashes + 2), _mm_unpackhi_epi32(lo, hi));
+         }
+      }
+
+      template <class K, int W> struct HashBatch<K, W, typename std::enable_if<
+         (std::is_integral<K>::value || std::is_enum<K>::value) && sizeof(K) == 4>::type>
+      {
+         static_assert(W == 4 || W == 8, "Keys are hashed four or eight at a time");
+         static inline void Of(const K * keys, uint64_t * hashes)
+         { for (int i = 0; i < W; i += 4) HashLanes::MixHash32(keys + i, hashes + i); }
+      };
+      #endif // ___SSE4
+
+      /// The hashes of n keys, eight and then four at a time
+      template <class K> inline void HashKeys(const K * keys, int n, uint64_t * hashes)
+      {
+         int i = 0;
+         for (; i + 8 <= n; i += 8) HashBatch<K, 8>::Of(keys + i, hashes + i);
+         if (i + 4 <= n) { HashBatch<K, 4>::Of(keys + i, hashes + i); i += 4; }
+         for (; i < n; ++i) hashes[i] = Hash<K>::Of(keys[i]);
+      }
+   }
+}
+
+#endif // HASH_H
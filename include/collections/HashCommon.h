@@ -0,0 +1,418 @@
+#ifndef HASH_COMMON_H
+#define HASH_COMMON_H
+
+#include <stdint.h>
+#include <type_traits>
+
+#if defined(___SSE)
+#include <emmintrin.h>
+#endif
+
+#include "Map.h"
+#include "Hash.h"
+
+/// The hash containers are open addressing tables in the style of the Swiss
+/// tables: beside the array of slots is an array of one control byte per
+/// slot, which holds HASH_EMPTY or, for a full slot, the low seven bits of
+/// its element's hash. A lookup compares the control bytes sixteen at a
+/// time against the seven bits it is looking for, with one SSE compare when
+/// built with ___SSE, and only looks at the slots that match, so a search
+/// touches one or two cache lines of control bytes and, almost always, one
+/// slot.
+///
+/// Probing is linear, one slot at a time, from the slot that the rest of
+/// the hash picks, and the control bytes are read in windows of sixteen
+/// starting there. An element is therefore always between its home slot and
+/// the first empty slot after it, and a search stops at the first window
+/// holding an empty slot. Removal keeps that true without tombstones: the
+/// elements after the removed one shift back into the gap for as long as
+/// that does not move one before its home, the backward shift deletion of
+/// linear probing. The table never fills past three quarters, so runs of
+/// full slots stay short.
+///
+/// The first sixteen control bytes are mirrored past the end of the array,
+/// so a window that runs off the end reads the start of the table without
+/// any wrapping arithmetic.
+
+namespace Collections
+{
+   namespace Mutable
+   {
+      template <class E> class HashSet;
+      template <class K, class V> class HashMap;
+   }
+
+   namespace Common
+   {
+      /// A set's slots hold its elements, a map's its key-value pairs, and
+      /// both are found by key
+      template <class E> struct HashEntry
+      {
+         typedef E Key;
+         static inline const E& KeyOf(const E& e) { return e; }
+         static inline bool Matches(const E& e, const E& key) { return KeyEqual<E>::Of(e, key); }
+      };
+
+      template <class K, class V> struct HashEntry<KeyValuePair<K, V> >
+      {
+         typedef K Key;
+         static inline const K& KeyOf(const KeyValuePair<K, V>& e) { return e.key; }
+         static inline bool Matches(const KeyValuePair<K, V>& e, const K& key) { return KeyEqual<K>::Of(e.key, key); }
+      };
+
+
+      ////////////////////
+      // Control Groups //
+      ////////////////////
+
+      /// Slots whose control bytes are compared at once
+      static const int HASH_GROUP = 16;
+
+      /// The control byte of an empty slot. Full slots hold seven bits of
+      /// hash, so the top bit alone marks the empty ones.
+      static const uint8_t HASH_EMPTY = 0x80;
+
+      /// Sixteen control bytes, from any position. Each match returns a 16
+      /// bit mask with bit i set if byte i matched.
+      struct HashGroup
+      {
+         #if defined(___SSE)
+         __m128i ctrl;
+         inline explicit HashGroup(const uint8_t * p) : ctrl(_mm_loadu_si128((const __m128i*)p)) {}
+         inline int Match(uint8_t h) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(char(h)))); }
+         inline int MatchEmpty() const { return _mm_movemask_epi8(ctrl); }
+         #else
+         const uint8_t * ctrl;
+         inline explicit HashGroup(const uint8_t * p) : ctrl(p) {}
+         inline int Match(uint8_t h) const
+         {
+            int m = 0;
+            for (int i = 0; i < HASH_GROUP; ++i) m |= int(ctrl[i] == h) << i;
+            return m;
+         }
+         inline int MatchEmpty() const
+         {
+            int m = 0;
+            for (int i = 0; i < HASH_GROUP; ++i) m |= int(ctrl[i] >> 7) << i;
+            return m;
+         }
+         #endif
+         inline int MatchFull() const { return ~MatchEmpty() & 0xFFFF; }
+      };
+
+
+      ///////////
+      // Slots //
+      ///////////
+
+      /// The control bytes and the slots of one table, reference counted
+      /// together. Only full slots hold a constructed element.
+      template <class E> class HashSlots : public Object
+      {
+      public:
+         int capacity;         //< A power of two, at least HASH_GROUP
+         int size;
+         uint8_t * control;    //< capacity + HASH_GROUP bytes
+         E * entries;
+
+         inline explicit HashSlots(int c)
+            : capacity(c), size(0)
+            , control((uint8_t*)malloc(c + HASH_GROUP))
+            , entries((E*)malloc(c * sizeof(E)))
+         {
+            assert(control && entries && (c & (c - 1)) == 0 && c >= HASH_GROUP);
+            memset(control, HASH_EMPTY, c + HASH_GROUP);
+         }
+
+         inline ~HashSlots()
+         {
+            if (!std::is_trivially_destructible<E>::value)
+               for (int i = 0; i < capacity; ++i) if (control[i] != HASH_EMPTY) entries[i].~E();
+            free(control); free(entries);
+         }
+
+         inline bool IsFull(int i) const { return control[i] != HASH_EMPTY; }
+
+         /// Writes slot i's control byte, and its mirror if it has one
+         inline void SetControl(int i, uint8_t c)
+         {
+            control[i] = c;
+            if (i < HASH_GROUP) control[capacity + i] = c;
+         }
+      };
+
+
+      ///////////////
+      // HashTable //
+      ///////////////
+
+      /// Copies share the slots, and growing the table reallocates the arrays
+      /// inside them, so every copy sees every update: the containers built
+      /// on this have the reference semantics of the other mutable containers.
+      template <class E> class HashTable
+      {
+      public:
+         typedef typename HashEntry<E>::Key K;
+         typedef HashSlots<E> Slots;
+
+         Ref<Slots> _slots;
+
+         /// Smallest table that holds n elements at no more than 3/4 full
+         static inline int CapacityFor(int n)
+         {
+            int c = HASH_GROUP;
+            while (c - c/4 < n) c *= 2;
+            return c;
+         }
+
+      private:
+         static inline uint64_t hash(const K& key) { return Hash<K>::Of(key); }
+         static inline uint8_t control(uint64_t h) { return uint8_t(h & 0x7F); }
+         static inline int home(uint64_t h, int capacity) { return int(h >> 7) & (capacity - 1); }
+
+         /// The first empty slot of s at or after the home slot of h
+         static int firstEmpty(const Slots& s, uint64_t h)
+         {
+            const int mask = s.capacity - 1;
+            for (int p = home(h, s.capacity); ; p = (p + HASH_GROUP) & mask)
+            {
+               const int m = HashGroup(s.control + p).MatchEmpty();
+               if (m) return (p + __builtin_ctz(m)) & mask;
+            }
+         }
+
+         /// Moves every element into new arrays of the given capacity
+         void rehash(int capacity);
+
+      public:
+         inline explicit HashTable(int allocation = 0) : _slots(new Slots(CapacityFor(allocation))) {}
+
+         /// A moved-from table has no slots, and is empty
+         inline int Size() const { return _slots ? _slots->size : 0; }
+         inline int Capacity() const { return _slots->capacity; }
+         inline const E& At(int slot) const { return _slots->entries[slot]; }
+
+         /// The slot holding key, or -1
+         int Find(const K& key) const
+         {
+            const Slots& s = *_slots;
+            const int mask = s.capacity - 1;
+            const uint64_t h = hash(key);
+            const uint8_t c = control(h);
+            for (int p = home(h, s.capacity); ; p = (p + HASH_GROUP) & mask)
+            {
+               const HashGroup g(s.control + p);
+               for (int m = g.Match(c); m; m &= m - 1)
+               {
+                  const int i = (p + __builtin_ctz(m)) & mask;
+                  if (HashEntry<E>::Matches(s.entries[i], key)) return i;
+               }
+               if (g.MatchEmpty()) return -1;
+            }
+         }
+
+         /// Returns true if the element was added. An element whose key is
+         /// already present is replaced if 'replace' is set, else left alone.
+         bool Insert(const E& e, bool replace);
+
+         /// Returns true if the key was present
+         bool Remove(const K& key);
+
+         /// Grows the table so that it holds n elements without rehashing
+         inline void Reserve(int n) { if (CapacityFor(n) > _slots->capacity) rehash(CapacityFor(n)); }
+
+         /// Removes every element, in the slots that all copies share
+         void Clear();
+
+         /// Whether t is this table or a copy of it, sharing its slots
+         inline bool Shares(const HashTable& t) const { return _slots == t._slots; }
+
+         /// Copies the slots, for the functional updates and Copy()
+         HashTable Clone() const;
+      };
+
+      template <class E> bool HashTable<E>::Insert(const E& e, bool replace)
+      {
+         const int found = Find(HashEntry<E>::KeyOf(e));
+         if (found != -1)
+         {
+            if (replace) _slots->entries[found] = e;
+            return false;
+         }
+
+         if (_slots->size + 1 > _slots->capacity - _slots->capacity/4) rehash(_slots->capacity * 2);
+
+         const uint64_t h = hash(HashEntry<E>::KeyOf(e));
+         const int i = firstEmpty(*_slots, h);
+         new (_slots->entries + i) E(e);
+         _slots->SetControl(i, control(h));
+         _slots->size++;
+         return true;
+      }
+
+      /// The elements after the gap move back into it unless that would put
+      /// them before their home slot, that is, unless their home is in the
+      /// part of the run between the gap and where they are now
+      template <class E> bool HashTable<E>::Remove(const K& key)
+      {
+         int gap = Find(key);
+         if (gap == -1) return false;
+
+         Slots& s = *_slots;
+         const int mask = s.capacity - 1;
+         s.entries[gap].~E();
+         for (int j = (gap + 1) & mask; s.IsFull(j); j = (j + 1) & mask)
+         {
+            const int h = home(hash(HashEntry<E>::KeyOf(s.entries[j])), s.capacity);
+            if (((j - h) & mask) < ((j - gap) & mask)) continue;
+            new (s.entries + gap) E(std::move(s.entries[j]));
+            s.entries[j].~E();
+            s.SetControl(gap, s.control[j]);
+            gap = j;
+         }
+         s.SetControl(gap, HASH_EMPTY);
+         s.size--;
+         return true;
+      }
+
+      /// The elements are moved into a temporary set of slots, whose arrays
+      /// are then swapped with the table's, so the old arrays, emptied, are
+      /// freed with the temporary
+      template <class E> void HashTable<E>::rehash(int capacity)
+      {
+         Slots& s = *_slots;
+         Slots grown(capacity);
+         for (int i = 0; i < s.capacity; ++i)
+         {
+            if (!s.IsFull(i)) continue;
+            const uint64_t h = hash(HashEntry<E>::KeyOf(s.entries[i]));
+            const int j = firstEmpty(grown, h);
+            new (grown.entries + j) E(std::move(s.entries[i]));
+            s.entries[i].~E();
+            grown.SetControl(j, control(h));
+         }
+         memset(s.control, HASH_EMPTY, s.capacity + HASH_GROUP);
+         std::swap(s.capacity, grown.capacity);
+         std::swap(s.control, grown.control);
+         std::swap(s.entries, grown.entries);
+      }
+
+      template <class E> void HashTable<E>::Clear()
+      {
+         Slots& s = *_slots;
+         if (!std::is_trivially_destructible<E>::value)
+            for (int i = 0; i < s.capacity; ++i) if (s.IsFull(i)) s.entries[i].~E();
+         memset(s.control, HASH_EMPTY, s.capacity + HASH_GROUP);
+         s.size = 0;
+      }
+
+      /// The copy keeps the layout, so no element is hashed again
+      template <class E> HashTable<E> HashTable<E>::Clone() const
+      {
+         const Slots& s = *_slots;
+         HashTable t(*this);
+         t._slots = new Slots(s.capacity);
+         memcpy(t._slots->control, s.control, s.capacity + HASH_GROUP);
+         for (int i = 0; i < s.capacity; ++i)
+            if (s.IsFull(i)) new (t._slots->entries + i) E(s.entries[i]);
+         t._slots->size = s.size;
+         return t;
+      }
+
+
+      ///////////////
+      // Iterators //
+      ///////////////
+
+      /// Visits the full slots in slot order, skipping sixteen empty slots
+      /// at a time. The iterator holds on to the slots, so it stays safe to
+      /// use while the table changes: a slot emptied under it, by a removal
+      /// or by growth into new arrays, is skipped rather than read. Adding
+      /// or removing elements while iterating may still skip or repeat some,
+      /// and growing the table moves the elements that Next() returned
+      /// references to.
+      template <class E> class HashIterator
+      {
+      protected:
+         friend class Mutable::HashSet<E>;
+         template <class A, class B> friend class Mutable::HashMap;
+
+         Ref<HashSlots<E> > _slots;
+         mutable int _slot;   //< The next full slot, or the capacity at the end
+
+         inline void seek(int i) const
+         {
+            const HashSlots<E>& s = *_slots;
+            for (; i < s.capacity; i += HASH_GROUP)
+            {
+               const int m = HashGroup(s.control + i).MatchFull();
+               if (m) { i += __builtin_ctz(m); break; }
+            }
+            _slot = i < s.capacity ? i : s.capacity;
+         }
+
+         /// Moves on from a slot that was emptied since the iterator got there
+         inline void settle() const
+         { if (_slot < _slots->capacity && !_slots->IsFull(_slot)) seek(_slot); }
+
+         inline HashIterator(const HashTable<E>& t) : _slots(t._slots), _slot(0) { seek(0); }
+
+         /// Positioned at a slot found by the table, or exhausted for -1
+         inline HashIterator(const HashTable<E>& t, int slot)
+            : _slots(t._slots), _slot(slot == -1 ? t.Capacity() : slot) {}
+
+      public:
+         inline bool HasNext() const { settle(); return _slot < _slots->capacity; }
+
+         inline const E& Next()
+         {
+            assert(HasNext());
+            settle();
+            const E& e = _slots->entries[_slot];
+            seek(_slot + 1);
+            return e;
+         }
+
+         inline const E& Peek() const { assert(HasNext()); settle(); return _slots->entries[_slot]; }
+
+         /// We provide an auto cast to bool operator, which signals if an
+         /// iterator points to a valid item or not, so that Contains() can be
+         /// used as if it returned a bool
+         inline operator bool() const { return HasNext(); }
+      };
+
+
+      //////////////
+      // Builders //
+      //////////////
+
+      /// Builds a HashSet<E> or a HashMap<K, V> (for E = KeyValuePair<K, V>),
+      /// keeping the first of any duplicates, as the other builders do. The
+      /// expected size is reserved up front, so a builder given the right
+      /// size never rehashes.
+      template <class E, class C> class HashBuilder
+      {
+      private:
+         HashTable<E> _table;
+
+         /// Flag goes true when the result has been returned and the
+         /// builder can no longer be used (it is disposable)
+         bool _complete;
+
+      public:
+         inline HashBuilder(int expectedSize = 1) : _table(expectedSize), _complete(false) {}
+
+         inline bool AddElement(const E& e)
+         {
+            assert(!_complete);
+            return _table.Insert(e, false);
+         }
+
+         inline int Size() const { return _table.Size(); }
+
+         inline C Result() { _complete = true; return C(std::move(_table)); }
+      };
+   }
+}
+
+#endif // HASH_COMMON_H
@@ -0,0 +1,145 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+
+#include "Map.h"
+#include "HashSet.h"
+
+/////////////////////////////////////////
+// Class HashMap <- Map <- Traversable //
+/////////////////////////////////////////
+
+namespace Collections
+{
+   namespace Immutable
+   {
+      template <class K, class V> struct HashMapTraits
+      {
+         typedef Common::HashTrieIterator<Common::KeyValuePair<K, V> > Iterator;
+         typedef Common::HashTrieBuilder<Common::KeyValuePair<K, V>, HashMap<K, V> > Builder;
+         typedef HashSet<K> SetType;
+      };
+
+      /// A persistent unordered map with O(log32 n) lookups and updates, for
+      /// keys with a Common::Hash, and the key-value pairs stored in the trie
+      /// nodes. Versions share all the nodes that an update does not touch.
+      /// See HashTrieCommon.h.
+      template <class K, class V>
+      class HashMap : public Map<K, V, HashMap<K, V>, HashMapTraits<K, V> >
+      {
+      public:
+
+         friend class Common::HashTrieBuilder<Common::KeyValuePair<K, V>, HashMap<K, V> >;
+
+         template <class U> struct SwapElementType { typedef HashMap<K, U> C; };
+
+         typedef Common::KeyValuePair<K, V> ElementType;
+         typedef Common::HashTrie<Common::KeyValuePair<K, V> > Trie;
+         typedef Common::HashTrieNode<Common::KeyValuePair<K, V> > Node;
+         typedef Common::HashTrieIterator<Common::KeyValuePair<K, V> > Iterator;
+         typedef Common::HashTrieBuilder<Common::KeyValuePair<K, V>, HashMap<K, V> > Builder;
+
+         /// The set container that corresponds to the HashMap<K, V> is HashSet<K>
+         typedef HashSet<K> SetType;
+
+      private:
+
+         int _size;  //< Number of mappings, for efficiency
+         Ref<Node> _root;
+
+         inline HashMap(int size, Ref<Node>&& root)
+            : _size(size)
+            , _root(std::move(root)) {}
+
+      public:
+
+         ///////////////////////////////////////////
+         // Copy Constructor, Reference Semantics //
+         ///////////////////////////////////////////
+
+         inline HashMap() : _size(0), _root(new Node) {}
+
+         /// The root's reference counter is automatically incremented
+         inline HashMap(const HashMap& rhs)
+            : _size(rhs._size)
+            , _root(rhs._root) {}
+
+         //////////////////////////////////////////////
+         // Assignment Operator, Reference Semantics //
+         //////////////////////////////////////////////
+
+         inline HashMap& operator = (const HashMap& rhs)
+         { _root = rhs._root; _size = rhs._size; return *this; }
+
+         /// Moves take over the root without touching its reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline HashMap(HashMap&& rhs)
+            : _size(rhs._size)
+            , _root(std::move(rhs._root)) { rhs._size = 0; }
+
+         inline HashMap& operator = (HashMap&& rhs)
+         {
+            _root = std::move(rhs._root); _size = rhs._size;
+            rhs._size = 0;
+            return *this;
+         }
+
+
+         ////////////////////////////////
+         // Inherited From Traversable //
+         ////////////////////////////////
+
+         virtual int Size() const { return _size; }
+         virtual Iterator GetIterator() const { return Iterator(_root); }
+
+
+         ////////////////////////
+         // Inherited From Map //
+         ////////////////////////
+
+         /// O(log32 n)
+         virtual bool Contains(const K& key) const { return Trie::Find(_root, key) != nullptr; }
+
+         virtual const V& GetOrElse(const K& key, const V& otherwise) const
+         {
+            const ElementType * e = Trie::Find(_root, key);
+            return e ? e->value : otherwise;
+         }
+
+         /// O(log32 n), the new map shares all but the nodes on the path to
+         /// the key. A key already present has its value replaced.
+         virtual HashMap<K, V> Insert(const K& key, const V& value) const;
+         virtual HashMap<K, V> Remove(const K& key) const;
+
+         virtual SetType Keys() const;
+      };
+
+
+      template <class K, class V> typename HashMap<K, V>::SetType HashMap<K, V>::Keys() const
+      {
+         typename SetType::Builder builder(_size);
+         Iterator iterator = this->GetIterator();
+         while (iterator.HasNext()) builder.AddElement(iterator.Next().key);
+         return builder.Result();
+      }
+
+      template <class K, class V> HashMap<K, V>
+      HashMap<K, V>::Insert(const K& key, const V& value) const
+      {
+         Ref<Node> root = _root;
+         const typename Trie::Change change =
+            Trie::Insert(root, ElementType(key, value), Trie::HashOf(key), 0, true, false);
+         return HashMap(change == Trie::ADDED ? _size + 1 : _size, std::move(root));
+      }
+
+      template <class K, class V> HashMap<K, V>
+      HashMap<K, V>::Remove(const K& key) const
+      {
+         Ref<Node> root = _root;
+         if (!Trie::Remove(root, key, Trie::HashOf(key), 0, false)) return *this;
+         return HashMap(_size - 1, std::move(root));
+      }
+
+   } // namespace Immutable
+} // namespace Collections
+
+#endif // HASH_MAP_H
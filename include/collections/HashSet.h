@@ -0,0 +1,189 @@
+#ifndef HASH_SET_H
+#define HASH_SET_H
+
+#include "Set.h"
+#include "HashTrieCommon.h"
+
+/////////////////////////////////////////
+// Class HashSet <- Set <- Traversable //
+/////////////////////////////////////////
+
+namespace Collections
+{
+   namespace Immutable
+   {
+      template <class E> struct HashSetTraits
+      {
+         typedef Common::HashTrieIterator<E> Iterator;
+         typedef Common::HashTrieBuilder<E, HashSet<E> > Builder;
+      };
+
+      /// A persistent unordered set with O(log32 n) Contains, Insert and
+      /// Remove, for elements with a Common::Hash. A new version shares all
+      /// but the few trie nodes on the path to the element it changes with
+      /// the version it came from. Iteration is in no particular order, but
+      /// two sets with the same elements iterate in the same order. See
+      /// HashTrieCommon.h.
+      template <class E>
+      class HashSet : public Set<E, HashSet<E>, HashSetTraits<E> >
+      {
+      public:
+
+         friend class Common::HashTrieBuilder<E, HashSet<E> >;
+
+         typedef E ElementType;
+         typedef Common::HashTrie<E> Trie;
+         typedef Common::HashTrieNode<E> Node;
+         typedef Common::HashTrieIterator<E> Iterator;
+         typedef Common::HashTrieBuilder<E, HashSet<E> > Builder;
+
+         template <class U> struct SwapElementType { typedef HashSet<U> C; };
+
+      private:
+
+         int _size;  //< Number of elements, for efficiency
+         Ref<Node> _root;
+
+         inline HashSet(int size, Ref<Node>&& root)
+            : _size(size)
+            , _root(std::move(root)) {}
+
+      public:
+
+         ///////////////////////////////////////////
+         // Copy Constructor, Reference Semantics //
+         ///////////////////////////////////////////
+
+         inline HashSet() : _size(0), _root(new Node) {}
+
+         /// The root's reference counter is automatically incremented
+         inline HashSet(const HashSet& rhs)
+            : _size(rhs._size)
+            , _root(rhs._root) {}
+
+         //////////////////////////////////////////////
+         // Assignment Operator, Reference Semantics //
+         //////////////////////////////////////////////
+
+         inline HashSet& operator = (const HashSet& rhs)
+         { _root = rhs._root; _size = rhs._size; return *this; }
+
+         /// Moves take over the root without touching its reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline HashSet(HashSet&& rhs)
+            : _size(rhs._size)
+            , _root(std::move(rhs._root)) { rhs._size = 0; }
+
+         inline HashSet& operator = (HashSet&& rhs)
+         {
+            _root = std::move(rhs._root); _size = rhs._size;
+            rhs._size = 0;
+            return *this;
+         }
+
+
+         ////////////////////////////////
+         // Inherited From Traversable //
+         ////////////////////////////////
+
+         virtual int Size() const { return _size; }
+         virtual Iterator GetIterator() const { return Iterator(_root); }
+
+
+         ////////////////////////
+         // Inherited From Set //
+         ////////////////////////
+
+         /// O(log32 n)
+         virtual Iterator Contains(const E& element) const { return Iterator(_root, element); }
+
+         /// These start from a copy of one set's root and insert or remove
+         /// the other's elements: the first change to each node copies it,
+         /// and the changes after that find the copy unshared and change it
+         /// in place. O(m log32 n), for m the smaller size where it can be.
+         virtual HashSet<E> Union(const HashSet<E>& set) const;
+         virtual HashSet<E> Intersection(const HashSet<E>& set) const;
+         virtual HashSet<E> Difference(const HashSet<E>& set) const;
+
+         /// O(log32 n), the new set shares all but the nodes on the path to e
+         virtual HashSet<E> Insert(const E& element) const;
+         virtual HashSet<E> Remove(const E& element) const;
+      };
+
+
+      template <class E> HashSet<E> HashSet<E>::Insert(const E& e) const
+      {
+         Ref<Node> root = _root;
+         if (Trie::Insert(root, e, Trie::HashOf(e), 0, false, false) == Trie::UNCHANGED) return *this;
+         return HashSet(_size + 1, std::move(root));
+      }
+
+      template <class E> HashSet<E> HashSet<E>::Remove(const E& e) const
+      {
+         Ref<Node> root = _root;
+         if (!Trie::Remove(root, e, Trie::HashOf(e), 0, false)) return *this;
+         return HashSet(_size - 1, std::move(root));
+      }
+
+      template <class E> HashSet<E> HashSet<E>::Union(const HashSet<E>& set) const
+      {
+         if (_size < set._size) return set.Union(*this);
+
+         int size = _size;
+         Ref<Node> root = _root;
+         Iterator itr = set.GetIterator();
+         while (itr.HasNext())
+         {
+            const E& e = itr.Next();
+            if (Trie::Insert(root, e, Trie::HashOf(e), 0, false, true) == Trie::ADDED) size++;
+         }
+         return HashSet(size, std::move(root));
+      }
+
+      template <class E> HashSet<E> HashSet<E>::Intersection(const HashSet<E>& set) const
+      {
+         if (_size > set._size) return set.Intersection(*this);
+
+         Builder builder(_size);
+         Iterator itr = this->GetIterator();
+         while (itr.HasNext())
+         {
+            const E& e = itr.Next();
+            if (Trie::Find(set._root, e)) builder.AddElement(e);
+         }
+         return builder.Result();
+      }
+
+      template <class E> HashSet<E> HashSet<E>::Difference(const HashSet<E>& set) const
+      {
+         if (_size == 0 || set._size == 0) return *this;
+
+         /// Removing the elements of the smaller set, or building from the
+         /// elements of this one not in the larger
+         if (set._size > _size)
+         {
+            Builder builder(_size);
+            Iterator itr = this->GetIterator();
+            while (itr.HasNext())
+            {
+               const E& e = itr.Next();
+               if (!Trie::Find(set._root, e)) builder.AddElement(e);
+            }
+            return builder.Result();
+         }
+
+         int size = _size;
+         Ref<Node> root = _root;
+         Iterator itr = set.GetIterator();
+         while (itr.HasNext())
+         {
+            const E& e = itr.Next();
+            if (Trie::Remove(root, e, Trie::HashOf(e), 0, true)) size--;
+         }
+         return HashSet(size, std::move(root));
+      }
+
+   } // namespace Immutable
+} // namespace Collections
+
+#endif // HASH_SET_H
@@ -0,0 +1,453 @@
+#ifndef HASH_TRIE_COMMON_H
+#define HASH_TRIE_COMMON_H
+
+#include <stdint.h>
+
+#include "../math/Bits.h"
+#include "HashCommon.h"
+
+/// The immutable hash containers are hash array mapped tries: each level of
+/// the trie takes the next five bits of an element's hash, and a node has
+/// up to 32 entries, one per value of those bits. Which entries are present
+/// is kept in a 32 bit map, and the entries themselves are packed in order,
+/// so entry 'bit' is at the count of set bits below it (Mathematics::BitCount,
+/// a popcnt). Following Steindorfer and Vinju's CHAMP layout, a node keeps
+/// two maps and two packed arrays: elements stored in the node itself, and
+/// child nodes, so that iteration and lookups find the elements of a node
+/// together. A million elements need four or five levels.
+///
+/// Nodes are reference counted Objects and are never changed once they are
+/// shared. An update copies only the nodes on the path to the element it
+/// changes, O(log32 n) of them, and the new version shares everything else
+/// with the old one, which stays valid. A node whose reference count is one
+/// belongs to nobody else, so updates through a path of such nodes, as when
+/// a builder bulk loads a new trie, change the nodes in place: the trie is
+/// transient while it is being built, and persistent once it is shared.
+///
+/// Removal keeps the trie canonical: a child left holding one element is
+/// folded back into its parent, so a set's shape, and its iteration order,
+/// depend only on the elements it holds. Elements whose 64 bit hashes are
+/// equal end up together in a collision node below the last level, searched
+/// in turn.
+
+namespace Collections
+{
+   namespace Immutable
+   {
+      template <class E> class HashSet;
+      template <class K, class V> class HashMap;
+   }
+
+   namespace Common
+   {
+      /// Hash bits taken per level, and the levels before hashes run out
+      static const int HASH_TRIE_BITS = 5;
+      static const int HASH_TRIE_DEPTH = 64 / HASH_TRIE_BITS + 2;   //< With the collision level
+
+      /// Moves the n elements of a to a new array with x at position i
+      template <class T> inline T * HashTrieInsertAt(T * a, int n, int i, const T& x)
+      {
+         T * b = (T*)malloc((n + 1) * sizeof(T));
+         assert(b);
+         new (b + i) T(x);
+         for (int k = 0; k < n; ++k) { new (b + (k < i ? k : k + 1)) T(std::move(a[k])); a[k].~T(); }
+         free(a);
+         return b;
+      }
+
+      /// Moves all but element i of the n elements of a to a new array
+      template <class T> inline T * HashTrieRemoveAt(T * a, int n, int i)
+      {
+         T * b = (T*)malloc((n > 1 ? n - 1 : 1) * sizeof(T));
+         assert(b);
+         for (int k = 0; k < n; ++k)
+         {
+            if (k != i) new (b + (k < i ? k : k - 1)) T(std::move(a[k]));
+            a[k].~T();
+         }
+         free(a);
+         return b;
+      }
+
+
+      ///////////
+      // Nodes //
+      ///////////
+
+      template <class E> class HashTrieNode : public Object
+      {
+      public:
+         typedef Ref<HashTrieNode> Child;
+
+         uint32_t dataMap, nodeMap;   //< Both zero in a collision node
+         int dataCount, nodeCount;
+         E * data;
+         Child * children;
+
+         inline HashTrieNode()
+            : dataMap(0), nodeMap(0), dataCount(0), nodeCount(0)
+            , data(nullptr), children(nullptr) {}
+
+         /// The copy shares the children
+         HashTrieNode(const HashTrieNode& n)
+            : Object()
+            , dataMap(n.dataMap), nodeMap(n.nodeMap), dataCount(n.dataCount), nodeCount(n.nodeCount)
+            , data((E*)malloc((n.dataCount > 0 ? n.dataCount : 1) * sizeof(E)))
+            , children((Child*)malloc((n.nodeCount > 0 ? n.nodeCount : 1) * sizeof(Child)))
+         {
+            for (int i = 0; i < dataCount; ++i) new (data + i) E(n.data[i]);
+            for (int i = 0; i < nodeCount; ++i) new (children + i) Child(n.children[i]);
+         }
+
+         ~HashTrieNode()
+         {
+            for (int i = 0; i < dataCount; ++i) data[i].~E();
+            for (int i = 0; i < nodeCount; ++i) children[i].~Child();
+            free(data); free(children);
+         }
+
+         /// The position of the entry for bit among the entries of map
+         static inline int Index(uint32_t map, uint32_t bit) { return Mathematics::BitCount(map & (bit - 1)); }
+
+         inline void InsertData(int i, const E& e) { data = HashTrieInsertAt(data, dataCount++, i, e); }
+         inline void RemoveData(int i) { data = HashTrieRemoveAt(data, dataCount--, i); }
+         inline void InsertChild(int i, const Child& c) { children = HashTrieInsertAt(children, nodeCount++, i, c); }
+         inline void RemoveChild(int i) { children = HashTrieRemoveAt(children, nodeCount--, i); }
+      };
+
+
+      //////////////
+      // HashTrie //
+      //////////////
+
+      template <class E> class HashTrie
+      {
+      public:
+         typedef typename HashEntry<E>::Key K;
+         typedef HashTrieNode<E> Node;
+         typedef Ref<Node> NodeRef;
+
+         /// What an insertion did
+         enum Change { UNCHANGED, ADDED, REPLACED };
+
+         static inline uint64_t HashOf(const K& key) { return Hash<K>::Of(key); }
+         static inline uint32_t BitOf(uint64_t h, int shift) { return 1u << ((h >> shift) & 31); }
+
+      private:
+         /// The node to change: ref itself if nothing else shares it, else a
+         /// copy, which ref is pointed at
+         static inline Node * edit(NodeRef& ref, bool unique)
+         {
+            if (!unique) ref = new Node(*ref);
+            return ref;
+         }
+
+         /// A node at 'shift' holding the two elements
+         static NodeRef pair(const E& a, uint64_t ha, const E& b, uint64_t hb, int shift);
+
+      public:
+         /// The element with key, or nullptr
+         static const E * Find(const Node * n, const K& key);
+
+         /// Inserts e below ref, which is the node at 'shift'. Nodes that are
+         /// not shared, while 'transient' is set, are changed in place; the
+         /// others are copied. A key already present takes the new element if
+         /// 'replace' is set.
+         static Change Insert(NodeRef& ref, const E& e, uint64_t h, int shift, bool replace, bool transient);
+
+         /// Returns true if the key was present
+         static bool Remove(NodeRef& ref, const K& key, uint64_t h, int shift, bool transient);
+      };
+
+      template <class E> typename HashTrie<E>::NodeRef
+      HashTrie<E>::pair(const E& a, uint64_t ha, const E& b, uint64_t hb, int shift)
+      {
+         NodeRef n = new Node;
+         if (shift >= 64) { n->InsertData(0, a); n->InsertData(1, b); return n; }
+
+         const uint32_t bitA = BitOf(ha, shift), bitB = BitOf(hb, shift);
+         if (bitA == bitB)
+         {
+            n->InsertChild(0, pair(a, ha, b, hb, shift + HASH_TRIE_BITS));
+            n->nodeMap = bitA;
+         }
+         else
+         {
+            n->InsertData(0, bitA < bitB ? a : b);
+            n->InsertData(1, bitA < bitB ? b : a);
+            n->dataMap = bitA | bitB;
+         }
+         return n;
+      }
+
+      template <class E> const E * HashTrie<E>::Find(const Node * n, const K& key)
+      {
+         const uint64_t h = HashOf(key);
+         for (int shift = 0; shift < 64; shift += HASH_TRIE_BITS)
+         {
+            const uint32_t bit = BitOf(h, shift);
+            if (n->dataMap & bit)
+            {
+               const E& e = n->data[Node::Index(n->dataMap, bit)];
+               return HashEntry<E>::Matches(e, key) ? &e : nullptr;
+            }
+            if (!(n->nodeMap & bit)) return nullptr;
+            n = n->children[Node::Index(n->nodeMap, bit)];
+         }
+         for (int i = 0; i < n->dataCount; ++i)
+            if (HashEntry<E>::Matches(n->data[i], key)) return n->data + i;
+         return nullptr;
+      }
+
+      template <class E> typename HashTrie<E>::Change
+      HashTrie<E>::Insert(NodeRef& ref, const E& e, uint64_t h, int shift, bool replace, bool transient)
+      {
+         const K& key = HashEntry<E>::KeyOf(e);
+         const bool unique = transient && ref->RefCount() == 1;
+
+         if (shift >= 64)
+         {
+            for (int i = 0; i < ref->dataCount; ++i)
+            {
+               if (!HashEntry<E>::Matches(ref->data[i], key)) continue;
+               if (!replace) return UNCHANGED;
+               edit(ref, unique)->data[i] = e;
+               return REPLACED;
+            }
+            Node * n = edit(ref, unique);
+            n->InsertData(n->dataCount, e);
+            return ADDED;
+         }
+
+         const uint32_t bit = BitOf(h, shift);
+         if (ref->dataMap & bit)
+         {
+            const int i = Node::Index(ref->dataMap, bit);
+            if (HashEntry<E>::Matches(ref->data[i], key))
+            {
+               if (!replace) return UNCHANGED;
+               edit(ref, unique)->data[i] = e;
+               return REPLACED;
+            }
+
+            /// Both elements move down into a new child
+            NodeRef child = pair(ref->data[i], HashOf(HashEntry<E>::KeyOf(ref->data[i])), e, h, shift + HASH_TRIE_BITS);
+            Node * n = edit(ref, unique);
+            n->RemoveData(i);
+            n->dataMap ^= bit;
+            n->InsertChild(Node::Index(n->nodeMap, bit), child);
+            n->nodeMap |= bit;
+            return ADDED;
+         }
+
+         if (ref->nodeMap & bit)
+         {
+            const int j = Node::Index(ref->nodeMap, bit);
+            if (unique) return Insert(ref->children[j], e, h, shift + HASH_TRIE_BITS, replace, true);
+
+            NodeRef child = ref->children[j];
+            const Change change = Insert(child, e, h, shift + HASH_TRIE_BITS, replace, false);
+            if (change != UNCHANGED) edit(ref, false)->children[j] = child;
+            return change;
+         }
+
+         Node * n = edit(ref, unique);
+         n->InsertData(Node::Index(n->dataMap, bit), e);
+         n->dataMap |= bit;
+         return ADDED;
+      }
+
+      template <class E>
+      bool HashTrie<E>::Remove(NodeRef& ref, const K& key, uint64_t h, int shift, bool transient)
+      {
+         const bool unique = transient && ref->RefCount() == 1;
+
+         if (shift >= 64)
+         {
+            for (int i = 0; i < ref->dataCount; ++i)
+            {
+               if (!HashEntry<E>::Matches(ref->data[i], key)) continue;
+               edit(ref, unique)->RemoveData(i);
+               return true;
+            }
+            return false;
+         }
+
+         const uint32_t bit = BitOf(h, shift);
+         if (ref->dataMap & bit)
+         {
+            const int i = Node::Index(ref->dataMap, bit);
+            if (!HashEntry<E>::Matches(ref->data[i], key)) return false;
+            Node * n = edit(ref, unique);
+            n->RemoveData(i);
+            n->dataMap ^= bit;
+            return true;
+         }
+
+         if (!(ref->nodeMap & bit)) return false;
+
+         const int j = Node::Index(ref->nodeMap, bit);
+         NodeRef child = ref->children[j];
+         if (unique) ref->children[j] = nullptr;   //< So that the child stays unique
+         if (!Remove(child, key, h, shift + HASH_TRIE_BITS, unique))
+         {
+            if (unique) ref->children[j] = std::move(child);
+            return false;
+         }
+
+         Node * n = edit(ref, unique);
+         if (child->nodeCount == 0 && child->dataCount == 1)
+         {
+            /// A child left with one element folds back into this node
+            const E e = child->data[0];
+            n->RemoveChild(j);
+            n->nodeMap ^= bit;
+            n->InsertData(Node::Index(n->dataMap, bit), e);
+            n->dataMap |= bit;
+         }
+         else n->children[j] = std::move(child);
+         return true;
+      }
+
+
+      ///////////////
+      // Iterators //
+      ///////////////
+
+      /// Depth first, each node's own elements before its children's. The
+      /// iterator holds the root, and so the whole version it iterates.
+      template <class E> class HashTrieIterator
+      {
+      protected:
+         friend class Immutable::HashSet<E>;
+         template <class A, class B> friend class Immutable::HashMap;
+
+         typedef HashTrieNode<E> Node;
+
+         Ref<Node> _root;
+         const Node * _nodes[HASH_TRIE_DEPTH];
+         int _next[HASH_TRIE_DEPTH];   //< Next entry of each node, elements then children
+         int _depth;
+         const E * _current;
+
+         /// Moves on to the next element, down into children and back up
+         inline void advance()
+         {
+            while (_depth >= 0)
+            {
+               const Node * n = _nodes[_depth];
+               int& i = _next[_depth];
+               if (i < n->dataCount) { _current = n->data + i++; return; }
+               if (i < n->dataCount + n->nodeCount)
+               {
+                  const Node * child = n->children[i++ - n->dataCount];
+                  _depth++;
+                  _nodes[_depth] = child; _next[_depth] = 0;
+               }
+               else _depth--;
+            }
+            _current = nullptr;
+         }
+
+         inline HashTrieIterator(const Ref<Node>& root) : _root(root), _depth(0)
+         { _nodes[0] = root; _next[0] = 0; advance(); }
+
+         /// Positioned at the element with key, so that iteration carries on
+         /// from there. The iterator is exhausted if key is not present.
+         HashTrieIterator(const Ref<Node>& root, const typename HashEntry<E>::Key& key);
+
+      public:
+         inline bool HasNext() const { return _current != nullptr; }
+
+         inline const E& Next()
+         {
+            assert(HasNext());
+            const E& e = *_current;
+            advance();
+            return e;
+         }
+
+         inline const E& Peek() const { assert(HasNext()); return *_current; }
+
+         /// We provide an auto cast to bool operator, which signals if an
+         /// iterator points to a valid item or not, so that Contains() can be
+         /// used as if it returned a bool
+         inline operator bool() const { return HasNext(); }
+      };
+
+      template <class E> HashTrieIterator<E>::HashTrieIterator(const Ref<Node>& root, const typename HashEntry<E>::Key& key)
+         : _root(root), _depth(0), _current(nullptr)
+      {
+         const uint64_t h = HashTrie<E>::HashOf(key);
+         const Node * n = root;
+         for (int shift = 0; ; shift += HASH_TRIE_BITS)
+         {
+            _nodes[_depth] = n;
+            int i = -1;
+            if (shift >= 64)
+            {
+               for (int k = 0; k < n->dataCount && i == -1; ++k)
+                  if (HashEntry<E>::Matches(n->data[k], key)) i = k;
+            }
+            else
+            {
+               const uint32_t bit = HashTrie<E>::BitOf(h, shift);
+               if (n->dataMap & bit)
+               {
+                  const int k = Node::Index(n->dataMap, bit);
+                  if (HashEntry<E>::Matches(n->data[k], key)) i = k;
+               }
+               else if (n->nodeMap & bit)
+               {
+                  const int j = Node::Index(n->nodeMap, bit);
+                  _next[_depth++] = n->dataCount + j + 1;
+                  n = n->children[j];
+                  continue;
+               }
+            }
+            if (i == -1) { _depth = -1; return; }
+            _next[_depth] = i + 1;
+            _current = n->data + i;
+            return;
+         }
+      }
+
+
+      //////////////
+      // Builders //
+      //////////////
+
+      /// Builds an Immutable::HashSet<E> or HashMap<K, V> (for E =
+      /// KeyValuePair<K, V>) in place, keeping the first of any duplicates,
+      /// as the other builders do. Nothing else can see the trie until
+      /// Result(), so every insertion changes its nodes in place.
+      template <class E, class C> class HashTrieBuilder
+      {
+      private:
+         Ref<HashTrieNode<E> > _root;
+         int _size;
+
+         /// Flag goes true when the result has been returned and the
+         /// builder can no longer be used (it is disposable)
+         bool _complete;
+
+      public:
+         inline HashTrieBuilder(int = 1) : _root(new HashTrieNode<E>), _size(0), _complete(false) {}
+
+         inline bool AddElement(const E& e)
+         {
+            assert(!_complete);
+            const uint64_t h = HashTrie<E>::HashOf(HashEntry<E>::KeyOf(e));
+            if (HashTrie<E>::Insert(_root, e, h, 0, false, true) != HashTrie<E>::ADDED) return false;
+            _size++;
+            return true;
+         }
+
+         inline int Size() const { return _size; }
+
+         inline C Result() { _complete = true; return C(_size, std::move(_root)); }
+      };
+   }
+}
+
+#endif // HASH_TRIE_COMMON_H
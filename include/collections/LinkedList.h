@@ -37,6 +37,7 @@ namespace Collections
       public:
          friend class Common::LinkedListIterator<E, LinkedList<E> >;
          friend class Common::LinkedListBuilder<E, LinkedList<E> >;
+         friend struct Common::Internals;
 
          typedef E ElementType;
          typedef Common::LinkedListIterator<E, LinkedList<E> > Iterator;
@@ -60,7 +61,7 @@ namespace Collections
             : _size(size)
             , _head(head)
             , _tail(tail)
-            , _nodePool(m) {}
+            , _nodePool(std::move(m)) {}
       
       public:
 
@@ -93,6 +94,24 @@ namespace Collections
             return *this; 
          }
 
+         /// Moves take over the node pool without touching its reference
+         /// counter. The moved-from list may only be assigned to or destroyed.
+         inline LinkedList(LinkedList&& rhs)
+            : _size(rhs._size)
+            , _head(rhs._head)
+            , _tail(rhs._tail)
+            , _nodePool(std::move(rhs._nodePool)) 
+         { rhs._size = 0; rhs._head = rhs._tail = -1; }
+
+         inline LinkedList& operator = (LinkedList&& rhs)
+         {  
+            _head = rhs._head; _tail = rhs._tail; 
+            _size = rhs._size; 
+            _nodePool = std::move(rhs._nodePool); 
+            rhs._size = 0; rhs._head = rhs._tail = -1;
+            return *this; 
+         }
+
 
          // Debug
          void Print() const;
@@ -128,7 +147,11 @@ namespace Collections
          virtual LinkedList<E> Prepend(const E& e) const;
          virtual LinkedList<E> Reverse() const;
 
-         friend LinkedList<E> Sorted(const LinkedList<E>& list);
+         /// O(N log N), stable. The elements are copied into a fresh pool,
+         /// merge sorted by relinking, then laid out in sorted order.
+         template <class F> LinkedList<E> SortedWith(F lessThan) const;
+
+         friend LinkedList<E> Sorted<>(const LinkedList<E>& list);
       };
 
 
@@ -177,6 +200,9 @@ namespace Collections
       }
       
       /// O(1)
+      /// Prepend and Append push into the node pool shared with other versions
+      /// of this list, so they must not race with each other across threads,
+      /// even when the reference counts are atomic
       template <class E> LinkedList<E> LinkedList<E>::Prepend(const E& e) const
       {
          // Push a new node into the memory pool, return new list
@@ -240,16 +266,26 @@ namespace Collections
          return newList;
       }
 
-      template <class E> LinkedList<E> Sorted(const LinkedList<E>& list)
+      template <class E> template <class F> 
+      LinkedList<E> LinkedList<E>::SortedWith(F lessThan) const
       {
-         typename LinkedList<E>::Builder builder = list.clone(list._size, list._size);
-         LinkedList<E> newList = builder.Result();
+         if (_size <= 1) return *this;
 
-         /// SORT HERE
-         assert(false);
+         Builder builder = this->clone(_size, _size);
+         LinkedList newList = builder.Result();
+
+         Common::MemoryPool<Node>& pool = *newList._nodePool;
+         int tail;
+         const int head = Common::MergeSortLinks(pool, newList._head, _size, lessThan, tail);
+         Common::LayOutInListOrder(pool, head, _size);
 
+         newList._head = 0;
+         newList._tail = _size-1;
          return newList;
       }
+
+      template <class E> LinkedList<E> Sorted(const LinkedList<E>& list)
+      { return list.SortedWith(Common::OperatorLessThan<E>()); }
    }
 }
 
@@ -7,6 +7,7 @@ namespace Collections
    namespace Immutable
    {
       template <class E> class LinkedList;
+      template <class E> LinkedList<E> Sorted(const LinkedList<E>& list);
    }
 
    namespace Mutable
@@ -36,6 +37,7 @@ namespace Collections
 
          inline LinkedListNode() : next(-1) {}
          inline LinkedListNode(const E& p, int n) : payload(p), next(n) {}            
+         inline LinkedListNode(E&& p, int n) : payload(std::move(p)), next(n) {}            
          inline ~LinkedListNode() {}
 
          inline bool operator == (const LinkedListNode& rhs) const
@@ -145,18 +147,61 @@ namespace Collections
             return *this;
          }
 
+         inline LinkedListBuilder(LinkedListBuilder&& rhs)
+            : _complete(rhs._complete)
+            , _size(rhs._size)
+            , _head(rhs._head)
+            , _tail(rhs._tail)
+            , _nodePool(std::move(rhs._nodePool)) { rhs._complete = true; }
+
+         inline LinkedListBuilder& operator = (LinkedListBuilder&& rhs)
+         {
+            _complete = rhs._complete;   _size = rhs._size;
+            _head = rhs._head;           _tail = rhs._tail;
+            _nodePool = std::move(rhs._nodePool);
+            rhs._complete = true;
+            return *this;
+         }
+
          // O(1)
          /// This is an append operation
-         inline void AddElement(E e)
+         inline void AddElement(const E& e) { append(LinkedListNode<E>(e, -1)); }
+         inline void AddElement(E&& e) { append(LinkedListNode<E>(std::move(e), -1)); }
+
+         inline void PrependElement(E e)
+         {
+            assert(!_complete);
+            _size++;
+
+            int newHead = _nodePool->Push(LinkedListNode<E>(std::move(e), _head));
+            if (_tail == -1) _tail = newHead;
+            _head = newHead;
+         }
+
+
+         /// The builder is disposable, so the node pool is handed to the
+         /// result rather than shared with it
+         inline C Result() 
+         { 
+            assert(!_complete); 
+            _complete = true;
+            C result = C(_size, _head, _tail, std::move(_nodePool));
+            _size = 0;
+            _head = _tail = -1;
+            return result;
+         }
+
+      private:
+
+         inline void append(LinkedListNode<E>&& node)
          {
             assert(!_complete);
             _size++;
 
-            _nodePool->Push(LinkedListNode<E>(e, -1));
-            int newTail = _nodePool->NextFreeIndex()-1;
+            int newTail = _nodePool->Push(std::move(node));
 
-            /// If newTail == 0, then this is the first entry
-            if (newTail == 0) _head = _tail = 0;
+            /// If there is no tail yet, then this is the first entry
+            if (_tail == -1) _head = _tail = newTail;
             else
             {
                assert(_tail != -1); assert(_head != -1);
@@ -164,30 +209,114 @@ namespace Collections
                _tail = newTail;
             }
          }
+      };
+
+
+      ////////////////////////////////////
+      // Merge Sort on Linked List Nodes //
+      ////////////////////////////////////
+
+      /// Merges the sorted lists a and b, both ending in -1, into one.
+      /// Ties go to a. Returns the head, and sets *tail unless it is null.
+      template <class E, class F>
+      inline int mergeLinks(MemoryPool<LinkedListNode<E> >& pool, int a, int b, F& lessThan, int * last)
+      {
+         int head, tail;
+         if (lessThan(pool.Index(b).payload, pool.Index(a).payload)) { head = tail = b; b = pool.Index(b).next; }
+         else                                                         { head = tail = a; a = pool.Index(a).next; }
+
+         while (a != -1 && b != -1)
+         {
+            int& next = pool.Index(tail).next;
+            if (lessThan(pool.Index(b).payload, pool.Index(a).payload)) { next = tail = b; b = pool.Index(b).next; }
+            else                                                         { next = tail = a; a = pool.Index(a).next; }
+         }
 
-         inline void PrependElement(E e)
+         if (a == -1) a = b;
+         pool.Index(tail).next = a;
+         if (last) { while (a != -1) { tail = a; a = pool.Index(a).next; } *last = tail; }
+         return head;
+      }
+
+      /// Stable merge sort of the 'size' nodes linked from 'head'. Only the
+      /// next indices change, no node or payload moves. Nodes are taken off
+      /// the front one at a time and carried up through a stack of sorted
+      /// runs of 1, 2, 4... nodes like a binary counter, so each merge works
+      /// on nodes that were touched recently and are likely still in cache.
+      /// O(N log N) comparisons, O(1) extra space. Returns the new head and
+      /// sets 'tail' to the new tail, whose next becomes -1.
+      template <class E, class F>
+      int MergeSortLinks(MemoryPool<LinkedListNode<E> >& pool, int head, int size, F lessThan, int& tail)
+      {
+         if (size == 0) { tail = -1; return -1; }
+
+         /// runs[i] is empty or holds 2^i nodes, runs above i hold older nodes
+         int runs[32];
+         int top = 0;
+         runs[0] = -1;
+
+         int n = head;
+         for (int i = 0; i < size; ++i)
          {
-            assert(!_complete);
-            _size++;
+            int carry = n;
+            n = pool.Index(n).next;
+
+            /// The list may continue past its tail into nodes shared with
+            /// longer lists, it is cut off here as each node is taken
+            pool.Index(carry).next = -1;
+
+            int r = 0;
+            for (; r < top && runs[r] != -1; ++r)
+            {
+               carry = mergeLinks(pool, runs[r], carry, lessThan, (int*)0);
+               runs[r] = -1;
+            }
+            if (r == top) top++;
+            runs[r] = carry;
+         }
 
-            _nodePool->Push(LinkedListNode<E>(e, _head));
-            int newHead = _nodePool->NextFreeIndex()-1;
-            if (newHead == 0) _head = _tail = 0;
-            else _head = newHead;
+         int sorted = -1;
+         tail = -1;
+         for (int r = 0; r < top; ++r)
+         {
+            if (runs[r] == -1) continue;
+            if (sorted == -1) { sorted = runs[r]; continue; }
+            sorted = mergeLinks(pool, runs[r], sorted, lessThan, &tail);
          }
 
+         /// A single run was never merged at the end
+         if (tail == -1) for (tail = sorted; pool.Index(tail).next != -1; tail = pool.Index(tail).next) {}
+         return sorted;
+      }
+
+      /// Moves the payloads of a pool whose slots [0, size) hold exactly the
+      /// list starting at 'head' so that slot i holds the i-th element, and
+      /// relinks slot i to i+1. The list is walked once: its i-th node trades
+      /// places with whatever is in slot i, and slot i keeps the index the
+      /// displaced node went to, so that a link into the part already placed
+      /// can be forwarded. O(N) time and O(1) extra space.
+      template <class E>
+      void LayOutInListOrder(MemoryPool<LinkedListNode<E> >& pool, int head, int size)
+      {
+         int n = head;
+         for (int i = 0; i < size; ++i)
+         {
+            while (n < i) n = pool.Index(n).next;
 
-         inline C Result() 
-         { 
-            assert(!_complete); 
-            _complete = true;
-            C result = C(_size, _head, _tail, _nodePool);
-            _size = 0;
-            _head = _tail = -1;
-            _nodePool = new MemoryPool<LinkedListNode<E> >(1);
-            return result;
+            LinkedListNode<E>& node = pool.Index(n);
+            const int next = node.next;
+            if (n != i)
+            {
+               LinkedListNode<E>& slot = pool.Index(i);
+               std::swap(node.payload, slot.payload);
+               node.next = slot.next;
+               slot.next = n;
+            }
+            n = next;
          }
-      };
+
+         for (int i = 0; i < size; ++i) pool.Index(i).next = i + 1 < size ? i + 1 : -1;
+      }
    }  // namespace Common
 } // namespace Collections
 
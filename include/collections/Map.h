@@ -17,7 +17,7 @@ namespace Collections
       public:
          A key; B value;
          inline KeyValuePair() {}
-         inline KeyValuePair(const A& k) : key(k) {}
+         inline KeyValuePair(const A& k) : key(k), value() {}
          inline KeyValuePair(const A& k, const B& v) : key(k), value(v) {}
 
          bool operator < (const A& rhs) const { return key < rhs; }
@@ -24,6 +24,7 @@ namespace Collections
 
          friend class Common::ArrayIterator<E>;
          friend class Common::ArrayBuilder<E, Array<E> >;
+         template <class U, class C> friend class Collections::ParallelArray;
 
          typedef E ElementType;
          typedef Common::ArrayIterator<E> Iterator;
@@ -33,18 +34,18 @@ namespace Collections
 
       protected:
          int _size;
-         Ref<Common::InitializedBuffer<E> > _data;
+         Ref<Common::UninitializedBuffer<E> > _data;
 
-         inline Array(int size, Ref<Common::InitializedBuffer<E> > data)
+         inline Array(int size, Ref<Common::UninitializedBuffer<E> > data)
             : _size(size), _data(data) {}
 
       public:
       
          /// Construct a mutable array of size zero
-         inline Array() : _size(0), _data(new Common::InitializedBuffer<E>()) {}
+         inline Array() : _size(0), _data(new Common::UninitializedBuffer<E>()) {}
 
          inline Array(int initSize) 
-            : _size(initSize), _data(new Common::InitializedBuffer<E>(initSize)) {}
+            : _size(initSize), _data(new Common::UninitializedBuffer<E>(initSize, initSize)) {}
 
          //////////////////////////////////////////////
          // Copy and Assignment, Reference Semantics //
@@ -58,6 +59,14 @@ namespace Collections
          inline Array& operator = (const Array& rhs)
          { _size = rhs._size; _data = rhs._data; return *this; }
 
+         /// Moves take over the data array without touching its reference
+         /// counter. The moved-from array is left empty.
+         inline Array(Array&& rhs) : _size(rhs._size), _data(std::move(rhs._data)) 
+         { rhs._size = 0; }
+
+         inline Array& operator = (Array&& rhs)
+         { _size = rhs._size; _data = std::move(rhs._data); rhs._size = 0; return *this; }
+
 
          ////////////////////////////////
          // Inherited From Traversable //
@@ -76,14 +85,24 @@ namespace Collections
          inline const E& operator [] (int i) const { return _data->Index(i); }
 
          virtual Array<E> Reverse() const;
-         friend Array<E> Sorted(const Array<E>& a);
+
+         /// Parallel bulk operations over this array, see Parallel.h. By
+         /// default uses one thread per hardware thread.
+         ParallelArray<E, Array<E> > Par(int threads = 0) const;
+         friend Array<E> Sorted<>(const Array<E>& a);
 
 
          ////////////////////////
          // Mutable Array Only //
          ////////////////////////
 
-         friend Array<E>& SortInPlace(Array<E>& a);
+         friend Array<E>& SortInPlace<>(Array<E>& a);
+         template <class U, class K> friend Array<U> SortedBy(const Array<U>& a, K key);
+         template <class U, class K> friend Array<U>& SortInPlaceBy(Array<U>& a, K key);
+         template <class U, class F> friend Array<U>& NthElement(Array<U>& a, int n, F lessThan);
+         template <class U, class F> friend Array<U>& PartialSort(Array<U>& a, int k, F lessThan);
+         template <class U> friend Array<U>& PartialSort(Array<U>& a, int k);
+         template <class U, class F> friend Array<U> TopK(const Array<U>& a, int k, F lessThan);
       };
 
 
@@ -97,34 +116,105 @@ namespace Collections
 
       template <class E> inline Array<E> Array<E>::Reverse() const                           
       {                                                                               
-         Array<E> newArray(Size());                                                   
-         for (int i = 0; i < Size(); ++i)                                             
-            ((E*)*newArray._data)[i] = (*this)[Size()-i-1];                            
-         return newArray;
+         Builder builder(Size());
+         for (int i = Size()-1; i >= 0; --i) builder.AddElement((*this)[i]);
+         return builder.Result();
       } 
 
       template <class E> inline Array<E> Sorted(const Array<E>& a)
       {
          /// 1. Make a copy
-         /// 2. In-place quicksort the copy
+         /// 2. In-place introsort the copy
          
          //typename Array<E>::Builder builder = a._clone(a.Size(), a.Size()); 
          //Array<E> sorted = builder.Result();
          Array<E> sorted = a.Copy();
 
-         //Common::SortInPlace(((E*)*sorted._data), 0, a.Size()-1);
-         Common::SortInPlace(((E*)&sorted[0]), 0, a.Size()-1);
+         Common::SortInPlace(((E*)*sorted._data), 0, a.Size()-1);
          
          return sorted;
       } 
 
       template <class E> inline Array<E>& SortInPlace(Array<E>& a)
       {
-         Common::SortInPlace<E>((E*)&a[0], 0, a.Size()-1);
-         //Common::SortInPlace<E>(((E*)*a._data), 0, a.Size()-1);
+         Common::SortInPlace<E>(((E*)*a._data), 0, a.Size()-1);
+         return a;
+      }
+
+      /// Stable radix sort by key(e), which must be arithmetic
+      template <class E, class K> inline Array<E> SortedBy(const Array<E>& a, K key)
+      {
+         Array<E> sorted = a.Copy();
+         Common::RadixSortBy(((E*)*sorted._data), a.Size(), key);
+         return sorted;
+      }
+
+      template <class E, class K> inline Array<E>& SortInPlaceBy(Array<E>& a, K key)
+      {
+         Common::RadixSortBy(((E*)*a._data), a.Size(), key);
          return a;
       }
 
+
+      ///////////////////////////////////
+      // Selection, see ArrayCommon.h  //
+      ///////////////////////////////////
+
+      /// O(n) on average. Puts the element a sort would put at position n
+      /// there, with nothing greater before it and nothing less after it.
+      template <class E, class F> inline Array<E>& NthElement(Array<E>& a, int n, F lessThan)
+      {
+         assert(n >= 0 && n < a.Size());
+         Common::SelectInPlace(((E*)*a._data), a.Size(), n, lessThan);
+         return a;
+      }
+
+      template <class E> inline Array<E>& NthElement(Array<E>& a, int n)
+      { return NthElement(a, n, Common::OperatorLessThan<E>()); }
+
+      /// O(n + k log k). Sorts the k smallest elements into the first k
+      /// positions, and leaves the rest after them in no particular order.
+      template <class E, class F> inline Array<E>& PartialSort(Array<E>& a, int k, F lessThan)
+      {
+         Common::PartialSortInPlace(((E*)*a._data), a.Size(), k, lessThan);
+         return a;
+      }
+
+      template <class E> inline Array<E>& PartialSort(Array<E>& a, int k)
+      {
+         Common::PartialSortInPlace(((E*)*a._data), a.Size(), k);
+         return a;
+      }
+
+      /// O(n log k), leaves the array alone. Returns its k smallest elements
+      /// in order, only ever holding k of them.
+      template <class E, class F> Array<E> TopK(const Array<E>& a, int k, F lessThan)
+      {
+         const int n = a.Size();
+         if (k > n) k = n;
+         if (k < 0) k = 0;
+
+         const E * data = (const E*)*a._data;
+         typename Array<E>::Builder builder(k);
+         for (int i = 0; i < k; ++i) builder.AddElement(data[i]);
+         Array<E> top = builder.Result();
+         if (k == 0) return top;
+
+         E * heap = (E*)*top._data;
+         Common::MakeHeapWith(heap, k, lessThan);
+         for (int i = k; i < n; ++i)
+         {
+            if (!lessThan(data[i], heap[0])) continue;
+            heap[0] = data[i];
+            Common::SiftDownWith(heap, 0, k, lessThan);
+         }
+         Common::SortHeapWith(heap, k, lessThan);
+         return top;
+      }
+
+      template <class E> inline Array<E> TopK(const Array<E>& a, int k)
+      { return TopK(a, k, Common::OperatorLessThan<E>()); }
+
    } // namespace Mutable
 } // namespace Collections
 
@@ -0,0 +1,179 @@
+#ifndef MUTABLE_BTREE_MAP_H
+#define MUTABLE_BTREE_MAP_H
+
+#include "Map.h"
+#include "MutableBTreeSet.h"
+
+//////////////////////////////////////////
+// Class BTreeMap <- Map <- Traversable //
+//////////////////////////////////////////
+
+namespace Collections
+{
+   namespace Mutable
+   {
+      template <class K, class V> struct BTreeMapTraits
+      {
+         typedef Common::BTreeMapIterator<K, V> Iterator;
+         typedef Common::BTreeMapBuilder<K, V> Builder;
+         typedef BTreeSet<K> SetType;
+      };
+
+      /// A drop-in alternative to Mutable::TreeMap, with the same interface,
+      /// for maps that are mostly searched. See BTreeCommon.h.
+      template <class K, class V>
+      class BTreeMap : public Map<K, V, BTreeMap<K, V>, BTreeMapTraits<K, V> >
+      {
+      public:
+
+         friend class Common::BTreeMapBuilder<K, V>;
+
+         template <class U> struct SwapElementType { typedef BTreeMap<K, U> C; };
+
+         typedef Common::KeyValuePair<K, V> ElementType;
+         typedef Common::BTree<K, V> Tree;
+         typedef Common::BTreeMapIterator<K, V> Iterator;
+         typedef Common::BTreeMapBuilder<K, V> Builder;
+
+         /// The set container that corresponds to the BTreeMap<K, V> is BTreeSet<K>
+         typedef BTreeSet<K> SetType;
+
+      private:
+
+         int _size;  //< Number of elements, for efficiency
+         Tree _tree;
+
+         inline BTreeMap(int size, const Tree& tree) : _size(size), _tree(tree) {}
+         inline BTreeMap(int size, Tree&& tree) : _size(size), _tree(std::move(tree)) {}
+
+      public:
+
+         ///////////////////////////////////////////
+         // Copy Constructor, Reference Semantics //
+         ///////////////////////////////////////////
+
+         inline BTreeMap() : _size(0), _tree(0) {}
+
+         /// The node pools' reference counters are automatically incremented
+         inline BTreeMap(const BTreeMap& rhs) : _size(rhs._size), _tree(rhs._tree) {}
+
+         //////////////////////////////////////////////
+         // Assignment Operator, Reference Semantics //
+         //////////////////////////////////////////////
+
+         inline BTreeMap& operator = (const BTreeMap& rhs)
+         { _tree = rhs._tree; _size = rhs._size; return *this; }
+
+         /// Moves take over the node pools without touching their reference
+         /// counters. The moved-from container may only be assigned to or destroyed.
+         inline BTreeMap(BTreeMap&& rhs) : _size(rhs._size), _tree(std::move(rhs._tree)) { rhs._size = 0; }
+
+         inline BTreeMap& operator = (BTreeMap&& rhs)
+         {
+            _tree = std::move(rhs._tree); _size = rhs._size;
+            rhs._size = 0;
+            return *this;
+         }
+
+
+         ////////////////////////////////
+         // Inherited From Traversable //
+         ////////////////////////////////
+
+         virtual int Size() const { return _size; }
+         virtual Iterator GetIterator() const { return Iterator(_tree); }
+
+
+         ////////////////////////
+         // Inherited From Map //
+         ////////////////////////
+
+         /// O(log n)
+         virtual bool Contains(const K& key) const
+         {
+            int leaf, slot;
+            _tree.Find(key, leaf, slot);
+            return slot != -1;
+         }
+
+         /// O(log n)
+         virtual const V& GetOrElse(const K& key, const V& otherwise) const
+         {
+            int leaf, slot;
+            _tree.Find(key, leaf, slot);
+            return slot == -1 ? otherwise : _tree._leaves->Index(leaf).values[slot];
+         }
+
+         /// O(n), the nodes are copied so that this map is left as it was. A
+         /// key already present has its value replaced.
+         virtual BTreeMap Insert(const K& key, const V& value) const;
+         virtual BTreeMap Remove(const K& key) const;
+
+         virtual SetType Keys() const;
+
+
+         ///////////////////////////
+         // Mutable BTreeMap Only //
+         ///////////////////////////
+
+         /// O(log n). Adding a key already present leaves its value as it
+         /// was, as with Mutable::TreeMap; Insert replaces it.
+         BTreeMap& operator += (const Common::KeyValuePair<K, V>& keyValuePair)
+         { if (_tree.Insert(keyValuePair.key, &keyValuePair.value, false)) _size++; return *this; }
+         BTreeMap& operator -= (const K& key) { if (_tree.Remove(key)) _size--; return *this; }
+
+         BTreeMap& operator += (const BTreeMap& map);   // destructive union
+         BTreeMap& operator -= (const BTreeMap& map);
+      };
+
+
+      /// The keys come out in order, so the set's leaves are filled in turn
+      template <class K, class V> typename BTreeMap<K, V>::SetType BTreeMap<K, V>::Keys() const
+      {
+         typename SetType::Builder builder(_size);
+         Iterator iterator = this->GetIterator();
+         while (iterator.HasNext()) builder.AddElement(iterator.Next().key);
+         return builder.Result();
+      }
+
+      template <class K, class V> BTreeMap<K, V>
+      BTreeMap<K, V>::Insert(const K& key, const V& value) const
+      {
+         Tree tree = _tree.Clone();
+         const bool added = tree.Insert(key, &value, true);
+         return BTreeMap(added ? _size+1 : _size, std::move(tree));
+      }
+
+      template <class K, class V> BTreeMap<K, V>
+      BTreeMap<K, V>::Remove(const K& key) const
+      {
+         if (!Contains(key)) return *this;
+         Tree tree = _tree.Clone();
+         tree.Remove(key);
+         return BTreeMap(_size-1, std::move(tree));
+      }
+
+      template <class K, class V> BTreeMap<K, V>&
+      BTreeMap<K, V>::operator += (const BTreeMap<K, V>& map)
+      {
+         if (&map != this)
+         {
+            Iterator itr = map.GetIterator();
+            while (itr.HasNext()) *this += itr.Next();
+         }
+         return *this;
+      }
+
+      template <class K, class V> BTreeMap<K, V>&
+      BTreeMap<K, V>::operator -= (const BTreeMap<K, V>& map)
+      {
+         if (&map == this) { *this = BTreeMap(); return *this; }
+         Iterator itr = map.GetIterator();
+         while (itr.HasNext()) *this -= itr.Next().key;
+         return *this;
+      }
+
+   } // namespace Mutable
+} // namespace Collections
+
+#endif // MUTABLE_BTREE_MAP_H
@@ -0,0 +1,172 @@
+#ifndef MUTABLE_BTREE_SET_H
+#define MUTABLE_BTREE_SET_H
+
+#include "Set.h"
+#include "BTreeCommon.h"
+
+//////////////////////////////////////////
+// Class BTreeSet <- Set <- Traversable //
+//////////////////////////////////////////
+
+namespace Collections
+{
+   namespace Mutable
+   {
+      template <class E> struct BTreeSetTraits
+      {
+         typedef Common::BTreeSetIterator<E> Iterator;
+         typedef Common::BTreeSetBuilder<E> Builder;
+      };
+
+      /// A drop-in alternative to Mutable::TreeSet, with the same interface,
+      /// for sets that are mostly searched. See BTreeCommon.h.
+      template <class E>
+      class BTreeSet : public Set<E, BTreeSet<E>, BTreeSetTraits<E> >
+      {
+      public:
+
+         friend class Common::BTreeSetBuilder<E>;
+
+         typedef E ElementType;
+         typedef Common::BTree<E, void> Tree;
+         typedef Common::BTreeSetIterator<E> Iterator;
+         typedef Common::BTreeSetBuilder<E> Builder;
+
+         template <class U> struct SwapElementType { typedef BTreeSet<U> C; };
+
+      private:
+
+         int _size;  //< Number of elements, for efficiency
+         Tree _tree;
+
+         inline BTreeSet(int size, const Tree& tree) : _size(size), _tree(tree) {}
+         inline BTreeSet(int size, Tree&& tree) : _size(size), _tree(std::move(tree)) {}
+
+         /// The result of a set operation, by a merge walk over both sets
+         template <Common::TreeMergeOp Op> BTreeSet combine(const BTreeSet& set) const
+         {
+            Builder builder(Op == Common::TREE_UNION ? _size + set._size :
+                            Op == Common::TREE_INTERSECTION ? min(_size, set._size) : _size);
+            Common::MergeSorted<Op>(this->GetIterator(), set.GetIterator(), builder);
+            return builder.Result();
+         }
+
+      public:
+
+         ///////////////////////////////////////////
+         // Copy Constructor, Reference Semantics //
+         ///////////////////////////////////////////
+
+         inline BTreeSet() : _size(0), _tree(0) {}
+
+         /// The node pools' reference counters are automatically incremented
+         inline BTreeSet(const BTreeSet& rhs) : _size(rhs._size), _tree(rhs._tree) {}
+
+         //////////////////////////////////////////////
+         // Assignment Operator, Reference Semantics //
+         //////////////////////////////////////////////
+
+         inline BTreeSet& operator = (const BTreeSet& rhs)
+         { _tree = rhs._tree; _size = rhs._size; return *this; }
+
+         /// Moves take over the node pools without touching their reference
+         /// counters. The moved-from container may only be assigned to or destroyed.
+         inline BTreeSet(BTreeSet&& rhs) : _size(rhs._size), _tree(std::move(rhs._tree)) { rhs._size = 0; }
+
+         inline BTreeSet& operator = (BTreeSet&& rhs)
+         {
+            _tree = std::move(rhs._tree); _size = rhs._size;
+            rhs._size = 0;
+            return *this;
+         }
+
+
+         ////////////////////////////////
+         // Inherited From Traversable //
+         ////////////////////////////////
+
+         virtual int Size() const { return _size; }
+         virtual Iterator GetIterator() const { return Iterator(_tree); }
+
+         /// O(log n), down the left or right edge
+         virtual E Head() const
+         { assert(_size > 0); return _tree._leaves->Index(_tree.FirstLeaf()).keys[0]; }
+         virtual E Last() const
+         {
+            assert(_size > 0);
+            const typename Tree::Leaf& leaf = _tree._leaves->Index(_tree.LastLeaf());
+            return leaf.keys[leaf.size - 1];
+         }
+
+
+         ////////////////////////
+         // Inherited From Set //
+         ////////////////////////
+
+         /// O(log n)
+         virtual Iterator Contains(const E& element) const { return Iterator(_tree, element); }
+
+         /// O(n + m), merge walks over both sets in order
+         virtual bool IsSubsetOf(const BTreeSet& set) const
+         { return _size <= set._size && Common::SortedIncludes(this->GetIterator(), set.GetIterator()); }
+
+         virtual BTreeSet Union(const BTreeSet& set) const { return combine<Common::TREE_UNION>(set); }
+         virtual BTreeSet Intersection(const BTreeSet& set) const { return combine<Common::TREE_INTERSECTION>(set); }
+         virtual BTreeSet Difference(const BTreeSet& set) const { return combine<Common::TREE_DIFFERENCE>(set); }
+
+         /// O(n), the nodes are copied so that this set is left as it was
+         virtual BTreeSet Insert(const E& element) const;
+         virtual BTreeSet Remove(const E& element) const;
+
+
+         ///////////////////////////
+         // Mutable BTreeSet Only //
+         ///////////////////////////
+
+         /// O(log n)
+         BTreeSet& operator += (const E& e) { if (_tree.Insert(e, nullptr, false)) _size++; return *this; }
+         BTreeSet& operator -= (const E& e) { if (_tree.Remove(e)) _size--; return *this; }
+
+         BTreeSet& operator += (const BTreeSet& set);   // destructive union
+         BTreeSet& operator -= (const BTreeSet& set);   // destructive set difference
+      };
+
+
+      template <class E> BTreeSet<E> BTreeSet<E>::Insert(const E& e) const
+      {
+         if (this->Contains(e)) return *this;
+         Tree tree = _tree.Clone();
+         tree.Insert(e, nullptr, false);
+         return BTreeSet(_size+1, std::move(tree));
+      }
+
+      template <class E> BTreeSet<E> BTreeSet<E>::Remove(const E& e) const
+      {
+         if (!this->Contains(e)) return *this;
+         Tree tree = _tree.Clone();
+         tree.Remove(e);
+         return BTreeSet(_size-1, std::move(tree));
+      }
+
+      template <class E> BTreeSet<E>& BTreeSet<E>::operator += (const BTreeSet<E>& set)
+      {
+         /// We need to handle the strange case where the rhs is the same container
+         /// as on the lhs
+         if (&set == this) return *this;
+         Iterator itr = set.GetIterator();
+         while (itr.HasNext()) *this += itr.Next();
+         return *this;
+      }
+
+      template <class E> BTreeSet<E>& BTreeSet<E>::operator -= (const BTreeSet<E>& set)
+      {
+         if (&set == this) { *this = BTreeSet(); return *this; }
+         Iterator itr = set.GetIterator();
+         while (itr.HasNext()) *this -= itr.Next();
+         return *this;
+      }
+
+   } // namespace Mutable
+} // namespace Collections
+
+#endif // MUTABLE_BTREE_SET_H
@@ -1,91 +1,174 @@
 #pragma once
 
-#ifndef HASH_MAP_H
-#define HASH_MAP_H
+#ifndef MUTABLE_HASH_MAP_H
+#define MUTABLE_HASH_MAP_H
 
+#include "Map.h"
+#include "MutableHashSet.h"
+
+/////////////////////////////////////////
+// Class HashMap <- Map <- Traversable //
+/////////////////////////////////////////
 
 namespace Collections
 {
-	namespace Mutable
-	{
-		template <class K, class V> class HashMap;
-
-		template <class K, class V> struct HashMapTraits
-		{
-			template <class U> struct SwapElementType { typedef HashMap<K, U> C; };
+   namespace Mutable
+   {
+      template <class K, class V> struct HashMapTraits
+      {
+         typedef Common::HashIterator<Common::KeyValuePair<K, V> > Iterator;
+         typedef Common::HashBuilder<Common::KeyValuePair<K, V>, HashMap<K, V> > Builder;
+         typedef HashSet<K> SetType;
+      };
 
-			class Iterator
-			{
-				
-			};
+      /// An unordered map with O(1) expected lookups and updates, for keys
+      /// with a Common::Hash. The key-value pairs share a slot, so a lookup
+      /// that finds its key has its value in the same cache line. Iteration
+      /// is in no particular order. See HashCommon.h.
+      template <class K, class V>
+      class HashMap : public Map<K, V, HashMap<K, V>, HashMapTraits<K, V> >
+      {
+      public:
 
-			class Builder
-			{
+         friend class Common::HashBuilder<Common::KeyValuePair<K, V>, HashMap<K, V> >;
 
-			};
-		};
+         template <class U> struct SwapElementType { typedef HashMap<K, U> C; };
 
+         typedef Common::KeyValuePair<K, V> ElementType;
+         typedef Common::HashTable<Common::KeyValuePair<K, V> > Table;
+         typedef Common::HashIterator<Common::KeyValuePair<K, V> > Iterator;
+         typedef Common::HashBuilder<Common::KeyValuePair<K, V>, HashMap<K, V> > Builder;
 
-		template <class K, class V> 
-		class HashMap : public Map<K, V, HashMap<K, V>, HashMapTraits<K, V> >
-		{
-		private:
+         /// The set container that corresponds to the HashMap<K, V> is HashSet<K>
+         typedef HashSet<K> SetType;
 
-			int _size;
+      private:
 
-		public:
+         Table _table;
 
-			friend class HashMapTraits<K, V>::Iterator;
-			friend class HashMapTraits<K, V>::Builder;
-
-			typedef typename HashMapTraits<K, V>::Iterator Iterator;
-			typedef typename HashMapTraits<K, V>::Builder Builder;
+         inline HashMap(const Table& table) : _table(table) {}
+         inline HashMap(Table&& table) : _table(std::move(table)) {}
 
+      public:
 
          ///////////////////////////////////////////
          // Copy Constructor, Reference Semantics //
          ///////////////////////////////////////////
-      
-         /// The data array's reference counter is automatically incremented
-         inline HashMap() : _size(0)  {}
-      
-         /// The data array's reference counter is automatically incremented
-         inline HashMap(const HashMap& rhs)
-            : _size(rhs._size) { }
 
+         inline HashMap() : _table(0) {}
+
+         /// The slots' reference counter is automatically incremented
+         inline HashMap(const HashMap& rhs) : _table(rhs._table) {}
 
          //////////////////////////////////////////////
          // Assignment Operator, Reference Semantics //
          //////////////////////////////////////////////
-      
-         inline HashMap& operator = (const HashMap& rhs)
-         { _size = rhs._size; return *this; }
+
+         inline HashMap& operator = (const HashMap& rhs) { _table = rhs._table; return *this; }
+
+         /// Moves take over the slots without touching their reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline HashMap(HashMap&& rhs) : _table(std::move(rhs._table)) {}
+         inline HashMap& operator = (HashMap&& rhs) { _table = std::move(rhs._table); return *this; }
 
 
          ////////////////////////////////
          // Inherited From Traversable //
          ////////////////////////////////
-      
-         virtual int Size() const { return _size; }
-         //virtual Iterator GetIterator() const { return Iterator(this->_root); }
+
+         virtual int Size() const { return _table.Size(); }
+         virtual Iterator GetIterator() const { return Iterator(_table); }
 
 
          ////////////////////////
          // Inherited From Map //
          ////////////////////////
 
-         virtual HashMap<K, V> Insert(const K& key, const V& value) const;
-         virtual HashMap<K, V> Remove(const K& key) const;
-         virtual typename HashMapTraits<K, V>::SetType Keys() const;
-		};
-
-
-	}
-}
-
-
-
-
-
-
-
+         /// O(1) expected
+         virtual bool Contains(const K& key) const { return _table.Find(key) != -1; }
+
+         virtual const V& GetOrElse(const K& key, const V& otherwise) const
+         {
+            const int slot = _table.Find(key);
+            return slot == -1 ? otherwise : _table.At(slot).value;
+         }
+
+         /// O(n), the slots are copied so that this map is left as it was. A
+         /// key already present has its value replaced.
+         virtual HashMap Insert(const K& key, const V& value) const;
+         virtual HashMap Remove(const K& key) const;
+
+         virtual SetType Keys() const;
+
+
+         //////////////////////////
+         // Mutable HashMap Only //
+         //////////////////////////
+
+         /// O(1) expected. Adding a key already present leaves its value as
+         /// it was, as with Mutable::TreeMap; Insert replaces it.
+         HashMap& operator += (const Common::KeyValuePair<K, V>& keyValuePair)
+         { _table.Insert(keyValuePair, false); return *this; }
+         HashMap& operator -= (const K& key) { _table.Remove(key); return *this; }
+
+         HashMap& operator += (const HashMap& map);   // destructive union
+         HashMap& operator -= (const HashMap& map);
+
+         /// Makes room for n mappings in all, so that adding up to that many
+         /// does not rehash
+         inline HashMap& Reserve(int n) { _table.Reserve(n); return *this; }
+      };
+
+
+      template <class K, class V> typename HashMap<K, V>::SetType HashMap<K, V>::Keys() const
+      {
+         typename SetType::Builder builder(Size());
+         Iterator iterator = this->GetIterator();
+         while (iterator.HasNext()) builder.AddElement(iterator.Next().key);
+         return builder.Result();
+      }
+
+      template <class K, class V> HashMap<K, V>
+      HashMap<K, V>::Insert(const K& key, const V& value) const
+      {
+         Table table = _table.Clone();
+         table.Insert(Common::KeyValuePair<K, V>(key, value), true);
+         return HashMap(std::move(table));
+      }
+
+      template <class K, class V> HashMap<K, V>
+      HashMap<K, V>::Remove(const K& key) const
+      {
+         if (!Contains(key)) return *this;
+         Table table = _table.Clone();
+         table.Remove(key);
+         return HashMap(std::move(table));
+      }
+
+      template <class K, class V> HashMap<K, V>&
+      HashMap<K, V>::operator += (const HashMap<K, V>& map)
+      {
+         if (!_table.Shares(map._table))
+         {
+            _table.Reserve(Size() + map.Size());
+            Iterator itr = map.GetIterator();
+            while (itr.HasNext()) *this += itr.Next();
+         }
+         return *this;
+      }
+
+      template <class K, class V> HashMap<K, V>&
+      HashMap<K, V>::operator -= (const HashMap<K, V>& map)
+      {
+         /// As for HashSet, removing the keys of a map sharing the table
+         /// clears it
+         if (_table.Shares(map._table)) { _table.Clear(); return *this; }
+         Iterator itr = map.GetIterator();
+         while (itr.HasNext()) *this -= itr.Next().key;
+         return *this;
+      }
+
+   } // namespace Mutable
+} // namespace Collections
+
+#endif // MUTABLE_HASH_MAP_H
@@ -0,0 +1,146 @@
+#ifndef MUTABLE_HASH_SET_H
+#define MUTABLE_HASH_SET_H
+
+#include "Set.h"
+#include "HashCommon.h"
+
+/////////////////////////////////////////
+// Class HashSet <- Set <- Traversable //
+/////////////////////////////////////////
+
+namespace Collections
+{
+   namespace Mutable
+   {
+      template <class E> struct HashSetTraits
+      {
+         typedef Common::HashIterator<E> Iterator;
+         typedef Common::HashBuilder<E, HashSet<E> > Builder;
+      };
+
+      /// An unordered set with O(1) expected Contains, Insert and Remove, for
+      /// elements with a Common::Hash. Iteration is in no particular order.
+      /// See HashCommon.h.
+      template <class E>
+      class HashSet : public Set<E, HashSet<E>, HashSetTraits<E> >
+      {
+      public:
+
+         friend class Common::HashBuilder<E, HashSet<E> >;
+
+         typedef E ElementType;
+         typedef Common::HashTable<E> Table;
+         typedef Common::HashIterator<E> Iterator;
+         typedef Common::HashBuilder<E, HashSet<E> > Builder;
+
+         template <class U> struct SwapElementType { typedef HashSet<U> C; };
+
+      private:
+
+         Table _table;
+
+         inline HashSet(const Table& table) : _table(table) {}
+         inline HashSet(Table&& table) : _table(std::move(table)) {}
+
+      public:
+
+         ///////////////////////////////////////////
+         // Copy Constructor, Reference Semantics //
+         ///////////////////////////////////////////
+
+         inline HashSet() : _table(0) {}
+
+         /// The slots' reference counter is automatically incremented
+         inline HashSet(const HashSet& rhs) : _table(rhs._table) {}
+
+         //////////////////////////////////////////////
+         // Assignment Operator, Reference Semantics //
+         //////////////////////////////////////////////
+
+         inline HashSet& operator = (const HashSet& rhs) { _table = rhs._table; return *this; }
+
+         /// Moves take over the slots without touching their reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline HashSet(HashSet&& rhs) : _table(std::move(rhs._table)) {}
+         inline HashSet& operator = (HashSet&& rhs) { _table = std::move(rhs._table); return *this; }
+
+
+         ////////////////////////////////
+         // Inherited From Traversable //
+         ////////////////////////////////
+
+         virtual int Size() const { return _table.Size(); }
+         virtual Iterator GetIterator() const { return Iterator(_table); }
+
+
+         ////////////////////////
+         // Inherited From Set //
+         ////////////////////////
+
+         /// O(1) expected
+         virtual Iterator Contains(const E& element) const { return Iterator(_table, _table.Find(element)); }
+
+         /// O(n), the elements are copied so that this set is left as it was
+         virtual HashSet Insert(const E& element) const;
+         virtual HashSet Remove(const E& element) const;
+
+
+         //////////////////////////
+         // Mutable HashSet Only //
+         //////////////////////////
+
+         /// O(1) expected
+         HashSet& operator += (const E& e) { _table.Insert(e, false); return *this; }
+         HashSet& operator -= (const E& e) { _table.Remove(e); return *this; }
+
+         HashSet& operator += (const HashSet& set);   // destructive union
+         HashSet& operator -= (const HashSet& set);   // destructive set difference
+
+         /// Makes room for n elements in all, so that adding up to that many
+         /// does not rehash
+         inline HashSet& Reserve(int n) { _table.Reserve(n); return *this; }
+      };
+
+
+      template <class E> HashSet<E> HashSet<E>::Insert(const E& e) const
+      {
+         if (this->Contains(e)) return *this;
+         Table table = _table.Clone();
+         table.Insert(e, false);
+         return HashSet(std::move(table));
+      }
+
+      template <class E> HashSet<E> HashSet<E>::Remove(const E& e) const
+      {
+         if (!this->Contains(e)) return *this;
+         Table table = _table.Clone();
+         table.Remove(e);
+         return HashSet(std::move(table));
+      }
+
+      template <class E> HashSet<E>& HashSet<E>::operator += (const HashSet<E>& set)
+      {
+         /// We need to handle the strange case where the rhs is the same container
+         /// as on the lhs, or a copy sharing its table
+         if (_table.Shares(set._table)) return *this;
+         _table.Reserve(Size() + set.Size());
+         Iterator itr = set.GetIterator();
+         while (itr.HasNext()) *this += itr.Next();
+         return *this;
+      }
+
+      template <class E> HashSet<E>& HashSet<E>::operator -= (const HashSet<E>& set)
+      {
+         /// Removing from the table that is being iterated would move
+         /// elements back past the iterator, so a set minus itself, or minus
+         /// a copy sharing its table, is cleared instead
+         if (_table.Shares(set._table)) { _table.Clear(); return *this; }
+         Iterator itr = set.GetIterator();
+         while (itr.HasNext()) *this -= itr.Next();
+         return *this;
+      }
+
+   } // namespace Mutable
+} // namespace Collections
+
+#endif // MUTABLE_HASH_SET_H
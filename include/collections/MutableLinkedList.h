@@ -36,6 +36,7 @@ namespace Collections
          friend class Common::MutableLinkedListIterator<E, LinkedList<E> >;
          friend class Common::LinkedListIterator<E, LinkedList<E> >;
          friend class Common::LinkedListBuilder<E, LinkedList<E> >;
+         friend struct Common::Internals;
 
          typedef E ElementType;
          typedef Common::MutableLinkedListIterator<E, LinkedList<E> > Iterator;
@@ -54,7 +55,7 @@ namespace Collections
          inline LinkedList
             ( int size, int head, int tail
             , Ref<Common::MemoryPool<Node> > m)
-            : _nodePool(m)
+            : _nodePool(std::move(m))
             , _head(head), _tail(tail), _size(size) {}
       
       public:
@@ -86,6 +87,22 @@ namespace Collections
             return *this; 
          }
 
+         /// Moves take over the node pool without touching its reference
+         /// counter. The moved-from list may only be assigned to or destroyed.
+         inline LinkedList(LinkedList&& rhs)
+            : _nodePool(std::move(rhs._nodePool))
+            , _head(rhs._head), _tail(rhs._tail), _size(rhs._size) 
+         { rhs._size = 0; rhs._head = rhs._tail = -1; }
+
+         inline LinkedList& operator = (LinkedList&& rhs)
+         {  
+            _head = rhs._head; _tail = rhs._tail; 
+            _size = rhs._size; 
+            _nodePool = std::move(rhs._nodePool); 
+            rhs._size = 0; rhs._head = rhs._tail = -1;
+            return *this; 
+         }
+
 
          // Debug
          void Print() const;
@@ -112,7 +129,13 @@ namespace Collections
          }
       
          virtual LinkedList<E> Reverse() const;
-         virtual LinkedList<E> Sorted() const;
+         /// Not virtual, so that lists of elements with no operator < can
+         /// still be instantiated
+         LinkedList<E> Sorted() const;
+
+         /// O(N log N), stable. Returns a new list in a fresh pool, laid out
+         /// in sorted order.
+         template <class F> LinkedList<E> SortedWith(F lessThan) const;
 
          /////////////////////////////
          // Mutable LinkedList Only //
@@ -128,6 +151,7 @@ namespace Collections
          }
 
          LinkedList<E>& operator += (const E& e);
+         LinkedList<E>& operator += (E&& e);
          LinkedList<E>& operator += (const LinkedList<E>& list);
 
          /// Semantics: inserts an element at the location currently occupied
@@ -135,6 +159,18 @@ namespace Collections
          /// itr->Next() will return e.
          LinkedList<E>& Insert(Iterator& itr, const E& e);
          LinkedList<E>& Remove(Iterator& itr);
+
+         /// Drops the node pool's free slots and lays the nodes out in list
+         /// order. Iterators taken before compaction remain valid, but see
+         /// the list as it was.
+         LinkedList<E>& Compact();
+
+         /// O(N log N), stable. When no other list shares the node pool the
+         /// nodes are relinked where they are, without moving or copying a
+         /// single element. Otherwise (and that includes a live iterator) the
+         /// sorted list gets a pool of its own.
+         LinkedList<E>& SortInPlace();
+         template <class F> LinkedList<E>& SortInPlaceWith(F lessThan);
       };
 
       template <class E> LinkedList<E> LinkedList<E>::Reverse() const
@@ -145,6 +181,19 @@ namespace Collections
          return builder.Result();
       }
 
+      template <class E> LinkedList<E>& LinkedList<E>::operator += (E&& e)
+      {
+         if (_size == 0) _head = _tail = _nodePool->Push(Node(std::move(e), -1));
+         else
+         {
+            int newTail = _nodePool->Push(Node(std::move(e), -1));
+            _nodePool->Index(_tail).next = newTail;
+            _tail = newTail;
+         }
+         _size++;
+         return *this;
+      }
+
       template <class E> LinkedList<E>& LinkedList<E>::operator += (const E& e)
       {
          if (_size == 0) _head = _tail = _nodePool->Push(Node(e, -1));
@@ -205,22 +254,71 @@ namespace Collections
          if (_head == itr._next) _head = n;
          if (_tail == itr._next) _tail = itr._current;
 
+         /// The slot can be reused unless another list shares the pool (the
+         /// iterator accounts for the second reference)
+         if (_nodePool->RefCount() <= 2) _nodePool->Free(itr._next);
+
          itr._next = n;
          _size--;
          return *this;
       }
 
-      template <class E> LinkedList<E> LinkedList<E>::Sorted() const
+      template <class E> LinkedList<E>& LinkedList<E>::Compact()
+      {
+         Ref<Common::MemoryPool<Node> > compacted = new Common::MemoryPool<Node>(_size);
+         const bool shared = _nodePool->RefCount() > 1;
+
+         int n = _head;
+         for (int i = 0; i < _size; ++i)
+         {
+            Node& node = _nodePool->Index(n);
+            n = node.next;
+            if (shared) compacted->Push(Node(node.payload, i+1));
+            else        compacted->Push(Node(std::move(node.payload), i+1));
+         }
+
+         if (_size > 0) 
+         { 
+            _head = 0; _tail = _size-1; 
+            compacted->Index(_tail).next = -1; 
+         }
+         _nodePool = compacted;
+         return *this;
+      }
+
+      template <class E> template <class F> 
+      LinkedList<E> LinkedList<E>::SortedWith(F lessThan) const
       {
          Builder builder = this->clone(_size, _size);
          LinkedList newList = builder.Result();
+         if (_size <= 1) return newList;
 
-         /// SORT HERE
-         assert(false);
+         Common::MemoryPool<Node>& pool = *newList._nodePool;
+         int tail;
+         const int head = Common::MergeSortLinks(pool, newList._head, _size, lessThan, tail);
+         Common::LayOutInListOrder(pool, head, _size);
 
+         newList._head = 0;
+         newList._tail = _size-1;
          return newList;
       }
 
+      template <class E> LinkedList<E> LinkedList<E>::Sorted() const
+      { return SortedWith(Common::OperatorLessThan<E>()); }
+
+      template <class E> template <class F> 
+      LinkedList<E>& LinkedList<E>::SortInPlaceWith(F lessThan)
+      {
+         if (_size <= 1) return *this;
+         if (_nodePool->RefCount() > 1) return *this = SortedWith(lessThan);
+
+         _head = Common::MergeSortLinks(*_nodePool, _head, _size, lessThan, _tail);
+         return *this;
+      }
+
+      template <class E> LinkedList<E>& LinkedList<E>::SortInPlace()
+      { return SortInPlaceWith(Common::OperatorLessThan<E>()); }
+
    } // namespace Mutable
 } // namespace Collections
 
@@ -29,6 +29,7 @@ namespace Collections
       
          friend class Common::BinaryTreeIterator<Common::KeyValuePair<K, V>, TreeMap<K, V> >;
          friend class Common::BinaryTreeBuilder<Common::KeyValuePair<K, V>, TreeMap<K, V> >;
+         friend struct Common::Internals;
       
          template <class U> struct SwapElementType { typedef TreeMap<K, U> C; };
 
@@ -49,6 +50,9 @@ namespace Collections
          inline TreeMap(int size, const Tree& tree)
             : _size(size)
             , _tree(tree) {}
+         inline TreeMap(int size, Tree&& tree)
+            : _size(size)
+            , _tree(std::move(tree)) {}
       
       public:
 
@@ -71,6 +75,19 @@ namespace Collections
          inline TreeMap& operator = (const TreeMap& rhs)
          { _tree = rhs._tree; _size = rhs._size; return *this; }
 
+         /// Moves take over the node pool without touching its reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline TreeMap(TreeMap&& rhs)
+            : _size(rhs._size)
+            , _tree(std::move(rhs._tree)) { rhs._size = 0; rhs._tree._root = -1; }
+
+         inline TreeMap& operator = (TreeMap&& rhs)
+         { 
+            _tree = std::move(rhs._tree); _size = rhs._size; 
+            rhs._size = 0; rhs._tree._root = -1;
+            return *this; 
+         }
+
 
          ////////////////////////////////
          // Inherited From Traversable //
@@ -79,6 +96,12 @@ namespace Collections
          virtual int Size() const { return _size; }
          virtual Iterator GetIterator() const { return Iterator(this->_tree); }
 
+         /// O(log n), down the left or right edge of the tree
+         virtual ElementType Head() const
+         { assert(_size > 0); return _tree._pool->Index(_tree.Select(0)).payload; }
+         virtual ElementType Last() const
+         { assert(_size > 0); return _tree._pool->Index(_tree.Select(_size - 1)).payload; }
+
 
          ////////////////////////
          // Inherited From Map //
@@ -92,6 +115,28 @@ namespace Collections
          virtual const V& GetOrElse(const K& key, const V& otherwise) const;
 
 
+         ///////////////////
+         // Range Queries //
+         ///////////////////
+
+         /// O(log n) to position the iterator, then in key order from there:
+         /// at the first key not less than key, or greater than key, through
+         /// to the end of the map
+         inline Iterator LowerBound(const K& key) const
+         { return Iterator(_tree, Common::KeyValuePair<K, V>(key), Common::TREE_LOWER_BOUND); }
+         inline Iterator UpperBound(const K& key) const
+         { return Iterator(_tree, Common::KeyValuePair<K, V>(key), Common::TREE_UPPER_BOUND); }
+
+         /// O(log n + k), iterates over the k mappings with keys in [lo, hi)
+         inline Iterator Range(const K& lo, const K& hi) const
+         { return Iterator(_tree, Common::KeyValuePair<K, V>(lo), Common::KeyValuePair<K, V>(hi)); }
+
+         /// The mappings with keys in [lo, hi). O(log n + k), the
+         /// k mappings arrive in order, so the result is built bottom-up.
+         using Map<K, V, TreeMap<K, V>, TreeMapTraits<K, V> >::FilterKeys;
+         TreeMap<K, V> FilterKeys(const K& lo, const K& hi) const;
+
+
          ///////////////////
          // Miscellaneous //
          ///////////////////
@@ -106,6 +151,11 @@ namespace Collections
          TreeMap<K, V>& operator += (const TreeMap<K, V>& map);   // destructive union
          TreeMap<K, V>& operator -= (const K& key);
          TreeMap<K, V>& operator -= (const TreeMap<K, V>& map);    
+
+         /// Drops the node pool's free slots and lays the nodes out in key
+         /// order. Iterators taken before compaction remain valid, but see
+         /// the map as it was.
+         inline TreeMap<K, V>& Compact() { _tree.Compact(); return *this; }
       };
 
 
@@ -146,6 +196,17 @@ namespace Collections
          #endif
       }
 
+      template <class K, class V> TreeMap<K, V>
+      TreeMap<K, V>::FilterKeys(const K& lo, const K& hi) const
+      {
+         const int k = _tree.Rank(Common::KeyValuePair<K, V>(hi)) - _tree.Rank(Common::KeyValuePair<K, V>(lo));
+         if (k <= 0) return TreeMap();
+         Iterator iterator = Range(lo, hi);
+         Builder builder(k);
+         while (iterator.HasNext()) builder.AddElement(iterator.Next());
+         return builder.Result();
+      }
+
       /// Note: Insert and Remove are here and not in Map because of the
       /// "return *this" statements, which do not work in the abstract
       /// base class for some reason that I do not quite understand.
@@ -28,6 +28,7 @@ namespace Collections
       
          friend class Common::MutableBinaryTreeIterator<E, TreeSet<E> >;
          friend class Common::BinaryTreeBuilder<E, TreeSet<E> >;
+         friend struct Common::Internals;
       
          typedef E ElementType;
          typedef Common::BinaryTree<E> Tree;
@@ -46,6 +47,28 @@ namespace Collections
          inline TreeSet(int size, const Tree& tree)
             : _size(size)
             , _tree(tree) {}
+         inline TreeSet(int size, Tree&& tree)
+            : _size(size)
+            , _tree(std::move(tree)) {}
+
+         /// The result of a set operation, by a merge walk over both sets
+         /// built bottom-up, or by split and join where Common::PreferJoin()
+         /// says that is cheaper
+         template <Common::TreeMergeOp Op> TreeSet combine(const TreeSet& set) const
+         {
+            int size;
+            if (Common::PreferJoin(_size, set._size))
+            {
+               Tree tree = Common::JoinTrees<Op>(_tree, _size, set._tree, set._size, size, false);
+               return TreeSet(size, std::move(tree));
+            }
+
+            Common::SortedTreeBuilder<E> builder(Op == Common::TREE_UNION ? _size + set._size :
+                                                 Op == Common::TREE_INTERSECTION ? min(_size, set._size) : _size);
+            Common::MergeSorted<Op>(this->GetIterator(), set.GetIterator(), builder);
+            size = builder.Size();
+            return TreeSet(size, builder.Result());
+         }
       
       
       public:
@@ -69,6 +92,19 @@ namespace Collections
          inline TreeSet& operator = (const TreeSet& rhs)
          { _tree = rhs._tree; _size = rhs._size; return *this; }
 
+         /// Moves take over the node pool without touching its reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline TreeSet(TreeSet&& rhs)
+            : _size(rhs._size)
+            , _tree(std::move(rhs._tree)) { rhs._size = 0; rhs._tree._root = -1; }
+
+         inline TreeSet& operator = (TreeSet&& rhs)
+         { 
+            _tree = std::move(rhs._tree); _size = rhs._size; 
+            rhs._size = 0; rhs._tree._root = -1;
+            return *this; 
+         }
+
 
          ////////////////////////////////
          // Inherited From Traversable //
@@ -77,15 +113,63 @@ namespace Collections
          virtual int Size() const { return _size; }
          virtual Iterator GetIterator() const { return Iterator(this->_tree); }
 
+         /// O(log n), down the left or right edge of the tree
+         virtual E Head() const { return Select(0); }
+         virtual E Last() const { return Select(_size - 1); }
+
+         /// O(log n) plus the size of the result: the copy starts from the
+         /// n-th element rather than stepping over the first n
+         virtual TreeSet<E> Drop(int n) const;
+
 
          ////////////////////////
          // Inherited From Set //
          ////////////////////////
 
          virtual Iterator Contains(const E& element) const;
+
+         /// Both trees iterate in order, so these can be a single merge walk,
+         /// O(n + m), with the result built bottom-up from the merged stream.
+         /// Where one set is much smaller, or both are large enough to share
+         /// out between threads, Union, Intersection and Difference split and
+         /// join the trees instead. The result must not share nodes with the
+         /// sets it came from, so the larger tree is copied without any
+         /// comparisons, and the rest is O(m log(n/m + 1)) for m <= n.
+         virtual bool IsSubsetOf(const TreeSet<E>& set) const;
+         virtual TreeSet<E> Union(const TreeSet<E>& set) const;
+         virtual TreeSet<E> Intersection(const TreeSet<E>& set) const;
+         virtual TreeSet<E> Difference(const TreeSet<E>& set) const;
+
          virtual TreeSet<E> Insert(const E& element) const;
          virtual TreeSet<E> Remove(const E& element) const;
 
+
+         //////////////////////
+         // Order Statistics //
+         //////////////////////
+
+         /// O(log n), the number of elements less than e
+         inline int Rank(const E& e) const { return _tree.Rank(e); }
+
+         /// O(log n), the i-th smallest element, from 0
+         inline const E& Select(int i) const
+         { assert(i >= 0 && i < _size); return _tree._pool->Index(_tree.Select(i)).payload; }
+         inline const E& operator [] (int i) const { return Select(i); }
+
+
+         ///////////////////
+         // Range Queries //
+         ///////////////////
+
+         /// O(log n) to position the iterator, then in order from there: at
+         /// the first element not less than e, or greater than e, through to
+         /// the end of the set
+         inline Iterator LowerBound(const E& e) const { return Iterator(_tree, e, Common::TREE_LOWER_BOUND); }
+         inline Iterator UpperBound(const E& e) const { return Iterator(_tree, e, Common::TREE_UPPER_BOUND); }
+
+         /// O(log n + k), iterates over the k elements in [lo, hi)
+         inline Iterator Range(const E& lo, const E& hi) const { return Iterator(_tree, lo, hi); }
+
          ///////////////////
          // Miscellaneous //
          ///////////////////
@@ -101,9 +185,24 @@ namespace Collections
          TreeSet<E>& operator += (const TreeSet<E>& set);   // destructive union
          TreeSet<E>& operator -= (const E& e);
          TreeSet<E>& operator -= (const TreeSet<E>& set);   // destructive set difference
+
+         /// Drops the node pool's free slots and lays the nodes out in sorted
+         /// order. Iterators taken before compaction remain valid, but see
+         /// the set as it was.
+         inline TreeSet<E>& Compact() { _tree.Compact(); return *this; }
       };
 
 
+      template <class E> TreeSet<E> TreeSet<E>::Drop(int n) const
+      {
+         n = max(0, n);
+         if (n >= _size) return TreeSet();
+         Builder builder(_size - n);
+         Iterator itr(_tree, Select(n));
+         while (itr.HasNext()) builder.AddElement(itr.Next());
+         return builder.Result();
+      }
+
       template <class E> TreeSet<E>& TreeSet<E>::operator += (const E& e)
       {
          if (_tree.Insert(e)) _size++;
@@ -148,12 +247,29 @@ namespace Collections
       template <class E> typename TreeSet<E>::Iterator 
       TreeSet<E>::Contains(const E& element) const
       {
-         int parent;
-         Iterator itr(this->_tree);
-         _tree.Find(element, parent, itr._nextNode);
-         return itr;
+         return Iterator(this->_tree, element);
       }
 
+      template <class E> bool TreeSet<E>::IsSubsetOf(const TreeSet<E>& set) const
+      {
+         if (_size > set._size) return false;
+         return Common::SortedIncludes(this->GetIterator(), set.GetIterator());
+      }
+
+      /// Union and Difference always build a new tree, even when one side is
+      /// empty, so that the result never shares nodes with an operand
+      template <class E> TreeSet<E> TreeSet<E>::Union(const TreeSet<E>& set) const
+      { return combine<Common::TREE_UNION>(set); }
+
+      template <class E> TreeSet<E> TreeSet<E>::Intersection(const TreeSet<E>& set) const
+      {
+         if (_size == 0 || set._size == 0) return TreeSet();
+         return combine<Common::TREE_INTERSECTION>(set);
+      }
+
+      template <class E> TreeSet<E> TreeSet<E>::Difference(const TreeSet<E>& set) const
+      { return combine<Common::TREE_DIFFERENCE>(set); }
+
       /// Note: Insert and Remove are here and not in Set because of the
       /// "return *this" statements, which do not work in the abstract
       /// base class for some reason that I do not quite understand.
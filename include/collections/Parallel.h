@@ -0,0 +1,427 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <type_traits>
+
+#include "Array.h"
+#include "MutableArray.h"
+#include "Scheduler.h"
+
+//////////////////////////////////////////////
+// Parallel Bulk Operations for Array Types //
+//////////////////////////////////////////////
+
+/// The bulk operations of Traversable walk a single iterator. For the random
+/// access containers (Immutable::Array, Mutable::Array, Vector) the work can
+/// instead be cut into contiguous chunks, about one per thread:
+///
+///    int n = a.Par().Count(isEven);
+///    auto evens = a.Par().Filter(isEven);
+///    auto squares = a.Par().Map([] (int i) { return i*i; });
+///    auto sorted = a.Par().Sorted();
+///
+/// Operations that produce a container build one partial result per chunk
+/// and concatenate them in chunk order, so the output has exactly the order
+/// the sequential operation would give. The functions passed in are called
+/// from several threads at once and must not share mutable state.
+///
+/// The chunks run as tasks on Scheduler::Default(), or for
+/// Mutable::ParallelSortInPlace on the scheduler passed in. Arrays too small
+/// to be worth splitting run on the calling thread only.
+/// Note that reference counts are only safe to touch from several threads
+/// when built with ___ATOMIC_REFCOUNT, so functions passed in should not
+/// copy containers around unless that is the case.
+
+namespace Collections
+{
+   namespace Common
+   {
+      /// Smallest range worth handing to a thread of its own
+      static const int PARALLEL_GRAIN = 0x1000;
+
+      /// Default degree of parallelism, the default scheduler's workers plus
+      /// the calling thread
+      inline int HardwareThreads() { return Scheduler::Default().Threads(); }
+
+      /// Number of chunks [0, n) is cut into, with at most 'threads' of them
+      /// and none smaller than the grain
+      inline int ChunkCount(int n, int threads)
+      {
+         const int byGrain = (n + PARALLEL_GRAIN - 1) / PARALLEL_GRAIN;
+         return max(1, min(threads, byGrain));
+      }
+
+      inline int ChunkBegin(int n, int chunks, int c) { return (int)((long long)n * c / chunks); }
+
+      /// Runs f(t) for each t in [0, tasks) as tasks on the scheduler s. The
+      /// calling thread runs task 0 itself, helps with the rest, and returns
+      /// once all tasks are done.
+      template <class F> void ParallelInvoke(int tasks, const F& f, Scheduler& s = Scheduler::Default())
+      {
+         if (tasks <= 1) { if (tasks == 1) f(0); return; }
+
+         Scheduler::TaskGroup g(s);
+         for (int t = tasks - 1; t > 0; --t) g.Spawn([&f, t] () { f(t); });
+         f(0);
+         g.Sync();
+      }
+
+      /// Cuts [0, n) into ChunkCount() chunks and runs f(c, begin, end) for
+      /// each chunk c in parallel. Returns the number of chunks.
+      template <class F> int ParallelChunks(int n, int threads, const F& f, Scheduler& s = Scheduler::Default())
+      {
+         const int chunks = ChunkCount(n, threads);
+         ParallelInvoke(chunks, [&f, n, chunks] (int c)
+         { f(c, ChunkBegin(n, chunks, c), ChunkBegin(n, chunks, c+1)); }, s);
+         return chunks;
+      }
+   }
+
+
+   namespace Common
+   {
+      //////////////////////////
+      // Parallel Sample Sort //
+      //////////////////////////
+
+      /// Arrays below this size are not worth sorting in parallel
+      static const int PARALLEL_SORT_THRESHOLD = 1 << 16;
+
+      /// Sample elements taken per bucket when choosing the splitters
+      static const int SAMPLE_SORT_OVERSAMPLING = 32;
+
+      /// Index of the bucket e belongs in. Bucket 2j holds the keys between
+      /// splitters j-1 and j, and bucket 2j-1 the keys equal to splitter j-1
+      /// if that splitter is heavy, that is, came up more than once in the
+      /// sample. Without heavy splitters there are no equality buckets, and
+      /// the index is just the number of splitters <= e.
+      template <class E> inline int sampleSortBucket(const E * splitters, int count, const bool * heavy, const E& e)
+      {
+         int lo = 0, hi = count;
+         while (lo < hi)
+         {
+            const int mid = (lo + hi) / 2;
+            if (e < splitters[mid]) hi = mid; else lo = mid + 1;
+         }
+         if (!heavy) return lo;
+         return lo > 0 && heavy[lo - 1] && !(splitters[lo - 1] < e) ? 2 * lo - 1 : 2 * lo;
+      }
+
+      /// Sorts a[0, n) with operator <, on up to 'threads' threads of the
+      /// scheduler s, all of them by default:
+      ///    1. A sorted sample of the array picks the splitters
+      ///    2. Each chunk of the array counts how many of its elements go in
+      ///       each bucket
+      ///    3. The counts give every (chunk, bucket) pair its own range of an
+      ///       auxiliary buffer, and the chunks move their elements there
+      ///    4. Each bucket is sorted on its own, with SortInPlace, and the
+      ///       chunks move the buffer back
+      /// A key common enough to be sampled as several splitters would fill
+      /// one bucket and leave its sort to one thread, so equal splitters are
+      /// merged into one, and the keys equal to it get a bucket of their own,
+      /// which needs no sorting. Apart from the small sample and count
+      /// tables, the one auxiliary buffer of n elements is the only
+      /// allocation. The result is the same as SortInPlace gives for totally
+      /// ordered keys.
+      template <class E> void ParallelSortInPlace(E * a, int n, int threads = 0, Scheduler& s = Scheduler::Default())
+      {
+         if (threads <= 0) threads = s.Threads();
+         if (n < PARALLEL_SORT_THRESHOLD || threads == 1) { SortInPlace(a, 0, n - 1); return; }
+
+         /// Several buckets per thread, so that work stealing evens them out
+         const int ranges = min(256, 4 * threads);
+         const int sampleSize = ranges * SAMPLE_SORT_OVERSAMPLING;
+
+         /// Evenly spaced samples with a little jitter, so that periodic
+         /// inputs do not fool the sampling
+         UninitializedBuffer<E> sample(sampleSize);
+         for (int i = 0; i < sampleSize; ++i)
+         {
+            const long long begin = (long long)n * i / sampleSize, end = (long long)n * (i + 1) / sampleSize;
+            sample.Append(a[(int)(begin + ((unsigned int)i * 2654435761u >> 8) % (end - begin))]);
+         }
+         SortInPlace((E*)sample, 0, sampleSize - 1);
+
+         /// The sample is sorted, so equal splitters are adjacent
+         UninitializedBuffer<E> splitterBuffer(ranges - 1);
+         bool heavy[256] = { false }, anyHeavy = false;
+         for (int r = 1; r < ranges; ++r)
+         {
+            const E& splitter = sample[r * SAMPLE_SORT_OVERSAMPLING];
+            const int count = splitterBuffer.Size();
+            if (count > 0 && !(splitterBuffer[count - 1] < splitter)) anyHeavy = heavy[count - 1] = true;
+            else splitterBuffer.Append(splitter);
+         }
+         const E * splitters = splitterBuffer;
+         const int splitterCount = splitterBuffer.Size();
+         const bool * equal = anyHeavy ? heavy : nullptr;
+         const int buckets = anyHeavy ? 2 * splitterCount + 1 : splitterCount + 1;
+
+         /// Count, then turn the counts into write positions, bucket major
+         const int chunks = ChunkCount(n, threads);
+         int * positions = (int*)calloc(chunks * buckets, sizeof(int));
+         int * bucketBegin = new int[buckets + 1];
+
+         ParallelChunks(n, threads, [a, positions, buckets, splitters, splitterCount, equal] (int c, int begin, int end)
+         {
+            int * counts = positions + c * buckets;
+            for (int i = begin; i < end; ++i) counts[sampleSortBucket(splitters, splitterCount, equal, a[i])]++;
+         }, s);
+
+         int running = 0;
+         for (int b = 0; b < buckets; ++b)
+         {
+            bucketBegin[b] = running;
+            for (int c = 0; c < chunks; ++c)
+            {
+               const int count = positions[c * buckets + b];
+               positions[c * buckets + b] = running;
+               running += count;
+            }
+         }
+         bucketBegin[buckets] = n;
+
+         E * aux = (E*)malloc(n * sizeof(E));
+         ParallelChunks(n, threads, [a, aux, positions, buckets, splitters, splitterCount, equal] (int c, int begin, int end)
+         {
+            int * next = positions + c * buckets;
+            for (int i = begin; i < end; ++i)
+               new (&aux[next[sampleSortBucket(splitters, splitterCount, equal, a[i])]++]) E(std::move(a[i]));
+         }, s);
+
+         /// Equality buckets are the odd ones, and are already in order
+         ParallelInvoke(buckets, [aux, bucketBegin, equal] (int b)
+         {
+            if (!equal || b % 2 == 0) SortInPlace(aux, bucketBegin[b], bucketBegin[b + 1] - 1);
+         }, s);
+
+         ParallelChunks(n, threads, [a, aux] (int, int begin, int end)
+         {
+            for (int i = begin; i < end; ++i)
+            {
+               a[i] = std::move(aux[i]);
+               aux[i].~E();
+            }
+         }, s);
+
+         free(aux);
+         free(positions);
+         delete [] bucketBegin;
+      }
+   }
+
+
+   /// Returned by Par() on the array containers. Holds a reference to the
+   /// array, so it is cheap to create and remains valid on its own.
+   template <class E, class C> class ParallelArray
+   {
+   private:
+      typedef Common::UninitializedBuffer<E> Buffer;
+
+      C _array;
+      int _threads;
+
+      inline const E * data() const { return _array.Size() > 0 ? &_array[0] : nullptr; }
+
+      /// Moves the per-chunk results into one buffer, in chunk order
+      static Ref<Buffer> concatenate(Ref<Buffer> * parts, int chunks)
+      {
+         int * offsets = new int[chunks+1];
+         offsets[0] = 0;
+         for (int c = 0; c < chunks; ++c) offsets[c+1] = offsets[c] + parts[c]->Size();
+
+         Ref<Buffer> result = new Buffer(offsets[chunks]);
+         Buffer * r = result;
+         Common::ParallelInvoke(chunks, [parts, offsets, r] (int c)
+         {
+            Buffer& part = *parts[c];
+            for (int i = 0; i < part.Size(); ++i) r->ConstructAt(offsets[c] + i, std::move(part[i]));
+         });
+         result->Commit(offsets[chunks]);
+         delete [] offsets;
+         return result;
+      }
+
+      template <class P> Pair<C, C> partition(P p, bool keepFalse) const;
+
+   public:
+      inline ParallelArray(const C& a, int threads)
+         : _array(a), _threads(threads > 0 ? threads : Common::HardwareThreads()) {}
+
+      inline int Threads() const { return _threads; }
+
+      /// f(e) for every element, in no particular order
+      template <class F> void ForEach(F f) const
+      {
+         const E * d = data();
+         Common::ParallelChunks(_array.Size(), _threads, [d, &f] (int, int begin, int end)
+         { for (int i = begin; i < end; ++i) f(d[i]); });
+      }
+
+      template <class P> int Count(P p) const
+      {
+         const E * d = data();
+         std::atomic<int> count(0);
+         Common::ParallelChunks(_array.Size(), _threads, [d, &p, &count] (int, int begin, int end)
+         {
+            int c = 0;
+            for (int i = begin; i < end; ++i) c += p(d[i]) ? 1 : 0;
+            count.fetch_add(c, std::memory_order_relaxed);
+         });
+         return count.load();
+      }
+
+      /// Stops all chunks early once any of them finds a match
+      template <class P> bool Exists(P p) const
+      {
+         const E * d = data();
+         std::atomic<bool> found(false);
+         Common::ParallelChunks(_array.Size(), _threads, [d, &p, &found] (int, int begin, int end)
+         {
+            for (int i = begin; i < end && !found.load(std::memory_order_relaxed); ++i)
+               if (p(d[i])) found.store(true, std::memory_order_relaxed);
+         });
+         return found.load();
+      }
+
+      template <class P> bool ForAll(P p) const
+      { return !Exists([&p] (const E& e) { return !p(e); }); }
+
+      /// Folds each chunk starting from 'identity', then folds the partial
+      /// results in chunk order. f must be associative, and identity must be
+      /// its identity element, for the result to match a sequential fold.
+      template <class A, class F> A Reduce(const A& identity, F f) const
+      {
+         const E * d = data();
+         const int chunks = Common::ChunkCount(_array.Size(), _threads);
+         Ref<Common::UninitializedBuffer<A> > partials = new Common::UninitializedBuffer<A>(chunks);
+         Common::UninitializedBuffer<A> * out = partials;
+         Common::ParallelChunks(_array.Size(), _threads, [d, &f, &identity, out] (int c, int begin, int end)
+         {
+            A a = identity;
+            for (int i = begin; i < end; ++i) a = f(a, d[i]);
+            out->ConstructAt(c, std::move(a));
+         });
+         partials->Commit(chunks);
+
+         A a = (*partials)[0];
+         for (int c = 1; c < chunks; ++c) a = f(a, (*partials)[c]);
+         return a;
+      }
+
+      /// Each chunk constructs its results directly in place in the output
+      template <class F>
+      typename C::template SwapElementType<typename std::decay<
+         decltype(std::declval<F&>()(std::declval<const E&>()))>::type>::C
+      Map(F f) const
+      {
+         typedef typename std::decay<decltype(f(std::declval<const E&>()))>::type U;
+         typedef typename C::template SwapElementType<U>::C Target;
+
+         const int n = _array.Size();
+         const E * d = data();
+         Ref<Common::UninitializedBuffer<U> > result = new Common::UninitializedBuffer<U>(n);
+         Common::UninitializedBuffer<U> * r = result;
+         Common::ParallelChunks(n, _threads, [d, &f, r] (int, int begin, int end)
+         { for (int i = begin; i < end; ++i) r->ConstructAt(i, f(d[i])); });
+         result->Commit(n);
+         return Target(n, result);
+      }
+
+      template <class P> C Filter(P p) const { return partition(p, false).first; }
+      template <class P> C FilterNot(P p) const
+      { return partition([&p] (const E& e) { return !p(e); }, false).first; }
+      template <class P> Pair<C, C> Partition(P p) const { return partition(p, true); }
+
+      /// A sorted copy, by parallel sample sort, see ParallelSortInPlace
+      C Sorted() const
+      {
+         const int n = _array.Size();
+         Ref<Buffer> sorted = _array._data->Clone(n);
+         Common::ParallelSortInPlace((E*)*sorted, n, _threads);
+         return C(n, sorted);
+      }
+
+
+      ///////////////
+      // Factories //
+      ///////////////
+
+      /// Builds an array of N elements, g(i) for each index, in parallel
+      template <class G> static C Construct(int N, G g, int threads = 0)
+      {
+         if (threads <= 0) threads = Common::HardwareThreads();
+         Ref<Buffer> result = new Buffer(N);
+         Buffer * r = result;
+         Common::ParallelChunks(N, threads, [r, &g] (int, int begin, int end)
+         { for (int i = begin; i < end; ++i) r->ConstructAt(i, g(i)); });
+         result->Commit(N);
+         return C(N, result);
+      }
+   };
+
+
+   ////////////////////////////////
+   // ParallelArray Definitions  //
+   ////////////////////////////////
+
+   template <class E, class C> template <class P>
+   Pair<C, C> ParallelArray<E, C>::partition(P p, bool keepFalse) const
+   {
+      const E * d = data();
+      const int chunks = Common::ChunkCount(_array.Size(), _threads);
+      Ref<Buffer> * trueParts  = new Ref<Buffer>[chunks];
+      Ref<Buffer> * falseParts = new Ref<Buffer>[chunks];
+
+      /// Each chunk gathers its matches into buffers of its own
+      Common::ParallelChunks(_array.Size(), _threads,
+         [d, &p, trueParts, falseParts, keepFalse] (int c, int begin, int end)
+      {
+         Buffer * t = new Buffer(end - begin);
+         Buffer * f = new Buffer(keepFalse ? end - begin : 0);
+         for (int i = begin; i < end; ++i)
+            if (p(d[i])) t->Append(d[i]);
+            else if (keepFalse) f->Append(d[i]);
+         trueParts[c] = t; falseParts[c] = f;
+      });
+
+      Ref<Buffer> t = concatenate(trueParts, chunks);
+      Ref<Buffer> f = concatenate(falseParts, chunks);
+      delete [] trueParts;
+      delete [] falseParts;
+      return Pair<C, C>(C(t->Size(), t), C(f->Size(), f));
+   }
+
+
+   ////////////////////////////////////
+   // Array Definitions of Par()     //
+   ////////////////////////////////////
+
+   template <class E> inline ParallelArray<E, Immutable::Array<E> >
+   Immutable::Array<E>::Par(int threads) const
+   { return ParallelArray<E, Immutable::Array<E> >(*this, threads); }
+
+   template <class E> inline ParallelArray<E, Mutable::Array<E> >
+   Mutable::Array<E>::Par(int threads) const
+   { return ParallelArray<E, Mutable::Array<E> >(*this, threads); }
+
+   namespace Mutable
+   {
+      /// SortInPlace on up to 'threads' threads of the scheduler s, for
+      /// large arrays
+      template <class E> inline Array<E>& ParallelSortInPlace(Array<E>& a, int threads = 0,
+                                                              Scheduler& s = Scheduler::Default())
+      {
+         if (a.Size() > 1) Common::ParallelSortInPlace(&a[0], a.Size(), threads, s);
+         return a;
+      }
+
+      /// On every thread of the scheduler s
+      template <class E> inline Array<E>& ParallelSortInPlace(Array<E>& a, Scheduler& s)
+      { return ParallelSortInPlace(a, s.Threads(), s); }
+   }
+
+} // namespace Collections
+
+#endif // PARALLEL_H
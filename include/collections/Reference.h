@@ -2,6 +2,7 @@
 #define COLLECTIONS_REFERENCE_H
 
 #include <new>
+#include <atomic>
 
 namespace Collections
 {
@@ -17,6 +18,7 @@ namespace Collections
    public:
       inline Ref() : p(NULL) {}
       inline Ref(const Ref& a) : p(a.p) { Collections::AddRef(p); }
+      inline Ref(Ref&& a) : p(a.p) { a.p = NULL; }
       inline Ref(T* a) : p(a) { Collections::AddRef(p); }
       inline ~Ref() { Collections::Release(p); }
 
@@ -32,23 +34,104 @@ namespace Collections
       }
       inline Ref& operator =(const Ref& a) { return *this = a.p; }
 
+      /// Steals the reference, no counter traffic at all
+      inline Ref& operator =(Ref&& a)
+      {
+         if (this != &a)
+         {
+            T* old = p;
+            p = a.p; a.p = NULL;
+            Collections::Release(old);
+         }
+         return *this;
+      }
+
       inline operator T* const&() const { return p;  }
       inline operator T*      &()       { return p;  }
       inline T& operator  *    () const { return *p; }
       inline T* operator ->    () const { return  p; }
    };
 
-   class Object
+
+   ///////////////////////////////
+   // Reference Counting Policy //
+   ///////////////////////////////
+
+   /// Plain integer counter. Cheapest possible, but an object counted this
+   /// way must never have its references copied or dropped by two threads
+   /// at once.
+   class SingleThreadedRefCount
    {
    private:
-      mutable int _refCtr;
+      int _count;
 
    public:
-      inline Object() : _refCtr(0) {}
-      virtual ~Object() {}
-      inline void AddRef () const { ++_refCtr; }
-      inline void Release() const { if (--_refCtr <= 0) delete this; }
+      inline SingleThreadedRefCount() : _count(0) {}
+      inline void Increment() { ++_count; }
+
+      /// Returns true when the last reference has been dropped
+      inline bool Decrement() { return --_count <= 0; }
+      inline int Count() const { return _count; }
    };
+
+   /// Atomic counter, safe to share across threads. Taking a new reference
+   /// never needs to order anything, since the caller already holds one, so
+   /// increments are relaxed. The decrement is a release so that all writes
+   /// made through this reference happen-before the delete, and the thread
+   /// that drops the last reference issues an acquire fence before deleting.
+   /// Count() is an acquire too: a container that finds itself the sole
+   /// owner and goes on to change the object in place must first see every
+   /// write the other owners made before they let go.
+   class AtomicRefCount
+   {
+   private:
+      std::atomic<int> _count;
+
+   public:
+      inline AtomicRefCount() : _count(0) {}
+      inline void Increment() { _count.fetch_add(1, std::memory_order_relaxed); }
+
+      /// Returns true when the last reference has been dropped
+      inline bool Decrement()
+      {
+         if (_count.fetch_sub(1, std::memory_order_release) > 1) return false;
+         std::atomic_thread_fence(std::memory_order_acquire);
+         return true;
+      }
+      inline int Count() const { return _count.load(std::memory_order_acquire); }
+   };
+
+   /// The policy used by Object, and so by every container, buffer and node
+   /// pool in the library. Build with -D___ATOMIC_REFCOUNT to make immutable
+   /// containers safe to hand to other threads.
+   #if defined(___ATOMIC_REFCOUNT)
+   typedef AtomicRefCount DefaultRefCount;
+   #else
+   typedef SingleThreadedRefCount DefaultRefCount;
+   #endif
+
+   /// Intrusively reference counted base class, for use with Ref<T>. The
+   /// counter belongs to the object's identity, not its value, so copying an
+   /// object starts the copy with a fresh count, and assignment leaves the
+   /// count of the target untouched.
+   template <class RefCountPolicy>
+   class BasicObject
+   {
+   private:
+      mutable RefCountPolicy _refCtr;
+
+   public:
+      inline BasicObject() {}
+      inline BasicObject(const BasicObject&) {}
+      inline BasicObject& operator = (const BasicObject&) { return *this; }
+      virtual ~BasicObject() {}
+
+      inline void AddRef () const { _refCtr.Increment(); }
+      inline void Release() const { if (_refCtr.Decrement()) delete this; }
+      inline int RefCount() const { return _refCtr.Count(); }
+   };
+
+   typedef BasicObject<DefaultRefCount> Object;
 }
 
 #endif // REFERENCE_H
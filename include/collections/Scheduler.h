@@ -0,0 +1,541 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+#include "Traversable.h"
+
+////////////////////////////////////
+// Work Stealing Task Scheduler   //
+////////////////////////////////////
+
+/// A pool of worker threads that runs fork-join work:
+///
+///    Scheduler::TaskGroup g;
+///    g.Spawn([&] () { left = Fib(n-1); });
+///    right = Fib(n-2);
+///    g.Sync();
+///
+///    ParallelFor(0, n, 1024, [&] (int begin, int end) { ... });
+///
+/// Every worker owns a deque of tasks. Spawn pushes onto the bottom of the
+/// spawning worker's deque and the owner pops from the bottom again, so a
+/// worker runs its own tasks depth first and in cache friendly order. A
+/// worker that runs out of tasks steals from the top of another worker's
+/// deque, which holds the oldest, and so usually largest, piece of work.
+///
+/// A thread waiting in Sync() does not block, it keeps running tasks (its
+/// own first, then stolen ones) until the tasks it waits on are done. This
+/// includes threads outside the pool: their spawns go to a shared deque,
+/// which they use as their own, and they help run work while they wait.
+///
+/// Tasks must not block on each other except through Sync(). Build with
+/// ___ATOMIC_REFCOUNT if tasks copy containers that other tasks share.
+
+namespace Collections
+{
+   class Scheduler;
+
+   namespace Common
+   {
+      /// Base class of everything the scheduler runs. Run() is responsible
+      /// for deleting the task once it is done.
+      class Task
+      {
+      public:
+         virtual ~Task() {}
+         virtual void Run() = 0;
+      };
+
+
+      /// The Chase-Lev work stealing deque, with the C11 memory orderings of
+      /// Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work
+      /// Stealing for Weak Memory Models" (PPoPP 2013). Push and Pop may
+      /// only be called by the owner, Steal by any thread.
+      class WorkDeque
+      {
+      private:
+         /// Ring buffer of task pointers. Growing allocates a ring twice the
+         /// size, the old ring is kept (thieves may still be reading it) and
+         /// freed with the deque.
+         struct Ring
+         {
+            long long mask;
+            std::atomic<Task*> * slots;
+            Ring * previous;
+
+            inline Ring(int logSize, Ring * prev)
+               : mask((1LL << logSize) - 1), slots(new std::atomic<Task*>[1LL << logSize]), previous(prev) {}
+            inline ~Ring() { delete [] slots; delete previous; }
+
+            inline long long Size() const { return mask + 1; }
+            inline Task * Get(long long i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+            inline void Put(long long i, Task * t) { slots[i & mask].store(t, std::memory_order_relaxed); }
+
+            Ring * Grow(long long top, long long bottom)
+            {
+               int logSize = 0;
+               while ((1LL << logSize) < 2 * Size()) logSize++;
+               Ring * r = new Ring(logSize, this);
+               for (long long i = top; i < bottom; ++i) r->Put(i, Get(i));
+               return r;
+            }
+         };
+
+         /// top and bottom are written by different threads, keep them apart
+         std::atomic<long long> _top;
+         char _pad0[64];
+         std::atomic<long long> _bottom;
+         std::atomic<Ring*> _ring;
+         char _pad1[64];
+
+         WorkDeque(const WorkDeque&);
+         WorkDeque& operator = (const WorkDeque&);
+
+      public:
+         inline WorkDeque(int logSize = 8) : _top(0), _bottom(0), _ring(new Ring(logSize, nullptr)) {}
+         inline ~WorkDeque() { delete _ring.load(); }
+
+         /// Approximate, may be stale by the time it returns
+         inline bool IsEmpty() const
+         { return _bottom.load(std::memory_order_relaxed) <= _top.load(std::memory_order_relaxed); }
+
+         void Push(Task * t)
+         {
+            const long long b = _bottom.load(std::memory_order_relaxed);
+            const long long top = _top.load(std::memory_order_acquire);
+            Ring * r = _ring.load(std::memory_order_relaxed);
+            if (b - top > r->Size() - 1)
+            {
+               r = r->Grow(top, b);
+               _ring.store(r, std::memory_order_release);
+            }
+            r->Put(b, t);
+            _bottom.store(b + 1, std::memory_order_release);
+         }
+
+         /// Takes the most recently pushed task, or nullptr
+         Task * Pop()
+         {
+            const long long b = _bottom.load(std::memory_order_relaxed) - 1;
+            Ring * r = _ring.load(std::memory_order_relaxed);
+            _bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            long long t = _top.load(std::memory_order_relaxed);
+
+            Task * task = nullptr;
+            if (t <= b)
+            {
+               task = r->Get(b);
+               if (t == b)
+               {
+                  /// Last task left, race any thieves for it
+                  if (!_top.compare_exchange_strong(t, t + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed))
+                     task = nullptr;
+                  _bottom.store(b + 1, std::memory_order_relaxed);
+               }
+            }
+            else _bottom.store(b + 1, std::memory_order_relaxed);
+            return task;
+         }
+
+         /// Takes the oldest task, or nullptr. 'contended' is set when the
+         /// deque was not empty but another thread won the race for the task.
+         Task * Steal(bool& contended)
+         {
+            contended = false;
+            long long t = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const long long b = _bottom.load(std::memory_order_acquire);
+            if (t >= b) return nullptr;
+
+            Ring * r = _ring.load(std::memory_order_acquire);
+            Task * task = r->Get(t);
+            if (!_top.compare_exchange_strong(t, t + 1,
+                  std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+               contended = true;
+               return nullptr;
+            }
+            return task;
+         }
+      };
+
+
+      /// Counters of one worker. Written only by their worker, and read
+      /// relaxed by anyone, so the padding keeps them off each other's
+      /// cache lines.
+      struct WorkerCounters
+      {
+         std::atomic<long long> tasksRun, steals, failedSteals, idleNanoseconds;
+         char pad[64];
+
+         inline WorkerCounters() : tasksRun(0), steals(0), failedSteals(0), idleNanoseconds(0) {}
+         inline void Add(std::atomic<long long>& c, long long n) { c.fetch_add(n, std::memory_order_relaxed); }
+      };
+   }
+
+
+   /// A snapshot of the counters of one worker
+   struct WorkerStats
+   {
+      long long tasksRun;        ///< Tasks this worker ran, spawned or stolen
+      long long steals;          ///< Tasks taken from other workers' deques
+      long long failedSteals;    ///< Steals lost to another thread
+      double idleMilliseconds;   ///< Time spent with nothing to run
+
+      inline WorkerStats() : tasksRun(0), steals(0), failedSteals(0), idleMilliseconds(0) {}
+   };
+
+
+   class Scheduler
+   {
+   private:
+      struct Worker
+      {
+         Common::WorkDeque deque;
+         Common::WorkerCounters counters;
+         std::thread thread;
+         unsigned int seed;
+      };
+
+      /// Which scheduler, and which of its workers, the current thread is
+      struct Context { Scheduler * scheduler; int index; };
+      static inline Context& current()
+      {
+         static thread_local Context c = { nullptr, -1 };
+         return c;
+      }
+
+      int _workerCount;
+      Worker * _workers;
+
+      /// Threads outside the pool spawn here, the mutex serializes the owner
+      /// side (Push and Pop) between them
+      Common::WorkDeque _shared;
+      std::mutex _sharedMutex;
+
+      /// Counters of all threads outside the pool, lumped together
+      Common::WorkerCounters _external;
+
+      /// Sleeping workers. A spawn bumps the epoch after publishing its task,
+      /// a worker only sleeps if the epoch has not moved since it last looked
+      /// for work, so no wake up is ever lost.
+      std::atomic<int> _sleepers;
+      std::atomic<unsigned int> _epoch;
+      std::atomic<bool> _shutdown;
+      std::mutex _sleepMutex;
+      std::condition_variable _wake;
+
+      Scheduler(const Scheduler&);
+      Scheduler& operator = (const Scheduler&);
+
+      inline int currentIndex() { Context& c = current(); return c.scheduler == this ? c.index : -1; }
+      inline Common::WorkerCounters& countersOf(int index)
+      { return index >= 0 ? _workers[index].counters : _external; }
+
+      void submit(Common::Task * t);
+      Common::Task * findWork(int index);
+      Common::Task * stealFrom(int index, unsigned int& seed);
+      void run(Common::Task * t, int index);
+      void workerLoop(int index);
+
+      template <class F> class FunctionTask;
+
+   public:
+      /// Starts 'threads' workers. Threads calling Sync() help out, so a
+      /// pool one smaller than the hardware keeps every core busy.
+      explicit Scheduler(int threads);
+      ~Scheduler();
+
+      /// The scheduler used by ParallelFor and Par(), with one worker fewer
+      /// than there are hardware threads
+      static Scheduler& Default();
+
+      /// Number of pool threads, plus one for the thread calling Sync()
+      inline int Threads() const { return _workerCount + 1; }
+      inline int Workers() const { return _workerCount; }
+
+      /// Counters of worker i, or with i == Workers() of all threads outside
+      /// the pool combined
+      WorkerStats Stats(int i) const;
+      void ResetStats();
+
+      /// Runs one pending task on the calling thread, if there is one
+      bool RunPending();
+
+
+      /// A set of spawned tasks to wait for. Groups nest freely: a task may
+      /// create its own groups and sync them. The destructor syncs.
+      class TaskGroup
+      {
+      private:
+         Scheduler& _scheduler;
+         std::atomic<int> _pending;
+
+         template <class F> friend class Scheduler::FunctionTask;
+
+         TaskGroup(const TaskGroup&);
+         TaskGroup& operator = (const TaskGroup&);
+
+      public:
+         inline TaskGroup(Scheduler& s = Scheduler::Default()) : _scheduler(s), _pending(0) {}
+         inline ~TaskGroup() { Sync(); }
+
+         /// f() will run at some point before Sync() returns, maybe on
+         /// another thread. f is copied.
+         template <class F> void Spawn(const F& f);
+
+         /// Returns once every task spawned on this group has finished,
+         /// running pending tasks in the meantime
+         void Sync();
+      };
+   };
+
+
+   /////////////////////////////
+   // Scheduler Definitions   //
+   /////////////////////////////
+
+   template <class F> class Scheduler::FunctionTask : public Common::Task
+   {
+   private:
+      F _f;
+      TaskGroup * _group;
+
+   public:
+      inline FunctionTask(const F& f, TaskGroup * g) : _f(f), _group(g) {}
+      void Run()
+      {
+         TaskGroup * g = _group;
+         _f();
+         delete this;
+         g->_pending.fetch_sub(1, std::memory_order_release);
+      }
+   };
+
+   inline Scheduler::Scheduler(int threads)
+      : _workerCount(threads > 0 ? threads : 0), _workers(nullptr),
+        _sleepers(0), _epoch(0), _shutdown(false)
+   {
+      if (_workerCount == 0) return;
+      _workers = new Worker[_workerCount];
+      for (int i = 0; i < _workerCount; ++i)
+      {
+         _workers[i].seed = 0x9E3779B9u * (i + 1);
+         _workers[i].thread = std::thread([this, i] () { workerLoop(i); });
+      }
+   }
+
+   inline Scheduler::~Scheduler()
+   {
+      {
+         std::lock_guard<std::mutex> lock(_sleepMutex);
+         _shutdown.store(true);
+      }
+      _wake.notify_all();
+      for (int i = 0; i < _workerCount; ++i) _workers[i].thread.join();
+      delete [] _workers;
+   }
+
+   inline Scheduler& Scheduler::Default()
+   {
+      static Scheduler s((int)std::thread::hardware_concurrency() - 1);
+      return s;
+   }
+
+   inline void Scheduler::submit(Common::Task * t)
+   {
+      const int index = currentIndex();
+      if (index >= 0) _workers[index].deque.Push(t);
+      else
+      {
+         std::lock_guard<std::mutex> lock(_sharedMutex);
+         _shared.Push(t);
+      }
+
+      _epoch.fetch_add(1, std::memory_order_seq_cst);
+      if (_sleepers.load(std::memory_order_seq_cst) > 0)
+      {
+         std::lock_guard<std::mutex> lock(_sleepMutex);
+         _wake.notify_one();
+      }
+   }
+
+   /// Visits the other deques starting at a random one, then the shared one
+   inline Common::Task * Scheduler::stealFrom(int index, unsigned int& seed)
+   {
+      Common::WorkerCounters& counters = countersOf(index);
+      seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+
+      for (int k = 0; k <= _workerCount; ++k)
+      {
+         const int victim = _workerCount > 0 ? (int)((seed + k) % (unsigned int)(_workerCount + 1)) : 0;
+         if (victim == index) continue;
+         Common::WorkDeque& d = victim < _workerCount ? _workers[victim].deque : _shared;
+
+         bool contended;
+         Common::Task * t = d.Steal(contended);
+         if (t) { counters.Add(counters.steals, 1); return t; }
+         if (contended) counters.Add(counters.failedSteals, 1);
+      }
+      return nullptr;
+   }
+
+   inline Common::Task * Scheduler::findWork(int index)
+   {
+      if (index >= 0)
+      {
+         Common::Task * t = _workers[index].deque.Pop();
+         if (t) return t;
+         return stealFrom(index, _workers[index].seed);
+      }
+
+      /// Threads outside the pool share the shared deque's owner end, the
+      /// mutex makes them take turns at it
+      {
+         std::lock_guard<std::mutex> lock(_sharedMutex);
+         Common::Task * t = _shared.Pop();
+         if (t) return t;
+      }
+      static thread_local unsigned int seed = 0x2545F491u;
+      return stealFrom(-1, seed);
+   }
+
+   inline void Scheduler::run(Common::Task * t, int index)
+   {
+      Common::WorkerCounters& counters = countersOf(index);
+      counters.Add(counters.tasksRun, 1);
+      t->Run();
+   }
+
+   inline bool Scheduler::RunPending()
+   {
+      const int index = currentIndex();
+      Common::Task * t = findWork(index);
+      if (t) run(t, index);
+      return t != nullptr;
+   }
+
+   inline void Scheduler::workerLoop(int index)
+   {
+      Context& c = current();
+      c.scheduler = this; c.index = index;
+      Common::WorkerCounters& counters = _workers[index].counters;
+      typedef std::chrono::steady_clock Clock;
+
+      while (!_shutdown.load(std::memory_order_relaxed))
+      {
+         Common::Task * t = findWork(index);
+         if (t) { run(t, index); continue; }
+
+         const Clock::time_point idleStart = Clock::now();
+
+         /// Spin briefly before going to sleep, work often turns up quickly
+         for (int spin = 0; spin < 64 && !t; ++spin)
+         {
+            std::this_thread::yield();
+            t = findWork(index);
+         }
+
+         if (!t)
+         {
+            _sleepers.fetch_add(1, std::memory_order_seq_cst);
+            const unsigned int epoch = _epoch.load(std::memory_order_seq_cst);
+            t = findWork(index);
+            if (!t)
+            {
+               std::unique_lock<std::mutex> lock(_sleepMutex);
+               while (_epoch.load(std::memory_order_seq_cst) == epoch && !_shutdown.load())
+                  _wake.wait(lock);
+            }
+            _sleepers.fetch_sub(1, std::memory_order_seq_cst);
+         }
+
+         counters.Add(counters.idleNanoseconds,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - idleStart).count());
+         if (t) run(t, index);
+      }
+   }
+
+   inline WorkerStats Scheduler::Stats(int i) const
+   {
+      assert(i >= 0 && i <= _workerCount);
+      const Common::WorkerCounters& c = i < _workerCount ? _workers[i].counters : _external;
+      WorkerStats s;
+      s.tasksRun = c.tasksRun.load(std::memory_order_relaxed);
+      s.steals = c.steals.load(std::memory_order_relaxed);
+      s.failedSteals = c.failedSteals.load(std::memory_order_relaxed);
+      s.idleMilliseconds = c.idleNanoseconds.load(std::memory_order_relaxed) / 1e6;
+      return s;
+   }
+
+   inline void Scheduler::ResetStats()
+   {
+      for (int i = 0; i <= _workerCount; ++i)
+      {
+         Common::WorkerCounters& c = countersOf(i < _workerCount ? i : -1);
+         c.tasksRun.store(0); c.steals.store(0); c.failedSteals.store(0); c.idleNanoseconds.store(0);
+      }
+   }
+
+   template <class F> inline void Scheduler::TaskGroup::Spawn(const F& f)
+   {
+      _pending.fetch_add(1, std::memory_order_relaxed);
+      _scheduler.submit(new FunctionTask<F>(f, this));
+   }
+
+   inline void Scheduler::TaskGroup::Sync()
+   {
+      while (_pending.load(std::memory_order_acquire) > 0)
+         if (!_scheduler.RunPending()) std::this_thread::yield();
+   }
+
+
+   ////////////////////
+   // Parallel Loops //
+   ////////////////////
+
+   namespace Common
+   {
+      template <class F> void parallelFor(Scheduler& s, int begin, int end, int grain, const F& f)
+      {
+         /// Hand the upper half to the pool and keep splitting the lower half,
+         /// so thieves always find the largest remaining ranges
+         Scheduler::TaskGroup g(s);
+         while (end - begin > grain)
+         {
+            const int middle = begin + (end - begin) / 2;
+            g.Spawn([&s, middle, end, grain, &f] () { parallelFor(s, middle, end, grain, f); });
+            end = middle;
+         }
+         f(begin, end);
+         g.Sync();
+      }
+   }
+
+   /// Calls f(b, e) on disjoint ranges covering [begin, end), each at most
+   /// 'grain' long, in parallel. Returns when all of them have run.
+   template <class F> inline void ParallelFor(int begin, int end, int grain, const F& f,
+                                              Scheduler& s = Scheduler::Default())
+   {
+      if (end <= begin) return;
+      Common::parallelFor(s, begin, end, grain > 0 ? grain : 1, f);
+   }
+
+   /// As above, with a grain giving each thread about eight ranges
+   template <class F> inline void ParallelFor(int begin, int end, const F& f)
+   {
+      Scheduler& s = Scheduler::Default();
+      const int grain = (end - begin) / (8 * s.Threads());
+      ParallelFor(begin, end, grain, f, s);
+   }
+
+} // namespace Collections
+
+#endif // SCHEDULER_H
@@ -0,0 +1,218 @@
+#ifndef SORTING_NETWORKS_H
+#define SORTING_NETWORKS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <type_traits>
+
+#if defined(___SSE4)
+#include <smmintrin.h>
+#endif
+
+//////////////////////////////////////
+// SIMD Sorting Networks            //
+//////////////////////////////////////
+
+/// Sorting kernels for blocks of up to 64 32-bit keys (int, unsigned int,
+/// float), four keys to an SSE register. A block of 16 is sorted entirely in
+/// registers:
+///
+///    1. An odd-even merge network of min/max pairs sorts the four columns
+///       of the 4x4 block, which a transpose turns into four sorted rows
+///    2. Bitonic merges join the rows into two sorted runs of 8, and those
+///       into one run of 16
+///
+/// Blocks of 32 and 64 are sorted 16 at a time and then merged in a single
+/// streaming pass per level: a bitonic merge of two registers emits the
+/// lower four keys and carries the upper four, which are merged next with
+/// the register from whichever run has the smaller head. No branches depend
+/// on the keys except that choice.
+///
+/// Keys are mapped onto signed integers that compare the same way, so one
+/// set of kernels serves all three types: unsigned keys flip their sign bit,
+/// and floats flip all but the sign bit when negative (ordering them like
+/// RadixKey does, which puts -0.0 before 0.0 and NaNs at the ends rather
+/// than losing them to min/max). A block is padded to 16, 32 or 64 with the
+/// largest key, sorted, and the first n keys mapped back.
+///
+/// The kernels need SSE4.1 (for the 32-bit integer min/max) and are only
+/// compiled with ___SSE4. SortingNetwork<E>::Simd tells whether a type has
+/// them, Common::SortSmall() in ArrayCommon.h works for any type.
+
+namespace Collections
+{
+   namespace Common
+   {
+      /// Largest block the networks sort
+      static const int SORT_NETWORK_MAX = 64;
+
+      template <class E, class Enable = void> struct SortingNetwork
+      { static const bool Simd = false; };
+
+      #if defined(___SSE4)
+      namespace Networks
+      {
+         typedef __m128i Reg;
+
+         inline Reg load(const int32_t * p) { return _mm_load_si128((const Reg*)p); }
+         inline void store(int32_t * p, Reg r) { _mm_store_si128((Reg*)p, r); }
+
+         inline void minMax(Reg& a, Reg& b)
+         {
+            const Reg t = _mm_min_epi32(a, b);
+            b = _mm_max_epi32(a, b);
+            a = t;
+         }
+
+         inline Reg reverse(Reg r) { return _mm_shuffle_epi32(r, _MM_SHUFFLE(0, 1, 2, 3)); }
+
+         template <int I0, int I1, int I2, int I3> inline Reg shuffle2(Reg a, Reg b)
+         {
+            return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b),
+                                                   _MM_SHUFFLE(I3, I2, I1, I0)));
+         }
+
+         /// Sorts a and b, each of which is a bitonic sequence of 4, with
+         /// compare distances 2 then 1, both registers at once
+         inline void sortBitonic4x2(Reg& a, Reg& b)
+         {
+            Reg x = _mm_unpacklo_epi64(a, b), y = _mm_unpackhi_epi64(a, b);
+            minMax(x, y);
+            Reg p = shuffle2<0, 2, 0, 2>(x, y), q = shuffle2<1, 3, 1, 3>(x, y);
+            minMax(p, q);
+            const Reg u = _mm_unpacklo_epi32(p, q), v = _mm_unpackhi_epi32(p, q);
+            a = _mm_unpacklo_epi64(u, v);
+            b = _mm_unpackhi_epi64(u, v);
+         }
+
+         /// a and b sorted on entry, on exit a holds the lower four of the
+         /// eight keys and b the upper four, both sorted
+         inline void merge4(Reg& a, Reg& b)
+         {
+            b = reverse(b);
+            minMax(a, b);
+            sortBitonic4x2(a, b);
+         }
+
+         /// (r0, r1) and (r2, r3) sorted runs of 8 on entry, one run of 16 on exit
+         inline void merge8(Reg& r0, Reg& r1, Reg& r2, Reg& r3)
+         {
+            Reg s2 = reverse(r3), s3 = reverse(r2);
+            minMax(r0, s2); minMax(r1, s3);
+            minMax(r0, r1); minMax(s2, s3);
+            sortBitonic4x2(r0, r1);
+            sortBitonic4x2(s2, s3);
+            r2 = s2; r3 = s3;
+         }
+
+         inline void sort16(int32_t * d)
+         {
+            Reg r0 = load(d), r1 = load(d + 4), r2 = load(d + 8), r3 = load(d + 12);
+
+            /// Batcher's odd-even merge network for 4 keys, down the columns
+            minMax(r0, r1); minMax(r2, r3);
+            minMax(r0, r2); minMax(r1, r3);
+            minMax(r1, r2);
+
+            __m128 c0 = _mm_castsi128_ps(r0), c1 = _mm_castsi128_ps(r1),
+                   c2 = _mm_castsi128_ps(r2), c3 = _mm_castsi128_ps(r3);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            r0 = _mm_castps_si128(c0); r1 = _mm_castps_si128(c1);
+            r2 = _mm_castps_si128(c2); r3 = _mm_castps_si128(c3);
+
+            merge4(r0, r1); merge4(r2, r3);
+            merge8(r0, r1, r2, r3);
+
+            store(d, r0); store(d + 4, r1); store(d + 8, r2); store(d + 12, r3);
+         }
+
+         /// Merges the sorted runs a[0, n) and b[0, n), n a multiple of 4, into out
+         inline void mergeRuns(const int32_t * a, const int32_t * b, int n, int32_t * out)
+         {
+            Reg low = load(a), high = load(b);
+            int i = 4, j = 4;
+            merge4(low, high);
+            store(out, low); out += 4;
+
+            while (i < n || j < n)
+            {
+               const bool takeA = j >= n || (i < n && a[i] <= b[j]);
+               Reg next = takeA ? load(a + i) : load(b + j);
+               if (takeA) i += 4; else j += 4;
+               merge4(next, high);
+               store(out, next); out += 4;
+            }
+            store(out, high);
+         }
+
+         /// Sorts a block of 16, 32 or 64 keys, aligned to 16 bytes
+         inline void sortBlock(int32_t * d, int block)
+         {
+            for (int i = 0; i < block; i += 16) sort16(d + i);
+            if (block == 16) return;
+
+            alignas(16) int32_t t[SORT_NETWORK_MAX];
+            if (block == 32) { mergeRuns(d, d + 16, 16, t); memcpy(d, t, 32 * sizeof(int32_t)); return; }
+
+            mergeRuns(d, d + 16, 16, t);
+            mergeRuns(d + 32, d + 48, 16, t + 32);
+            mergeRuns(t, t + 32, 32, d);
+         }
+
+         /// Order preserving maps onto int32_t, each its own inverse
+         template <class E> struct Key;
+         template <> struct Key<int32_t>
+         {
+            static inline int32_t Scalar(int32_t k) { return k; }
+            static inline Reg Vector(Reg r) { return r; }
+         };
+         template <> struct Key<uint32_t>
+         {
+            static inline int32_t Scalar(int32_t k) { return (int32_t)((uint32_t)k ^ 0x80000000u); }
+            static inline Reg Vector(Reg r) { return _mm_xor_si128(r, _mm_set1_epi32((int32_t)0x80000000u)); }
+         };
+         template <> struct Key<float>
+         {
+            static inline int32_t Scalar(int32_t k) { return k ^ ((k >> 31) & 0x7FFFFFFF); }
+            static inline Reg Vector(Reg r)
+            { return _mm_xor_si128(r, _mm_and_si128(_mm_srai_epi32(r, 31), _mm_set1_epi32(0x7FFFFFFF))); }
+         };
+      }
+
+      template <class E> struct SortingNetwork<E, typename std::enable_if<sizeof(E) == 4 &&
+         (std::is_integral<E>::value || std::is_same<E, float>::value)>::type>
+      {
+         static const bool Simd = true;
+
+         typedef typename std::conditional<std::is_same<E, float>::value, float,
+            typename std::conditional<std::is_signed<E>::value, int32_t, uint32_t>::type>::type KeyType;
+         typedef Networks::Key<KeyType> Key;
+
+         /// Sorts a[0, n), n <= SORT_NETWORK_MAX
+         static void Sort(E * a, int n)
+         {
+            assert(n >= 0 && n <= SORT_NETWORK_MAX);
+            if (n < 2) return;
+
+            alignas(16) int32_t keys[SORT_NETWORK_MAX];
+            const int block = n <= 16 ? 16 : n <= 32 ? 32 : 64;
+
+            int i = 0;
+            for (; i + 4 <= n; i += 4)
+               Networks::store(keys + i, Key::Vector(_mm_loadu_si128((const Networks::Reg*)(a + i))));
+            for (; i < n; ++i) { int32_t k; memcpy(&k, a + i, 4); keys[i] = Key::Scalar(k); }
+            for (; i < block; ++i) keys[i] = INT32_MAX;
+
+            Networks::sortBlock(keys, block);
+
+            for (i = 0; i + 4 <= n; i += 4)
+               _mm_storeu_si128((Networks::Reg*)(a + i), Key::Vector(Networks::load(keys + i)));
+            for (; i < n; ++i) { const int32_t k = Key::Scalar(keys[i]); memcpy(a + i, &k, 4); }
+         }
+      };
+      #endif // ___SSE4
+   }
+}
+
+#endif // SORTING_NETWORKS_H
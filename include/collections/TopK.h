@@ -0,0 +1,83 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include "Vector.h"
+
+/////////////////////////////////
+// Streaming Top-K Selection   //
+/////////////////////////////////
+
+/// Keeps the k smallest elements seen so far (in the comparator's order) out
+/// of a stream too large, or too scattered, to gather into an array first:
+///
+///    TopKAccumulator<float> nearest(10);
+///    nearest.AddAll(distances.GetIterator());
+///    nearest.AddAll(moreDistances.GetIterator());
+///    Mutable::Array<float> ten = nearest.Result();
+///
+/// The elements are held in a max-heap of at most k, so the k-th smallest is
+/// always on top, and an element that does not beat it costs one comparison.
+/// O(log k) per element at worst, O(k) memory. Pass a "greater than"
+/// comparator to keep the k largest instead.
+
+namespace Collections
+{
+   template <class E, class F = Common::OperatorLessThan<E> > class TopKAccumulator
+   {
+   private:
+      Vector<E> _heap;
+      int _k;
+      F _lessThan;
+
+      inline E * heap() { return &_heap[0]; }
+
+   public:
+      inline TopKAccumulator(int k, F lessThan = F())
+         : _heap(Vector<E>::Construct(k > 0 ? k : 1)), _k(k > 0 ? k : 0), _lessThan(lessThan) {}
+
+      inline int K() const { return _k; }
+      inline int Size() const { return _heap.Size(); }
+      inline bool IsFull() const { return _heap.Size() == _k; }
+
+      /// The k-th smallest so far, which an element must beat to get in
+      inline const E& Threshold() const { assert(Size() > 0); return _heap[0]; }
+
+      inline void Add(const E& e)
+      {
+         if (_heap.Size() < _k)
+         {
+            _heap.Push(e);
+            Common::SiftUpWith(heap(), _heap.Size() - 1, _lessThan);
+         }
+         else if (_k > 0 && _lessThan(e, heap()[0]))
+         {
+            heap()[0] = e;
+            Common::SiftDownWith(heap(), 0, _k, _lessThan);
+         }
+      }
+
+      /// Takes every remaining element of any Traversable's iterator
+      template <class Itr> inline void AddAll(Itr itr)
+      { while (itr.HasNext()) Add(itr.Next()); }
+
+      inline void Clear() { _heap.Clear(); }
+
+      /// O(k log k). The elements kept, in order, the accumulator is left
+      /// as it was.
+      Mutable::Array<E> Result() const
+      {
+         const int n = _heap.Size();
+         typename Mutable::Array<E>::Builder builder(n);
+         for (int i = 0; i < n; ++i) builder.AddElement(_heap[i]);
+         Mutable::Array<E> result = builder.Result();
+         if (n > 0)
+         {
+            F lessThan = _lessThan;
+            Common::SortHeapWith(&result[0], n, lessThan);
+         }
+         return result;
+      }
+   };
+}
+
+#endif // TOP_K_H
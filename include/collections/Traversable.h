@@ -2,6 +2,10 @@
 #define TRAVERSABLE_H
 
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+#include <type_traits>
 #include "Reference.h"
 
 /* Design Principles
@@ -21,10 +25,10 @@
  *          LinkedList   (Mutable, Immutable)
  *          Array        (Mutable, Immutable)
  *       Set
- *          HashSet
+ *          HashSet (Mutable, Immutable)
  *          TreeSet (Sorted, Mutable, Immutable)
  *       Map
- *          HashMap
+ *          HashMap (Mutable, Immutable)
  *          TreeMap (SortedMap)
  */
 
@@ -40,11 +44,29 @@ namespace Collections
    {
    public:
       A first; B second;
+      inline Pair() {}
       inline Pair(const A& a, const B& b) : first(a), second(b) {}
+      inline Pair(A&& a, B&& b) : first(std::move(a)), second(std::move(b)) {}
+
+      inline bool operator == (const Pair& rhs) const { return first == rhs.first && second == rhs.second; }
+      inline bool operator != (const Pair& rhs) const { return !(*this == rhs); }
+
+      /// Lexicographic, first then second
+      inline bool operator < (const Pair& rhs) const
+      { return first < rhs.first || (!(rhs.first < first) && second < rhs.second); }
    };
 
    namespace Common
    {      
+      /// Reads the node pools and trees of the node based containers, whose
+      /// layout no interface shows, for the unit tests. Only declared here.
+      struct Internals;
+
+      /// operator < as a function object, the default comparator of the
+      /// algorithms that take one, so that it inlines like a lambda
+      template <class E> struct OperatorLessThan
+      { inline bool operator () (const E& a, const E& b) const { return a < b; } };
+
       template <class E> class InitializedBuffer : public Object
       {
       private:
@@ -61,6 +83,21 @@ namespace Collections
             if (_capacity > 0) _pool = new E[_capacity];
          }
 
+         inline InitializedBuffer(InitializedBuffer&& rhs)
+            : _pool(rhs._pool), _capacity(rhs._capacity)
+         { rhs._pool = nullptr; rhs._capacity = 0; }
+
+         inline InitializedBuffer& operator = (InitializedBuffer&& rhs)
+         {
+            if (this != &rhs)
+            {
+               if (_pool) delete [] _pool;
+               _pool = rhs._pool; _capacity = rhs._capacity;
+               rhs._pool = nullptr; rhs._capacity = 0;
+            }
+            return *this;
+         }
+
          inline ~InitializedBuffer()
          { if (_pool) { delete [] _pool; _pool = nullptr; } }
 
@@ -75,31 +112,182 @@ namespace Collections
       };
 
 
+      /// Backing store for the array collections. The allocation is raw memory
+      /// and elements are placement constructed as they are appended, so only
+      /// the first Size() slots hold live objects; the rest, up to Capacity(),
+      /// is uninitialized. Building an array of N elements therefore costs N
+      /// constructions instead of N default constructions plus N assignments.
+      ///
+      /// Growth relocates the live elements. Trivially copyable types are
+      /// relocated by realloc, which can often extend the block in place and
+      /// otherwise falls back to a memcpy, everything else is move constructed
+      /// into the new block and destroyed in the old one.
+      template <class E> class UninitializedBuffer : public Object
+      {
+      private:
+         E * _pool;
+         int _capacity, _size;
+
+         static const bool TRIVIALLY_RELOCATABLE = std::is_trivially_copyable<E>::value;
+         static const bool TRIVIALLY_DESTRUCTIBLE = std::is_trivially_destructible<E>::value;
+
+         inline void destroy()
+         {
+            if (!TRIVIALLY_DESTRUCTIBLE)
+               for (int i = 0; i < _size; ++i) _pool[i].~E();
+            _size = 0;
+         }
+
+      public:
+         inline int Capacity() const { return _capacity; }
+         inline int Size() const { return _size; }
+
+         /// Allocates room for initialCapacity elements, and default constructs
+         /// the first initialSize of them
+         inline UninitializedBuffer(int initialCapacity = 0, int initialSize = 0)
+            : _pool(nullptr), _capacity(0), _size(0)
+         {
+            assert(initialSize <= initialCapacity);
+            Reserve(initialCapacity);
+            if (!std::is_trivial<E>::value)
+               for (int i = 0; i < initialSize; ++i) new (_pool+i) E;
+            _size = initialSize;
+         }
+
+         inline ~UninitializedBuffer() { destroy(); if (_pool) free(_pool); }
+
+         /// Grows the allocation to hold at least newCapacity elements, the live
+         /// elements are relocated and keep their indices
+         void Reserve(int newCapacity)
+         {
+            if (newCapacity <= _capacity) return;
+
+            if (TRIVIALLY_RELOCATABLE)
+            {
+               E * newPool = (E*)realloc((void*)_pool, newCapacity * sizeof(E));
+               assert(newPool);
+               _pool = newPool;
+            }
+            else
+            {
+               E * newPool = (E*)malloc(newCapacity * sizeof(E));
+               assert(newPool);
+               for (int i = 0; i < _size; ++i)
+               {
+                  new (newPool+i) E(std::move(_pool[i]));  //< Move
+                  _pool[i].~E();                           //< Destroy
+               }
+               if (_pool) free(_pool);
+               _pool = newPool;
+            }
+            _capacity = newCapacity;
+         }
+
+         /// Returns a new buffer of the given capacity holding copies of the
+         /// live elements. Used when growing a buffer that is shared.
+         Ref<UninitializedBuffer> Clone(int newCapacity) const
+         {
+            Ref<UninitializedBuffer> b = new UninitializedBuffer(newCapacity > _size ? newCapacity : _size);
+            if (TRIVIALLY_RELOCATABLE && _size > 0) memcpy((void*)b->_pool, _pool, _size * sizeof(E));
+            else for (int i = 0; i < _size; ++i) new (b->_pool+i) E(_pool[i]);
+            b->_size = _size;
+            return b;
+         }
+
+         /// Constructs a new element in the first uninitialized slot
+         template <class U> inline void Append(U&& e)
+         {
+            assert(_size < _capacity);
+            new (_pool + _size) E(std::forward<U>(e));
+            _size++;
+         }
+
+         /// Constructs an element in an arbitrary uninitialized slot, so that
+         /// disjoint ranges can be filled concurrently. The slots are not live
+         /// until Commit() declares them so.
+         template <class U> inline void ConstructAt(int i, U&& e)
+         {
+            assert(i >= _size && i < _capacity);
+            new (_pool + i) E(std::forward<U>(e));
+         }
+
+         /// Declares every slot below n live, after they have all been filled
+         /// with ConstructAt()
+         inline void Commit(int n) { assert(n >= _size && n <= _capacity); _size = n; }
+
+         inline const E& operator [] (int i) const { return Index(i); }
+         inline E& operator [] (int i) { return Index(i); }
+
+         inline const E& Index (int i) const { assert(i >= 0 && i < _size); return _pool[i]; }
+         inline E& Index (int i) { assert(i >= 0 && i < _size); return _pool[i]; } 
+
+         inline operator E* const&() const { return _pool; }
+         inline operator E*      &()       { return _pool; }     
+
+      private:
+         UninitializedBuffer(const UninitializedBuffer&);
+         UninitializedBuffer& operator = (const UninitializedBuffer&);
+      };
+
+
+      /// Backing store for node based collections, nodes refer to each other by
+      /// index into the pool. Slots released with Free() are threaded onto an
+      /// intrusive free list (the index of the next free slot is written into
+      /// the dead slot itself) and handed out again by Push() before the pool
+      /// grows, so that a container with steady churn has a bounded footprint.
       template <class E> class MemoryPool : public Object
       {
       private:
          static const int MIN_CAPACITY = 0x10;
+         static_assert(sizeof(E) >= sizeof(int), "free list links are stored in dead slots");
 
          // _pool is an UNINITIALIZED buffer, cannot use assignment for new
          // entries...
          E * _pool;
          int _capacity, _nextFreeIndex;
 
+         /// Head of the free list, -1 when there are no freed slots
+         int _freeHead, _freeCount;
+
          /// Private constructor that does no allocations, used internally only
-         inline MemoryPool() : _pool(nullptr), _capacity(0), _nextFreeIndex(-1) {}
+         inline MemoryPool() 
+            : _pool(nullptr), _capacity(0), _nextFreeIndex(-1), _freeHead(-1), _freeCount(0) {}
 
          inline bool isFull() const { return _capacity == _nextFreeIndex; }
 
+         inline int nextFree(int i) const { int n; memcpy(&n, _pool+i, sizeof(int)); return n; }
+         inline void setNextFree(int i, int n) { memcpy((void*)(_pool+i), &n, sizeof(int)); }
+
+         /// Returns a flag per slot below _nextFreeIndex marking the dead ones,
+         /// or nullptr if there are none. The caller frees the array.
+         bool * deadSlots() const
+         {
+            if (_freeCount == 0) return nullptr;
+            bool * dead = (bool*)calloc(_nextFreeIndex, sizeof(bool));
+            for (int i = _freeHead; i != -1; i = nextFree(i)) dead[i] = true;
+            return dead;
+         }
+
+         /// Copies (or moves) the live slots of src into the raw memory dst,
+         /// and the free list links of the dead ones
+         template <bool Move> static void relocate(E * dst, E * src, int n, const bool * dead)
+         {
+            for (int i = 0; i < n; ++i)
+            {
+               if (dead && dead[i]) memcpy((void*)(dst+i), src+i, sizeof(int));
+               else if (Move) { new (dst+i) E(std::move(src[i])); src[i].~E(); }
+               else new (dst+i) E(src[i]);
+            }
+         }
+
          void resize(int newCapacity)
          {
             if (newCapacity <= Capacity()) return;
 
             E * newPool = (E*)malloc(newCapacity * sizeof(E));
-            for (int i = 0; i < _nextFreeIndex; ++i)
-            {
-               new (newPool+i) E(_pool[i]);  //< Copy
-               _pool[i].~E();                //< Destroy
-            }
+            bool * dead = deadSlots();
+            relocate<true>(newPool, _pool, _nextFreeIndex, dead);
+            if (dead) free(dead);
 
             if (_pool) free(_pool);
             _pool = newPool;
@@ -115,42 +303,135 @@ namespace Collections
             }
          }
 
+         /// Returns the slot the next element should be constructed in
+         inline int allocate()
+         {
+            if (_freeHead != -1)
+            {
+               int i = _freeHead;
+               _freeHead = nextFree(i);
+               _freeCount--;
+               return i;
+            }
+            expandIfFull();
+            return _nextFreeIndex++;
+         }
+
+         /// Destroys every element and releases the allocation
+         void clear()
+         {
+            bool * dead = deadSlots();
+            for (int i = 0; i < _nextFreeIndex; ++i) if (!dead || !dead[i]) _pool[i].~E();
+            if (dead) free(dead);
+            if (_pool) free(_pool);
+            _pool = nullptr; _capacity = 0; _nextFreeIndex = 0;
+            _freeHead = -1; _freeCount = 0;
+         }
+
       public:
          inline int Capacity() const { return _capacity; }
-         inline int NextFreeIndex() const { return _nextFreeIndex; }
+         /// Read atomically, since Append() may be claiming slots on other threads
+         inline int NextFreeIndex() const { return __atomic_load_n(&_nextFreeIndex, __ATOMIC_RELAXED); }
+
+         /// Number of live elements, which is less than NextFreeIndex() by
+         /// the number of slots waiting on the free list
+         inline int Size() const { return NextFreeIndex() - _freeCount; }
+         inline int FreeCount() const { return _freeCount; }
 
          Ref<MemoryPool> Clone() const
          {
             Ref<MemoryPool> p = new MemoryPool();
             p->_capacity = _capacity;
             p->_nextFreeIndex = _nextFreeIndex;
+            p->_freeHead = _freeHead;
+            p->_freeCount = _freeCount;
             p->_pool = (E*)malloc(_capacity * sizeof(E));
-            for (int i = 0; i < _nextFreeIndex; ++i)
-               new (p->_pool+i) E(_pool[i]);  //< Copy Each Object
+            bool * dead = deadSlots();
+            relocate<false>(p->_pool, _pool, _nextFreeIndex, dead);  //< Copy Each Object
+            if (dead) free(dead);
             return p;
          }
 
          /// Constructor with initial size
          MemoryPool(int initialCapacity)
-            : _pool(nullptr), _capacity(0), _nextFreeIndex(0)
+            : _pool(nullptr), _capacity(0), _nextFreeIndex(0), _freeHead(-1), _freeCount(0)
          {
             resize(MIN_CAPACITY > initialCapacity ? MIN_CAPACITY : initialCapacity);
             assert(_capacity >= initialCapacity);
          }
 
+         /// Takes over the other pool's allocation, leaving it empty
+         MemoryPool(MemoryPool&& rhs)
+            : _pool(rhs._pool), _capacity(rhs._capacity), _nextFreeIndex(rhs._nextFreeIndex)
+            , _freeHead(rhs._freeHead), _freeCount(rhs._freeCount)
+         { 
+            rhs._pool = nullptr; rhs._capacity = 0; rhs._nextFreeIndex = 0; 
+            rhs._freeHead = -1; rhs._freeCount = 0;
+         }
+
+         MemoryPool& operator = (MemoryPool&& rhs)
+         {
+            if (this != &rhs)
+            {
+               clear();
+               _pool = rhs._pool; _capacity = rhs._capacity; _nextFreeIndex = rhs._nextFreeIndex;
+               _freeHead = rhs._freeHead; _freeCount = rhs._freeCount;
+               rhs._pool = nullptr; rhs._capacity = 0; rhs._nextFreeIndex = 0;
+               rhs._freeHead = -1; rhs._freeCount = 0;
+            }
+            return *this;
+         }
+
+         ~MemoryPool() { clear(); }
+
          /// Adds a new element to the pool, returns the index for the newly
-         /// added element
+         /// added element. Freed slots are reused first.
          int Push(const E& e)
          {
-            expandIfFull();
-            new (_pool + _nextFreeIndex) E(e);
-            _nextFreeIndex++;
-            return _nextFreeIndex-1;
+            int i = allocate();
+            new (_pool + i) E(e);
+            return i;
+         }
+
+         int Push(E&& e)
+         {
+            int i = allocate();
+            new (_pool + i) E(std::move(e));
+            return i;
+         }
+
+         /// Adds a new element for a version of a persistent container, and
+         /// returns its index, or -1 if the pool is shared and full. The other
+         /// owners of a shared pool may be reading it, or appending to it, on
+         /// other threads, so it never moves: the slot past the last one is
+         /// claimed with a compare and swap, and a full pool stays full. A
+         /// pool with no other owner grows as with Push(). e may refer into
+         /// the pool.
+         template <class U> int Append(U&& e)
+         {
+            if (RefCount() <= 1) { E copy(std::forward<U>(e)); return Push(std::move(copy)); }
+
+            int i = NextFreeIndex();
+            do { if (i >= _capacity) return -1; }
+            while (!__atomic_compare_exchange_n(&_nextFreeIndex, &i, i + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+            new (_pool + i) E(std::forward<U>(e));
+            return i;
+         }
+
+         /// Destroys the element at index i and puts its slot on the free list.
+         /// Nothing may refer to index i afterwards.
+         void Free(int i)
+         {
+            assert(i >= 0 && i < _nextFreeIndex);
+            _pool[i].~E();
+            setNextFree(i, _freeHead);
+            _freeHead = i;
+            _freeCount++;
          }
 
          void Pop()
          {
-            assert(_nextFreeIndex > 0);
+            assert(_nextFreeIndex > 0 && _freeCount == 0);
             (_pool + _nextFreeIndex-1)->~E();
             _nextFreeIndex--;
          }
@@ -172,6 +453,12 @@ namespace Collections
 
 namespace Collections
 {
+   namespace Views
+   {
+      template <class S> class View;
+      template <class Itr, class E> class IteratorSource;
+   }
+
    class EmptyCollectionException {};
    class NoElementFoundException {};
 
@@ -256,6 +543,10 @@ namespace Collections
       virtual Pair<C, C> Partition(Predicate p) const { return partition(p); }
       virtual Pair<C, C> Partition(PredicateByValue p) const { return partition(p); }
 
+      /// Lazy pipeline over the elements, see View.h. Combinators chained
+      /// on a view do no work until a terminal operation such as To<C>()
+      Views::View<Views::IteratorSource<Iterator, E> > View() const;
+
       template <class P> inline bool ForAll     (P p) const;
       template <class P> inline bool Exists     (P p) const;
       template <class P> inline int  Count      (P p) const;
@@ -392,7 +683,7 @@ namespace Collections
       while (iterator.HasNext())
       {
          E e = iterator.Next();
-         if (p(e)) builder.AddElement(e);
+         if (p(e)) builder.AddElement(std::move(e));
       }
       return builder.Result();
    }
@@ -405,7 +696,7 @@ namespace Collections
       while (iterator.HasNext())
       {
          E e = iterator.Next();
-         if (!p(e)) builder.AddElement(e);
+         if (!p(e)) builder.AddElement(std::move(e));
       }
       return builder.Result();
    }
@@ -451,8 +742,8 @@ namespace Collections
       while (iterator.HasNext())
       {
          E e = iterator.Next();
-         if (p(e)) builderTrue.AddElement(e);
-         else      builderFalse.AddElement(e);
+         if (p(e)) builderTrue.AddElement(std::move(e));
+         else      builderFalse.AddElement(std::move(e));
       }
       return Pair<C, C>(builderTrue.Result(), builderFalse.Result());
    }
@@ -1,7 +1,13 @@
 #ifndef TREE_COMMON_H
 #define TREE_COMMON_H
 
+#include <stdint.h>
+#include <type_traits>
+
 #include "Vector.h"
+#include "Hash.h"
+#include "FlatCommon.h"
+#include "Scheduler.h"
 
 namespace Collections
 {
@@ -38,19 +44,121 @@ namespace Collections
 
       template <class T> inline bool
       Equals(const T& lhs, const T& rhs) { return lhs == rhs; }
-      
 
+      template <class A, class B> class KeyValuePair;
+
+
+      ////////////////////
+      // Treap Priority //
+      ////////////////////
+
+      /// A treap node's priority is a hash of its key rather than a random
+      /// number, so the shape of a tree depends only on the keys it holds,
+      /// not on the order they arrived in or on which thread built it. Two
+      /// trees holding the same key give its nodes the same priority, which
+      /// the split and join set operations below rely on to keep the
+      /// result's shape canonical. Maps hash only the key.
+      ///
+      /// The 64-bit finalizer from MurmurHash3 spreads even consecutive
+      /// integers evenly over the priority range.
+      inline int MixPriority(uint64_t x)
+      {
+         x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+         x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+         x ^= x >> 33;
+         return int(uint32_t(x));
+      }
+
+      /// Other types with a Common::Hash (Hash.h) take the low bits of their
+      /// hash. Types with no hash fall back on a per-thread generator, which
+      /// is reproducible for a given insertion order and needs no locking.
+      template <class E, class Enable = void> struct TreePriority
+      {
+         static inline int Of(const E& e) { return of(e, HasHash<E>()); }
+
+      private:
+         static inline int of(const E& e, std::true_type) { return int(uint32_t(Hash<E>::Of(e))); }
+         static inline int of(const E&, std::false_type)
+         {
+            static thread_local uint64_t state = 0x9E3779B97F4A7C15ULL;
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            return MixPriority(state);
+         }
+      };
+
+      template <class E> struct TreePriority<E, typename std::enable_if<
+         std::is_integral<E>::value || std::is_enum<E>::value>::type>
+      { static inline int Of(E e) { return MixPriority(uint64_t(e)); } };
+
+      template <class E> struct TreePriority<E, typename std::enable_if<std::is_floating_point<E>::value>::type>
+      {
+         /// -0.0 == 0.0, so both must hash alike
+         static inline int Of(E e)
+         {
+            const double d = e == 0 ? 0.0 : double(e);
+            uint64_t bits; memcpy(&bits, &d, sizeof(bits));
+            return MixPriority(bits);
+         }
+      };
+
+      template <class E> struct TreePriority<E*>
+      { static inline int Of(const E * e) { return MixPriority(uint64_t(uintptr_t(e))); } };
+
+      template <class A, class B> struct TreePriority<KeyValuePair<A, B> >
+      { static inline int Of(const KeyValuePair<A, B>& e) { return TreePriority<A>::Of(e.key); } };
+
+      template <class A, class B> struct TreePriority<Pair<A, B> >
+      {
+         static inline int Of(const Pair<A, B>& e)
+         { return MixPriority(uint64_t(uint32_t(TreePriority<A>::Of(e.first))) * 31 + uint32_t(TreePriority<B>::Of(e.second))); }
+      };
+
+
+      class TreeStack;
+
+      /// 'count' is the number of nodes in the subtree rooted at the node,
+      /// itself included, which makes the tree an order statistic tree
       template <class E> class BinaryTreeNode
       {
       public:
-         int left, right, priority;
+         int left, right, priority, count;
          E payload;
+
+         inline BinaryTreeNode() {}
+         template <class U> inline BinaryTreeNode(U&& p, int pr)
+            : left(-1), right(-1), priority(pr), count(1), payload(std::forward<U>(p)) {}
       };
 
       template <class E> class BinaryTree
       {
       private:
          void Remove(int& n);
+         template <class U> bool insert(U&& e);
+         bool graft(const MemoryPool<BinaryTreeNode<E> >& from, int n, int& copy);
+
+         /// The persistent updates in this tree, which may share its pool with
+         /// other versions. Each returns false, leaving the tree as it was, if
+         /// the shared pool fills up on the way, and otherwise can not fail.
+         bool persistentInsert(const E& e, bool& added);
+         bool persistentRemove(const E& e, bool& removed);
+         bool persistentSplitAt(int k, int& l, int& r);
+
+         /// Appends a copy of node n to the pool and returns the copy, or -1
+         /// if the pool is shared and full. Other versions sharing the pool
+         /// may be appending to it at the same time.
+         inline int copy(int n) { return _pool->Append((*_pool)[n]); }
+
+         /// Node n, if it is at or above 'fresh' and so belongs to the update
+         /// under way, or otherwise a copy of it, ready to be relinked. -1 if
+         /// the copy does not fit.
+         inline int unshare(int n, int fresh) { return n >= fresh ? n : copy(n); }
+
+         /// Returns the slot of an unlinked node to the pool, unless some other
+         /// container or iterator still shares the pool and may refer to it
+         inline void release(int n) { if (_pool->RefCount() == 1) _pool->Free(n); }
+
+         /// Takes one off the count of every ancestor of node n
+         void discount(int n);
 
       public:
          int _root;
@@ -61,6 +169,33 @@ namespace Collections
          inline BinaryTree(int r, Ref<MemoryPool<BinaryTreeNode<E> > > pool) :
             _root(r), _pool(pool) {}
 
+         /// The number of nodes in the subtree n, and the update of n's count
+         /// from its children's, for after its links have changed
+         inline int Count(int n) const { return n == -1 ? 0 : (*_pool)[n].count; }
+         inline void Recount(int n)
+         {
+            BinaryTreeNode<E>& node = (*_pool)[n];
+            node.count = 1 + Count(node.left) + Count(node.right);
+         }
+
+         /// Order statistics, O(log n): the number of elements less than e,
+         /// and the node holding the i-th smallest element (from 0)
+         int Rank(const E& e) const;
+         int Select(int i) const;
+
+         /// O(log n), the node holding the first element not less than e, or
+         /// greater than e if strict, or -1 if there is none. If given, 'path'
+         /// is left holding the nodes passed on the left on the way down,
+         /// short of the bound itself, which is where an iterator positioned
+         /// at the bound carries on from.
+         int Bound(const E& e, bool strict, TreeStack * path = nullptr) const;
+
+         /// O(log n), the node holding e, or -1, with 'path' holding the nodes
+         /// passed on the left on the way down to it, which is where an
+         /// iterator positioned at e carries on from. 'path' is left empty if
+         /// e is not in the tree.
+         int Seek(const E& e, TreeStack& path) const;
+
          /// Finds the element e in the binary tree, records the index of the 
          /// parent node and the target node in the out parameters. If target
          /// is either not found (-1) or is the root node, then parent := -1
@@ -73,11 +208,81 @@ namespace Collections
          /// The ordering property of the binary search tree is preserved as
          /// long as this is performed on the root node of the tree
          ///
-         bool Insert(const E& e);
+         inline bool Insert(const E& e) { return insert(e); }
+         inline bool Insert(E&& e) { return insert(std::move(e)); }
 
          /// Removes the node 'n' from the tree, preserving the ordering property
          void Remove(int n, int parent);
 
+         /// Rebuilds the node pool holding only the nodes reachable from the
+         /// root, laid out in traversal order so that iteration walks memory
+         /// front to back, with room for 'capacity' nodes if that is more.
+         /// Indices into the old pool are invalidated.
+         void Compact(int capacity = 0);
+
+         /// Copies the tree into a pool of its own, with room for 'capacity'
+         /// nodes if that is more, and leaves the old pool as it was. Other
+         /// versions sharing the old pool may append to it meanwhile.
+         void Detach(int capacity);
+
+         /// Split() divides the subtree t into the keys less than e, rooted
+         /// at l, and the keys greater, rooted at r, and sets 'found' to the
+         /// node holding e, or -1. That node's own links are left as they
+         /// were. Join() links the subtrees l and r, every key in l less than
+         /// every key in r, into one. Both are O(log n).
+         ///
+         /// These and the set algebra below relink the nodes at or above
+         /// 'fresh' in place: they were made by the operation under way, and
+         /// nothing else refers to them. The nodes below 'fresh' may be shared
+         /// with other versions, and are copied with MemoryPool::Append()
+         /// before they are relinked, so that the inputs stay as they were.
+         /// With 'fresh' at 0 nothing is copied and nothing allocated. Each
+         /// returns false if a copy does not fit in the shared pool.
+         bool Split(int t, const E& e, int fresh, int& l, int& r, int& found);
+         bool Join(int l, int r, int fresh, int& joined);
+
+         /// Set algebra by split and join on the subtrees a and b of this
+         /// tree's pool. Sets 'root' to the root of the result, and adds the
+         /// number of keys found in both to 'matched'. The two recursive
+         /// halves run as tasks on the scheduler s for the first 'forks'
+         /// levels.
+         bool Union(int a, int b, int fresh, int forks, Scheduler& s, int& root, int& matched);
+         bool Intersection(int a, int b, int fresh, int forks, Scheduler& s, int& root, int& matched);
+         bool Difference(int a, int b, int fresh, int forks, Scheduler& s, int& root, int& matched);
+
+         /// Copies the nodes of another tree into this pool, with Append(),
+         /// and sets 'root' to the index of the copy's root. Returns false if
+         /// the pool is shared and they do not fit.
+         bool Graft(const BinaryTree& other, int& root) { return graft(*other._pool, other._root, root); }
+
+         /// Persistent updates, for the immutable trees. No existing node is
+         /// touched: the nodes on the path from the root down to the change
+         /// are copied to the end of the pool and the copies relinked, so this
+         /// tree, and every other version sharing its pool, stay as they
+         /// were. Each returns the new version, which shares the pool, in
+         /// O(log n) time and new nodes. PersistentInsert replaces an element
+         /// equal to e, which is how a map updates a value. New nodes only
+         /// go into fresh slots, with MemoryPool::Append(), and a shared pool
+         /// never moves, so versions sharing a pool can be read and updated
+         /// on any number of threads at once. Once the shared pool is full,
+         /// the update starts over on a compacted copy of this tree, in a
+         /// pool of its own.
+         BinaryTree PersistentInsert(const E& e, bool& added) const;
+         BinaryTree PersistentRemove(const E& e, bool& removed) const;
+
+         /// Splits the tree into its first k elements, l, and the rest, r,
+         /// copying only the O(log n) nodes on the path between them. Both
+         /// share this tree's pool.
+         void PersistentSplitAt(int k, BinaryTree& l, BinaryTree& r) const;
+
+         /// Detaches the tree into a pool of its own with room for a run of
+         /// persistent updates
+         inline void CompactForUpdates();
+
+         /// Compacts the tree into a pool of its own if the pool it shares
+         /// holds more than TREE_PERSISTENT_SLACK times its 'size' nodes
+         inline void CompactIfSparse(int size);
+
          /// Tree Rotations, used to maintain balance
          void RotateLeft(int a, int b, int aParent);
          void RotateRight(int a, int b, int bParent);
@@ -100,6 +305,59 @@ namespace Collections
       //////////////////////////
 
 
+      /// The path from the root to an iterator's position, kept inline in the
+      /// iterator so that iterating never touches the allocator. The stack
+      /// holds the ancestors we went left from, so its height is bounded by
+      /// the depth of the tree. A treap's expected depth is under 3 log2(n),
+      /// which for any pool indexable by an int is comfortably below the
+      /// inline capacity; a pathologically deep path spills to the heap
+      /// rather than failing.
+      class TreeStack
+      {
+      private:
+         static const int INLINE_DEPTH = 96;
+
+         int _inline[INLINE_DEPTH];
+         int * _heap;
+         int _size, _capacity;
+
+         inline int * data() { return _heap ? _heap : _inline; }
+         inline const int * data() const { return _heap ? _heap : _inline; }
+
+         void grow()
+         {
+            int * heap = (int*)malloc(2 * _capacity * sizeof(int));
+            memcpy(heap, data(), _size * sizeof(int));
+            if (_heap) free(_heap);
+            _heap = heap;
+            _capacity *= 2;
+         }
+
+      public:
+         inline TreeStack() : _heap(nullptr), _size(0), _capacity(INLINE_DEPTH) {}
+         inline ~TreeStack() { if (_heap) free(_heap); }
+
+         /// Copies only the live part of the stack
+         inline TreeStack(const TreeStack& rhs) : _heap(nullptr), _size(0), _capacity(INLINE_DEPTH)
+         { *this = rhs; }
+
+         inline TreeStack& operator = (const TreeStack& rhs)
+         {
+            if (this == &rhs) return *this;
+            while (_capacity < rhs._size) grow();
+            _size = rhs._size;
+            memcpy(data(), rhs.data(), _size * sizeof(int));
+            return *this;
+         }
+
+         inline int Size() const { return _size; }
+         inline void Clear() { _size = 0; }
+         inline void Push(int n) { if (_size == _capacity) grow(); data()[_size++] = n; }
+         inline int Pop() { assert(_size > 0); return data()[--_size]; }
+         inline int Top() const { assert(_size > 0); return data()[_size-1]; }
+      };
+
+
       /// We are looking for the next-left-most node. The next node is not 
       /// in our left subtree, but is the left-most node in the right 
       /// subtree, if we have a right subtree. If we do not have a right 
@@ -122,6 +380,10 @@ namespace Collections
          return e; 
 
 
+      /// Where an iterator starts from, for LowerBound() and UpperBound()
+      enum TreeBound { TREE_LOWER_BOUND, TREE_UPPER_BOUND };
+
+
       template <class E, class C> class MutableBinaryTreeIterator
       {
       protected:
@@ -134,12 +396,14 @@ namespace Collections
          friend class Mutable::TreeMap<typename C::KeyType, typename C::ValueType>;
 
          Ref<MemoryPool<BinaryTreeNode<E> > > _pool;
-         Vector<int> _stack;
+         TreeStack _stack;
          int _nextNode;
+         int _endNode;  //< The node the iteration stops at, -1 for the end of the tree
 
          inline MutableBinaryTreeIterator(const BinaryTree<E>& a) 
             : _pool(a._pool)
             , _nextNode(a._root) 
+            , _endNode(-1)
          {
             /// The initial node should be the left-most node
             /// and the stack should contain the path to get there
@@ -153,14 +417,38 @@ namespace Collections
             }            
          }
 
+         /// Positions the iterator at e, with the stack holding the path to it,
+         /// so that iteration carries on in order from there. The iterator is
+         /// exhausted if e is not present.
+         inline MutableBinaryTreeIterator(const BinaryTree<E>& a, const E& e)
+            : _pool(a._pool), _nextNode(-1), _endNode(-1) { _nextNode = a.Seek(e, _stack); }
+
+         /// Positions the iterator at the lower or upper bound of e, so that
+         /// iteration carries on in order from there to the end of the tree
+         inline MutableBinaryTreeIterator(const BinaryTree<E>& a, const E& e, TreeBound bound)
+            : _pool(a._pool), _nextNode(-1), _endNode(-1)
+         { _nextNode = a.Bound(e, bound == TREE_UPPER_BOUND, &_stack); }
+
+         /// Iterates over the elements in [lo, hi), O(log n) to set up. The
+         /// iteration stops at the lower bound of hi, which cannot come before
+         /// the lower bound of lo.
+         inline MutableBinaryTreeIterator(const BinaryTree<E>& a, const E& lo, const E& hi)
+            : _pool(a._pool), _nextNode(-1), _endNode(-1)
+         {
+            if (!(lo < hi)) return;
+            _nextNode = a.Bound(lo, false, &_stack);
+            _endNode = a.Bound(hi, false);
+         }
+
       public:
 
          inline MutableBinaryTreeIterator(const MutableBinaryTreeIterator<E, C>& itr)
             : _pool(itr._pool)
-            , _stack(itr._stack.Copy())  //< Copy to make sure it's not aliased
-            , _nextNode(itr._nextNode) {}
+            , _stack(itr._stack)
+            , _nextNode(itr._nextNode)
+            , _endNode(itr._endNode) {}
 
-         inline bool HasNext() const { return _nextNode != -1; }
+         inline bool HasNext() const { return _nextNode != _endNode; }
          inline E& Next() { TREE_ITERATOR_NEXT(); }
 
          inline const E& Peek() const
@@ -188,12 +476,14 @@ namespace Collections
          friend class Mutable::TreeMap<typename C::KeyType, typename C::ValueType>;
 
          Ref<MemoryPool<BinaryTreeNode<E> > > _pool;
-         Vector<int> _stack;
+         TreeStack _stack;
          int _nextNode;
+         int _endNode;  //< The node the iteration stops at, -1 for the end of the tree
 
          inline BinaryTreeIterator(const BinaryTree<E>& a) 
             : _pool(a._pool)
             , _nextNode(a._root) 
+            , _endNode(-1)
          {
             /// The initial node should be the left-most node
             /// and the stack should contain the path to get there
@@ -207,14 +497,30 @@ namespace Collections
             }            
          }
 
+         inline BinaryTreeIterator(const BinaryTree<E>& a, const E& e)
+            : _pool(a._pool), _nextNode(-1), _endNode(-1) { _nextNode = a.Seek(e, _stack); }
+
+         inline BinaryTreeIterator(const BinaryTree<E>& a, const E& e, TreeBound bound)
+            : _pool(a._pool), _nextNode(-1), _endNode(-1)
+         { _nextNode = a.Bound(e, bound == TREE_UPPER_BOUND, &_stack); }
+
+         inline BinaryTreeIterator(const BinaryTree<E>& a, const E& lo, const E& hi)
+            : _pool(a._pool), _nextNode(-1), _endNode(-1)
+         {
+            if (!(lo < hi)) return;
+            _nextNode = a.Bound(lo, false, &_stack);
+            _endNode = a.Bound(hi, false);
+         }
+
       public:
 
          inline BinaryTreeIterator(const MutableBinaryTreeIterator<E, C>& itr)
             : _pool(itr._pool)
-            , _stack(itr._stack.Copy())  //< Copy to make sure it's not aliased
-            , _nextNode(itr._nextNode) {}
+            , _stack(itr._stack)
+            , _nextNode(itr._nextNode)
+            , _endNode(itr._endNode) {}
 
-         inline bool HasNext() const { return _nextNode != -1; }
+         inline bool HasNext() const { return _nextNode != _endNode; }
          inline const E& Next() { TREE_ITERATOR_NEXT(); }
 
          inline const E& Peek() const
@@ -229,10 +535,74 @@ namespace Collections
       };
 
 
+      /////////////////////////
+      // Sorted Tree Builder //
+      /////////////////////////
+
+      /// Builds a treap from elements that arrive in strictly ascending
+      /// order, in O(n) rather than O(n log n), with no searching and no
+      /// rotations. Each new element is the largest so far, so it belongs on
+      /// the tree's right spine: the spine nodes of lower priority than the
+      /// new node become its left subtree, and it becomes the right child of
+      /// the spine node above them. Every node is pushed onto and popped off
+      /// the spine at most once, and its subtree is complete, and counted,
+      /// when it is popped. The nodes are allocated in sorted order, so
+      /// iterating the result walks the pool front to back.
+      template <class E> class SortedTreeBuilder
+      {
+      private:
+         BinaryTree<E> _tree;
+         TreeStack _spine;    //< The right spine of the tree so far, root first
+         int _size;
+
+      public:
+         inline SortedTreeBuilder(int allocation = 1) : _tree(max(allocation, 1)), _size(0) {}
+
+         /// True if e is greater than everything appended so far
+         inline bool Accepts(const E& e) const
+         { return _spine.Size() == 0 || _tree._pool->Index(_spine.Top()).payload < e; }
+
+         template <class U> inline void Append(U&& e)
+         {
+            MemoryPool<BinaryTreeNode<E> >& pool = *_tree._pool;
+            assert(Accepts(e));
+
+            const int priority = TreePriority<E>::Of(e);
+            const int n = pool.Push(BinaryTreeNode<E>(std::forward<U>(e), priority));
+            int below = -1;
+            while (_spine.Size() > 0 && pool[_spine.Top()].priority < pool[n].priority)
+               { below = _spine.Pop(); _tree.Recount(below); }
+
+            pool[n].left = below;
+            if (_spine.Size() > 0) pool[_spine.Top()].right = n;
+            else _tree._root = n;
+            _spine.Push(n);
+            _size++;
+         }
+
+         inline int Size() const { return _size; }
+
+         /// The builder is disposable, so the tree is handed over to the result
+         inline BinaryTree<E> Result()
+         {
+            while (_spine.Size() > 0) _tree.Recount(_spine.Pop());
+            return std::move(_tree);
+         }
+      };
+
+
       /////////////////////////
       // Binary Tree Builder //
       /////////////////////////
 
+      /// Takes elements in any order. While they arrive in strictly ascending
+      /// order, as they do from another sorted container or from sorted
+      /// input, they go straight onto a SortedTreeBuilder, in O(1) each. From
+      /// the first one out of order on the rest are only collected, and
+      /// Result() sorts them once and merges them with the ascending run into
+      /// a new tree, O(n log n) in all but with no searching or rotating.
+      /// Either way the result's nodes are laid out in the pool in sorted
+      /// order. Of equal elements the first one added is kept.
       template <class E, class C> class BinaryTreeBuilder
       {
       private:
@@ -247,17 +617,55 @@ namespace Collections
          /// Flag goes true when the result has been returned and the 
          /// builder can no longer be used (it is disposable)
          bool _complete;
-         int _size;
 
-         BinaryTree<E> _tree; //< The tree under construction
+         SortedTreeBuilder<E> _ascending;       //< The ascending run the input starts with
+         Ref<UninitializedBuffer<E> > _rest;    //< Everything after it, unsorted
+
+         template <class U> inline void add(U&& e)
+         {
+            assert(!_complete);
+            if (_rest == nullptr)
+            {
+               if (_ascending.Accepts(e)) { _ascending.Append(std::forward<U>(e)); return; }
+               _rest = new UninitializedBuffer<E>(max(_ascending.Size(), 0x10));
+            }
+            else if (_rest->Size() == _rest->Capacity()) _rest->Reserve(2 * _rest->Capacity());
+            _rest->Append(std::forward<U>(e));
+         }
+
+         /// Merges the ascending run with the rest, sorted, the run winning ties
+         BinaryTree<E> merge(int& size)
+         {
+            E * rest = (E*)*_rest;
+            const int m = FlatSortUnique(rest, _rest->Size());
+
+            BinaryTree<E> run = _ascending.Result();
+            MemoryPool<BinaryTreeNode<E> >& pool = *run._pool;
+            const int n = pool.Size();
 
-         inline BinaryTreeBuilder(const BinaryTree<E>& tree, int size)
-            : _tree(tree), _size(size), _complete(false) {}
+            SortedTreeBuilder<E> merged(n + m);
+            int i = 0, j = 0;
+            while (i < n && j < m)
+            {
+               if (rest[j] < pool[i].payload) merged.Append(std::move(rest[j++]));
+               else
+               {
+                  if (!(pool[i].payload < rest[j])) j++;
+                  merged.Append(std::move(pool[i++].payload));
+               }
+            }
+            for (; i < n; ++i) merged.Append(std::move(pool[i].payload));
+            for (; j < m; ++j) merged.Append(std::move(rest[j]));
+
+            _rest = nullptr;
+            size = merged.Size();
+            return merged.Result();
+         }
          
       public:
 
          inline BinaryTreeBuilder(int allocation = 1) 
-            : _complete(false), _size(0), _tree(allocation) {}
+            : _complete(false), _ascending(allocation) {}
       
          //////////////////////////////////////////////
          // Copy and Assignment, Reference Semantics //
@@ -265,34 +673,184 @@ namespace Collections
 
          inline BinaryTreeBuilder(const BinaryTreeBuilder& rhs)
             : _complete(rhs._complete)
-            , _size(rhs._size)
-            , _tree(rhs._tree) { }
+            , _ascending(rhs._ascending)
+            , _rest(rhs._rest) { }
 
          /// Should we allow this??  This strikes me as highly questionable
          inline BinaryTreeBuilder& operator = (const BinaryTreeBuilder& rhs)
          {  
             _complete = rhs._complete;  
-            _tree = rhs._tree;  
-            _size = rhs._size;       
+            _ascending = rhs._ascending;  
+            _rest = rhs._rest;       
             return *this; 
          }
 
-         /// This is set insertion, returns false if 'e' was preexistant, 
-         /// automatically avoids inserting duplicates
-         /// We should move the implementation of this routine to the node
-         /// object, so that it can be used internally by the tree collections
-         /// without a builder (general in-place insertion).
-         inline bool AddElement(E e) 
-         {
-            assert(!_complete);  
-            if (_tree.Insert(e)) { _size++; return true; }
-            return false;       
+         inline BinaryTreeBuilder(BinaryTreeBuilder&& rhs)
+            : _complete(rhs._complete)
+            , _ascending(std::move(rhs._ascending))
+            , _rest(std::move(rhs._rest)) { rhs._complete = true; }
+
+         inline BinaryTreeBuilder& operator = (BinaryTreeBuilder&& rhs)
+         {  
+            _complete = rhs._complete;  
+            _ascending = std::move(rhs._ascending);  
+            _rest = std::move(rhs._rest);       
+            rhs._complete = true;
+            return *this; 
          }
 
-         inline C Result() { _complete = true; return C(_size, _tree); }
+         inline void AddElement(const E& e) { add(e); }
+         inline void AddElement(E&& e) { add(std::move(e)); }
+
+         /// The builder is disposable, so the tree is handed over to the result
+         inline C Result()
+         {
+            assert(!_complete);
+            _complete = true;
+            int size = _ascending.Size();
+            BinaryTree<E> tree = _rest == nullptr ? _ascending.Result() : merge(size);
+            return C(size, std::move(tree));
+         }
       };
 
 
+      /////////////////////////
+      // Ordered Set Algebra //
+      /////////////////////////
+
+      enum TreeMergeOp { TREE_UNION, TREE_INTERSECTION, TREE_DIFFERENCE };
+
+      /// One simultaneous walk over two iterators that produce their elements
+      /// in ascending order, appending the union, intersection or difference
+      /// to 'out' in O(n + m). 'out' is anything with an Append() that takes
+      /// ascending elements, such as a SortedTreeBuilder. Where both hold an
+      /// equal element the one from 'a' is kept.
+      template <TreeMergeOp Op, class Itr, class Out>
+      void MergeSorted(Itr a, Itr b, Out& out)
+      {
+         while (a.HasNext() && b.HasNext())
+         {
+            if (a.Peek() < b.Peek())
+            {
+               const auto& e = a.Next();
+               if (Op != TREE_INTERSECTION) out.Append(e);
+            }
+            else if (b.Peek() < a.Peek())
+            {
+               const auto& e = b.Next();
+               if (Op == TREE_UNION) out.Append(e);
+            }
+            else
+            {
+               const auto& e = a.Next(); b.Next();
+               if (Op != TREE_DIFFERENCE) out.Append(e);
+            }
+         }
+         if (Op != TREE_INTERSECTION) while (a.HasNext()) out.Append(a.Next());
+         if (Op == TREE_UNION)        while (b.HasNext()) out.Append(b.Next());
+      }
+
+      /// True if every element 'sub' produces is also produced by 'super',
+      /// both in ascending order, O(n + m)
+      template <class Itr> bool SortedIncludes(Itr sub, Itr super)
+      {
+         while (sub.HasNext())
+         {
+            while (super.HasNext() && super.Peek() < sub.Peek()) super.Next();
+            if (!super.HasNext() || sub.Peek() < super.Peek()) return false;
+            sub.Next(); super.Next();
+         }
+         return true;
+      }
+
+      /// Join based set algebra is used where one set is more than this many
+      /// times the size of the other, or where both together hold at least
+      /// TREE_JOIN_PARALLEL_MIN keys and there are threads to share the work
+      static const int TREE_JOIN_RATIO = 4;
+      static const int TREE_JOIN_PARALLEL_MIN = 1 << 16;
+
+      inline bool PreferJoin(int n, int m)
+      {
+         if (min(n, m) * TREE_JOIN_RATIO < max(n, m)) return true;
+         return n + m >= TREE_JOIN_PARALLEL_MIN && Scheduler::Default().Threads() > 1;
+      }
+
+      /// Levels of the join recursion that fork, enough for about eight
+      /// tasks per thread of the scheduler s
+      inline int JoinForks(Scheduler& s = Scheduler::Default())
+      {
+         int threads = s.Threads(), forks = 3;
+         if (threads == 1) return 0;
+         while (threads > 1) { forks++; threads >>= 1; }
+         return forks;
+      }
+
+      /// The union, intersection or difference of a (n keys) and b (m keys)
+      /// as a new tree, by split and join, in O(m log(n/m + 1)) for m <= n,
+      /// with the recursion forking onto the scheduler s.
+      ///
+      /// If 'shared', for the immutable trees, the result shares the larger
+      /// tree's pool: the smaller tree is grafted onto it, unless it already
+      /// lives there, and the splits and joins copy the nodes they relink,
+      /// so no other node of the larger tree is ever copied. Should the pool
+      /// fill up, the operation starts over, as the persistent updates do,
+      /// on a copy of the larger tree in a pool of its own with room for
+      /// updates, where nothing needs copying. Otherwise the result must
+      /// not share nodes with a or b, and the larger tree is copied into a
+      /// new pool, without comparisons, which makes it O(n + m log(n/m + 1)).
+      template <TreeMergeOp Op, class E>
+      BinaryTree<E> JoinTrees(const BinaryTree<E>& a, int n, const BinaryTree<E>& b, int m, int& size,
+                              bool shared, Scheduler& s = Scheduler::Default())
+      {
+         const bool aLarger = n >= m;
+         const BinaryTree<E>& smaller = aLarger ? b : a;
+         BinaryTree<E> tree = aLarger ? a : b;
+         const int forks = n + m >= TREE_JOIN_PARALLEL_MIN ? JoinForks(s) : 0;
+
+         int root, matched;
+         auto join = [&] (int fresh) -> bool
+         {
+            int grafted = smaller._root;
+            if (&*smaller._pool != &*tree._pool && !tree.Graft(smaller, grafted)) return false;
+            const int ra = aLarger ? tree._root : grafted, rb = aLarger ? grafted : tree._root;
+            matched = 0;
+            if (Op == TREE_UNION)        return tree.Union(ra, rb, fresh, forks, s, root, matched);
+            if (Op == TREE_INTERSECTION) return tree.Intersection(ra, rb, fresh, forks, s, root, matched);
+            return tree.Difference(ra, rb, fresh, forks, s, root, matched);
+         };
+
+         if (!shared || !join(tree._pool->NextFreeIndex()))
+         {
+            if (shared) tree.CompactForUpdates(); else tree.Detach(n + m);
+            bool joined = join(0);
+            assert(joined);
+         }
+         tree._root = root;
+         size = Op == TREE_UNION ? n + m - matched : Op == TREE_INTERSECTION ? matched : n - matched;
+
+         if (shared) tree.CompactIfSparse(size);
+         else if (2 * size < tree._pool->Size()) tree.Compact();
+         return tree;
+      }
+
+
+
+      /// Persistent updates leave the nodes they copied in the pool, where
+      /// they stay for as long as any version sharing the pool is alive, and
+      /// as garbage after that. So that a long run of updates does not grow
+      /// the pool without bound, the result of an update is compacted into a
+      /// pool of its own once the shared one holds this many times its size:
+      /// an O(n) copy at most once every n / log n updates, which keeps
+      /// updates O(log n) amortized. The new pool has room for as many
+      /// nodes, so the updates after it fill it before it needs to move.
+      static const int TREE_PERSISTENT_SLACK = 4;
+
+      template <class E> inline void BinaryTree<E>::CompactForUpdates()
+      { Detach(TREE_PERSISTENT_SLACK * max(Count(_root), 0x10)); }
+
+      template <class E> inline void BinaryTree<E>::CompactIfSparse(int size)
+      { if (_pool->Size() > TREE_PERSISTENT_SLACK * max(size, 0x10)) CompactForUpdates(); }
+
 
       /// Tree Rotations, used to maintain balance
       template <class E> void BinaryTree<E>::RotateLeft(int a, int b, int aParent)
@@ -320,6 +878,7 @@ namespace Collections
          //int z = pool[b].right;
 
          pool[b].left  = a; pool[a].right = y;
+         Recount(a); Recount(b);
 
          if (_root == a) _root = b;
       }
@@ -349,6 +908,7 @@ namespace Collections
          //int z = pool[b].right;
 
          pool[b].left  = y; pool[a].right = b;
+         Recount(b); Recount(a);
 
          if (_root == b) _root = a;
       }
@@ -370,17 +930,21 @@ namespace Collections
             if (pool[n].left == -1)
             {
                /// thre's a right child, but no left child, just snip it out
+               discount(n);
                if (parent == -1) { assert(_root == n); _root = pool[n].right; }
                else if (pool[parent].left == n) pool[parent].left = pool[n].right;
                else pool[parent].right = pool[n].right;
+               release(n);
                return;
             }
             else if (pool[n].right == -1)
             {
                /// there's only a left child
+               discount(n);
                if (parent == -1) { assert(_root == n); _root = pool[n].left; }
                else if (pool[parent].left == n) pool[parent].left = pool[n].left;
                else pool[parent].right = pool[n].left;
+               release(n);
                return;
             }
             else
@@ -407,9 +971,75 @@ namespace Collections
          assert(pool[n].left == -1 && pool[n].right == -1);
          assert(parent != -1 ? pool[parent].left == n || pool[parent].right == n : true);
 
+         discount(n);
          if      (parent == -1)           _root              = -1;
          else if (pool[parent].left == n) pool[parent].left  = -1;
          else                             pool[parent].right = -1;
+         release(n);
+      }
+
+
+      /// n is still linked, so the path down to it can be found by its payload
+      template <class E> void BinaryTree<E>::discount(int n)
+      {
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         const E& e = pool[n].payload;
+         for (int t = _root; t != n; t = pool[t].payload < e ? pool[t].right : pool[t].left)
+            pool[t].count--;
+      }
+
+
+      /////////////
+      // Compact //
+      /////////////
+
+      template <class E> void BinaryTree<E>::Compact(int capacity)
+      {
+         typedef BinaryTreeNode<E> Node;
+         MemoryPool<Node>& pool = *_pool;
+
+         /// The reachable nodes are copied in order, recording the new index
+         /// of each one. They are moved out of the old pool if nothing else
+         /// can see it
+         const bool shared = _pool->RefCount() > 1;
+         Ref<MemoryPool<Node> > compacted = new MemoryPool<Node>(max(Count(_root), capacity));
+         int * remap = (int*)malloc(max(pool.NextFreeIndex(), 1) * sizeof(int));
+         {
+            TreeStack stack;
+            int n = _root;
+            while (n != -1 || stack.Size() > 0)
+            {
+               while (n != -1) { stack.Push(n); n = pool[n].left; }
+               n = stack.Pop();
+               remap[n] = shared ? compacted->Push(pool[n]) : compacted->Push(std::move(pool[n]));
+               n = pool[n].right;
+            }
+         }
+
+         /// Then the copies are relinked to each other, front to back
+         for (int i = 0; i < compacted->NextFreeIndex(); ++i)
+         {
+            Node& node = (*compacted)[i];
+            if (node.left  != -1) node.left  = remap[node.left];
+            if (node.right != -1) node.right = remap[node.right];
+         }
+         
+         if (_root != -1) _root = remap[_root];
+         free(remap);
+         _pool = compacted;
+      }
+
+      /// A pool holding this tree's nodes and nothing else, as a builder
+      /// leaves it, is copied slot by slot rather than walked. Any slots
+      /// past them were claimed by other versions, and are left alone.
+      template <class E> void BinaryTree<E>::Detach(int capacity)
+      {
+         const int size = Count(_root);
+         if (_pool->NextFreeIndex() != size) { Compact(capacity); return; }
+
+         Ref<MemoryPool<BinaryTreeNode<E> > > copy = new MemoryPool<BinaryTreeNode<E> >(max(size, capacity));
+         for (int i = 0; i < size; ++i) copy->Push((*_pool)[i]);
+         _pool = copy;
       }
 
 
@@ -418,13 +1048,14 @@ namespace Collections
       // Insert //
       ////////////
 
-      /// This function is not thread-safe
+      /// The trail lives on the call stack, so insertion allocates nothing
+      /// beyond the new node, and threads deriving new versions of a shared
+      /// immutable tree do not share scratch space.
       /// should return the int where it was inserted ?
-      template <class E> bool BinaryTree<E>::Insert(const E& e)
+      template <class E> template <class U> bool BinaryTree<E>::insert(U&& e)
       {
          MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
-         static Vector<int> trail = Vector<int>::Construct(0x40);
-         trail.Clear();
+         TreeStack trail;
 
          /// we're going to walk down the tree until we find the location where
          /// this element belongs, and we need to maintain a stack
@@ -434,39 +1065,36 @@ namespace Collections
 
          trail.Push(-1);
          int cNode = _root; 
+         bool wentRight = false;
          while (cNode != -1)
          {
             if (pool[cNode].payload < e)
-            { trail.Push(cNode); cNode = pool[cNode].right; }
+            { trail.Push(cNode); cNode = pool[cNode].right; wentRight = true; }
             else if (e < pool[cNode].payload)
-            { trail.Push(cNode); cNode = pool[cNode].left; }
+            { trail.Push(cNode); cNode = pool[cNode].left; wentRight = false; }
             else /* e == pool[cNode].payload */ break; 
          }
          
-         int pNode = trail.Last();
+         int pNode = trail.Top();
 
          if (cNode == -1) // we should insert here
          {
-
-            BinaryTreeNode<E> newNode;
-            newNode.payload  = e;
-            newNode.left     = newNode.right = -1;
-            newNode.priority = rand();
+            /// e may be moved from here on, all comparisons are done
+            const int priority = TreePriority<E>::Of(e);
+            int n = pool.Push(BinaryTreeNode<E>(std::forward<U>(e), priority));
 
             if (pNode == -1)
             {
                /// we insert at the root
                assert(_root == -1);
-               _root = pool.Push(newNode);
+               _root = n;
             }
             else
             {
-               int n = pool.Push(newNode);
-
                /// we have a leaf node that is a parent-to-be
-               if (pool.Index(pNode).payload < e)
+               if (wentRight)
                { assert(pool[pNode].right == -1); pool[pNode].right = n; }
-               else if (e < pool[pNode].payload)
+               else
                { assert(pool[pNode].left == -1); pool[pNode].left = n; }
 
                /// This is the case where we may have to maintain the
@@ -482,6 +1110,10 @@ namespace Collections
 
                   p = grandparent;
                }
+
+               /// The rotations recounted the nodes they moved, the
+               /// ancestors above them have one more node below
+               for (; p > -1; p = trail.Pop()) pool[p].count++;
             }
             
             return true;
@@ -490,6 +1122,409 @@ namespace Collections
       }
 
 
+      ////////////////////
+      // Split and Join //
+      ////////////////////
+
+      /// Both walk down a single path, hooking each node they pass, or its
+      /// copy, below the last one on the side it belongs to, so they take
+      /// time proportional to the depth. Hooks are kept as indices, since a
+      /// pool of one owner may move as copies are appended. The nodes passed
+      /// are recounted on the way back up, deepest first.
+      template <class E> bool BinaryTree<E>::Split(int t, const E& e, int fresh, int& lRoot, int& rRoot, int& found)
+      {
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         TreeStack path;
+         lRoot = rRoot = found = -1;
+         int lParent = -1, rParent = -1, lRest = -1, rRest = -1;
+         while (t != -1)
+         {
+            const bool less = pool[t].payload < e;
+            if (!less && !(e < pool[t].payload)) { found = t; lRest = pool[t].left; rRest = pool[t].right; break; }
+
+            const int c = unshare(t, fresh);
+            if (c == -1) return false;
+            path.Push(c);
+            if (less)
+            {
+               if (lParent == -1) lRoot = c; else pool[lParent].right = c;
+               lParent = c; t = pool[c].right;
+            }
+            else
+            {
+               if (rParent == -1) rRoot = c; else pool[rParent].left = c;
+               rParent = c; t = pool[c].left;
+            }
+         }
+         if (lParent == -1) lRoot = lRest; else pool[lParent].right = lRest;
+         if (rParent == -1) rRoot = rRest; else pool[rParent].left = rRest;
+         while (path.Size() > 0) Recount(path.Pop());
+         return true;
+      }
+
+      template <class E> bool BinaryTree<E>::Join(int l, int r, int fresh, int& joined)
+      {
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         TreeStack path;
+         int root = -1, parent = -1;
+         bool parentRight = false;
+         while (l != -1 && r != -1)
+         {
+            const bool fromLeft = pool[l].priority > pool[r].priority;
+            const int c = unshare(fromLeft ? l : r, fresh);
+            if (c == -1) return false;
+            if (fromLeft) l = pool[c].right; else r = pool[c].left;
+            path.Push(c);
+
+            if (parent == -1) root = c;
+            else if (parentRight) pool[parent].right = c;
+            else pool[parent].left = c;
+            parent = c; parentRight = fromLeft;
+         }
+
+         const int rest = l != -1 ? l : r;
+         if (parent == -1) root = rest;
+         else if (parentRight) pool[parent].right = rest;
+         else pool[parent].left = rest;
+         while (path.Size() > 0) Recount(path.Pop());
+         joined = root;
+         return true;
+      }
+
+      /// Runs left() and right(), as two tasks of the scheduler s while forks
+      /// remain
+      template <class L, class R> inline void forkJoin(Scheduler& s, int forks, const L& left, const R& right)
+      {
+         if (forks <= 0) { left(); right(); return; }
+         Scheduler::TaskGroup g(s);
+         g.Spawn(left);
+         right();
+         g.Sync();
+      }
+
+      /// The root of higher priority stays on top, and the other tree is
+      /// split around its key. The recursion follows the smaller tree, so
+      /// the work is O(m log(n/m + 1)) for sets of n and m keys, m <= n,
+      /// and so are the nodes copied, one for each node the recursion
+      /// relinks and those on the paths of the splits and joins.
+      template <class E> bool BinaryTree<E>::Union(int a, int b, int fresh, int forks, Scheduler& s, int& root, int& matched)
+      {
+         if (a == -1) { root = b; return true; }
+         if (b == -1) { root = a; return true; }
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         if (pool[a].priority < pool[b].priority) std::swap(a, b);
+
+         int bl, br, found;
+         if (!Split(b, pool[a].payload, fresh, bl, br, found)) return false;
+
+         const int al = pool[a].left, ar = pool[a].right;
+         int left, right, ml = 0, mr = 0;
+         bool lDone, rDone;
+         forkJoin(s, forks, [&] () { lDone = Union(al, bl, fresh, forks - 1, s, left,  ml); },
+                            [&] () { rDone = Union(ar, br, fresh, forks - 1, s, right, mr); });
+         const int c = lDone && rDone ? unshare(a, fresh) : -1;
+         if (c == -1) return false;
+
+         pool[c].left = left; pool[c].right = right; Recount(c);
+         matched += ml + mr + (found != -1);
+         root = c;
+         return true;
+      }
+
+      template <class E> bool BinaryTree<E>::Intersection(int a, int b, int fresh, int forks, Scheduler& s, int& root, int& matched)
+      {
+         if (a == -1 || b == -1) { root = -1; return true; }
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         if (pool[a].priority < pool[b].priority) std::swap(a, b);
+
+         int bl, br, found;
+         if (!Split(b, pool[a].payload, fresh, bl, br, found)) return false;
+
+         const int al = pool[a].left, ar = pool[a].right;
+         int left, right, ml = 0, mr = 0;
+         bool lDone, rDone;
+         forkJoin(s, forks, [&] () { lDone = Intersection(al, bl, fresh, forks - 1, s, left,  ml); },
+                            [&] () { rDone = Intersection(ar, br, fresh, forks - 1, s, right, mr); });
+         if (!lDone || !rDone) return false;
+         matched += ml + mr;
+
+         if (found == -1) return Join(left, right, fresh, root);
+         const int c = unshare(a, fresh);
+         if (c == -1) return false;
+         pool[c].left = left; pool[c].right = right; Recount(c);
+         matched++;
+         root = c;
+         return true;
+      }
+
+      /// Not symmetric, so the tree whose root is split depends on which
+      /// side has the root of higher priority
+      template <class E> bool BinaryTree<E>::Difference(int a, int b, int fresh, int forks, Scheduler& s, int& root, int& matched)
+      {
+         if (a == -1 || b == -1) { root = a; return true; }
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+
+         int left, right, ml = 0, mr = 0, found;
+         bool lDone, rDone;
+         if (pool[a].priority >= pool[b].priority)
+         {
+            int bl, br;
+            if (!Split(b, pool[a].payload, fresh, bl, br, found)) return false;
+            const int al = pool[a].left, ar = pool[a].right;
+            forkJoin(s, forks, [&] () { lDone = Difference(al, bl, fresh, forks - 1, s, left,  ml); },
+                               [&] () { rDone = Difference(ar, br, fresh, forks - 1, s, right, mr); });
+            if (!lDone || !rDone) return false;
+            matched += ml + mr;
+
+            if (found != -1) { matched++; return Join(left, right, fresh, root); }
+            const int c = unshare(a, fresh);
+            if (c == -1) return false;
+            pool[c].left = left; pool[c].right = right; Recount(c);
+            root = c;
+            return true;
+         }
+         else
+         {
+            int al, ar;
+            if (!Split(a, pool[b].payload, fresh, al, ar, found)) return false;
+            const int bl = pool[b].left, br = pool[b].right;
+            forkJoin(s, forks, [&] () { lDone = Difference(al, bl, fresh, forks - 1, s, left,  ml); },
+                               [&] () { rDone = Difference(ar, br, fresh, forks - 1, s, right, mr); });
+            if (!lDone || !rDone) return false;
+            matched += ml + mr + (found != -1);
+            return Join(left, right, fresh, root);
+         }
+      }
+
+      template <class E> bool BinaryTree<E>::graft(const MemoryPool<BinaryTreeNode<E> >& from, int n, int& copy)
+      {
+         copy = -1;
+         if (n == -1) return true;
+         copy = _pool->Append(from[n]);
+         int left, right;
+         if (copy == -1 || !graft(from, from[n].left, left) || !graft(from, from[n].right, right)) return false;
+         (*_pool)[copy].left = left; (*_pool)[copy].right = right;
+         return true;
+      }
+
+
+      ////////////////////////
+      // Persistent Updates //
+      ////////////////////////
+
+      /// Each update works on a copy of this tree sharing its pool, and if
+      /// the pool fills up, on a compacted copy in a pool of its own
+      template <class E> BinaryTree<E> BinaryTree<E>::PersistentInsert(const E& e, bool& added) const
+      {
+         BinaryTree t(*this);
+         if (!t.persistentInsert(e, added)) { t.CompactForUpdates(); bool r = t.persistentInsert(e, added); assert(r); }
+         return t;
+      }
+
+      template <class E> BinaryTree<E> BinaryTree<E>::PersistentRemove(const E& e, bool& removed) const
+      {
+         BinaryTree t(*this);
+         if (!t.persistentRemove(e, removed)) { t.CompactForUpdates(); bool r = t.persistentRemove(e, removed); assert(r); }
+         return t;
+      }
+
+      template <class E> void BinaryTree<E>::PersistentSplitAt(int k, BinaryTree& l, BinaryTree& r) const
+      {
+         BinaryTree t(*this);
+         int lRoot, rRoot;
+         if (!t.persistentSplitAt(k, lRoot, rRoot)) { t.CompactForUpdates(); bool s = t.persistentSplitAt(k, lRoot, rRoot); assert(s); }
+         l = BinaryTree(lRoot, t._pool);
+         r = BinaryTree(rRoot, t._pool);
+      }
+
+      /// The path down to e is recorded on the way down and copied on the
+      /// way back up. A new node rotates up past the copies of lower
+      /// priority, as in insert(), and those rotations only relink copies.
+      template <class E> bool BinaryTree<E>::persistentInsert(const E& e, bool& added)
+      {
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         TreeStack path;
+
+         int n = _root;
+         while (n != -1)
+         {
+            if (pool[n].payload < e)      { path.Push(n); n = pool[n].right; }
+            else if (e < pool[n].payload) { path.Push(n); n = pool[n].left; }
+            else break;
+         }
+
+         /// A new leaf, or the replacement for the equal node, which keeps
+         /// its links and priority. e is not looked at after this, so it may
+         /// refer into the pool.
+         added = n == -1;
+         int top;
+         if (added) top = pool.Append(BinaryTreeNode<E>(e, TreePriority<E>::Of(e)));
+         else
+         {
+            BinaryTreeNode<E> replacement(e, pool[n].priority);
+            replacement.left = pool[n].left; replacement.right = pool[n].right;
+            top = pool.Append(std::move(replacement));
+         }
+         if (top == -1) return false;
+
+         const int created = top;
+         bool rising = added;
+         while (path.Size() > 0)
+         {
+            const int p = copy(path.Pop());
+            if (p == -1) return false;
+            const bool right = pool[p].payload < pool[top].payload;
+            if (rising && pool[p].priority < pool[created].priority)
+            {
+               /// top is the new node, rotate it above the copy of its parent
+               if (right) { pool[p].right = pool[created].left;  pool[created].left  = p; }
+               else       { pool[p].left  = pool[created].right; pool[created].right = p; }
+               Recount(p); Recount(created);
+            }
+            else
+            {
+               if (right) pool[p].right = top; else pool[p].left = top;
+               Recount(p);
+               top = p;
+               rising = false;
+            }
+         }
+         _root = top;
+         return true;
+      }
+
+      template <class E> bool BinaryTree<E>::persistentRemove(const E& e, bool& removed)
+      {
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         TreeStack path;
+
+         int n = _root;
+         while (n != -1)
+         {
+            if (pool[n].payload < e)      { path.Push(n); n = pool[n].right; }
+            else if (e < pool[n].payload) { path.Push(n); n = pool[n].left; }
+            else break;
+         }
+         removed = n != -1;
+         if (!removed) return true;
+
+         /// The removed node's subtrees are joined in its place, and the path
+         /// above is copied to point at the join
+         int top, below = n;
+         if (!Join(pool[n].left, pool[n].right, pool.NextFreeIndex(), top)) return false;
+         while (path.Size() > 0)
+         {
+            const int original = path.Pop();
+            const bool left = pool[original].left == below;
+            const int p = copy(original);
+            if (p == -1) return false;
+            if (left) pool[p].left = top; else pool[p].right = top;
+            Recount(p);
+            top = p; below = original;
+         }
+         _root = top;
+         return true;
+      }
+
+      /// The path to the split is copied on the way down: each copy goes to
+      /// the left side, with its left subtree, if it is among the first k,
+      /// and to the right side otherwise, hooked below the last copy on the
+      /// same side. The copies are recounted deepest first.
+      template <class E> bool BinaryTree<E>::persistentSplitAt(int k, int& lRoot, int& rRoot)
+      {
+         MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         TreeStack copies;
+
+         lRoot = rRoot = -1;
+         int lParent = -1, rParent = -1;
+         for (int n = _root; n != -1; )
+         {
+            const int c = copy(n);
+            if (c == -1) return false;
+            copies.Push(c);
+            const int before = Count(pool[c].left);
+            if (before < k)
+            {
+               k -= before + 1;
+               if (lParent == -1) lRoot = c; else pool[lParent].right = c;
+               lParent = c; n = pool[c].right;
+            }
+            else
+            {
+               if (rParent == -1) rRoot = c; else pool[rParent].left = c;
+               rParent = c; n = pool[c].left;
+            }
+         }
+         if (lParent != -1) pool[lParent].right = -1;
+         if (rParent != -1) pool[rParent].left = -1;
+         while (copies.Size() > 0) Recount(copies.Pop());
+         return true;
+      }
+
+
+      //////////////////////
+      // Order Statistics //
+      //////////////////////
+
+      template <class E> int BinaryTree<E>::Rank(const E& e) const
+      {
+         const MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         int rank = 0, n = _root;
+         while (n != -1)
+         {
+            if (pool[n].payload < e) { rank += Count(pool[n].left) + 1; n = pool[n].right; }
+            else n = pool[n].left;
+         }
+         return rank;
+      }
+
+      template <class E> int BinaryTree<E>::Select(int i) const
+      {
+         assert(i >= 0 && i < Count(_root));
+         const MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         int n = _root;
+         while (true)
+         {
+            const int before = Count(pool[n].left);
+            if (i < before) n = pool[n].left;
+            else if (i == before) return n;
+            else { i -= before + 1; n = pool[n].right; }
+         }
+      }
+
+      template <class E> int BinaryTree<E>::Bound(const E& e, bool strict, TreeStack * path) const
+      {
+         const MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         int bound = -1, n = _root;
+         if (path) path->Clear();
+         while (n != -1)
+         {
+            if (strict ? !(e < pool[n].payload) : pool[n].payload < e) n = pool[n].right;
+            else
+            {
+               if (path && bound != -1) path->Push(bound);
+               bound = n;
+               n = pool[n].left;
+            }
+         }
+         return bound;
+      }
+
+      template <class E> int BinaryTree<E>::Seek(const E& e, TreeStack& path) const
+      {
+         const MemoryPool<BinaryTreeNode<E> >& pool = *_pool;
+         path.Clear();
+         for (int n = _root; n != -1; )
+         {
+            if (pool[n].payload < e) n = pool[n].right;
+            else if (e < pool[n].payload) { path.Push(n); n = pool[n].left; }
+            else return n;
+         }
+         path.Clear();
+         return -1;
+      }
+
+
       //////////
       // Find //
       //////////
@@ -29,6 +29,7 @@ namespace Collections
       
          friend class Common::BinaryTreeIterator<Common::KeyValuePair<K, V>, TreeMap<K, V> >;
          friend class Common::BinaryTreeBuilder<Common::KeyValuePair<K, V>, TreeMap<K, V> >;
+         friend struct Common::Internals;
       
          template <class U> struct SwapElementType { typedef TreeMap<K, U> C; };
 
@@ -49,6 +50,9 @@ namespace Collections
          inline TreeMap(int size, const Tree& tree)
             : _size(size)
             , _tree(tree) {}
+         inline TreeMap(int size, Tree&& tree)
+            : _size(size)
+            , _tree(std::move(tree)) {}
       
       public:
 
@@ -71,6 +75,19 @@ namespace Collections
          inline TreeMap& operator = (const TreeMap& rhs)
          { _tree = rhs._tree; _size = rhs._size; return *this; }
 
+         /// Moves take over the node pool without touching its reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline TreeMap(TreeMap&& rhs)
+            : _size(rhs._size)
+            , _tree(std::move(rhs._tree)) { rhs._size = 0; rhs._tree._root = -1; }
+
+         inline TreeMap& operator = (TreeMap&& rhs)
+         { 
+            _tree = std::move(rhs._tree); _size = rhs._size; 
+            rhs._size = 0; rhs._tree._root = -1;
+            return *this; 
+         }
+
 
          ////////////////////////////////
          // Inherited From Traversable //
@@ -79,6 +96,43 @@ namespace Collections
          virtual int Size() const { return _size; }
          virtual Iterator GetIterator() const { return Iterator(this->_tree); }
 
+         /// O(log n), down the left or right edge of the tree
+         virtual ElementType Head() const
+         { assert(_size > 0); return _tree._pool->Index(_tree.Select(0)).payload; }
+         virtual ElementType Last() const
+         { assert(_size > 0); return _tree._pool->Index(_tree.Select(_size - 1)).payload; }
+
+         /// O(log n), by splitting the tree at position n, and compacting the
+         /// sides that are kept, as for TreeSet
+         virtual TreeMap<K, V> Take(int n) const
+         {
+            if (n >= _size) return *this;
+            n = max(0, n);
+            Tree l(-1, _tree._pool), r(-1, _tree._pool);
+            _tree.PersistentSplitAt(n, l, r);
+            l.CompactIfSparse(n);
+            return TreeMap(n, std::move(l));
+         }
+
+         virtual TreeMap<K, V> Drop(int n) const
+         {
+            if (n <= 0) return *this;
+            n = min(n, _size);
+            Tree l(-1, _tree._pool), r(-1, _tree._pool);
+            _tree.PersistentSplitAt(n, l, r);
+            r.CompactIfSparse(_size - n);
+            return TreeMap(_size - n, std::move(r));
+         }
+
+         Pair<TreeMap<K, V>, TreeMap<K, V> > SplitAt(int n) const
+         {
+            n = max(0, min(n, _size));
+            Tree l(-1, _tree._pool), r(-1, _tree._pool);
+            _tree.PersistentSplitAt(n, l, r);
+            l.CompactIfSparse(n); r.CompactIfSparse(_size - n);
+            return Pair<TreeMap, TreeMap>(TreeMap(n, std::move(l)), TreeMap(_size - n, std::move(r)));
+         }
+
          virtual bool Contains(const K& key) const;
          virtual const V& GetOrElse(const K& key, const V& otherwise) const;
 
@@ -92,6 +146,29 @@ namespace Collections
          virtual SetType Keys() const;
 
 
+         ///////////////////
+         // Range Queries //
+         ///////////////////
+
+         /// O(log n) to position the iterator, then in key order from there:
+         /// at the first key not less than key, or greater than key, through
+         /// to the end of the map
+         inline Iterator LowerBound(const K& key) const
+         { return Iterator(_tree, Common::KeyValuePair<K, V>(key), Common::TREE_LOWER_BOUND); }
+         inline Iterator UpperBound(const K& key) const
+         { return Iterator(_tree, Common::KeyValuePair<K, V>(key), Common::TREE_UPPER_BOUND); }
+
+         /// O(log n + k), iterates over the k mappings with keys in [lo, hi)
+         inline Iterator Range(const K& lo, const K& hi) const
+         { return Iterator(_tree, Common::KeyValuePair<K, V>(lo), Common::KeyValuePair<K, V>(hi)); }
+
+         /// The mappings with keys in [lo, hi). O(log n): the map is split
+         /// at the ranks of lo and hi, and shares all but O(log n) nodes with
+         /// this one.
+         using Map<K, V, TreeMap<K, V>, TreeMapTraits<K, V> >::FilterKeys;
+         TreeMap<K, V> FilterKeys(const K& lo, const K& hi) const;
+
+
          ///////////////////
          // Miscellaneous //
          ///////////////////
@@ -126,37 +203,44 @@ namespace Collections
          else return _tree._pool->Index(target).payload.value;
       }
 
+      template <class K, class V> TreeMap<K, V>
+      TreeMap<K, V>::FilterKeys(const K& lo, const K& hi) const
+      {
+         const int a = _tree.Rank(Common::KeyValuePair<K, V>(lo));
+         const int b = _tree.Rank(Common::KeyValuePair<K, V>(hi));
+         if (b <= a) return TreeMap();
+         return Drop(a).Take(b - a);
+      }
+
       /// Note: Insert and Remove are here and not in Map because of the
       /// "return *this" statements, which do not work in the abstract
       /// base class for some reason that I do not quite understand.
 
-      /// O(n)
+      /// O(log n), the new map shares this map's node pool and all but the
+      /// O(log n) nodes on the path to the key. A key already present has
+      /// its value replaced.
       template <class K, class V> TreeMap<K, V>
       TreeMap<K, V>::Insert(const K& key, const V& value) const
       {
-         /// Can't use this early out because we may be updating the value
-         //if (this->Contains(key)) return *this;
-
-         auto pTree = _tree.Clone();
-         pTree.Insert(Common::KeyValuePair<K, V>(key, value));
-         return TreeMap(_size+1, pTree);
+         bool added;
+         Tree tree = _tree.PersistentInsert(Common::KeyValuePair<K, V>(key, value), added);
+         const int size = added ? _size+1 : _size;
+         tree.CompactIfSparse(size);
+         return TreeMap(size, std::move(tree));
       }
 
-      /// O(n)
+      /// O(log n)
       template <class K, class V> TreeMap<K, V>
       TreeMap<K, V>::Remove(const K& key) const
       {
-         // Ok, this is simple. First locate the item to remove
-         int parent, target;
-         _tree.Find(Common::KeyValuePair<K, V>(key), parent, target);
+         bool removed;
+         Tree tree = _tree.PersistentRemove(Common::KeyValuePair<K, V>(key), removed);
 
          /// if it was not present, then we're done!
-         if (target == -1) return *this;
+         if (!removed) return *this;
 
-         /// else, clone the tree and remove the node
-         auto pTree = _tree.Clone();
-         pTree.Remove(target, parent);
-         return TreeMap(_size-1, pTree);
+         tree.CompactIfSparse(_size-1);
+         return TreeMap(_size-1, std::move(tree));
       }   
 
    } // namespace Immutable
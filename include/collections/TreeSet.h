@@ -33,6 +33,7 @@ namespace Collections
       
          friend class Common::BinaryTreeIterator<E, TreeSet<E> >;
          friend class Common::BinaryTreeBuilder<E, TreeSet<E> >;
+         friend struct Common::Internals;
 
          typedef E ElementType;      
          typedef Common::BinaryTree<E> Tree;
@@ -50,6 +51,28 @@ namespace Collections
          inline TreeSet(int size, const Tree& tree)
             : _size(size)
             , _tree(tree) {}
+         inline TreeSet(int size, Tree&& tree)
+            : _size(size)
+            , _tree(std::move(tree)) {}
+
+         /// The result of a set operation, by a merge walk over both sets
+         /// built bottom-up, or by split and join where Common::PreferJoin()
+         /// says that is cheaper
+         template <Common::TreeMergeOp Op> TreeSet combine(const TreeSet& set) const
+         {
+            int size;
+            if (Common::PreferJoin(_size, set._size))
+            {
+               Tree tree = Common::JoinTrees<Op>(_tree, _size, set._tree, set._size, size, true);
+               return TreeSet(size, std::move(tree));
+            }
+
+            Common::SortedTreeBuilder<E> builder(Op == Common::TREE_UNION ? _size + set._size :
+                                                 Op == Common::TREE_INTERSECTION ? min(_size, set._size) : _size);
+            Common::MergeSorted<Op>(this->GetIterator(), set.GetIterator(), builder);
+            size = builder.Size();
+            return TreeSet(size, builder.Result());
+         }
       
       
       public:
@@ -73,6 +96,19 @@ namespace Collections
          inline TreeSet& operator = (const TreeSet& rhs)
          { _tree = rhs._tree; _size = rhs._size; return *this; }
 
+         /// Moves take over the node pool without touching its reference
+         /// counter. The moved-from container may only be assigned to or destroyed.
+         inline TreeSet(TreeSet&& rhs)
+            : _size(rhs._size)
+            , _tree(std::move(rhs._tree)) { rhs._size = 0; rhs._tree._root = -1; }
+
+         inline TreeSet& operator = (TreeSet&& rhs)
+         { 
+            _tree = std::move(rhs._tree); _size = rhs._size; 
+            rhs._size = 0; rhs._tree._root = -1;
+            return *this; 
+         }
+
 
          ////////////////////////////////
          // Inherited From Traversable //
@@ -81,15 +117,70 @@ namespace Collections
          virtual int Size() const { return _size; }
          virtual Iterator GetIterator() const { return Iterator(this->_tree); }
 
+         /// O(log n), down the left or right edge of the tree
+         virtual E Head() const { return Select(0); }
+         virtual E Last() const { return Select(_size - 1); }
+
+         /// O(log n), by splitting the tree at position n. The two sides share
+         /// this set's node pool and all but the O(log n) nodes on the path
+         /// between them. As after Insert and Remove, a side that is kept is
+         /// compacted once the pool holds four times its size. Tail and Init
+         /// follow from these.
+         virtual TreeSet<E> Take(int n) const;
+         virtual TreeSet<E> Drop(int n) const;
+         Pair<TreeSet<E>, TreeSet<E> > SplitAt(int n) const;
+
 
          ////////////////////////
          // Inherited From Set //
          ////////////////////////
 
          virtual Iterator Contains(const E& element) const;
+
+         /// Both trees iterate in order, so these can be a single merge walk,
+         /// O(n + m), with the result built bottom-up from the merged stream.
+         /// Where one set is much smaller, or both are large enough to share
+         /// out between threads, Union, Intersection and Difference split and
+         /// join the trees instead, in O(m log(n/m + 1)) for m <= n: the
+         /// result shares the larger set's node pool, where only the nodes the
+         /// splits and joins relink are copied. A set whose pool is full, as
+         /// one straight from a builder, is copied into a pool with room
+         /// first, as for Insert().
+         virtual bool IsSubsetOf(const TreeSet<E>& set) const;
+         virtual TreeSet<E> Union(const TreeSet<E>& set) const;
+         virtual TreeSet<E> Intersection(const TreeSet<E>& set) const;
+         virtual TreeSet<E> Difference(const TreeSet<E>& set) const;
+
          virtual TreeSet<E> Insert(const E& element) const;
          virtual TreeSet<E> Remove(const E& element) const;
 
+
+         //////////////////////
+         // Order Statistics //
+         //////////////////////
+
+         /// O(log n), the number of elements less than e
+         inline int Rank(const E& e) const { return _tree.Rank(e); }
+
+         /// O(log n), the i-th smallest element, from 0
+         inline const E& Select(int i) const
+         { assert(i >= 0 && i < _size); return _tree._pool->Index(_tree.Select(i)).payload; }
+         inline const E& operator [] (int i) const { return Select(i); }
+
+
+         ///////////////////
+         // Range Queries //
+         ///////////////////
+
+         /// O(log n) to position the iterator, then in order from there: at
+         /// the first element not less than e, or greater than e, through to
+         /// the end of the set
+         inline Iterator LowerBound(const E& e) const { return Iterator(_tree, e, Common::TREE_LOWER_BOUND); }
+         inline Iterator UpperBound(const E& e) const { return Iterator(_tree, e, Common::TREE_UPPER_BOUND); }
+
+         /// O(log n + k), iterates over the k elements in [lo, hi)
+         inline Iterator Range(const E& lo, const E& hi) const { return Iterator(_tree, lo, hi); }
+
          ///////////////////
          // Miscellaneous //
          ///////////////////
@@ -98,49 +189,96 @@ namespace Collections
       };
 
 
+      template <class E> Pair<TreeSet<E>, TreeSet<E> > TreeSet<E>::SplitAt(int n) const
+      {
+         n = max(0, min(n, _size));
+         Tree l(-1, _tree._pool), r(-1, _tree._pool);
+         _tree.PersistentSplitAt(n, l, r);
+         l.CompactIfSparse(n); r.CompactIfSparse(_size - n);
+         return Pair<TreeSet, TreeSet>(TreeSet(n, std::move(l)), TreeSet(_size - n, std::move(r)));
+      }
+
+      /// Take and Drop split the same way, but only compact the side they keep
+      template <class E> TreeSet<E> TreeSet<E>::Take(int n) const
+      {
+         if (n >= _size) return *this;
+         n = max(0, n);
+         Tree l(-1, _tree._pool), r(-1, _tree._pool);
+         _tree.PersistentSplitAt(n, l, r);
+         l.CompactIfSparse(n);
+         return TreeSet(n, std::move(l));
+      }
+
+      template <class E> TreeSet<E> TreeSet<E>::Drop(int n) const
+      {
+         if (n <= 0) return *this;
+         n = min(n, _size);
+         Tree l(-1, _tree._pool), r(-1, _tree._pool);
+         _tree.PersistentSplitAt(n, l, r);
+         r.CompactIfSparse(_size - n);
+         return TreeSet(_size - n, std::move(r));
+      }
+
       template <class E> typename TreeSet<E>::Iterator 
       TreeSet<E>::Contains(const E& element) const
       {
-         int parent;
-         Iterator itr(this->_tree);
-         _tree.Find(element, parent, itr._nextNode);
-         return itr;
+         return Iterator(this->_tree, element);
+      }
+
+      template <class E> bool TreeSet<E>::IsSubsetOf(const TreeSet<E>& set) const
+      {
+         if (_size > set._size) return false;
+         return Common::SortedIncludes(this->GetIterator(), set.GetIterator());
+      }
+
+      template <class E> TreeSet<E> TreeSet<E>::Union(const TreeSet<E>& set) const
+      {
+         if (set._size == 0) return *this;
+         if (_size == 0) return set;
+         return combine<Common::TREE_UNION>(set);
+      }
+
+      template <class E> TreeSet<E> TreeSet<E>::Intersection(const TreeSet<E>& set) const
+      {
+         if (_size == 0 || set._size == 0) return TreeSet();
+         return combine<Common::TREE_INTERSECTION>(set);
+      }
+
+      template <class E> TreeSet<E> TreeSet<E>::Difference(const TreeSet<E>& set) const
+      {
+         if (_size == 0 || set._size == 0) return *this;
+         return combine<Common::TREE_DIFFERENCE>(set);
       }
 
       /// Note: Insert and Remove are here and not in Set because of the
       /// "return *this" statements, which do not work in the abstract
       /// base class for some reason that I do not quite understand.
 
-      /// O(n)
+      /// O(log n), the new set shares this set's node pool and all but the
+      /// O(log n) nodes on the path to e
       template <class E> TreeSet<E>
       TreeSet<E>::Insert(const E& e) const
       {
          if (this->Contains(e)) return *this;
 
-         auto pTree = _tree.Clone();
-         bool r = pTree.Insert(e); assert(r);
-
-         return TreeSet(_size+1, pTree);
+         bool added;
+         Tree tree = _tree.PersistentInsert(e, added); assert(added);
+         tree.CompactIfSparse(_size+1);
+         return TreeSet(_size+1, std::move(tree));
       }
 
-      /// O(n log n)
+      /// O(log n)
       template <class E> TreeSet<E>
       TreeSet<E>::Remove(const E& e) const
       {
-         // Ok, this is simple. First locate the item to remove
-         int parent, target;
-         _tree.Find(e, parent, target);
+         bool removed;
+         Tree tree = _tree.PersistentRemove(e, removed);
 
          /// if it was not present, then we're done!
-         if (target == -1) return *this;
-
-         /// if size == 0, then Find() would have come up empty handed
-         assert(_size > 0);
+         if (!removed) return *this;
 
-         /// else, clone the tree and remove the node
-         auto pTree = _tree.Clone();
-         pTree.Remove(target, parent);   
-         return TreeSet(_size-1, pTree);
+         tree.CompactIfSparse(_size-1);
+         return TreeSet(_size-1, std::move(tree));
       } 
       
       template <class E> void TreeSet<E>::PrintGraph(const char * fileName) const
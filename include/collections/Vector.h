@@ -12,17 +12,15 @@ namespace Collections
 
       inline bool isFull() const { return Capacity() == Size(); }
 
+      /// Grows in place when the buffer is ours alone. A buffer shared with
+      /// another array is copied instead, so that the two part ways.
       inline void resize(int newCapacity)
       {
          if (newCapacity <= Capacity()) return;
 
-         Ref<Common::InitializedBuffer<E> > newData 
-            = new Common::InitializedBuffer<E>(newCapacity);
-         for (int i = 0; i < Size(); ++i)
-            ((E*)*newData)[i] = ((E*)(*Mutable::Array<E>::_data))[i];
-
-         Mutable::Array<E>::_data = newData;
-         Mutable::Array<E>::_size = newCapacity;
+         Ref<Common::UninitializedBuffer<E> >& data = Mutable::Array<E>::_data;
+         if (data->RefCount() == 1) data->Reserve(newCapacity);
+         else data = data->Clone(newCapacity);
       }
 
       inline void expandIfFull()
@@ -44,6 +42,26 @@ namespace Collections
          : Mutable::Array<E>(rhs)
          , _currentSize(rhs.Size()) { }
 
+      inline Vector(Vector&& rhs) 
+         : Mutable::Array<E>(std::move(rhs))
+         , _currentSize(rhs._currentSize) { rhs._currentSize = 0; }
+      inline Vector(Mutable::Array<E>&& rhs)
+         : Mutable::Array<E>(std::move(rhs))
+         , _currentSize(Mutable::Array<E>::Size()) { }
+
+      inline Vector& operator = (const Vector& rhs)
+      { 
+         Mutable::Array<E>::operator = (rhs); 
+         _currentSize = rhs._currentSize; 
+         return *this; 
+      }
+      inline Vector& operator = (Vector&& rhs)
+      { 
+         _currentSize = rhs._currentSize; rhs._currentSize = 0;
+         Mutable::Array<E>::operator = (std::move(rhs)); 
+         return *this; 
+      }
+
 
       ///////////////
       // Factories // 
@@ -69,7 +87,7 @@ namespace Collections
          return Vector(builder.Result());
       }
 
-      inline int Capacity() const { return Mutable::Array<E>::Size(); }
+      inline int Capacity() const { return Mutable::Array<E>::_data->Capacity(); }
       virtual int Size() const { return _currentSize; }
 
       // We need to override the GetIterator function so that we can
@@ -81,17 +99,34 @@ namespace Collections
          return itr; 
       }
 
+      /// Slots below the buffer's size are still live from before a Pop() or
+      /// Clear() and are assigned to, the rest are constructed in place
       inline Vector& Push(const E& e) 
       {
          expandIfFull();
 
-         ((E*)(*Mutable::Array<E>::_data))[_currentSize].~E();   /// Call destructor on existing thing  
-         new (& ((E*)(*Mutable::Array<E>::_data))[_currentSize++]) E(e); /// Construct new copy in its place 
+         Common::UninitializedBuffer<E>& data = *Mutable::Array<E>::_data;
+         if (_currentSize < data.Size()) data[_currentSize] = e;
+         else data.Append(e);
+         _currentSize++;
+
+         return *this;
+      }
+
+      inline Vector& Push(E&& e) 
+      {
+         expandIfFull();
+
+         Common::UninitializedBuffer<E>& data = *Mutable::Array<E>::_data;
+         if (_currentSize < data.Size()) data[_currentSize] = std::move(e);
+         else data.Append(std::move(e));
+         _currentSize++;
 
          return *this;
       }
 
       inline Vector& operator += (const E& e) { return this->Push(e); }
+      inline Vector& operator += (E&& e) { return this->Push(std::move(e)); }
 
       inline E Pop()
       {
@@ -0,0 +1,266 @@
+#ifndef VIEW_H
+#define VIEW_H
+
+#include <type_traits>
+#include "Traversable.h"
+
+/////////////////////////////////////////////
+// Lazy Views, Fused Traversable Pipelines //
+/////////////////////////////////////////////
+
+/// Every Traversable operation (Filter, Take, MapValues...) builds a whole new
+/// container, so a chain of them walks and allocates once per link. A view
+/// instead describes the chain, and nothing happens until a terminal operation
+/// (To<C>(), FoldLeft, ForEach, Count) pulls elements through it:
+///
+///    auto firstEvens = a.View().Filter(isEven).Take(3).To<Immutable::Array<int> >();
+///
+/// Each stage is a small value type holding the stage before it, and all of
+/// the Pull() calls are inline, so the compiler sees a single loop with the
+/// stages' logic fused into its body and no intermediate storage.
+///
+/// Views hold an iterator, so they share the container's data and remain
+/// valid as long as an iterator would.
+
+namespace Collections
+{
+   namespace Views
+   {
+      /// A source or stage of a pipeline implements:
+      ///    typedef ... ElementType;
+      ///    bool Pull(ElementType& out);  // false when exhausted
+
+
+      /// The head of every pipeline, adapts a container iterator
+      template <class Itr, class E> class IteratorSource
+      {
+      private:
+         Itr _itr;
+
+      public:
+         typedef E ElementType;
+         inline IteratorSource(const Itr& itr) : _itr(itr) {}
+
+         inline bool Pull(E& out)
+         {
+            if (!_itr.HasNext()) return false;
+            out = _itr.Next();
+            return true;
+         }
+      };
+
+      template <class S, class F> class MapStage
+      {
+      private:
+         S _s; F _f;
+         typedef typename S::ElementType SourceType;
+
+      public:
+         typedef typename std::decay<
+            decltype(std::declval<F&>()(std::declval<const SourceType&>()))>::type ElementType;
+
+         inline MapStage(const S& s, const F& f) : _s(s), _f(f) {}
+
+         inline bool Pull(ElementType& out)
+         {
+            SourceType e;
+            if (!_s.Pull(e)) return false;
+            out = _f(e);
+            return true;
+         }
+      };
+
+      template <class S, class P> class FilterStage
+      {
+      private:
+         S _s; P _p;
+
+      public:
+         typedef typename S::ElementType ElementType;
+         inline FilterStage(const S& s, const P& p) : _s(s), _p(p) {}
+
+         inline bool Pull(ElementType& out)
+         {
+            while (_s.Pull(out)) if (_p(out)) return true;
+            return false;
+         }
+      };
+
+      template <class S> class TakeStage
+      {
+      private:
+         S _s; int _remaining;
+
+      public:
+         typedef typename S::ElementType ElementType;
+         inline TakeStage(const S& s, int n) : _s(s), _remaining(n) {}
+
+         inline bool Pull(ElementType& out)
+         {
+            if (_remaining <= 0 || !_s.Pull(out)) return false;
+            _remaining--;
+            return true;
+         }
+      };
+
+      template <class S> class DropStage
+      {
+      private:
+         S _s; int _toSkip;
+
+      public:
+         typedef typename S::ElementType ElementType;
+         inline DropStage(const S& s, int n) : _s(s), _toSkip(n) {}
+
+         inline bool Pull(ElementType& out)
+         {
+            for (; _toSkip > 0; --_toSkip) if (!_s.Pull(out)) return false;
+            return _s.Pull(out);
+         }
+      };
+
+      template <class S, class P> class TakeWhileStage
+      {
+      private:
+         S _s; P _p; bool _done;
+
+      public:
+         typedef typename S::ElementType ElementType;
+         inline TakeWhileStage(const S& s, const P& p) : _s(s), _p(p), _done(false) {}
+
+         inline bool Pull(ElementType& out)
+         {
+            if (_done || !_s.Pull(out) || !_p(out)) { _done = true; return false; }
+            return true;
+         }
+      };
+
+      /// Pairs up elements of two pipelines, ends with the shorter of the two
+      template <class S, class T> class ZipStage
+      {
+      private:
+         S _s; T _t;
+
+      public:
+         typedef Pair<typename S::ElementType, typename T::ElementType> ElementType;
+         inline ZipStage(const S& s, const T& t) : _s(s), _t(t) {}
+
+         inline bool Pull(ElementType& out)
+         { return _s.Pull(out.first) && _t.Pull(out.second); }
+      };
+
+      /// Pairs each element with its position in the pipeline
+      template <class S> class EnumerateStage
+      {
+      private:
+         S _s; int _i;
+
+      public:
+         typedef Pair<int, typename S::ElementType> ElementType;
+         inline EnumerateStage(const S& s) : _s(s), _i(0) {}
+
+         inline bool Pull(ElementType& out)
+         {
+            if (!_s.Pull(out.second)) return false;
+            out.first = _i++;
+            return true;
+         }
+      };
+
+
+      /// The user facing wrapper around a pipeline. The combinators each return
+      /// a new View with one more stage, the terminal operations run it.
+      template <class S> class View
+      {
+      private:
+         S _s;
+
+         template <class T> friend class View;
+
+      public:
+         typedef typename S::ElementType ElementType;
+
+         inline View(const S& s) : _s(s) {}
+
+         ////////////////////////////
+         // Lazy Combinators, O(1) //
+         ////////////////////////////
+
+         template <class F> inline View<MapStage<S, F> > Map(F f) const
+         { return View<MapStage<S, F> >(MapStage<S, F>(_s, f)); }
+
+         template <class P> inline View<FilterStage<S, P> > Filter(P p) const
+         { return View<FilterStage<S, P> >(FilterStage<S, P>(_s, p)); }
+
+         inline View<TakeStage<S> > Take(int n) const
+         { return View<TakeStage<S> >(TakeStage<S>(_s, n)); }
+
+         inline View<DropStage<S> > Drop(int n) const
+         { return View<DropStage<S> >(DropStage<S>(_s, n)); }
+
+         template <class P> inline View<TakeWhileStage<S, P> > TakeWhile(P p) const
+         { return View<TakeWhileStage<S, P> >(TakeWhileStage<S, P>(_s, p)); }
+
+         template <class T> inline View<ZipStage<S, T> > Zip(const View<T>& rhs) const
+         { return View<ZipStage<S, T> >(ZipStage<S, T>(_s, rhs._s)); }
+
+         inline View<EnumerateStage<S> > Enumerate() const
+         { return View<EnumerateStage<S> >(EnumerateStage<S>(_s)); }
+
+
+         /////////////////////////////////
+         // Terminal Operations, O(n)   //
+         /////////////////////////////////
+
+         /// Materializes the pipeline into a container of type C
+         template <class C> C To() const
+         {
+            S s = _s;
+            typename C::Builder builder;
+            ElementType e;
+            while (s.Pull(e)) builder.AddElement(std::move(e));
+            return builder.Result();
+         }
+
+         template <class A, class F> A FoldLeft(A a, F f) const
+         {
+            S s = _s;
+            ElementType e;
+            while (s.Pull(e)) a = f(a, e);
+            return a;
+         }
+
+         template <class F> void ForEach(F f) const
+         {
+            S s = _s;
+            ElementType e;
+            while (s.Pull(e)) f(e);
+         }
+
+         int Count() const
+         {
+            S s = _s;
+            ElementType e;
+            int c = 0;
+            while (s.Pull(e)) c++;
+            return c;
+         }
+      };
+   } // namespace Views
+
+
+   /////////////////////////////////////
+   // Traversable Definition of View  //
+   /////////////////////////////////////
+
+   template <class E, class C, class CTraits>
+   inline Views::View<Views::IteratorSource<typename CTraits::Iterator, E> >
+   Traversable<E, C, CTraits>::View() const
+   {
+      typedef Views::IteratorSource<Iterator, E> Source;
+      return Views::View<Source>(Source(this->GetIterator()));
+   }
+
+} // namespace Collections
+
+#endif // VIEW_H
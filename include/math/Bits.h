@@ -56,8 +56,11 @@ namespace Mathematics
    }
 
    static inline int32_t BitCount( const uint16_t input ) { return BitCount(uint8_t (input)) + BitCount(uint8_t (input >>  8)); }
-   static inline int32_t BitCount( const uint32_t input ) { return BitCount(uint16_t(input)) + BitCount(uint16_t(input >> 16)); }
-   static inline int32_t BitCount( const uint64_t input ) { return BitCount(uint32_t(input)) + BitCount(uint32_t(input >> 32)); }
+
+   /// The compiler's builtins become a single popcnt instruction where the
+   /// target has one (-msse4.2 or -mpopcnt), and a short bit trick elsewhere
+   static inline int32_t BitCount( const uint32_t input ) { return __builtin_popcount(input); }
+   static inline int32_t BitCount( const uint64_t input ) { return __builtin_popcountll(input); }
 
    static inline int8_t  BitCount( const int8_t  input ) { return (int8_t) BitCount(uint8_t (input)); }
    static inline int32_t BitCount( const int16_t input ) { return (int32_t)BitCount(uint8_t (input)) + BitCount(int8_t (input >>  8)); }
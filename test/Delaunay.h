@@ -87,10 +87,13 @@ private:
       inline Vertex circumcenter(Vertex v0, Vertex v1, Vertex v2);
    };
 
+public:
+
    ////////////////
    // Edge Class //
    ////////////////
 
+   /// Public, so that the hashed edge set can specialize Common::Hash for it
    class Edge
    {
    public:
@@ -127,6 +130,7 @@ private:
       }
    };
 
+private:
 
    typedef Collections::Mutable::LinkedList<Triangle> TriangleList;
    typedef Collections::Mutable::Array<Vertex> PointList;
@@ -165,6 +169,16 @@ private:
    IndexList _indices;
 };
 
+/// Edges are keys of a hashed set while a point is inserted. The indices
+/// are stored in order, so one mix of both covers either direction.
+namespace Collections { namespace Common {
+   template <> struct Hash<Delaunay::Edge>
+   {
+      static inline uint64_t Of(const Delaunay::Edge& e)
+      { return MixHash((uint64_t(uint32_t(e.i0)) << 32) | uint32_t(e.i1)); }
+   };
+} }
+
 ////////////////////
 // Implementation //
 ////////////////////
@@ -228,7 +242,7 @@ inline void Delaunay::generateSuperTriangle(AABBox2f bounds, Delaunay::Vertex ve
 
 inline void Delaunay::insertPoint(TriangleList& tList, Vertex v, int i)
 {
-   typedef Collections::Mutable::TreeSet<Edge> EdgeSet;
+   typedef Collections::Mutable::HashSet<Edge> EdgeSet;
 
    EdgeSet edgeSet = EdgeSet(); //edgeSet += Edge(); /// WTF?
    auto t = tList.GetIterator();
@@ -92,6 +92,128 @@ void performanceTestVector()
 }
 
 
+/// Plain structs of the kind that get put in arrays by the thousand. The
+/// empty default constructor is what Vector2f and friends do too.
+template <int N> struct Particle
+{
+   float v[N];
+   inline Particle() {}
+   inline Particle(float f) { for (int i = 0; i < N; ++i) v[i] = f; }
+   inline bool operator == (const Particle& rhs) const { return v[0] == rhs.v[0]; }
+   inline bool operator != (const Particle& rhs) const { return v[0] != rhs.v[0]; }
+};
+
+/// The way builders used to work, kept here for comparison: every slot of
+/// a new buffer is default constructed, then assigned to, and growing copies
+/// the elements one at a time into a second default constructed buffer
+template <class E> E * OldStyleBuild(int n, const E * values)
+{
+   int capacity = 1, size = 0;
+   E * data = new E[capacity];
+   for (int i = 0; i < n; ++i)
+   {
+      if (size == capacity)
+      {
+         E * data2x = new E[2*capacity];
+         for (int j = 0; j < size; ++j) data2x[j] = data[j];
+         delete [] data;
+         data = data2x; capacity *= 2;
+      }
+      data[size++] = values[i];
+   }
+   return data;
+}
+
+template <class E> void performanceTestBuilder(const char * name, int n)
+{
+   typedef typename Immutable::Array<E>::Builder Builder;
+
+   E * pool = new E[n];
+   for (int i = 0; i < n; ++i) pool[i] = E(float(i));
+
+   StopWatch watch;
+   double times[3];
+
+   /// Builder with no size hint, so that growth is exercised too
+   watch.Start();
+   {
+      Builder builder;
+      for (int i = 0; i < n; ++i) builder.AddElement(pool[i]);
+      Immutable::Array<E> a = builder.Result();
+      if (a.Size() != n || a[n-1] != pool[n-1]) printf("Wrong value!\n");
+   }
+   watch.Stop();
+   times[0] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   {
+      E * data = OldStyleBuild(n, pool);
+      if (data[n-1] != pool[n-1]) printf("Wrong value!\n");
+      delete [] data;
+   }
+   watch.Stop();
+   times[1] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   {
+      std::vector<E> stlVec;
+      for (int i = 0; i < n; ++i) stlVec.push_back(pool[i]);
+      if (stlVec[n-1] != pool[n-1]) printf("Wrong value!\n");
+   }
+   watch.Stop();
+   times[2] = watch.ReadTime().ToMilliseconds();
+
+   delete [] pool;
+
+   printf("%-24s %8.2f ms  %8.2f ms  %8.2f ms\n", name, 
+      (float)times[0], (float)times[1], (float)times[2]);
+}
+
+void performanceTestBuilders()
+{
+   const int N = 4000000;
+   printf("\n                          Builder    Old Builder     STL   \n");
+
+   /// The first run pays for faulting in fresh pages from the OS, which would
+   /// otherwise be charged to whichever builder happened to go first
+   performanceTestBuilder<Particle<16> >("(Warm up):", N);
+   performanceTestBuilder<float>   ("Build Array<float>:", N);
+   performanceTestBuilder<Particle<4> >("Build Array<float[4]>:", N);
+   performanceTestBuilder<Particle<16> >("Build Array<float[16]>:", N);
+}
+
+
+/// A query-style chain, once through eager container operations (each link
+/// builds an intermediate array) and once through a fused view
+void performanceTestView()
+{
+   typedef Immutable::Array<int> Array;
+   const int N = 4000000;
+
+   Array a = Array::Construct(N, [] (int i) { return (i * 37) % 1000; });
+   auto isSmall = [] (int i) { return i < 500; };
+   auto square  = [] (int i) { return i * i; };
+
+   StopWatch watch;
+   double times[2];
+
+   watch.Start();
+   Array eager = MapValues<Array, int>(a.Filter(isSmall), square).Drop(10).Take(N/4);
+   watch.Stop();
+   times[0] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   Array lazy = a.View().Filter(isSmall).Map(square).Drop(10).Take(N/4).To<Array>();
+   watch.Stop();
+   times[1] = watch.ReadTime().ToMilliseconds();
+
+   if (eager.Size() != lazy.Size() || eager.Last() != lazy.Last()) printf("Results differ!\n");
+
+   printf("\n                          Eager        View   \n");
+   printf("Filter.Map.Drop.Take:     %8.2f ms  %8.2f ms\n", (float)times[0], (float)times[1]);
+}
+
+
 void testImmutableArray()
 {
    ///////////////////////////
@@ -166,6 +288,8 @@ int main()
 
    testVector();
    performanceTestVector();
+   performanceTestBuilders();
+   performanceTestView();
 
    printf("Exiting main...\n");
    return 0;
@@ -27,25 +27,6 @@ ostream& operator << (ostream& o, const Immutable::LinkedList<int>& c) { STREAM_
 //ostream& operator << (ostream& o, const Mutable::Array<int>& c) { STREAM_OUT_DEF }
 
 
-// Produces a sorted list of the contents in list, N^2
-template <class C, class E> Mutable::LinkedList<E> InsertionSort(const C& collection)
-{
-   typedef typename C::Iterator Iterator;
-
-   Mutable::LinkedList<E> list;
-   Iterator itr = collection.GetIterator();
-   while (itr.HasNext())
-   {
-      auto item = itr.Next();
-      Iterator lItr = list.GetIterator();
-      while (lItr.HasNext() && lItr.Peek() < item) lItr.Next();
-      list.Insert(lItr, item);
-   }
-
-   return list;
-}
-
-
 /////////////////////////
 // Performance Testing //
 /////////////////////////
@@ -126,7 +107,7 @@ template <class C> void performanceTestMutableLinkedList()
    ///////////
 
    watch.Start();
-   InsertionSort<Mutable::LinkedList<int>, int>(l);
+   l.SortInPlace(); // relinks the nodes where they are
    watch.Stop();
    sort[MINE] = watch.ReadTime().ToMilliseconds();
 
@@ -149,6 +130,9 @@ template <> void performanceTestMutableLinkedList<Immutable::LinkedList<int> >()
 { }
 
 
+static Immutable::LinkedList<int> sortedList(const Immutable::LinkedList<int>& l) { return Sorted(l); }
+static Mutable::LinkedList<int> sortedList(const Mutable::LinkedList<int>& l) { return l.Sorted(); }
+
 template <class C> void performanceTestLinkedList()
 {
    typedef C List;
@@ -167,6 +151,7 @@ template <class C> void performanceTestLinkedList()
    double constructionTimes[2];
    double reductionTimes[2];
    double reversalTimes[2];
+   double sortTimes[2];
 
    ///////////////////////
    // List Construction //
@@ -229,6 +214,29 @@ template <class C> void performanceTestLinkedList()
    }
 
 
+   ///////////////
+   // List Sort //
+   ///////////////
+
+   {
+      typename List::Builder shuffled(N);
+      STLList stlShuffled;
+      for (int i = 0; i < N; ++i) { const int r = rand(); shuffled.AddElement(r); stlShuffled.push_back(r); }
+      List lShuffled = shuffled.Result();
+
+      watch.Start();
+      List lSorted = sortedList(lShuffled); // makes a copy
+      watch.Stop();
+      sortTimes[MINE] = watch.ReadTime().ToMilliseconds();
+
+      watch.Start();
+      STLList listCopy = stlShuffled;
+      listCopy.sort();
+      watch.Stop();
+      sortTimes[THEIRS] = watch.ReadTime().ToMilliseconds();
+   }
+
+
 
 
    delete [] pool;
@@ -238,6 +246,7 @@ template <class C> void performanceTestLinkedList()
    printf("List Construction:   %8.2f ms  %8.2f ms\n", (float)constructionTimes[MINE], constructionTimes[THEIRS]);
    printf("List Reduction:      %8.2f ms  %8.2f ms\n", (float)reductionTimes[MINE]   , reductionTimes[THEIRS]);
    printf("List Reversal:       %8.2f ms  %8.2f ms\n", (float)reversalTimes[MINE]    , reversalTimes[THEIRS]);
+   printf("List Sort:           %8.2f ms  %8.2f ms\n", (float)sortTimes[MINE]        , sortTimes[THEIRS]);
 
    performanceTestMutableLinkedList<C>();
 
@@ -272,7 +281,7 @@ template <class C> void testMutableList()
    cout << "Testing mutable list" << endl;
    cout << "  List l = " << l << endl;
 
-   cout << "  Sorted l = " << InsertionSort<Mutable::LinkedList<int>, int>(l) << endl;
+   cout << "  Sorted l = " << l.Sorted() << endl;
 
    cout << "  Removing even values:" << endl;
 
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <iostream>
+#include <thread>
+
+#include <Mathematics.h>
+#include <Collections.h>
+
+#include "Clock.h"
+
+using namespace std;
+using namespace Mathematics;
+using namespace Collections;
+
+/////////////////////////
+// Performance Testing //
+/////////////////////////
+
+/// Runs each Par() operation on a large array with 1, 2, 4... threads, up to
+/// the number of hardware threads, and reports the time and the speedup over
+/// a single thread.
+
+typedef Immutable::Array<int> Array;
+
+/// A little arithmetic per element, so that the operations are not purely
+/// bound by memory bandwidth
+inline unsigned int Scramble(unsigned int x)
+{
+   x ^= x >> 16; x *= 0x7feb352dU;
+   x ^= x >> 15; x *= 0x846ca68bU;
+   return x ^ (x >> 16);
+}
+
+template <class F> double Time(F f, int repeats)
+{
+   StopWatch watch;
+   watch.Start();
+   for (int r = 0; r < repeats; ++r) f();
+   watch.Stop();
+   return watch.ReadTime().ToMilliseconds() / repeats;
+}
+
+template <class F> void ProfileOperation(const char * name, int maxThreads, F f)
+{
+   f(1); // warm up, so the first row does not pay for page faults
+
+   printf("%-12s", name);
+   double single = 0;
+   for (int t = 1; t <= maxThreads; t *= 2)
+   {
+      const double ms = Time([&f, t] () { f(t); }, 4);
+      if (t == 1) single = ms;
+      printf("  %8.2f ms (%4.2fx)", (float)ms, (float)(single / ms));
+   }
+   printf("\n");
+}
+
+int main()
+{
+   const int N = 1 << 23;
+   const int T = Collections::max(1, (int)std::thread::hardware_concurrency());
+
+   Array a = Array::Construct(N, [] (int i) { return i; });
+   unsigned int checksum = 0;
+
+   printf("%i elements, up to %i threads\n\n", N, T);
+   printf("%-12s", "");
+   for (int t = 1; t <= T; t *= 2) printf("  %2i Thread(s)         ", t);
+   printf("\n");
+
+   ProfileOperation("Construct", T, [&checksum, N] (int t)
+   {
+      Array b = ParallelArray<int, Array>::Construct(N, [] (int i) { return (int)Scramble(i); }, t);
+      checksum += b[N/2];
+   });
+
+   ProfileOperation("Map", T, [&a, &checksum, N] (int t)
+   {
+      Array b = a.Par(t).Map([] (int i) { return (int)Scramble(i); });
+      checksum += b[N/2];
+   });
+
+   ProfileOperation("Filter", T, [&a, &checksum] (int t)
+   {
+      Array b = a.Par(t).Filter([] (int i) { return (Scramble(i) & 3) == 0; });
+      checksum += b.Size();
+   });
+
+   ProfileOperation("Count", T, [&a, &checksum] (int t)
+   {
+      checksum += a.Par(t).Count([] (int i) { return (Scramble(i) & 1) == 0; });
+   });
+
+   ProfileOperation("Reduce", T, [&a, &checksum] (int t)
+   {
+      checksum += a.Par(t).Reduce(0U, [] (unsigned int s, int i) { return s + Scramble(i); });
+   });
+
+   printf("\nChecksum: %u\n", checksum);
+   printf("Exiting profiling routine...\n");
+   return 0;
+}
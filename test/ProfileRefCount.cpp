@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <Mathematics.h>
+#include <Collections.h>
+
+#include "Clock.h"
+
+using namespace std;
+using namespace Mathematics;
+using namespace Collections;
+
+/////////////////////////
+// Performance Testing //
+/////////////////////////
+
+/// Here we compare the two reference counting policies. Each test hands out
+/// and drops references at a high rate:
+///    single thread, both policies (the raw cost of the atomic instruction)
+///    N threads sharing one object (all threads fight over one cache line)
+///    N threads each with a private object (atomic, but uncontended)
+
+template <class RefCountPolicy> class Payload : public BasicObject<RefCountPolicy>
+{
+public:
+   int value;
+   inline Payload(int v) : value(v) {}
+};
+
+/// Taking the reference by value in a function the compiler cannot see into
+/// forces one AddRef/Release pair per call, which is what passing containers
+/// around by value costs
+template <class T> __attribute__((noinline)) int Touch(Ref<T> r) { return r->value; }
+
+template <class T> int CopyLoop(const Ref<T>& r, int n)
+{
+   int sum = 0;
+   for (int i = 0; i < n; ++i) sum += Touch(r);
+   return sum;
+}
+
+template <class T> double ProfileSingleThread(int n)
+{
+   StopWatch watch;
+   Ref<T> r = new T(1);
+
+   watch.Start();
+   int sum = CopyLoop(r, n);
+   watch.Stop();
+
+   if (sum != n) printf("sum = %i\n", sum);
+   return watch.ReadTime().ToMilliseconds();
+}
+
+template <class T> double ProfileThreads(int numThreads, int n, bool shared)
+{
+   StopWatch watch;
+   Ref<T> sharedRef = new T(1);
+   std::vector<int> sums(numThreads, 0);
+
+   watch.Start();
+   std::vector<std::thread> threads;
+   for (int t = 0; t < numThreads; ++t)
+   {
+      int * sum = &sums[t];
+      threads.push_back(std::thread([&sharedRef, shared, sum, n] ()
+      {
+         /// Private objects are allocated by their own thread, so that they
+         /// do not end up sharing a cache line with each other
+         Ref<T> r = shared ? sharedRef : Ref<T>(new T(1));
+         *sum = CopyLoop(r, n);
+      }));
+   }
+   for (int t = 0; t < numThreads; ++t) threads[t].join();
+   watch.Stop();
+
+   for (int t = 0; t < numThreads; ++t) if (sums[t] != n) printf("sum = %i\n", sums[t]);
+   if (sharedRef->RefCount() != 1) printf("Reference count was corrupted!\n");
+   return watch.ReadTime().ToMilliseconds();
+}
+
+/// Hands a single immutable array to every thread, each thread passes it
+/// around by value and reduces it. Only meaningful when the containers are
+/// built with the atomic policy.
+double ProfileSharedArray(int numThreads, int n)
+{
+   typedef Immutable::Array<int> Array;
+   Array a = Array::Construct(1024, [] (int i) { return i; });
+
+   StopWatch watch;
+   watch.Start();
+   std::vector<std::thread> threads;
+   for (int t = 0; t < numThreads; ++t)
+   {
+      threads.push_back(std::thread([&a, n] ()
+      {
+         int sum = 0;
+         for (int i = 0; i < n; ++i) { Array local = a; sum += local[i & 1023]; }
+         if (sum < 0) printf("sum = %i\n", sum);
+      }));
+   }
+   for (int t = 0; t < numThreads; ++t) threads[t].join();
+   watch.Stop();
+
+   if (a.Size() != 1024) printf("Array was corrupted!\n");
+   return watch.ReadTime().ToMilliseconds();
+}
+
+
+int main()
+{
+   typedef Payload<SingleThreadedRefCount> Plain;
+   typedef Payload<AtomicRefCount> Atomic;
+
+   const int N = 10000000;
+   const int T = Collections::max(2, (int)std::thread::hardware_concurrency());
+
+   printf("%i reference copies per thread, %i threads\n\n", N, T);
+
+   printf("                                SingleThreaded      Atomic   \n");
+   printf("1 Thread:                        %8.2f ms  %8.2f ms\n",
+      (float)ProfileSingleThread<Plain>(N), (float)ProfileSingleThread<Atomic>(N));
+   printf("%2i Threads, Private Objects:          -      %8.2f ms\n",
+      T, (float)ProfileThreads<Atomic>(T, N, false));
+   printf("%2i Threads, One Shared Object:        -      %8.2f ms\n",
+      T, (float)ProfileThreads<Atomic>(T, N, true));
+
+   #if defined(___ATOMIC_REFCOUNT)
+   printf("%2i Threads, Shared Immutable::Array:  -      %8.2f ms\n",
+      T, (float)ProfileSharedArray(T, N));
+   #else
+   printf("\nBuild with -D___ATOMIC_REFCOUNT to profile containers shared between threads\n");
+   #endif
+
+   printf("Exiting profiling routine...\n");
+   return 0;
+}
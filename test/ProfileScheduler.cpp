@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <iostream>
+#include <thread>
+
+#include <Mathematics.h>
+#include <Collections.h>
+
+#include "Clock.h"
+
+using namespace std;
+using namespace Mathematics;
+using namespace Collections;
+
+/////////////////////////
+// Performance Testing //
+/////////////////////////
+
+/// Fork-join microbenchmarks of the work stealing scheduler:
+///    fibonacci, one spawn per call above a cutoff, measures the raw cost
+///       of Spawn/Sync against the plain recursive function
+///    a reduction over a large array with ParallelFor, at several grains
+/// followed by the per-worker counters of the default scheduler.
+
+__attribute__((noinline)) long long Fib(int n) { return n < 2 ? n : Fib(n-1) + Fib(n-2); }
+
+long long ForkJoinFib(int n, int cutoff)
+{
+   if (n < cutoff) return Fib(n);
+   long long a = 0;
+   Scheduler::TaskGroup g;
+   g.Spawn([&a, n, cutoff] () { a = ForkJoinFib(n - 1, cutoff); });
+   long long b = ForkJoinFib(n - 2, cutoff);
+   g.Sync();
+   return a + b;
+}
+
+template <class F> double Time(F f)
+{
+   StopWatch watch;
+   watch.Start();
+   f();
+   watch.Stop();
+   return watch.ReadTime().ToMilliseconds();
+}
+
+void PrintStats()
+{
+   Scheduler& s = Scheduler::Default();
+   printf("\n   Worker      Tasks      Steals   Failed Steals     Idle\n");
+   for (int i = 0; i <= s.Workers(); ++i)
+   {
+      WorkerStats w = s.Stats(i);
+      if (i < s.Workers()) printf("   %6i", i); else printf("   caller");
+      printf(" %10lli  %10lli      %10lli  %8.2f ms\n",
+         w.tasksRun, w.steals, w.failedSteals, (float)w.idleMilliseconds);
+   }
+   s.ResetStats();
+}
+
+void ProfileFib()
+{
+   const int N = 32;
+   long long expected = 0, result = 0;
+
+   printf("Fibonacci(%i), %i threads\n\n", N, Scheduler::Default().Threads());
+   printf("   Sequential:            %8.2f ms\n", (float)Time([&expected, N] () { expected = Fib(N); }));
+
+   const int cutoffs[] = { 2, 10, 16, 20 };
+   for (int c = 0; c < 4; ++c)
+   {
+      const double ms = Time([&result, N, &cutoffs, c] () { result = ForkJoinFib(N, cutoffs[c]); });
+      printf("   Fork-join, cutoff %2i:  %8.2f ms%s\n", cutoffs[c], (float)ms, result == expected ? "" : " WRONG");
+   }
+   PrintStats();
+}
+
+void ProfileReduction()
+{
+   typedef Immutable::Array<int> Array;
+   const int N = 1 << 24;
+   Array a = Array::Construct(N, [] (int i) { return i & 0xFF; });
+   const int * d = &a[0];
+
+   long long expected = 0;
+   printf("\nReduction of %i ints\n\n", N);
+   printf("   Sequential:            %8.2f ms\n", (float)Time([d, N, &expected] ()
+   { for (int i = 0; i < N; ++i) expected += d[i]; }));
+
+   const int grains[] = { 1 << 10, 1 << 14, 1 << 18, 1 << 22 };
+   for (int g = 0; g < 4; ++g)
+   {
+      std::atomic<long long> sum(0);
+      const int grain = grains[g];
+      const double ms = Time([d, N, grain, &sum] ()
+      {
+         ParallelFor(0, N, grain, [d, &sum] (int begin, int end)
+         {
+            long long s = 0;
+            for (int i = begin; i < end; ++i) s += d[i];
+            sum += s;
+         });
+      });
+      printf("   ParallelFor, grain %7i: %8.2f ms%s\n", grain, (float)ms, sum == expected ? "" : " WRONG");
+   }
+   PrintStats();
+}
+
+int main()
+{
+   Scheduler::Default().ResetStats();
+   ProfileFib();
+   ProfileReduction();
+
+   printf("Exiting profiling routine...\n");
+   return 0;
+}
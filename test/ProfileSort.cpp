@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 #include <Mathematics.h>
 #include <Collections.h>
@@ -42,20 +43,43 @@ ostream& operator << (ostream& o, const Immutable::LinkedList<int>& c)        {
 ostream& operator << (ostream& o, const Immutable::LinkedList<float>& c)      { STREAM_OUT_DEF }
 
 
+/// Input distributions, the ones after RANDOM are the classic ways to make a
+/// quicksort go quadratic or waste its time
+enum Distribution { RANDOM, SORTED, REVERSED, ALL_EQUAL, ORGAN_PIPE, FEW_DISTINCT, DISTRIBUTIONS };
+const char * const distributionNames[DISTRIBUTIONS] =
+   { "Random", "Sorted", "Reverse Sorted", "All Equal", "Organ Pipe", "16 Distinct Keys" };
+
+void MakeInput(Distribution d, int N, std::vector<int>& out)
+{
+   srand(1001938110);
+   out.resize(N);
+   for (int i = 0; i < N; ++i)
+   {
+      switch (d)
+      {
+      case RANDOM:       out[i] = rand() % (2*N); break;
+      case SORTED:       out[i] = i; break;
+      case REVERSED:     out[i] = N - i; break;
+      case ALL_EQUAL:    out[i] = 7; break;
+      case ORGAN_PIPE:   out[i] = i < N/2 ? i : N - i; break;
+      default:           out[i] = rand() % 16; break;
+      }
+   }
+}
+
 void Profile_MutableArraySort
    ( const int N
+   , Distribution d
    , float& sortedTime
    , float& inPlaceSortTime
    , float& stlTime)
 {
    StopWatch watch;
-   std::pair<float, float> times;
 
    /// Construct two arrays, one using our container, one using
    /// an equivalent stl container, both with same element values
-   srand(1001938110);
    std::vector<int> stlArray;
-   for (int i = 0; i < N; ++i) stlArray.push_back(rand() % (2*N));
+   MakeInput(d, N, stlArray);
    auto burnsArray = Mutable::Array<int>::Construct(N, &stlArray[0]);
 
    watch.Start();
@@ -69,8 +93,133 @@ void Profile_MutableArraySort
    watch.Start();
    std::sort (stlArray.begin(), stlArray.begin()+N);  
    watch.Stop(); stlTime = watch.ReadTime().ToMilliseconds();
+
+   for (int i = 0; i < N; ++i)
+      if (burnsArray[i] != stlArray[i] || sorted[i] != stlArray[i]) { printf("Sort is WRONG!\n"); break; }
+}
+
+
+/// Arithmetic arrays are radix sorted, compare against the comparison sort
+/// they used to get and against std::sort
+template <class E> void Profile_RadixSort(const char * name, const int N)
+{
+   StopWatch watch;
+   srand(1001938110);
+   std::vector<E> input(N);
+   for (int i = 0; i < N; ++i) input[i] = (E)(rand() - RAND_MAX/2) / (E)7;
+
+   std::vector<E> stl = input;
+   auto radix = Mutable::Array<E>::Construct(N, &input[0]);
+   auto intro = Mutable::Array<E>::Construct(N, &input[0]);
+
+   watch.Start();
+   Mutable::SortInPlace(radix);
+   watch.Stop(); const float radixTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   Common::IntroSortInPlace(&intro[0], 0, N-1);
+   watch.Stop(); const float introTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   std::sort(stl.begin(), stl.end());
+   watch.Stop(); const float stlTime = watch.ReadTime().ToMilliseconds();
+
+   for (int i = 0; i < N; ++i) if (radix[i] != stl[i] || intro[i] != stl[i]) { printf("Sort is WRONG!\n"); break; }
+   printf("%-22s%8.2f ms     %8.2f ms     %8.2f ms   (%.1fx)\n",
+      name, radixTime, introTime, stlTime, stlTime / radixTime);
+}
+
+/// Parallel sample sort at 1, 2, 4... threads, up to the default scheduler's
+void Profile_ParallelSort(const int N)
+{
+   StopWatch watch;
+   srand(1001938110);
+   std::vector<int> input(N);
+   for (int i = 0; i < N; ++i) input[i] = rand();
+
+   const int T = Scheduler::Default().Threads();
+   printf("\nParallel sample sort, %i random ints, up to %i threads\n\n", N, T);
+
+   float single = 0.0f;
+   for (int t = 1; t <= T; t *= 2)
+   {
+      auto a = Mutable::Array<int>::Construct(N, &input[0]);
+      watch.Start();
+      Mutable::ParallelSortInPlace(a, t);
+      watch.Stop();
+      const float ms = watch.ReadTime().ToMilliseconds();
+      if (t == 1) single = ms;
+
+      for (int i = 1; i < N; ++i) if (a[i] < a[i-1]) { printf("Sort is WRONG!\n"); break; }
+      printf("%2i Thread(s)        %8.2f ms   (%.2fx)\n", t, ms, single / ms);
+   }
+}
+
+/// Many independent small sorts, as when sorting per-cell or per-node lists.
+/// SortSmall uses the SIMD sorting networks for int and float keys.
+template <class E> void Profile_SmallSorts(const char * name, const int size, const int batches)
+{
+   StopWatch watch;
+   srand(1001938110);
+   std::vector<E> input(size * batches);
+   for (size_t i = 0; i < input.size(); ++i) input[i] = (E)(rand() % 100000) / (E)3;
+
+   std::vector<E> networks = input, insertion = input, stl = input;
+
+   watch.Start();
+   for (int b = 0; b < batches; ++b) Common::SortSmall(&networks[b * size], size);
+   watch.Stop(); const float networkTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int b = 0; b < batches; ++b) Common::insertionSort(&insertion[b * size], 0, size);
+   watch.Stop(); const float insertionTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int b = 0; b < batches; ++b) std::sort(stl.begin() + b * size, stl.begin() + (b + 1) * size);
+   watch.Stop(); const float stlTime = watch.ReadTime().ToMilliseconds();
+
+   if (networks != stl || insertion != stl) printf("Sort is WRONG!\n");
+   printf("%-8s %2i keys   %8.2f ms     %8.2f ms     %8.2f ms   (%.1fx)\n",
+      name, size, networkTime, insertionTime, stlTime, stlTime / networkTime);
 }
 
+/// Selecting the k smallest of N against sorting all N, and against the
+/// std:: equivalents
+void Profile_Selection(const int N, const int k)
+{
+   StopWatch watch;
+   srand(1001938110);
+   std::vector<int> input(N);
+   for (int i = 0; i < N; ++i) input[i] = rand();
+
+   auto nth = Mutable::Array<int>::Construct(N, &input[0]);
+   auto partial = Mutable::Array<int>::Construct(N, &input[0]);
+   auto full = Mutable::Array<int>::Construct(N, &input[0]);
+   std::vector<int> stlNth = input, stlPartial = input;
+
+   watch.Start(); Mutable::NthElement(nth, k - 1);
+   watch.Stop(); const float nthTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start(); Mutable::PartialSort(partial, k);
+   watch.Stop(); const float partialTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start(); auto top = Mutable::TopK(full, k);
+   watch.Stop(); const float topTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start(); Mutable::SortInPlace(full);
+   watch.Stop(); const float sortTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start(); std::nth_element(stlNth.begin(), stlNth.begin() + k - 1, stlNth.end());
+   watch.Stop(); const float stlNthTime = watch.ReadTime().ToMilliseconds();
+
+   watch.Start(); std::partial_sort(stlPartial.begin(), stlPartial.begin() + k, stlPartial.end());
+   watch.Stop(); const float stlPartialTime = watch.ReadTime().ToMilliseconds();
+
+   if (nth[k-1] != full[k-1]) printf("NthElement is WRONG!\n");
+   for (int i = 0; i < k; ++i) if (partial[i] != full[i] || top[i] != full[i]) { printf("Selection is WRONG!\n"); break; }
+   printf("k = %-8i  %8.2f ms   %8.2f ms  %8.2f ms   %8.2f ms       %8.2f ms        %8.2f ms\n",
+      k, nthTime, partialTime, topTime, sortTime, stlNthTime, stlPartialTime);
+}
 
 int main()
 {
@@ -78,12 +227,37 @@ int main()
 
    const int N = 5000000;
 
-   float mArray[3] = {0.0f};
-   Profile_MutableArraySort (N, mArray[0], mArray[1], mArray[2]);
-
+   printf("Mutable::Array<int>, %i elements\n\n", N);
    printf("                         Sorted()   SortInPlace()     std::sort()   \n");
-   printf("Mutable::Array<int>   %8.2f ms     %8.2f ms     %8.2f ms\n", mArray[0], mArray[1], mArray[2]);
-   
+   for (int d = 0; d < DISTRIBUTIONS; ++d)
+   {
+      float times[3] = {0.0f};
+      Profile_MutableArraySort (N, (Distribution)d, times[0], times[1], times[2]);
+      printf("%-18s    %8.2f ms     %8.2f ms     %8.2f ms\n", distributionNames[d], times[0], times[1], times[2]);
+   }
+
+   const int R = 20000000;
+   printf("\nRandom keys, %i elements\n\n", R);
+   printf("                    SortInPlace()    Introsort       std::sort()\n");
+   Profile_RadixSort<int>         ("Array<int>",          R);
+   Profile_RadixSort<unsigned int>("Array<unsigned int>", R);
+   Profile_RadixSort<float>       ("Array<float>",        R);
+
+   const int B = 1 << 21;
+   printf("\n%i small sorts of 16 keys, fewer of larger sizes, same total\n\n", B);
+   printf("                   SortSmall()   Insertion Sort     std::sort()\n");
+   Profile_SmallSorts<int>  ("int",   16, B);
+   Profile_SmallSorts<int>  ("int",   32, B / 2);
+   Profile_SmallSorts<int>  ("int",   64, B / 4);
+   Profile_SmallSorts<float>("float", 16, B);
+   Profile_SmallSorts<float>("float", 64, B / 4);
+
+   printf("\nSelecting the k smallest of %i random ints\n\n", R);
+   printf("              NthElement  PartialSort        TopK  SortInPlace  std::nth_element  std::partial_sort\n");
+   for (int k = 10; k <= R / 10; k *= 100) Profile_Selection(R, k);
+   Profile_Selection(R, R / 10);
+
+   Profile_ParallelSort(R);
 
    return 0;
-}
\ No newline at end of file
+}
@@ -1,6 +1,10 @@
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <set>
+#include <map>
+#include <unordered_map>
+#include <vector>
 
 #include <Mathematics.h>
 #include <Collections.h>
@@ -159,6 +163,391 @@ template <class C> void performanceTestTreeSet()
 
 
 
+/// Versioned snapshots: every update derives a new map and all the versions
+/// are kept. The immutable TreeMap copies only the path to the key, where a
+/// std::map has to be copied whole for each version.
+void performanceTestVersions()
+{
+   typedef Immutable::TreeMap<int, float> Map;
+   const int N = 100000, VERSIONS = 5000, STL_VERSIONS = 50;
+
+   srand(1001938110);
+   Map::Builder builder(N);
+   for (int i = 0; i < N; ++i) builder.AddElement(Common::KeyValuePair<int, float>(i, float(i)));
+   std::vector<Map> versions(1, builder.Result());
+
+   StopWatch watch;
+   watch.Start();
+   for (int i = 1; i < VERSIONS; ++i)
+      versions.push_back(versions.back().Insert(rand() % (2*N), float(i)));
+   watch.Stop();
+   const double mine = watch.ReadTime().ToMilliseconds() * 1000.0 / (VERSIONS - 1);
+
+   std::vector<std::map<int, float> > stlVersions(1);
+   for (int i = 0; i < N; ++i) stlVersions[0][i] = float(i);
+   watch.Start();
+   for (int i = 1; i < STL_VERSIONS; ++i)
+   {
+      stlVersions.push_back(stlVersions.back());
+      stlVersions.back()[rand() % (2*N)] = float(i);
+   }
+   watch.Stop();
+   const double theirs = watch.ReadTime().ToMilliseconds() * 1000.0 / (STL_VERSIONS - 1);
+
+   float sum = 0;
+   for (int i = 0; i < VERSIONS; i += VERSIONS / 10) sum += versions[i].GetOrElse(N / 2, 0.0f);
+
+   printf("                                Burns          STL   \n");
+   printf("Versioned Update (%i entries): %8.2f us  %8.2f us   (%.0f)\n", N, mine, theirs, sum);
+}
+
+
+/// The B+-tree map against the treap and std::map, each filled by random
+/// inserts: lookups (half of them hit), an in-order traversal, and
+/// removing every other key
+void performanceTestBTree()
+{
+   typedef Common::KeyValuePair<int, float> Pair;
+   const int N = 500000, QUERIES = 2000000;
+
+   srand(1001938110);
+   int * keys = new int[N];
+   int * queries = new int[QUERIES];
+   for (int i = 0; i < N; ++i) keys[i] = rand();
+   for (int i = 0; i < QUERIES; ++i) queries[i] = (i & 1) ? keys[rand() % N] : rand();
+
+   const int BTREE = 0, TREE = 1, STL = 2;
+   StopWatch watch;
+   double times[4][3];
+   float sums[3] = { 0, 0, 0 }, values[3] = { 0, 0, 0 };
+
+   Mutable::BTreeMap<int, float> btreeMap;
+   Mutable::TreeMap<int, float> treeMap;
+   std::map<int, float> stlMap;
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) btreeMap += Pair(keys[i], float(i));
+   watch.Stop();
+   times[0][BTREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) treeMap += Pair(keys[i], float(i));
+   watch.Stop();
+   times[0][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) stlMap.insert(std::make_pair(keys[i], float(i)));
+   watch.Stop();
+   times[0][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) values[BTREE] += btreeMap.GetOrElse(queries[i], 1.0f);
+   watch.Stop();
+   times[1][BTREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) values[TREE] += treeMap.GetOrElse(queries[i], 1.0f);
+   watch.Stop();
+   times[1][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i)
+   {
+      auto found = stlMap.find(queries[i]);
+      values[STL] += found == stlMap.end() ? 1.0f : found->second;
+   }
+   watch.Stop();
+   times[1][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (auto itr = btreeMap.GetIterator(); itr.HasNext(); ) sums[BTREE] += itr.Next().value;
+   watch.Stop();
+   times[2][BTREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (auto itr = treeMap.GetIterator(); itr.HasNext(); ) sums[TREE] += itr.Next().value;
+   watch.Stop();
+   times[2][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (auto& kv : stlMap) sums[STL] += kv.second;
+   watch.Stop();
+   times[2][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) btreeMap -= keys[i];
+   watch.Stop();
+   times[3][BTREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) treeMap -= keys[i];
+   watch.Stop();
+   times[3][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) stlMap.erase(keys[i]);
+   watch.Stop();
+   times[3][STL] = watch.ReadTime().ToMilliseconds();
+
+   if (values[BTREE] != values[STL] || values[TREE] != values[STL] || sums[BTREE] != sums[STL] || sums[TREE] != sums[STL] ||
+       btreeMap.Size() != int(stlMap.size()) || treeMap.Size() != int(stlMap.size()))
+      printf("BTreeMap results disagree!\n");
+
+   delete [] keys;
+   delete [] queries;
+
+   const char * names[4] = { "Random Insertion:", "Random Lookup:   ", "Traversal:       ", "Removal:         " };
+   printf("                                BTreeMap      TreeMap       STL   \n");
+   for (int t = 0; t < 4; ++t)
+      printf("%s               %8.2f ms  %8.2f ms  %8.2f ms\n", names[t],
+             (float)times[t][BTREE], (float)times[t][TREE], (float)times[t][STL]);
+}
+
+
+/// Point lookups are what the hash map is for: half the queries hit, half
+/// miss. Traversal order differs between the three, so the traversals are
+/// checked by count rather than by sum.
+void performanceTestHash()
+{
+   typedef Common::KeyValuePair<int, float> Pair;
+   const int N = 500000, QUERIES = 2000000;
+
+   srand(1001938110);
+   int * keys = new int[N];
+   int * queries = new int[QUERIES];
+   for (int i = 0; i < N; ++i) keys[i] = rand();
+   for (int i = 0; i < QUERIES; ++i) queries[i] = (i & 1) ? keys[rand() % N] : rand();
+
+   const int HASH = 0, TREE = 1, STL = 2;
+   StopWatch watch;
+   double times[4][3];
+   int counts[3] = { 0, 0, 0 };
+   float values[3] = { 0, 0, 0 };
+
+   Mutable::HashMap<int, float> hashMap;
+   Mutable::TreeMap<int, float> treeMap;
+   std::unordered_map<int, float> stlMap;
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) hashMap += Pair(keys[i], float(i));
+   watch.Stop();
+   times[0][HASH] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) treeMap += Pair(keys[i], float(i));
+   watch.Stop();
+   times[0][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) stlMap.insert(std::make_pair(keys[i], float(i)));
+   watch.Stop();
+   times[0][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) values[HASH] += hashMap.GetOrElse(queries[i], 1.0f);
+   watch.Stop();
+   times[1][HASH] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) values[TREE] += treeMap.GetOrElse(queries[i], 1.0f);
+   watch.Stop();
+   times[1][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i)
+   {
+      auto found = stlMap.find(queries[i]);
+      values[STL] += found == stlMap.end() ? 1.0f : found->second;
+   }
+   watch.Stop();
+   times[1][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (auto itr = hashMap.GetIterator(); itr.HasNext(); itr.Next()) counts[HASH]++;
+   watch.Stop();
+   times[2][HASH] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (auto itr = treeMap.GetIterator(); itr.HasNext(); itr.Next()) counts[TREE]++;
+   watch.Stop();
+   times[2][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (auto& kv : stlMap) { (void)kv; counts[STL]++; }
+   watch.Stop();
+   times[2][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) hashMap -= keys[i];
+   watch.Stop();
+   times[3][HASH] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) treeMap -= keys[i];
+   watch.Stop();
+   times[3][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) stlMap.erase(keys[i]);
+   watch.Stop();
+   times[3][STL] = watch.ReadTime().ToMilliseconds();
+
+   if (values[HASH] != values[STL] || values[TREE] != values[STL] || counts[HASH] != counts[STL] || counts[TREE] != counts[STL] ||
+       hashMap.Size() != int(stlMap.size()) || treeMap.Size() != int(stlMap.size()))
+      printf("HashMap results disagree!\n");
+
+   delete [] keys;
+   delete [] queries;
+
+   const char * names[4] = { "Random Insertion:", "Random Lookup:   ", "Traversal:       ", "Removal:         " };
+   printf("                                 HashMap      TreeMap  unordered_map\n");
+   for (int t = 0; t < 4; ++t)
+      printf("%s               %8.2f ms  %8.2f ms  %8.2f ms\n", names[t],
+             (float)times[t][HASH], (float)times[t][TREE], (float)times[t][STL]);
+}
+
+
+/// The persistent hash trie against the persistent treap: a bulk build,
+/// a run of versioned updates, each made from the one before and all kept,
+/// and lookups (half of them hit) in the last version
+void performanceTestHashTrie()
+{
+   typedef Common::KeyValuePair<int, float> Pair;
+   const int N = 200000, VERSIONS = 100000, QUERIES = 2000000;
+
+   srand(1001938110);
+   int * keys = new int[N];
+   int * queries = new int[QUERIES];
+   for (int i = 0; i < N; ++i) keys[i] = rand();
+   for (int i = 0; i < QUERIES; ++i) queries[i] = (i & 1) ? keys[rand() % N] : rand();
+
+   const int TRIE = 0, TREE = 1;
+   StopWatch watch;
+   double times[3][2];
+   float values[2] = { 0, 0 };
+
+   watch.Start();
+   Immutable::HashMap<int, float>::Builder trieBuilder(N);
+   for (int i = 0; i < N; ++i) trieBuilder.AddElement(Pair(keys[i], float(i)));
+   std::vector<Immutable::HashMap<int, float> > trieVersions(1, trieBuilder.Result());
+   watch.Stop();
+   times[0][TRIE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   Immutable::TreeMap<int, float>::Builder treeBuilder(N);
+   for (int i = 0; i < N; ++i) treeBuilder.AddElement(Pair(keys[i], float(i)));
+   std::vector<Immutable::TreeMap<int, float> > treeVersions(1, treeBuilder.Result());
+   watch.Stop();
+   times[0][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 1; i < VERSIONS; ++i)
+      trieVersions.push_back(trieVersions.back().Insert(keys[(i * 7919) % N], float(-i)));
+   watch.Stop();
+   times[1][TRIE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 1; i < VERSIONS; ++i)
+      treeVersions.push_back(treeVersions.back().Insert(keys[(i * 7919) % N], float(-i)));
+   watch.Stop();
+   times[1][TREE] = watch.ReadTime().ToMilliseconds();
+
+   const Immutable::HashMap<int, float> trie = trieVersions.back();
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) values[TRIE] += trie.GetOrElse(queries[i], 1.0f);
+   watch.Stop();
+   times[2][TRIE] = watch.ReadTime().ToMilliseconds();
+
+   const Immutable::TreeMap<int, float> tree = treeVersions.back();
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) values[TREE] += tree.GetOrElse(queries[i], 1.0f);
+   watch.Stop();
+   times[2][TREE] = watch.ReadTime().ToMilliseconds();
+
+   if (values[TRIE] != values[TREE] || trie.Size() != tree.Size())
+      printf("Immutable HashMap results disagree!\n");
+
+   delete [] keys;
+   delete [] queries;
+
+   const char * names[3] = { "Bulk Build:      ", "Versioned Insert:", "Random Lookup:   " };
+   printf("                                 HashMap      TreeMap   (Immutable)\n");
+   for (int t = 0; t < 3; ++t)
+      printf("%s               %8.2f ms  %8.2f ms\n", names[t], (float)times[t][TRIE], (float)times[t][TREE]);
+}
+
+
+/// The hash functions: 32 bit keys one at a time, against the 64 bit mix
+/// and in batches, and byte strings against std::hash
+void performanceTestHashFunctions()
+{
+   const int N = 1 << 22, ROUNDS = 8, STRINGS = 1 << 16;
+
+   int * keys = new int[N];
+   uint64_t * hashes = new uint64_t[N];
+   srand(1001938110);
+   for (int i = 0; i < N; ++i) keys[i] = rand();
+
+   StopWatch watch;
+   uint64_t check[4] = { 0, 0, 0, 0 };
+   double times[5];
+
+   watch.Start();
+   for (int r = 0; r < ROUNDS; ++r)
+      for (int i = 0; i < N; ++i) hashes[i] = Common::MixHash(uint64_t(keys[i]) + r);
+   watch.Stop();
+   times[0] = watch.ReadTime().ToMilliseconds();
+   check[0] = hashes[N/2];
+
+   watch.Start();
+   for (int r = 0; r < ROUNDS; ++r)
+      for (int i = 0; i < N; ++i) hashes[i] = Common::Hash<int>::Of(keys[i] + r);
+   watch.Stop();
+   times[1] = watch.ReadTime().ToMilliseconds();
+   check[1] = hashes[N/2];
+
+   watch.Start();
+   for (int r = 0; r < ROUNDS; ++r)
+   {
+      keys[N/2] += r;
+      Common::HashKeys(keys, N, hashes);
+      keys[N/2] -= r;
+   }
+   watch.Stop();
+   times[2] = watch.ReadTime().ToMilliseconds();
+   check[2] = hashes[N/2];
+
+   std::vector<std::string> strings(STRINGS);
+   for (int i = 0; i < STRINGS; ++i)
+   {
+      strings[i].resize(8 + i % 57);
+      for (size_t c = 0; c < strings[i].size(); ++c) strings[i][c] = char('a' + (i * 31 + c * 7) % 26);
+   }
+
+   watch.Start();
+   for (int r = 0; r < ROUNDS * 8; ++r)
+      for (int i = 0; i < STRINGS; ++i) check[3] += Common::Hash<std::string>::Of(strings[i]);
+   watch.Stop();
+   times[3] = watch.ReadTime().ToMilliseconds();
+
+   std::hash<std::string> stlHash;
+   watch.Start();
+   for (int r = 0; r < ROUNDS * 8; ++r)
+      for (int i = 0; i < STRINGS; ++i) check[3] += stlHash(strings[i]);
+   watch.Stop();
+   times[4] = watch.ReadTime().ToMilliseconds();
+
+   delete [] keys;
+   delete [] hashes;
+
+   printf("int keys (%i x %i):      MixHash %8.2f ms   Hash<int> %8.2f ms   HashKeys %8.2f ms\n",
+          N, ROUNDS, (float)times[0], (float)times[1], (float)times[2]);
+   printf("strings (8 to 64 bytes): HashBytes %8.2f ms   std::hash %8.2f ms   (%x)\n",
+          (float)times[3], (float)times[4], unsigned(check[0] ^ check[1] ^ check[2] ^ check[3]));
+}
+
+
+
 
 void testMutableTreeSet() 
 {
@@ -257,11 +646,22 @@ template <class C> void testTreeSet()
    testMutableTreeSet();
 }
 
-int main()
+/// "btree" runs only the B+-tree comparison
+int main(int argc, char ** argv)
 {
+   if (argc > 1 && strcmp(argv[1], "btree") == 0) { performanceTestBTree(); return 0; }
+   if (argc > 1 && strcmp(argv[1], "hash") == 0) { performanceTestHash(); return 0; }
+   if (argc > 1 && strcmp(argv[1], "trie") == 0) { performanceTestHashTrie(); return 0; }
+   if (argc > 1 && strcmp(argv[1], "hashfn") == 0) { performanceTestHashFunctions(); return 0; }
+
    //testTreeSet<Immutable::TreeSet<int> >();
    //testTreeSet<Mutable::TreeSet<int> >();
    performanceTestTreeSet<Mutable::TreeSet<int> >();
+   performanceTestVersions();
+   performanceTestBTree();
+   performanceTestHash();
+   performanceTestHashTrie();
+   performanceTestHashFunctions();
 
    printf("Exiting main...\n");
    return 0;
@@ -1,6 +1,10 @@
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <set>
+#include <vector>
+#include <algorithm>
+#include <iterator>
 
 #include <Mathematics.h>
 #include <Collections.h>
@@ -61,6 +65,7 @@ template <class C> void performanceTestTreeSet()
    double randomConstructionTimes[2] = { 0.0, 0.0 };
    double removalTimes[2] = { 0.0, 0.0 };
    double reductionTimes[2] = { 0.0, 0.0 };
+   double smallReductionTimes[2] = { 0.0, 0.0 };
 
 
    //////////////////////////////////
@@ -147,6 +152,43 @@ template <class C> void performanceTestTreeSet()
       if (sum < 0.0f) printf("sum = %.2f\n", sum);
    }
 
+   /////////////////////////////
+   // Small TreeSet Reduction //
+   /////////////////////////////
+
+   /// Many short traversals, where the cost of setting up the iterator
+   /// dominates rather than the walk itself
+   const int SMALL = 16, REPEATS = N / 4;
+   {
+      typename MyTreeSet::Builder builder(SMALL);
+      for (int i = 0; i < SMALL; ++i) builder.AddElement(randomPool[i]);
+      MyTreeSet smallSet = builder.Result();
+
+      watch.Start();
+      unsigned sum = 0;
+      for (int r = 0; r < REPEATS; ++r)
+      {
+         auto itr = smallSet.GetIterator();
+         while (itr.HasNext()) sum = sum * 31 + itr.Next();
+      }
+      watch.Stop();
+      smallReductionTimes[MINE] = watch.ReadTime().ToMilliseconds();
+      if (sum == 1) printf("sum = %u\n", sum);
+   }
+
+   {
+      std::set<int> smallSTLSet(randomPool, randomPool + SMALL);
+
+      watch.Start();
+      unsigned sum = 0;
+      for (int r = 0; r < REPEATS; ++r)
+         for (std::set<int>::iterator i = smallSTLSet.begin(); i != smallSTLSet.end(); ++i)
+            sum = sum * 31 + *i;
+      watch.Stop();
+      smallReductionTimes[THEIRS] = watch.ReadTime().ToMilliseconds();
+      if (sum == 1) printf("sum = %u\n", sum);
+   }
+
    delete [] orderedPool;
    delete [] randomPool;
 
@@ -156,14 +198,238 @@ template <class C> void performanceTestTreeSet()
    printf("TreeSet Random  Construction:   %8.2f ms  %8.2f ms\n", (float)randomConstructionTimes[MINE], (float)randomConstructionTimes[THEIRS]);
    printf("TreeSet Item Removal:           %8.2f ms  %8.2f ms\n", (float)removalTimes[MINE], (float)removalTimes[THEIRS]);
    printf("TreeSet Reduction:              %8.2f ms  %8.2f ms\n", (float)reductionTimes[MINE]   , (float)reductionTimes[THEIRS]);
+   printf("Small TreeSet Reduction:        %8.2f ms  %8.2f ms\n", (float)smallReductionTimes[MINE], (float)smallReductionTimes[THEIRS]);
 
    printf("Exiting profiling routine...\n");
 }
 
 
-int main()
+/// Lookups in a set built once from random keys: the sorted vector against
+/// the treap and std::set. Half of the queries hit.
+void performanceTestLookup()
+{
+   const int N = 500000, QUERIES = 2000000;
+
+   srand(1001938110);
+   int * keys = new int[N];
+   int * queries = new int[QUERIES];
+   for (int i = 0; i < N; ++i) keys[i] = rand();
+   for (int i = 0; i < QUERIES; ++i) queries[i] = (i & 1) ? keys[rand() % N] : rand();
+
+   const int FLAT = 0, TREE = 1, STL = 2;
+   StopWatch watch;
+   double constructionTimes[3], lookupTimes[3];
+   int hits[3] = { 0, 0, 0 };
+
+   watch.Start();
+   Immutable::FlatSet<int> flatSet = Immutable::FlatSet<int>::Construct(N, keys);
+   watch.Stop();
+   constructionTimes[FLAT] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   Immutable::TreeSet<int> treeSet = Immutable::TreeSet<int>::Construct(N, keys);
+   watch.Stop();
+   constructionTimes[TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   std::set<int> stlSet(keys, keys + N);
+   watch.Stop();
+   constructionTimes[STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) hits[FLAT] += bool(flatSet.Contains(queries[i]));
+   watch.Stop();
+   lookupTimes[FLAT] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) hits[TREE] += bool(treeSet.Contains(queries[i]));
+   watch.Stop();
+   lookupTimes[TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) hits[STL] += stlSet.count(queries[i]);
+   watch.Stop();
+   lookupTimes[STL] = watch.ReadTime().ToMilliseconds();
+
+   if (hits[FLAT] != hits[STL] || hits[TREE] != hits[STL]) printf("Lookup results disagree!\n");
+
+   delete [] keys;
+   delete [] queries;
+
+   printf("                                FlatSet       TreeSet       STL   \n");
+   printf("Random Construction:            %8.2f ms  %8.2f ms  %8.2f ms\n", (float)constructionTimes[FLAT], (float)constructionTimes[TREE], (float)constructionTimes[STL]);
+   printf("Random Lookup:                  %8.2f ms  %8.2f ms  %8.2f ms\n", (float)lookupTimes[FLAT], (float)lookupTimes[TREE], (float)lookupTimes[STL]);
+}
+
+
+/// Union, intersection and difference of two overlapping sets of n and m
+/// keys: TreeSet's own versions (a merge walk, or split and join when the
+/// sizes are unbalanced or there are threads to share the work) against
+/// the generic Set versions (a lookup or an insertion per element) and the
+/// std:: algorithms over std::set
+void performanceTestSetAlgebra(int n, int m)
+{
+   typedef Immutable::TreeSet<int> Tree;
+   typedef Set<int, Tree, Immutable::TreeSetTraits<int> > Generic;
+
+   srand(1001938110);
+   int * a = new int[n];
+   int * b = new int[m];
+   for (int i = 0; i < n; ++i) a[i] = rand() % (4*n);
+   for (int i = 0; i < m; ++i) b[i] = rand() % (4*n);
+
+   const Tree ta = Tree::Construct(n, a), tb = Tree::Construct(m, b);
+   const std::set<int> sa(a, a + n), sb(b, b + m);
+
+   const int MINE = 0, GENERIC = 1, STL = 2;
+   StopWatch watch;
+   double times[3][3];
+   int sizes[3][3];
+
+   for (int op = 0; op < 3; ++op)
+   {
+      watch.Start();
+      Tree r = op == 0 ? ta.Union(tb) : op == 1 ? ta.Intersection(tb) : ta.Difference(tb);
+      watch.Stop();
+      times[op][MINE] = watch.ReadTime().ToMilliseconds(); sizes[op][MINE] = r.Size();
+
+      watch.Start();
+      Tree g = op == 0 ? ta.Generic::Union(tb) : op == 1 ? ta.Generic::Intersection(tb) : ta.Generic::Difference(tb);
+      watch.Stop();
+      times[op][GENERIC] = watch.ReadTime().ToMilliseconds(); sizes[op][GENERIC] = g.Size();
+
+      watch.Start();
+      std::set<int> s;
+      auto out = std::inserter(s, s.end());
+      if (op == 0)      std::set_union       (sa.begin(), sa.end(), sb.begin(), sb.end(), out);
+      else if (op == 1) std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(), out);
+      else              std::set_difference  (sa.begin(), sa.end(), sb.begin(), sb.end(), out);
+      watch.Stop();
+      times[op][STL] = watch.ReadTime().ToMilliseconds(); sizes[op][STL] = int(s.size());
+
+      if (sizes[op][MINE] != sizes[op][STL] || sizes[op][GENERIC] != sizes[op][STL])
+         printf("Set algebra results disagree!\n");
+   }
+
+   delete [] a;
+   delete [] b;
+
+   const char * names[3] = { "Union:       ", "Intersection:", "Difference:  " };
+   printf("%7d x %7d keys               TreeSet       Generic       STL   \n", n, m);
+   for (int op = 0; op < 3; ++op)
+      printf("TreeSet %s           %8.2f ms  %8.2f ms  %8.2f ms\n", names[op],
+             (float)times[op][MINE], (float)times[op][GENERIC], (float)times[op][STL]);
+}
+
+
+/// The B+-tree against the treap and std::set, each filled by random
+/// inserts: lookups (half of them hit), an in-order traversal, and
+/// removing every other key
+void performanceTestBTree()
 {
+   const int N = 500000, QUERIES = 2000000;
+
+   srand(1001938110);
+   int * keys = new int[N];
+   int * queries = new int[QUERIES];
+   for (int i = 0; i < N; ++i) keys[i] = rand();
+   for (int i = 0; i < QUERIES; ++i) queries[i] = (i & 1) ? keys[rand() % N] : rand();
+
+   const int BTREE = 0, TREE = 1, STL = 2;
+   StopWatch watch;
+   double times[4][3];
+   int hits[3] = { 0, 0, 0 };
+   long long sums[3] = { 0, 0, 0 };
+
+   Mutable::BTreeSet<int> btreeSet;
+   Mutable::TreeSet<int> treeSet;
+   std::set<int> stlSet;
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) btreeSet += keys[i];
+   watch.Stop();
+   times[0][BTREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) treeSet += keys[i];
+   watch.Stop();
+   times[0][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; ++i) stlSet.insert(keys[i]);
+   watch.Stop();
+   times[0][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) hits[BTREE] += bool(btreeSet.Contains(queries[i]));
+   watch.Stop();
+   times[1][BTREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) hits[TREE] += bool(treeSet.Contains(queries[i]));
+   watch.Stop();
+   times[1][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < QUERIES; ++i) hits[STL] += stlSet.count(queries[i]);
+   watch.Stop();
+   times[1][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (auto itr = btreeSet.GetIterator(); itr.HasNext(); ) sums[BTREE] += itr.Next();
+   watch.Stop();
+   times[2][BTREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (auto itr = treeSet.GetIterator(); itr.HasNext(); ) sums[TREE] += itr.Next();
+   watch.Stop();
+   times[2][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int k : stlSet) sums[STL] += k;
+   watch.Stop();
+   times[2][STL] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) btreeSet -= keys[i];
+   watch.Stop();
+   times[3][BTREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) treeSet -= keys[i];
+   watch.Stop();
+   times[3][TREE] = watch.ReadTime().ToMilliseconds();
+
+   watch.Start();
+   for (int i = 0; i < N; i += 2) stlSet.erase(keys[i]);
+   watch.Stop();
+   times[3][STL] = watch.ReadTime().ToMilliseconds();
+
+   if (hits[BTREE] != hits[STL] || hits[TREE] != hits[STL] || sums[BTREE] != sums[STL] || sums[TREE] != sums[STL] ||
+       btreeSet.Size() != int(stlSet.size()) || treeSet.Size() != int(stlSet.size()))
+      printf("BTreeSet results disagree!\n");
+
+   delete [] keys;
+   delete [] queries;
+
+   const char * names[4] = { "Random Insertion:", "Random Lookup:   ", "Traversal:       ", "Removal:         " };
+   printf("                                BTreeSet      TreeSet       STL   \n");
+   for (int t = 0; t < 4; ++t)
+      printf("%s               %8.2f ms  %8.2f ms  %8.2f ms\n", names[t],
+             (float)times[t][BTREE], (float)times[t][TREE], (float)times[t][STL]);
+}
+
+
+/// "btree" runs only the B+-tree comparison
+int main(int argc, char ** argv)
+{
+   if (argc > 1 && strcmp(argv[1], "btree") == 0) { performanceTestBTree(); return 0; }
+
    performanceTestTreeSet<Mutable::TreeSet<int> >();
+   performanceTestLookup();
+   performanceTestSetAlgebra(1000000, 1000000);
+   performanceTestSetAlgebra(1000000, 10000);
+   performanceTestBTree();
    return 0;
 }
 
@@ -1,5 +1,11 @@
 #include <stdio.h>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <iterator>
+#include <algorithm>
 
 #include <Mathematics.h>
 #include <Collections.h>
@@ -20,6 +26,18 @@ template <class T> int ToKey(const T& t);
 template <> int ToKey(const int& t) { return t; }
 template <> int ToKey<Common::KeyValuePair<int, float> >(const Common::KeyValuePair<int, float>& t) { return t.key; }
 
+/// The node pools and trees behind the containers, for the tests of their
+/// layout: slot reuse, compaction and tree shape
+namespace Collections { namespace Common {
+   struct Internals
+   {
+      template <class E> static const MemoryPool<LinkedListNode<E> >& NodePool(const Mutable::LinkedList<E>& t) { return *t._nodePool; }
+      template <class E> static const MemoryPool<LinkedListNode<E> >& NodePool(const Immutable::LinkedList<E>& t) { return *t._nodePool; }
+      template <class C> static const typename C::Tree& Tree(const C& t) { return t._tree; }
+      template <class C> static C Make(int size, typename C::Tree&& tree) { return C(size, std::move(tree)); }
+   };
+} }
+
 auto isNonNegative  = [] (int i) -> bool { return i >= 0; };
 auto isNegative     = [] (int i) -> bool { return i < 0; };
 auto alwaysSucceeds = [] (int i) -> bool { return true; };
@@ -43,6 +61,18 @@ template <class T> typename T::ElementType ToElement(int i) { return i; }
 template <> typename Immutable::TreeMap<int, float>::ElementType 
 ToElement<Immutable::TreeMap<int, float> >(int i) 
 { return Common::KeyValuePair<int, float>(i, i * 0.5f); }
+template <> typename Immutable::FlatMap<int, float>::ElementType 
+ToElement<Immutable::FlatMap<int, float> >(int i) 
+{ return Common::KeyValuePair<int, float>(i, i * 0.5f); }
+template <> typename Mutable::BTreeMap<int, float>::ElementType 
+ToElement<Mutable::BTreeMap<int, float> >(int i) 
+{ return Common::KeyValuePair<int, float>(i, i * 0.5f); }
+template <> typename Immutable::HashMap<int, float>::ElementType 
+ToElement<Immutable::HashMap<int, float> >(int i) 
+{ return Common::KeyValuePair<int, float>(i, i * 0.5f); }
+template <> typename Mutable::HashMap<int, float>::ElementType 
+ToElement<Mutable::HashMap<int, float> >(int i) 
+{ return Common::KeyValuePair<int, float>(i, i * 0.5f); }
 //template <> typename Mutable::TreeMap<int, float>::ElementType 
 //ToElement<Mutable::TreeMap<int, float> >(int i) 
 //{ return Common::KeyValuePair<int, float>(i, i * 0.5f); }
@@ -73,12 +103,21 @@ template <class T> struct ToString { constexpr static const char * const s = "";
 
 template <> struct ToString<Immutable::Array<int> >           { constexpr static const char * const value = "Immutable::Array<int>"; };
 template <> struct ToString<Mutable::Array<int>   >           { constexpr static const char * const value = "Mutable::Array<int>"; };
+template <> struct ToString<Collections::Vector<int> >         { constexpr static const char * const value = "Vector<int>"; };
 template <> struct ToString<Immutable::LinkedList<int> >      { constexpr static const char * const value = "Immutable::LinkedList<int>"; };
 template <> struct ToString<Mutable::LinkedList<int>   >      { constexpr static const char * const value = "Mutable::LinkedList<int>"; };
 template <> struct ToString<Immutable::TreeSet<int> >         { constexpr static const char * const value = "Immutable::TreeSet<int>"; };
 template <> struct ToString<Mutable::TreeSet<int>   >         { constexpr static const char * const value = "Mutable::TreeSet<int>"; };
 template <> struct ToString<Immutable::TreeMap<int, float> >  { constexpr static const char * const value = "Immutable::TreeMap<int, float>"; };
 template <> struct ToString<Mutable::TreeMap<int, float> >    { constexpr static const char * const value = "Mutable::TreeMap<int, float>"; };
+template <> struct ToString<Immutable::FlatSet<int> >         { constexpr static const char * const value = "Immutable::FlatSet<int>"; };
+template <> struct ToString<Immutable::FlatMap<int, float> >  { constexpr static const char * const value = "Immutable::FlatMap<int, float>"; };
+template <> struct ToString<Mutable::BTreeSet<int> >           { constexpr static const char * const value = "Mutable::BTreeSet<int>"; };
+template <> struct ToString<Mutable::BTreeMap<int, float> >    { constexpr static const char * const value = "Mutable::BTreeMap<int, float>"; };
+template <> struct ToString<Immutable::HashSet<int> >          { constexpr static const char * const value = "Immutable::HashSet<int>"; };
+template <> struct ToString<Immutable::HashMap<int, float> >   { constexpr static const char * const value = "Immutable::HashMap<int, float>"; };
+template <> struct ToString<Mutable::HashSet<int> >            { constexpr static const char * const value = "Mutable::HashSet<int>"; };
+template <> struct ToString<Mutable::HashMap<int, float> >     { constexpr static const char * const value = "Mutable::HashMap<int, float>"; };
 
 
 #define STREAM_OUT_DEF o << "[ "; Printer p; c.ForEach(p); o << "]"; return o;
@@ -562,6 +601,61 @@ template <class T> bool Test_Copy()
    return true;
 }
 
+template <class T> bool Test_Move()
+{
+   typedef typename T::ElementType E;
+   const int N = 8;
+   const E values[N] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+   T a = T::Construct(N, values);
+   T b = std::move(a);
+   if (a.Size() != 0 || b.Size() != N) return false;
+   if (!IsEqual(b, T::Construct(N, values))) return false;
+
+   a = std::move(b);
+   if (b.Size() != 0) return false;
+   if (!IsEqual(a, T::Construct(N, values))) return false;
+
+   /// A moved-from container can be assigned to again
+   b = a;
+   if (!IsEqual(a, b)) return false;
+
+   return true;
+}
+
+template <class T> bool Test_View()
+{
+   const int N = 8;
+   int values[N] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+   auto t = T::Construct(N, values);
+
+   /// A fused chain gives the same result as the eager one
+   auto lazy = t.View().Filter(isOdd).Take(3).template To<T>();
+   if (!IsEqual(lazy, t.Filter(isOdd).Take(3))) return false;
+
+   auto tenTimes = t.View().Map(ScaleBy10()).Drop(2).template To<T>();
+   if (!IsEqual(tenTimes, MapValues<T, int>(t, ScaleBy10()).Drop(2))) return false;
+
+   auto small = t.View().TakeWhile(lt4).template To<T>();
+   if (!IsEqual(small, t.TakeWhile(lt4))) return false;
+
+   /// Terminal folds, nothing is materialized
+   if (t.View().Filter(isEven).Count() != 4) return false;
+   int sum = t.View().Map(ScaleBy10()).FoldLeft(0, [] (int a, int b) { return a + b; });
+   if (sum != 280) return false;
+
+   /// Zip ends with the shorter side, Enumerate counts from 0
+   int matches = 0;
+   t.View().Enumerate().Zip(t.View().Drop(5)).ForEach(
+      [&matches] (const Pair<Pair<int, int>, int>& p) 
+      { if (p.first.first == p.first.second && p.second == p.first.first + 5) matches++; });
+   if (matches != 3) return false;
+
+   /// The view of an empty container yields nothing
+   if (T().View().Map(ScaleBy10()).Count() != 0) return false;
+   return true;
+}
+
 template <class T> bool Test_Traversable()
 {
    bool b = true;
@@ -586,6 +680,8 @@ template <class T> bool Test_Traversable()
    cout << "Test_Count<"      << ToString<T>::value << "> ... " << ( (b &= Test_Count<T>()) ? "Passed" : "FAILED") << endl;
    cout << "Test_CountWhile<" << ToString<T>::value << "> ... " << ( (b &= Test_CountWhile<T>()) ? "Passed" : "FAILED") << endl;
    cout << "Test_Copy<"       << ToString<T>::value << "> ... " << ( (b &= Test_Copy<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Move<"       << ToString<T>::value << "> ... " << ( (b &= Test_Move<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_View<"       << ToString<T>::value << "> ... " << ( (b &= Test_View<T>()) ? "Passed" : "FAILED") << endl;
    return b;
 }
 
@@ -613,6 +709,7 @@ template <class T> bool Test_TraversableMap()
    cout << "Test_Count<"      << ToString<T>::value << "> ... " << ( (b &= Test_Count_Map<T>()) ? "Passed" : "FAILED") << endl;
    cout << "Test_CountWhile<" << ToString<T>::value << "> ... " << ( (b &= Test_CountWhile<T>()) ? "Passed" : "FAILED") << endl;
    cout << "Test_Copy<"       << ToString<T>::value << "> ... " << ( (b &= Test_Copy<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Move<"       << ToString<T>::value << "> ... " << ( (b &= Test_Move<T>()) ? "Passed" : "FAILED") << endl;
    return b;
 }
 
@@ -940,231 +1037,1367 @@ template <class T> bool Test_DestructiveSetDifference()
    return true;
 }       
 
-template <class T> bool Test_MutableArray()
-{
-   bool b = true;
-   cout << "Test_SquareBracketUpdate<" << ToString<T>::value << "> ... " << ( (b &= Test_SquareBracketUpdate<T>()) ? "Passed" : "FAILED") << endl;
-   return b;
-}
-
-template <class T> bool Test_MutableLinkedList()
-{
-   bool b = true;
-   cout << "Test_SquareBracketUpdate<"      << ToString<T>::value << "> ... " << ( (b &= Test_SquareBracketUpdate<T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_DestructiveAppendElement<" << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveAppendElement<T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_DestructiveAppendList<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveAppendList<T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_DestructiveListInsert<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveListInsert<T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_DestructiveListRemove<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveListRemove<T>()) ? "Passed" : "FAILED") << endl;
-   return b;
-}
-
-template <class T> bool Test_MutableTreeSet()
+/// Elements that own memory must be constructed, moved and destroyed exactly
+/// once each, which the raw storage beneath arrays has to get right by hand
+template <class T> bool Test_NonTrivialElements()
 {
-   bool b = true;
-   cout << "Test_DestructiveSetInsertElement<" << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetInsertElement<T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_DestructiveSetUnion<"         << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetUnion<T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_DestructiveSetRemove<"        << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetRemove<T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_DestructiveSetDifference<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetDifference<T>()) ? "Passed" : "FAILED") << endl;
-   return b;
-}
+   typedef typename T::template SwapElementType<std::string>::C StringArray;
+   const int N = 1000;
 
+   typename StringArray::Builder builder;   //< No size hint, so it must grow
+   for (int i = 0; i < N; ++i) builder.AddElement(std::to_string(i));
+   StringArray a = builder.Result();
 
-///////////////////////////////////////////////////////////////////////////////
-//                              Set Unit Tests                               //
-///////////////////////////////////////////////////////////////////////////////
+   if (a.Size() != N) return false;
+   for (int i = 0; i < N; ++i) if (a[i] != std::to_string(i)) return false;
 
+   StringArray r = a.Reverse();
+   for (int i = 0; i < N; ++i) if (r[i] != std::to_string(N-1-i)) return false;
 
-template <class T> bool Test_SetContains()
-{
-   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
-   auto t = T::Construct(N, values);
+   /// Popped slots are reused by later pushes
+   Collections::Vector<std::string> v;
+   for (int i = 0; i < N; ++i) v.Push(std::to_string(i));
+   for (int i = 0; i < N/2; ++i) if (v.Pop() != std::to_string(N-1-i)) return false;
+   for (int i = N/2; i < N; ++i) v += std::to_string(-i);
+   if (v.Size() != N) return false;
+   for (int i = 0; i < N; ++i) if (v[i] != std::to_string(i < N/2 ? i : -i)) return false;
 
-   for (int i = 0; i < N; ++i) if (!t.Contains(values[i])) return false;
-   if (T().Contains(0)) return false;
+   /// A Vector sharing its buffer with an array must not write into it
+   Collections::Vector<std::string> w = Mutable::Array<std::string>(v);
+   w.Push("tail");
+   if (v.Size() != N || w.Size() != N+1 || w[N] != "tail") return false;
 
    return true;
 }
-template <class T> bool Test_IsSubsetOf()
-{
-   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
-   auto t = T::Construct(N, values);
 
-   for (int i = 0; i < N; ++i) if (!T().Insert(values[i]).IsSubsetOf(t)) 
-      return false;
-   for (int i = 0; i < N; ++i) 
-      if (!T().Insert(values[i]).Insert(values[(i+1)%N]).IsSubsetOf(t)) 
-         return false;
+/// Parallel operations must agree exactly with their sequential versions,
+/// including element order, whatever the number of threads
+template <class T> bool Test_Par()
+{
+   const int N = 100000;
+   auto t = T::Construct(N, [] (int i) { return (i * 37) % 1001 - 500; });
 
-   if (!T().IsSubsetOf(t)) return false;
-   if (t.IsSubsetOf(T())) return false;
+   for (int threads = 1; threads <= 5; threads += 2)
+   {
+      auto par = t.Par(threads);
+      if (par.Count(isEven) != t.Count(isEven)) return false;
+      if (par.Exists(isNegative) != t.Exists(isNegative)) return false;
+      if (par.Exists([] (int i) { return i > 500; })) return false;
+      if (par.ForAll(alwaysSucceeds) != true) return false;
+      if (par.ForAll(isNonNegative) != t.ForAll(isNonNegative)) return false;
+
+      long long sum = par.Reduce(0LL, [] (long long a, int b) { return a + b; });
+      if (sum != t.View().FoldLeft(0LL, [] (long long a, int b) { return a + b; })) return false;
+
+      if (!IsEqual(par.Map(ScaleBy10()), MapValues<T, int>(t, ScaleBy10()))) return false;
+      if (!IsEqual(par.Filter(isOdd), t.Filter(isOdd))) return false;
+      if (!IsEqual(par.FilterNot(isOdd), t.FilterNot(isOdd))) return false;
+
+      auto halves = par.Partition(isNegative);
+      auto expected = t.Partition(isNegative);
+      if (!IsEqual(halves.first, expected.first) || !IsEqual(halves.second, expected.second)) return false;
+
+      std::atomic<int> visited(0);
+      par.ForEach([&visited] (int) { visited++; });
+      if (visited != N) return false;
+
+      auto generated = ParallelArray<int, T>::Construct(N, [] (int i) { return (i * 37) % 1001 - 500; }, threads);
+      if (!IsEqual(generated, t)) return false;
+   }
 
+   /// Too small to split, and empty
+   if (!IsEqual(T::Construct(3, [] (int i) { return i; }).Par().Filter(isOdd), T::Construct(1, [] (int) { return 1; }))) return false;
+   if (T().Par().Count(alwaysSucceeds) != 0 || T().Par().Map(ScaleBy10()).Size() != 0) return false;
    return true;
 }
-template <class T> bool Test_Union()
+
+/// Par() on a Vector copies it to a Mutable::Array, whose size must come
+/// from the Vector's virtual Size(), leaving out the slots a Pop() left
+template <> bool Test_Par<Collections::Vector<int> >()
 {
-   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
-   auto t = T::Construct(N, values);
+   const int N = 100000;
+   auto input = [] (int i) { return (i * 37) % 1001 - 500; };
+   auto expected = Mutable::Array<int>::Construct(N, input);
 
-   if (!IsEqual( t, t | t )) return false;
-   if (!IsEqual( t, t | T() )) return false;
+   Collections::Vector<int> v;
+   for (int i = 0; i < N; ++i) v += input(i);
+   for (int i = 0; i < 1000; ++i) v += 1000;
+   for (int i = 0; i < 1000; ++i) v.Pop();
 
-   for (int i = 0; i < N; ++i) 
-      if (!IsEqual( t, t | T().Insert(values[i]))) return false;
+   for (int threads = 1; threads <= 5; threads += 2)
+   {
+      auto par = v.Par(threads);
+      if (par.Count(isEven) != expected.Count(isEven)) return false;
+      if (par.Exists([] (int i) { return i > 500; })) return false;
+      if (par.ForAll(isNonNegative) != expected.ForAll(isNonNegative)) return false;
 
-   auto u = t | T().Insert(1) | T().Insert(1) | T().Insert(1);
-   if (u.Size() != t.Size() + 1) return false;
-   if (!u.Contains(1)) return false;
+      long long sum = par.Reduce(0LL, [] (long long a, int b) { return a + b; });
+      if (sum != expected.View().FoldLeft(0LL, [] (long long a, int b) { return a + b; })) return false;
 
-   return true;
-}
-template <class T> bool Test_Intersection()
-{
-   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
-   auto t = T::Construct(N, values);
+      if (!IsEqual(par.Map(ScaleBy10()), MapValues<Mutable::Array<int>, int>(expected, ScaleBy10()))) return false;
+      if (!IsEqual(par.Filter(isOdd), expected.Filter(isOdd))) return false;
 
-   if (!IsEqual( t, t & t ))     return false;
-   if (!IsEqual( T(), t & T() )) return false;  
-   for (int i = 0; i < N; ++i) 
-      if (!IsEqual( T() + values[i], t & T() + values[i] )) 
-         return false;
+      std::atomic<int> visited(0);
+      par.ForEach([&visited] (int) { visited++; });
+      if (visited != N) return false;
+   }
 
-   return true;
+   v.Clear();
+   return v.Par().Count(alwaysSucceeds) == 0 && v.Par().Map(ScaleBy10()).Size() == 0;
 }
-template <class T> bool Test_Difference()
-{
-   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
-   auto t = T::Construct(N, values);
 
-   if (!IsEqual( T(), t - t )) return false;
-   if (!IsEqual( t, t - T() )) return false;
-   if ((t - T().Insert(0)).Size() != t.Size()-1) return false;
-   if ((T() - T()).Size() != 0) return false;
+/// The input patterns that trip up naive quicksorts
+enum SortPattern { RANDOM, SORTED, REVERSED, ALL_EQUAL, ORGAN_PIPE, FEW_DISTINCT, SORT_PATTERNS };
 
-   return true;
+static int SortInput(SortPattern p, int n, int i)
+{
+   switch (p)
+   {
+   case RANDOM:       return (int)(((unsigned int)i * 2654435761u) >> 7) - (1 << 24);
+   case SORTED:       return i;
+   case REVERSED:     return n - i;
+   case ALL_EQUAL:    return 42;
+   case ORGAN_PIPE:   return i < n/2 ? i : n - i;
+   default:           return (int)(((unsigned int)i * 2654435761u) >> 29);
+   }
 }
-template <class T> bool Test_Insert()
+
+/// Sorting must agree with std::sort on every pattern and size
+template <class T> bool Test_Sorted()
 {
-   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
-   auto t = T();
-   for (int i = 0; i < N; ++i) t = t + values[i];
-   if (!IsEqual( t, T::Construct(N, values) )) return false;
+   const int sizes[] = { 0, 1, 2, 3, 23, 24, 25, 127, 128, 129, 1000, 100000 };
+   for (int p = 0; p < SORT_PATTERNS; ++p)
+   {
+      for (int s = 0; s < 12; ++s)
+      {
+         const int n = sizes[s];
+         std::vector<int> expected(n);
+         for (int i = 0; i < n; ++i) expected[i] = SortInput((SortPattern)p, n, i);
+         T t = T::Construct(n, [&expected] (int i) { return expected[i]; });
+         std::sort(expected.begin(), expected.end());
+
+         T sorted = Sorted(t);
+         if (sorted.Size() != n) return false;
+         for (int i = 0; i < n; ++i) if (sorted[i] != expected[i]) return false;
+
+         /// The original is left alone
+         for (int i = 0; i < n; ++i) if (t[i] != SortInput((SortPattern)p, n, i)) return false;
+      }
+   }
    return true;
 }
-template <class T> bool Test_Remove()
+
+/// Radix sorted element and key types must come out in operator < order, and
+/// sorting by key must be stable
+template <class T> bool Test_SortedBy()
 {
-   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
-   auto t = T::Construct(N, values);
+   typedef typename T::template SwapElementType<float>::C Floats;
+   typedef typename T::template SwapElementType<Pair<int, int> >::C Pairs;
+   const int N = 5000;
+
+   std::vector<float> expected(N);
+   for (int i = 0; i < N; ++i) expected[i] = (float)SortInput(RANDOM, N, i) / 1024.0f;
+   expected[7] = -0.0f; expected[8] = 0.0f; expected[9] = -1e30f; expected[10] = 1e30f;
+   Floats floats = Floats::Construct(N, [&expected] (int i) { return expected[i]; });
+   std::sort(expected.begin(), expected.end());
+   Floats sortedFloats = Sorted(floats);
+   for (int i = 0; i < N; ++i) if (sortedFloats[i] != expected[i]) return false;
+
+   /// Few distinct keys, the second member records the original position
+   Pairs pairs = Pairs::Construct(N, [] (int i) { return Pair<int, int>(SortInput(FEW_DISTINCT, N, i) - 4, i); });
+   Pairs byKey = SortedBy(pairs, [] (const Pair<int, int>& p) { return p.first; });
+   for (int i = 1; i < N; ++i)
+   {
+      if (byKey[i].first < byKey[i-1].first) return false;
+      if (byKey[i].first == byKey[i-1].first && byKey[i].second < byKey[i-1].second) return false;
+   }
 
-   int indirection[N] = { 0, 4, 2, 6, 3, 5, 7, 1 };
-   for (int i = 0; i < N; ++i) t = t - values[indirection[i]];
-   if (t.Size() != 0) return false;
-   if (!IsEqual( t, T() )) return false;
+   /// Unsigned 64 bit and signed 8 bit keys
+   Pairs byIndex = SortedBy(byKey, [] (const Pair<int, int>& p) { return (unsigned long long)p.second << 33; });
+   for (int i = 0; i < N; ++i) if (byIndex[i].second != i) return false;
+   Pairs byChar = SortedBy(pairs, [] (const Pair<int, int>& p) { return (signed char)p.first; });
+   for (int i = 0; i < N; ++i) if (byChar[i].first != byKey[i].first || byChar[i].second != byKey[i].second) return false;
 
-   return true;
-}
+   /// bool is integral but not radix sorted, false comes first
+   typedef typename T::template SwapElementType<bool>::C Bools;
+   Bools bools = Sorted(Bools::Construct(N, [] (int i) { return i % 3 == 0; }));
+   for (int i = 0; i < N; ++i) if (bools[i] != (i >= N - (N + 2) / 3)) return false;
 
+   return SortedBy(Pairs(), [] (const Pair<int, int>& p) { return p.first; }).Size() == 0;
+}
 
-template <class T> bool Test_Set()
+/// The parallel sort must give exactly what the sequential one does
+template <class T> bool Test_ParallelSort()
 {
-   bool b = true;
-   cout << "Test_SetContains<"   << ToString<T>::value << "> ... " << ( (b &= Test_SetContains  <T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_IsSubsetOf<"    << ToString<T>::value << "> ... " << ( (b &= Test_IsSubsetOf   <T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_Union<"         << ToString<T>::value << "> ... " << ( (b &= Test_Union        <T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_Intersection<"  << ToString<T>::value << "> ... " << ( (b &= Test_Intersection <T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_Difference<"    << ToString<T>::value << "> ... " << ( (b &= Test_Difference   <T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_Insert<"        << ToString<T>::value << "> ... " << ( (b &= Test_Insert       <T>()) ? "Passed" : "FAILED") << endl;
-   cout << "Test_Remove<"        << ToString<T>::value << "> ... " << ( (b &= Test_Remove       <T>()) ? "Passed" : "FAILED") << endl;
-   return b;  
-}
+   const int N = 3 * Common::PARALLEL_SORT_THRESHOLD + 17;
+   for (int p = 0; p < SORT_PATTERNS; ++p)
+   {
+      T t = T::Construct(N, [N, p] (int i) { return SortInput((SortPattern)p, N, i); });
+      T expected = Sorted(t);
+      for (int threads = 2; threads <= 5; threads += 3)
+      {
+         T sorted = t.Par(threads).Sorted();
+         for (int i = 0; i < N; ++i) if (sorted[i] != expected[i]) return false;
+      }
+   }
 
+   /// Through the comparison sort, and an array too small to split
+   typedef typename T::template SwapElementType<std::string>::C Strings;
+   Strings strings = Strings::Construct(N, [] (int i) { return std::to_string(SortInput(RANDOM, 0, i)); });
+   Strings sortedStrings = strings.Par(3).Sorted(), expectedStrings = Sorted(strings);
+   for (int i = 0; i < N; ++i) if (sortedStrings[i] != expectedStrings[i]) return false;
 
-///////////////////////////////////////////////////////////////////////////////
-//                              Map Unit Tests                               //
-///////////////////////////////////////////////////////////////////////////////
+   T small = T::Construct(100, [] (int i) { return 100 - i; });
+   return IsEqual(small.Par(4).Sorted(), Sorted(small));
+}
 
-/// Access
-template <class T> bool Test_Contains_Map() 
-{ 
+/// Small sorts go through the sorting networks for int and float keys, and
+/// must cover every block size, and the padding around it
+template <class T> bool Test_SortSmall()
+{
    typedef typename T::ElementType E;
-   const int N = 8; const E values[N] = { ToElement<T>(5), ToElement<T>(16), ToElement<T>(77), ToElement<T>(90), ToElement<T>(191), ToElement<T>(-249), ToElement<T>(-29), ToElement<T>(0) };
-   auto t = T::Construct(N, values);
+   for (int n = 0; n <= 2 * Common::SORT_NETWORK_MAX + 1; ++n)
+   {
+      for (int p = 0; p < SORT_PATTERNS; ++p)
+      {
+         std::vector<E> keys(n + 1), expected;
+         std::vector<float> floats(n + 1), expectedFloats;
+         for (int i = 0; i < n; ++i)
+         {
+            keys[i] = (E)SortInput((SortPattern)p, n, i);
+            floats[i] = (float)keys[i] * -0.5f;
+         }
+         expected.assign(keys.begin(), keys.begin() + n);
+         expectedFloats.assign(floats.begin(), floats.begin() + n);
+         std::sort(expected.begin(), expected.end());
+         std::sort(expectedFloats.begin(), expectedFloats.end());
+
+         Common::SortSmall(&keys[0], n);
+         Common::SortSmall(&floats[0], n);
+         for (int i = 0; i < n; ++i)
+            if (keys[i] != expected[i] || floats[i] != expectedFloats[i]) return false;
+      }
+   }
+   return true;
+}
 
+template <class T> bool Test_ArraySort()
+{
    bool b = true;
-   for (int i = 0; i < N; ++i) b &= t.Contains(values[i].key);
-   if (!b) return false;
-
-   if (t.Contains(-1)) return false;
-   if (T().Contains(100)) return false;
+   cout << "Test_Sorted<"   << ToString<T>::value << "> ... " << ( (b &= Test_Sorted<T>())   ? "Passed" : "FAILED") << endl;
+   cout << "Test_SortedBy<" << ToString<T>::value << "> ... " << ( (b &= Test_SortedBy<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_ParallelSort<" << ToString<T>::value << "> ... " << ( (b &= Test_ParallelSort<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_SortSmall<" << ToString<T>::value << "> ... " << ( (b &= Test_SortSmall<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
 
-   return true;
+/// Fork-join on a private pool, so that there is real concurrency whatever
+/// the hardware
+static int ForkJoinFib(Scheduler& s, int n)
+{
+   if (n < 2) return n;
+   int a = 0;
+   Scheduler::TaskGroup g(s);
+   g.Spawn([&s, &a, n] () { a = ForkJoinFib(s, n - 1); });
+   int b = ForkJoinFib(s, n - 2);
+   g.Sync();
+   return a + b;
 }
 
-template <class T> bool Test_GetOrElse_Map() 
-{ 
-   typedef typename T::ElementType E; const int N = 8; 
-   const E values[N] = { ToElement<T>(5), ToElement<T>(16), ToElement<T>(77), ToElement<T>(90), ToElement<T>(191), ToElement<T>(-249), ToElement<T>(-29), ToElement<T>(0) };
-   auto t = T::Construct(N, values);
+bool Test_SpawnSync()
+{
+   Scheduler s(3);
+   if (ForkJoinFib(s, 18) != 2584) return false;
 
-   bool b = true;
-   for (int i = 0; i < N; ++i) 
+   /// Many tasks on one group, some spawned from inside other tasks
+   std::atomic<int> counter(0);
    {
-      b &= (t.GetOrElse(values[i].key, -3.14159f) == values[i].value);
-      b &= (t.GetOrElse(500, -3.14159f) == -3.14159f);
+      Scheduler::TaskGroup g(s);
+      for (int i = 0; i < 1000; ++i)
+         g.Spawn([&counter, &g] () { counter++; g.Spawn([&counter] () { counter++; }); });
    }
-   if (!b) return false;
-   if (T().GetOrElse(500, -3.14159f) != -3.14159f) return false;
+   if (counter != 2000) return false;
 
-   return true;
+   /// A pool without workers runs everything on the syncing thread
+   Scheduler none(0);
+   return ForkJoinFib(none, 12) == 144;
 }
 
+bool Test_ParallelFor()
+{
+   Scheduler s(3);
+   const int N = 100000;
+   std::atomic<int> * hits = new std::atomic<int>[N];
+   for (int i = 0; i < N; ++i) hits[i] = 0;
 
-/// Functional Updates. A new container is returned with the specified mapping
-/// added, removed, or updated as appropriate. 
-template <class T> bool Test_Insert_Map() 
-{ 
-   typedef typename T::ElementType E; const int N = 8; 
-   const E valuesA[N] = { ToElement<T>(5), ToElement<T>(16), ToElement<T>(77), ToElement<T>(90), ToElement<T>(191), ToElement<T>(-249), ToElement<T>(-29), ToElement<T>(0) };
-   const E valuesB[N] = { ToElement<T>(40), ToElement<T>(1), ToElement<T>(2), ToElement<T>(3), ToElement<T>(4), ToElement<T>(50), ToElement<T>(6), ToElement<T>(7) };
-   auto t = T::Construct(N, valuesA);
-
-   for (int i = 0; i < N; ++i)
-      if (!t.Contains(valuesA[i].key)) return false;
+   /// Every index is visited exactly once, in ranges no longer than the grain
+   bool b = true;
+   std::atomic<int> oversized(0);
+   ParallelFor(0, N, 100, [hits, &oversized] (int begin, int end)
+   {
+      if (end - begin > 100) oversized++;
+      for (int i = begin; i < end; ++i) hits[i]++;
+   }, s);
+   for (int i = 0; i < N; ++i) b &= hits[i] == 1;
+   b &= oversized == 0;
+   delete [] hits;
+
+   /// Nested loops, and the default scheduler and grain
+   std::atomic<long long> sum(0);
+   ParallelFor(0, 100, [&sum] (int begin, int end)
+   {
+      for (int i = begin; i < end; ++i)
+         ParallelFor(0, 1000, 10, [&sum] (int b, int e) { sum += e - b; });
+   });
+   b &= sum == 100000;
+
+   int calls = 0;
+   ParallelFor(5, 5, 1, [&calls] (int, int) { calls++; }, s);
+   return b && calls == 0;
+}
 
-   for (int i = 0; i < N; ++i)
+bool Test_SchedulerStats()
+{
+   Scheduler s(2);
+   s.ResetStats();
+   std::atomic<int> counter(0);
+   ParallelFor(0, 4096, 1, [&counter] (int, int) { counter++; }, s);
+
+   /// Every task shows up in exactly one worker's count
+   long long tasks = 0;
+   for (int i = 0; i <= s.Workers(); ++i)
    {
-      t = t.Insert(valuesB[i].key, valuesB[i].value);
-      if (!t.Contains(valuesB[i].key)) return false;
-      if (!t.Contains(valuesA[i].key)) return false;
-      if (t.GetOrElse(valuesB[i].key, -100.0f) != valuesB[i].value) return false;
+      WorkerStats w = s.Stats(i);
+      if (w.steals > w.tasksRun + 4096 || w.idleMilliseconds < 0) return false;
+      tasks += w.tasksRun;
    }
+   return counter == 4096 && tasks == 4095;
+}
 
-   if (!T().Insert(10, 3.14159f).Contains(10)) 
-      return false;
-
-   return true;
+bool Test_Scheduler()
+{
+   bool b = true;
+   cout << "Test_SpawnSync ... "      << ( (b &= Test_SpawnSync())      ? "Passed" : "FAILED") << endl;
+   cout << "Test_ParallelFor ... "    << ( (b &= Test_ParallelFor())    ? "Passed" : "FAILED") << endl;
+   cout << "Test_SchedulerStats ... " << ( (b &= Test_SchedulerStats()) ? "Passed" : "FAILED") << endl;
+   return b;
 }
 
-template <class T> bool Test_Remove_Map() 
-{ 
-   typedef typename T::ElementType E; const int N = 8; 
-   const E valuesA[N] = { ToElement<T>(5), ToElement<T>(16), ToElement<T>(77), ToElement<T>(90), ToElement<T>(191), ToElement<T>(-249), ToElement<T>(-29), ToElement<T>(0) };
-   const E valuesB[N] = { ToElement<T>(40), ToElement<T>(1), ToElement<T>(2), ToElement<T>(3), ToElement<T>(4), ToElement<T>(50), ToElement<T>(6), ToElement<T>(7) };
-   auto t = T::Construct(N, valuesA);
+template <class T> bool Test_ParallelArray()
+{
+   bool b = true;
+   cout << "Test_Par<" << ToString<T>::value << "> ... " << ( (b &= Test_Par<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
 
-   for (int i = 0; i < N; ++i)
+/// Selection must agree with a full sort on every pattern, and on Vectors
+/// must stay within the live elements
+template <class T> bool Test_Selection()
+{
+   const int sizes[] = { 1, 2, 15, 16, 17, 100, 1000, 50000 };
+   for (int p = 0; p < SORT_PATTERNS; ++p)
    {
-      t = t.Remove(valuesA[i].key).Remove(valuesB[i].key);
-      if (t.Contains(valuesA[i].key)) return false;
-      for (int j = i+1; j < N; ++j)
-         if (!t.Contains(valuesA[j].key)) return false;
+      for (int s = 0; s < 8; ++s)
+      {
+         const int n = sizes[s];
+         auto input = [n, p] (int i) { return SortInput((SortPattern)p, n, i); };
+         std::vector<int> expected(n);
+         for (int i = 0; i < n; ++i) expected[i] = input(i);
+         std::sort(expected.begin(), expected.end());
+
+         const int ks[] = { 0, 1, n/3, n/2, n-1, n };
+         for (int j = 0; j < 6; ++j)
+         {
+            const int k = ks[j];
+            if (k < n)
+            {
+               T t = T(Mutable::Array<int>::Construct(n, input));
+               NthElement(t, k);
+               if (t[k] != expected[k]) return false;
+               for (int i = 0; i < k; ++i) if (t[k] < t[i]) return false;
+               for (int i = k+1; i < n; ++i) if (t[i] < t[k]) return false;
+            }
+
+            T t = T(Mutable::Array<int>::Construct(n, input));
+            PartialSort(t, k);
+            for (int i = 0; i < k; ++i) if (t[i] != expected[i]) return false;
+
+            auto top = TopK(T(Mutable::Array<int>::Construct(n, input)), k);
+            if (top.Size() != k) return false;
+            for (int i = 0; i < k; ++i) if (top[i] != expected[i]) return false;
+         }
+
+         /// The largest, through the comparators
+         const int k = n/4 + 1;
+         auto greater = [] (int a, int b) { return a > b; };
+         T t = T(Mutable::Array<int>::Construct(n, input));
+         PartialSort(t, k, greater);
+         auto top = TopK(t, k, greater);
+         for (int i = 0; i < k; ++i) if (t[i] != expected[n-1-i] || top[i] != expected[n-1-i]) return false;
+         NthElement(t, n-k, greater);
+         if (t[n-k] != expected[k-1]) return false;
+      }
    }
 
-   if (T().Remove(10).Size() != 0) return false;
+   /// Elements past a Vector's size must not be selected
+   Collections::Vector<int> v;
+   for (int i = 0; i < 100; ++i) v += 100 - i;
+   for (int i = 0; i < 50; ++i) v.Pop();
+   PartialSort(v, 10);
+   for (int i = 0; i < 10; ++i) if (v[i] != 51 + i) return false;
+   return NthElement(v, 0)[0] == 51 && TopK(v, 200).Size() == 50;
+}
+
+/// The accumulator must keep the k smallest of a stream from any container
+template <class T> bool Test_TopKAccumulator()
+{
+   const int N = 20000;
+   auto input = [] (int i) { return SortInput(RANDOM, N, i); };
+   T t = T::Construct(N, input);
+   std::vector<int> expected(N);
+   for (int i = 0; i < N; ++i) expected[i] = input(i);
+   std::sort(expected.begin(), expected.end());
+
+   TopKAccumulator<int> smallest(100);
+   smallest.AddAll(t.GetIterator());
+   Mutable::Array<int> result = smallest.Result();
+   if (result.Size() != 100 || smallest.Threshold() != expected[99]) return false;
+   for (int i = 0; i < 100; ++i) if (result[i] != expected[i]) return false;
+
+   /// From a set, largest first, and fewer elements than k
+   auto greater = [] (int a, int b) { return a > b; };
+   TopKAccumulator<int, decltype(greater)> largest(10, greater);
+   largest.AddAll(Immutable::TreeSet<int>::Construct(5, [] (int i) { return i * 3; }).GetIterator());
+   if (largest.IsFull() || !IsEqual(largest.Result(), Mutable::Array<int>::Construct(5, [] (int i) { return 12 - i * 3; }))) return false;
+
+   TopKAccumulator<int> none(0);
+   none.AddAll(t.GetIterator());
+   return none.Result().Size() == 0;
+}
+
+/// Sorting in place on several threads must agree with std::sort, on random
+/// input, few distinct keys, and sizes on either side of the sequential cutoff,
+/// and on a scheduler of its own
+template <class T> bool Test_ParallelSortInPlace()
+{
+   const int T0 = Common::PARALLEL_SORT_THRESHOLD;
+   const int sizes[] = { 0, 1, 2, T0 - 1, T0, T0 + 1, 3 * T0 + 17 };
+   const SortPattern patterns[] = { RANDOM, FEW_DISTINCT, ALL_EQUAL, REVERSED };
+   for (int s = 0; s < 7; ++s)
+   {
+      for (int p = 0; p < 4; ++p)
+      {
+         const int n = sizes[s];
+         std::vector<int> expected(n);
+         for (int i = 0; i < n; ++i) expected[i] = SortInput(patterns[p], n, i);
+         T t = T::Construct(n, [&expected] (int i) { return expected[i]; });
+         std::sort(expected.begin(), expected.end());
+
+         for (int threads = 2; threads <= 5; threads += 3)
+         {
+            T sorted = T::Construct(n, [&t] (int i) { return t[i]; });
+            if (&Mutable::ParallelSortInPlace(sorted, threads) != &sorted || sorted.Size() != n) return false;
+            for (int i = 0; i < n; ++i) if (sorted[i] != expected[i]) return false;
+         }
+      }
+   }
 
+   /// Through the comparison sort
+   typedef typename T::template SwapElementType<std::string>::C Strings;
+   const int N = 2 * T0 + 5;
+   Strings strings = Strings::Construct(N, [] (int i) { return std::to_string(SortInput(FEW_DISTINCT, 0, i)); });
+   std::vector<std::string> expectedStrings(N);
+   for (int i = 0; i < N; ++i) expectedStrings[i] = strings[i];
+   std::sort(expectedStrings.begin(), expectedStrings.end());
+   Mutable::ParallelSortInPlace(strings, 3);
+   for (int i = 0; i < N; ++i) if (strings[i] != expectedStrings[i]) return false;
+
+   /// One key, and four, fill the sample with equal splitters, whose keys
+   /// go to equality buckets. The sort runs on the scheduler it is given.
+   Scheduler pool(3);
+   for (int distinct = 1; distinct <= 4; distinct *= 4)
+   {
+      auto key = [distinct] (int i) { return (int)(((unsigned int)i * 2654435761u) >> 8) % distinct * 1000; };
+      T t = T::Construct(N, key);
+      pool.ResetStats();
+      if (&Mutable::ParallelSortInPlace(t, pool) != &t) return false;
+
+      long long tasks = 0;
+      for (int w = 0; w <= pool.Workers(); ++w) tasks += pool.Stats(w).tasksRun;
+      if (tasks == 0) return false;
+
+      int counts[4] = { 0, 0, 0, 0 };
+      for (int i = 0; i < N; ++i) counts[key(i) / 1000]++;
+      for (int i = 0, k = 0; k < distinct; ++k)
+         for (int end = i + counts[k]; i < end; ++i) if (t[i] != k * 1000) return false;
+   }
    return true;
 }
 
-/// Returns a set container containing only the keys in the map
+template <class T> bool Test_MutableArray()
+{
+   bool b = true;
+   cout << "Test_SquareBracketUpdate<" << ToString<T>::value << "> ... " << ( (b &= Test_SquareBracketUpdate<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_NonTrivialElements<" << ToString<T>::value << "> ... " << ( (b &= Test_NonTrivialElements<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Selection<" << ToString<T>::value << "> ... " << ( (b &= Test_Selection<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_TopKAccumulator<" << ToString<T>::value << "> ... " << ( (b &= Test_TopKAccumulator<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_ParallelSortInPlace<" << ToString<T>::value << "> ... " << ( (b &= Test_ParallelSortInPlace<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+/// Removing and re-adding elements in a steady state must reuse the freed
+/// node slots, and Compact() must leave the contents unchanged
+template <class T> bool Test_ListChurn()
+{
+   const int N = 64;
+   T t;
+   for (int i = 0; i < N; ++i) t += i;
+   const int footprint = Common::Internals::NodePool(t).NextFreeIndex();
+
+   for (int round = 0; round < 10; ++round)
+   {
+      /// Remove the odd elements, then put them back at the end
+      auto itr = t.GetIterator();
+      while (itr.HasNext())
+         if (itr.Peek() % 2) t.Remove(itr);
+         else itr.Next(); 
+      for (int i = 1; i < N; i += 2) t += i;
+   }
+   if (t.Size() != N || Common::Internals::NodePool(t).NextFreeIndex() != footprint) return false;
+
+   T before = t.Copy();
+   t.Compact();
+   if (!IsEqual(before, t)) return false;
+   for (int i = 0; i < N; ++i) if (Common::Internals::NodePool(t).Index(i).payload != t[i]) return false;
+   return true;
+}
+
+static Immutable::LinkedList<int> SortedList(const Immutable::LinkedList<int>& t) { return Sorted(t); }
+static Mutable::LinkedList<int> SortedList(const Mutable::LinkedList<int>& t) { return t.Sorted(); }
+
+/// List sorts must agree with std::sort, be stable, and lay the result out
+/// in order in its pool
+template <class T> bool Test_SortedList()
+{
+   const int sizes[] = { 0, 1, 2, 3, 17, 1000, 20000 };
+   for (int p = 0; p < SORT_PATTERNS; ++p)
+   {
+      for (int s = 0; s < 7; ++s)
+      {
+         const int n = sizes[s];
+         std::vector<int> expected(n);
+         for (int i = 0; i < n; ++i) expected[i] = SortInput((SortPattern)p, n, i);
+         T t = T::Construct(n, [&expected] (int i) { return expected[i]; });
+         std::sort(expected.begin(), expected.end());
+
+         T sorted = SortedList(t);
+         if (sorted.Size() != n) return false;
+         auto itr = sorted.GetIterator();
+         for (int i = 0; i < n; ++i) 
+            if (itr.Next() != expected[i] || Common::Internals::NodePool(sorted).Index(i).payload != expected[i]) return false;
+
+         /// The original is left alone
+         itr = t.GetIterator();
+         for (int i = 0; i < n; ++i) if (itr.Next() != SortInput((SortPattern)p, n, i)) return false;
+      }
+   }
+
+   /// Few distinct keys, the second member records the original position
+   typedef typename T::template SwapElementType<Pair<int, int> >::C Pairs;
+   const int N = 5000;
+   Pairs pairs = Pairs::Construct(N, [] (int i) { return Pair<int, int>(SortInput(FEW_DISTINCT, N, i), i); });
+   Pairs byKey = pairs.SortedWith([] (const Pair<int, int>& a, const Pair<int, int>& b) { return a.first < b.first; });
+   auto itr = byKey.GetIterator();
+   Pair<int, int> previous = itr.Next();
+   while (itr.HasNext())
+   {
+      const Pair<int, int> p = itr.Next();
+      if (p.first < previous.first || (p.first == previous.first && p.second < previous.second)) return false;
+      previous = p;
+   }
+
+   /// A prefix of a longer list, whose tail still links on into the pool
+   T prefix = T::Construct(100, [] (int i) { return 100 - i; }).Take(50);
+   return IsEqual(SortedList(prefix), T::Construct(50, [] (int i) { return 51 + i; }));
+}
+
+/// Sorting a list that owns its pool must relink the nodes where they are,
+/// and sorting a list that shares it must leave the other list alone
+template <class T> bool Test_SortInPlaceList()
+{
+   const int N = 1000;
+   T t;
+   for (int i = 0; i < N; ++i) t += SortInput(RANDOM, N, i);
+   {
+      auto itr = t.GetIterator();
+      while (itr.HasNext())
+         if (itr.Peek() % 3 == 0) t.Remove(itr);
+         else itr.Next();
+   }
+
+   /// A live iterator would count as a second reference to the pool
+   std::vector<int> expected;
+   auto collect = [&expected] (int i) { expected.push_back(i); };
+   t.ForEach(collect);
+   std::stable_sort(expected.begin(), expected.end());
+
+   const Common::MemoryPool<Common::LinkedListNode<int> >* pool = &Common::Internals::NodePool(t);
+   t.SortInPlace();
+   if (&Common::Internals::NodePool(t) != pool || t.Size() != (int)expected.size()) return false;
+   for (size_t i = 0; i < expected.size(); ++i) if (t[i] != expected[i]) return false;
+
+   /// Descending, through the comparator
+   t.SortInPlaceWith([] (int a, int b) { return a > b; });
+   if (&Common::Internals::NodePool(t) != pool) return false;
+   for (size_t i = expected.size(); i > 0; --i) if (t[expected.size() - i] != expected[i-1]) return false;
+
+   T shared = t, before = t.Copy();
+   shared.SortInPlace();
+   if (&Common::Internals::NodePool(shared) == pool || !IsEqual(t, before)) return false;
+   auto itr = shared.GetIterator();
+   for (size_t i = 0; i < expected.size(); ++i) if (itr.Next() != expected[i]) return false;
+
+   T empty;
+   return empty.SortInPlace().Size() == 0;
+}
+
+template <class T> bool Test_MutableLinkedList()
+{
+   bool b = true;
+   cout << "Test_SquareBracketUpdate<"      << ToString<T>::value << "> ... " << ( (b &= Test_SquareBracketUpdate<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveAppendElement<" << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveAppendElement<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveAppendList<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveAppendList<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveListInsert<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveListInsert<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveListRemove<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveListRemove<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_ListChurn<"                << ToString<T>::value << "> ... " << ( (b &= Test_ListChurn<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_SortInPlaceList<"          << ToString<T>::value << "> ... " << ( (b &= Test_SortInPlaceList<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+/// Every node's count is the size of its subtree; returns that size, or -1
+template <class E> int CountedSize(const Common::BinaryTree<E>& tree, int n)
+{
+   if (n == -1) return 0;
+   const Common::BinaryTreeNode<E>& node = tree._pool->Index(n);
+   const int l = CountedSize(tree, node.left), r = CountedSize(tree, node.right);
+   return l == -1 || r == -1 || node.count != 1 + l + r ? -1 : node.count;
+}
+template <class E> int CountedSize(const Common::BinaryTree<E>& tree) { return CountedSize(tree, tree._root); }
+
+template <class T> bool Test_SetChurn()
+{
+   const int N = 256;
+   T t;
+   for (int i = 0; i < N; ++i) t += ToElement<T>(i);
+   const int footprint = Common::Internals::Tree(t)._pool->NextFreeIndex();
+
+   for (int round = 0; round < 10; ++round)
+   {
+      for (int i = 0; i < N; i += 3) t -= ToKey<typename T::ElementType>(ToElement<T>(i));
+      for (int i = 0; i < N; i += 3) t += ToElement<T>(i);
+   }
+   if (t.Size() != N || Common::Internals::Tree(t)._pool->NextFreeIndex() != footprint) return false;
+   if (CountedSize(Common::Internals::Tree(t)) != N) return false;
+
+   T before = t.Copy();
+   t.Compact();
+   if (!IsEqual(before, t)) return false;
+
+   /// Nodes are laid out in order
+   auto itr = t.GetIterator();
+   for (int i = 0; i < N; ++i)
+      if (ToKey(itr.Next()) != ToKey(Common::Internals::Tree(t)._pool->Index(i).payload)) return false;
+   return true;
+}
+
+/// Appends the payloads below node n in preorder, which captures the shape
+template <class E> void Preorder(const Common::BinaryTree<E>& tree, int n, std::vector<E>& out)
+{
+   if (n == -1) return;
+   out.push_back(tree._pool->Index(n).payload);
+   Preorder(tree, tree._pool->Index(n).left, out);
+   Preorder(tree, tree._pool->Index(n).right, out);
+}
+template <class E> void Preorder(const Common::BinaryTree<E>& tree, std::vector<E>& out) { Preorder(tree, tree._root, out); }
+
+/// No node has a higher priority than its parent
+template <class E> bool IsHeapOrdered(const Common::BinaryTree<E>& tree, int n)
+{
+   if (n == -1) return true;
+   const Common::BinaryTreeNode<E>& node = tree._pool->Index(n);
+   if (node.left  != -1 && tree._pool->Index(node.left).priority  > node.priority) return false;
+   if (node.right != -1 && tree._pool->Index(node.right).priority > node.priority) return false;
+   return IsHeapOrdered(tree, node.left) && IsHeapOrdered(tree, node.right);
+}
+template <class E> bool IsHeapOrdered(const Common::BinaryTree<E>& tree) { return IsHeapOrdered(tree, tree._root); }
+
+/// Priorities are a hash of the key, so the same keys make the same tree
+/// whatever order they arrive in
+template <class T> bool Test_TreeShape()
+{
+   const int N = 2000;
+   T ascending, descending, scattered;
+   for (int i = 0; i < N; ++i) { ascending += i; descending += N-1-i; scattered += (i * 7919) % N; }
+
+   std::vector<int> a, d, s;
+   Preorder(Common::Internals::Tree(ascending), a);
+   Preorder(Common::Internals::Tree(descending), d);
+   Preorder(Common::Internals::Tree(scattered), s);
+   if (a != d || a != s) return false;
+   if (!IsHeapOrdered(Common::Internals::Tree(ascending))) return false;
+
+   /// Built bottom-up by a merge, the shape is the same again
+   T merged = T::Construct(N/2, [] (int i) { return 2*i; }) | T::Construct(N/2, [] (int i) { return 2*i + 1; });
+   std::vector<int> m;
+   Preorder(Common::Internals::Tree(merged), m);
+   return m == a;
+}
+
+/// The builder takes ascending input straight onto the tree's right spine
+/// and sorts anything else first. Either way the nodes come out laid out in
+/// order, in the same canonical shape as inserting the keys one at a time.
+template <class T> bool Test_TreeBuilder()
+{
+   const int N = 3000;
+   T inserted;
+   for (int i = 0; i < N; ++i) inserted += (i * 7919) % N;
+   std::vector<int> expected;
+   Preorder(Common::Internals::Tree(inserted), expected);
+
+   typename T::Builder ascending(N), scattered(N), mixed(N);
+   for (int i = 0; i < N; ++i) ascending.AddElement(i);
+   for (int i = 0; i < N; ++i) scattered.AddElement((i * 7919) % N);
+   for (int i = 0; i < N; ++i) mixed.AddElement(i < N/2 ? i : N-1 - (i - N/2));
+   for (int i = 0; i < N; i += 3) { scattered.AddElement(i); mixed.AddElement(i); }
+
+   const T built[3] = { ascending.Result(), scattered.Result(), mixed.Result() };
+   for (int b = 0; b < 3; ++b)
+   {
+      if (built[b].Size() != N) return false;
+      std::vector<int> shape;
+      const typename T::Tree& tree = Common::Internals::Tree(built[b]);
+      Preorder(tree, shape);
+      if (shape != expected || CountedSize(tree) != N) return false;
+      for (int i = 0; i < N; ++i) if (tree._pool->Index(i).payload != i) return false;
+   }
+   return true;
+}
+
+/// Of keys added more than once the builder keeps the first, in or out of order
+template <class T> bool Test_TreeMapBuilder()
+{
+   const int N = 2000;
+   typename T::Builder builder(N);
+   for (int i = 0; i < N; ++i) builder.AddElement(Common::KeyValuePair<int, float>(i, float(i)));
+   for (int i = N-1; i >= 0; i -= 2) builder.AddElement(Common::KeyValuePair<int, float>(i, -1.0f));
+   for (int i = 2*N-1; i >= N; --i) builder.AddElement(Common::KeyValuePair<int, float>(i, float(i)));
+   for (int i = N; i < 2*N; i += 2) builder.AddElement(Common::KeyValuePair<int, float>(i, -1.0f));
+
+   T t = builder.Result();
+   if (t.Size() != 2*N) return false;
+   auto itr = t.GetIterator();
+   for (int i = 0; i < 2*N; ++i)
+   {
+      auto e = itr.Next();
+      if (e.key != i || e.value != float(i)) return false;
+   }
+   return true;
+}
+
+/// Split and join set algebra, through the container when the sizes are
+/// unbalanced, and on the tree directly with the recursion forking
+template <class T> bool Test_JoinAlgebra()
+{
+   auto big = [] (int i) { return (i * 7919) % 40000; };
+   auto small = [] (int i) { return i * 97 - 3000; };
+   const int NB = 30000, NS = 700;
+
+   std::set<int> sb, ss;
+   for (int i = 0; i < NB; ++i) sb.insert(big(i));
+   for (int i = 0; i < NS; ++i) ss.insert(small(i));
+   std::vector<int> expected[4];
+   std::set_union(sb.begin(), sb.end(), ss.begin(), ss.end(), std::back_inserter(expected[0]));
+   std::set_intersection(sb.begin(), sb.end(), ss.begin(), ss.end(), std::back_inserter(expected[1]));
+   std::set_difference(sb.begin(), sb.end(), ss.begin(), ss.end(), std::back_inserter(expected[2]));
+   std::set_difference(ss.begin(), ss.end(), sb.begin(), sb.end(), std::back_inserter(expected[3]));
+
+   T tb = T::Construct(NB, big), ts = T::Construct(NS, small);
+   const T results[4] = { tb | ts, tb & ts, tb - ts, ts - tb };
+   for (int r = 0; r < 4; ++r)
+   {
+      if (results[r].Size() != int(expected[r].size())) return false;
+      if (!IsHeapOrdered(Common::Internals::Tree(results[r]))) return false;
+      if (CountedSize(Common::Internals::Tree(results[r])) != int(expected[r].size())) return false;
+      auto itr = results[r].GetIterator();
+      for (int x : expected[r]) if (itr.Next() != x) return false;
+   }
+
+   /// On the tree directly, with the recursion forking onto a scheduler of
+   /// its own: in a pool of the tree's own, relinked in place, and in a pool
+   /// shared with the big set, where the tasks append their copies at once
+   /// and the big set is left as it was
+   Scheduler pool(3);
+   typename T::Tree roomy = Common::Internals::Tree(tb);
+   roomy.Detach(4 * NB);
+   for (int shared = 0; shared < 2; ++shared)
+   {
+      for (int op = 0; op < 3; ++op)
+      {
+         typename T::Tree tree = shared ? roomy : Common::Internals::Tree(tb).Clone();
+         const int fresh = shared ? tree._pool->NextFreeIndex() : 0;
+         int grafted, root, matched = 0;
+         if (!tree.Graft(Common::Internals::Tree(ts), grafted)) return false;
+
+         pool.ResetStats();
+         const bool done = op == 0 ? tree.Union(tree._root, grafted, fresh, 4, pool, root, matched) :
+                           op == 1 ? tree.Intersection(tree._root, grafted, fresh, 4, pool, root, matched) :
+                                     tree.Difference(tree._root, grafted, fresh, 4, pool, root, matched);
+         long long tasks = 0;
+         for (int w = 0; w <= pool.Workers(); ++w) tasks += pool.Stats(w).tasksRun;
+         if (!done || tasks == 0 || matched != int(expected[1].size())) return false;
+
+         tree._root = root;
+         if (!IsHeapOrdered(tree)) return false;
+         if (CountedSize(tree) != int(expected[op].size())) return false;
+
+         T result = Common::Internals::Make<T>(int(expected[op].size()), std::move(tree));
+         auto itr = result.GetIterator();
+         for (int x : expected[op]) if (!itr.HasNext() || itr.Next() != x) return false;
+         if (itr.HasNext()) return false;
+      }
+   }
+
+   if (!IsHeapOrdered(roomy) || CountedSize(roomy) != int(sb.size())) return false;
+   T unchanged = Common::Internals::Make<T>(int(sb.size()), typename T::Tree(roomy));
+   auto itr = unchanged.GetIterator();
+   for (int x : sb) if (!itr.HasNext() || itr.Next() != x) return false;
+   return !itr.HasNext();
+}
+
+/// Every version derived by Insert and Remove, from any earlier version,
+/// keeps its own contents while later versions share its node pool
+template <class T> bool Test_PersistentTreeSet()
+{
+   const int VERSIONS = 3000, KEYS = 500;
+   std::vector<T> versions(1);
+   std::vector<std::set<int> > expected(1);
+
+   unsigned int seed = 12345;
+   for (int i = 1; i < VERSIONS; ++i)
+   {
+      seed = seed * 1664525u + 1013904223u;
+      const int from = int((seed >> 8) % versions.size()), key = int((seed >> 4) % KEYS);
+      std::set<int> s = expected[from];
+      if (seed & 0x80000000u) { versions.push_back(versions[from].Remove(key)); s.erase(key); }
+      else                    { versions.push_back(versions[from].Insert(key)); s.insert(key); }
+      expected.push_back(s);
+   }
+
+   for (int v = 0; v < VERSIONS; ++v)
+   {
+      if (versions[v].Size() != int(expected[v].size())) return false;
+      auto itr = versions[v].GetIterator();
+      for (int x : expected[v]) if (!itr.HasNext() || itr.Next() != x) return false;
+      if (itr.HasNext()) return false;
+   }
+   return true;
+}
+
+/// The versions derived from one set append to the pool they share, which
+/// must not move a node. With the atomic policy they are also derived on
+/// several threads at once while the set is read, from a set whose pool
+/// has room left: the first update after the pool filled compacted it.
+template <class T> bool Test_SharedPoolVersions()
+{
+   const int N = 2000;
+   T base;
+   for (int i = 0; i < N; ++i) base = base.Insert(2 * i);
+   const int * first = &base.Select(0);
+   for (int i = 0; i < N; ++i) if (base.Insert(2 * i + 1).Size() != N + 1) return false;
+   if (&base.Select(0) != first || base.Size() != N) return false;
+
+   #if defined(___ATOMIC_REFCOUNT)
+   const int TASKS = 4;
+   const T shared = base.Insert(-1);
+   Scheduler s(3);
+   std::vector<T> derived(TASKS);
+   std::atomic<int> misread(0);
+   {
+      Scheduler::TaskGroup g(s);
+      for (int t = 0; t < TASKS; ++t)
+      {
+         g.Spawn([&shared, &derived, &misread, t, N, TASKS] ()
+         {
+            T v = shared;
+            for (int i = 0; i < N; ++i)
+            {
+               v = v.Insert(2 * i + 1);
+               if (i % TASKS == t) v = v.Remove(2 * i);
+               if (!shared.Contains(2 * i) || shared.Contains(2 * i + 1)) misread++;
+            }
+            derived[t] = v;
+         });
+      }
+   }
+   if (misread != 0) return false;
+   for (int t = 0; t < TASKS; ++t)
+   {
+      if (derived[t].Size() != 2 * N - N / TASKS + 1 || !derived[t].Contains(-1)) return false;
+      for (int k = 0; k < 2 * N; ++k)
+         if (bool(derived[t].Contains(k)) != (k % 2 == 1 || (k / 2) % TASKS != t)) return false;
+   }
+   #endif
+
+   auto itr = base.GetIterator();
+   for (int i = 0; i < N; ++i) if (!itr.HasNext() || itr.Next() != 2 * i) return false;
+   return !itr.HasNext();
+}
+
+/// Long runs of Drop(1) and of Take(Size() - 1) leave each result sharing a
+/// pool of no more than TREE_PERSISTENT_SLACK times its size
+template <class T> bool Test_SliceFootprint()
+{
+   const int N = 3000;
+   T dropped = T::Construct(N, [] (int i) { return i; }), taken = dropped;
+   for (int i = 1; i < N; ++i)
+   {
+      dropped = dropped.Drop(1); taken = taken.Take(N - i);
+      if (dropped.Head() != i || taken.Last() != N - i - 1) return false;
+      const int size = N - i, most = Common::TREE_PERSISTENT_SLACK * (size > 0x10 ? size : 0x10);
+      if (Common::Internals::Tree(dropped)._pool->Size() > most || Common::Internals::Tree(taken)._pool->Size() > most) return false;
+   }
+   return dropped.Size() == 1 && taken.Size() == 1;
+}
+
+/// Set algebra with a much smaller set works in the pool the larger set
+/// shares, adding O(m log n) nodes to it and copying none of the rest. A
+/// set straight from a builder fills its pool, so the first union copies it
+/// into one with room for updates, once.
+template <class T> bool Test_JoinFootprint()
+{
+   const int N = 100000, M = 10;
+   const T big = T::Construct(N, [] (int i) { return 2 * i; });
+   const T first = big | T::Construct(M, [] (int i) { return 4 * i + 1; });
+   const T small = T::Construct(M, [] (int i) { return (2 * i + 1) * (N / M) + 1; });
+
+   const auto& pool = *Common::Internals::Tree(first)._pool;
+   const int before = pool.Size();
+   const T u = first | small, i = first & small, d = first - small;
+   const int added = pool.Size() - before;
+   if (&*Common::Internals::Tree(u)._pool != &pool || added > 4 * M * 17) return false;
+
+   if (u.Size() != N + 2 * M || i.Size() != 0 || d.Size() != N + M || first.Size() != N + M) return false;
+   auto itr = u.GetIterator();
+   for (int k = 0; k < 2 * N; ++k)
+   {
+      const bool inFirst = k % 2 == 0 || (k % 4 == 1 && k < 4 * M);
+      const bool inSmall = k % 2 == 1 && (k - 1) % (N / M) == 0 && ((k - 1) / (N / M)) % 2 == 1;
+      if ((inFirst || inSmall) && (!itr.HasNext() || itr.Next() != k)) return false;
+   }
+   return !itr.HasNext() && IsEqual(d, first) && big.Size() == N;
+}
+
+/// Updating a value leaves the older versions with the old one
+template <class T> bool Test_PersistentTreeMap()
+{
+   const int N = 2000;
+   T t;
+   for (int i = 0; i < N; ++i) t = t.Insert(i, float(i));
+   T updated = t;
+   for (int i = 0; i < N; i += 2) updated = updated.Insert(i, -1.0f);
+   T removed = updated;
+   for (int i = 0; i < N; i += 4) removed = removed.Remove(i);
+
+   if (t.Size() != N || updated.Size() != N || removed.Size() != N - N/4) return false;
+   for (int i = 0; i < N; ++i)
+   {
+      if (t.GetOrElse(i, -2.0f) != float(i)) return false;
+      if (updated.GetOrElse(i, -2.0f) != (i % 2 == 0 ? -1.0f : float(i))) return false;
+      if (removed.GetOrElse(i, -2.0f) != (i % 4 == 0 ? -2.0f : i % 2 == 0 ? -1.0f : float(i))) return false;
+   }
+   return true;
+}
+
+/// Rank, Select and the positional slices against a sorted vector, on a
+/// set that has been through inserts, removals and a union
+template <class T> bool Test_OrderStatistics()
+{
+   const int N = 4000;
+   T t = T::Construct(N, [] (int i) { return (i * 7919) % N * 3; });
+   for (int i = 0; i < 300; ++i) { t = t.Remove(i * 39 % (3*N)); t = t.Insert(i * 41 % (3*N) + 1); }
+   t = t | T::Construct(50, [] (int i) { return i * 101 + 2; });
+
+   std::vector<int> expected;
+   auto itr = t.GetIterator();
+   while (itr.HasNext()) expected.push_back(itr.Next());
+   const int n = int(expected.size());
+   if (t.Size() != n || t.Head() != expected[0] || t.Last() != expected[n-1]) return false;
+
+   for (int i = 0; i < n; ++i)
+   {
+      if (t[i] != expected[i] || t.Select(i) != expected[i]) return false;
+      if (t.Rank(expected[i]) != i || t.Rank(expected[i] + 1) != i + 1) return false;
+   }
+   if (t.Rank(-1) != 0 || t.Rank(1 << 30) != n) return false;
+
+   const int cuts[] = { -3, 0, 1, 17, n/2, n-1, n, n+5 };
+   for (int c : cuts)
+   {
+      const int k = c < 0 ? 0 : c > n ? n : c;
+      auto split = t.SplitAt(c);
+      const T take = t.Take(c), drop = t.Drop(c);
+      if (take.Size() != k || drop.Size() != n-k || split.first.Size() != k || split.second.Size() != n-k) return false;
+      auto a = take.GetIterator(), b = drop.GetIterator(), sa = split.first.GetIterator(), sb = split.second.GetIterator();
+      for (int i = 0; i < k; ++i) if (a.Next() != expected[i] || sa.Next() != expected[i]) return false;
+      for (int i = k; i < n; ++i) if (b.Next() != expected[i] || sb.Next() != expected[i]) return false;
+      if (k > 0 && (take.Last() != expected[k-1] || take[k-1] != expected[k-1])) return false;
+      if (k < n && (drop.Head() != expected[k] || drop.Rank(expected[k]) != 0)) return false;
+   }
+
+   /// The original is untouched by slicing
+   auto again = t.GetIterator();
+   for (int x : expected) if (again.Next() != x) return false;
+   return t.Size() == n;
+}
+
+/// LowerBound, UpperBound and Range against std::set, probing the keys
+/// that are present, those between them and those beyond either end
+template <class T> bool Test_RangeQueries()
+{
+   const int N = 3000;
+   T t = T::Construct(N, [] (int i) { return (i * 7919) % N * 4; });
+   for (int i = 0; i < 200; ++i) { t = t.Remove(i * 52 % (4*N)); t = t.Insert(i * 36 % (4*N) + 2); }
+   std::set<int> expected;
+   auto all = t.GetIterator();
+   while (all.HasNext()) expected.insert(all.Next());
+
+   for (int x = -5; x < 4*N + 5; x += 3)
+   {
+      auto lower = t.LowerBound(x), upper = t.UpperBound(x);
+      for (auto i = expected.lower_bound(x); i != expected.end(); ++i) if (!lower || lower.Next() != *i) return false;
+      for (auto i = expected.upper_bound(x); i != expected.end(); ++i) if (!upper || upper.Next() != *i) return false;
+      if (lower || upper) return false;
+   }
+
+   const int ranges[][2] = { {0, 4*N}, {-10, 7}, {8, 8}, {9, 8}, {101, 102}, {100, 133}, {4*N - 50, 4*N + 50}, {777, 2999} };
+   for (auto r : ranges)
+   {
+      auto range = t.Range(r[0], r[1]);
+      for (auto i = expected.lower_bound(r[0]); i != expected.end() && *i < r[1]; ++i)
+         if (!range || range.Next() != *i) return false;
+      if (range.HasNext()) return false;
+   }
+   return true;
+}
+
+/// Range iteration and the range form of FilterKeys on a map
+template <class T> bool Test_MapRangeQueries()
+{
+   const int N = 2000;
+   typename T::Builder builder(N);
+   for (int i = 0; i < N; ++i) builder.AddElement(Common::KeyValuePair<int, float>(i * 7919 % N * 2, float(i)));
+   const T t = builder.Result();
+
+   const int ranges[][2] = { {0, 2*N}, {-10, 7}, {8, 8}, {9, 8}, {101, 102}, {100, 133}, {2*N - 50, 2*N + 50}, {777, 2999} };
+   for (auto r : ranges)
+   {
+      const int lo = r[0], hi = r[1];
+      auto slow = t.FilterKeys([lo, hi] (int k) { return k >= lo && k < hi; });
+      const T fast = t.FilterKeys(lo, hi);
+      auto range = t.Range(lo, hi);
+      auto a = slow.GetIterator(), b = fast.GetIterator();
+      if (slow.Size() != fast.Size()) return false;
+      while (a.HasNext())
+      {
+         auto e = a.Next(), f = b.Next(), g = range.Next();
+         if (e.key != f.key || e.value != f.value || e.key != g.key || e.value != g.value) return false;
+      }
+      if (range.HasNext()) return false;
+
+      auto lower = t.LowerBound(lo), upper = t.UpperBound(lo);
+      const int first = lo <= 0 ? 0 : lo % 2 ? lo + 1 : lo;
+      if ((first < 2*N) != lower.HasNext() || (first < 2*N && lower.Peek().key != first)) return false;
+      const int after = lo < 0 ? 0 : lo % 2 ? lo + 1 : lo + 2;
+      if ((after < 2*N) != upper.HasNext() || (after < 2*N && upper.Peek().key != after)) return false;
+   }
+   return t.Size() == N;
+}
+
+template <class T> bool Test_MutableTreeSet()
+{
+   bool b = true;
+   cout << "Test_DestructiveSetInsertElement<" << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetInsertElement<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveSetUnion<"         << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetUnion<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveSetRemove<"        << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetRemove<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveSetDifference<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetDifference<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_SetChurn<"                    << ToString<T>::value << "> ... " << ( (b &= Test_SetChurn<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_TreeShape<"                   << ToString<T>::value << "> ... " << ( (b &= Test_TreeShape<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_TreeBuilder<"                 << ToString<T>::value << "> ... " << ( (b &= Test_TreeBuilder<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_JoinAlgebra<"                 << ToString<T>::value << "> ... " << ( (b &= Test_JoinAlgebra<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+template <class T> bool Test_MutableTreeMap()
+{
+   bool b = true;
+   cout << "Test_SetChurn<"       << ToString<T>::value << "> ... " << ( (b &= Test_SetChurn<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_TreeMapBuilder<" << ToString<T>::value << "> ... " << ( (b &= Test_TreeMapBuilder<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                              Set Unit Tests                               //
+///////////////////////////////////////////////////////////////////////////////
+
+
+template <class T> bool Test_SetContains()
+{
+   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
+   auto t = T::Construct(N, values);
+
+   for (int i = 0; i < N; ++i) if (!t.Contains(values[i])) return false;
+   if (T().Contains(0)) return false;
+
+   return true;
+}
+template <class T> bool Test_IsSubsetOf()
+{
+   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
+   auto t = T::Construct(N, values);
+
+   for (int i = 0; i < N; ++i) if (!T().Insert(values[i]).IsSubsetOf(t)) 
+      return false;
+   for (int i = 0; i < N; ++i) 
+      if (!T().Insert(values[i]).Insert(values[(i+1)%N]).IsSubsetOf(t)) 
+         return false;
+
+   if (!T().IsSubsetOf(t)) return false;
+   if (t.IsSubsetOf(T())) return false;
+
+   return true;
+}
+template <class T> bool Test_Union()
+{
+   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
+   auto t = T::Construct(N, values);
+
+   if (!IsEqual( t, t | t )) return false;
+   if (!IsEqual( t, t | T() )) return false;
+
+   for (int i = 0; i < N; ++i) 
+      if (!IsEqual( t, t | T().Insert(values[i]))) return false;
+
+   auto u = t | T().Insert(1) | T().Insert(1) | T().Insert(1);
+   if (u.Size() != t.Size() + 1) return false;
+   if (!u.Contains(1)) return false;
+
+   return true;
+}
+template <class T> bool Test_Intersection()
+{
+   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
+   auto t = T::Construct(N, values);
+
+   if (!IsEqual( t, t & t ))     return false;
+   if (!IsEqual( T(), t & T() )) return false;  
+   for (int i = 0; i < N; ++i) 
+      if (!IsEqual( T() + values[i], t & T() + values[i] )) 
+         return false;
+
+   return true;
+}
+template <class T> bool Test_Difference()
+{
+   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
+   auto t = T::Construct(N, values);
+
+   if (!IsEqual( T(), t - t )) return false;
+   if (!IsEqual( t, t - T() )) return false;
+   if ((t - T().Insert(0)).Size() != t.Size()-1) return false;
+   if ((T() - T()).Size() != 0) return false;
+
+   return true;
+}
+template <class T> bool Test_Insert()
+{
+   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
+   auto t = T();
+   for (int i = 0; i < N; ++i) t = t + values[i];
+   if (!IsEqual( t, T::Construct(N, values) )) return false;
+   return true;
+}
+template <class T> bool Test_Remove()
+{
+   const int N = 8; const int values[N] = { 5, 16, 77, 90, 191, -249, -29, 0 };
+   auto t = T::Construct(N, values);
+
+   int indirection[N] = { 0, 4, 2, 6, 3, 5, 7, 1 };
+   for (int i = 0; i < N; ++i) t = t - values[indirection[i]];
+   if (t.Size() != 0) return false;
+   if (!IsEqual( t, T() )) return false;
+
+   return true;
+}
+
+
+/// The iterator returned by Contains() continues in order from the element
+/// found, and copies of an iterator advance independently
+template <class T> bool Test_ContainsIterator()
+{
+   const int N = 200;
+   auto t = T::Construct(N, [] (int i) { return (i * 37) % 200; });
+
+   for (int i = 0; i < N; ++i)
+   {
+      auto itr = t.Contains(i);
+      for (int j = i; j < N; ++j) if (!itr.HasNext() || itr.Next() != j) return false;
+      if (itr.HasNext()) return false;
+   }
+   if (t.Contains(N)) return false;
+
+   auto a = t.GetIterator();
+   for (int i = 0; i < N/2; ++i) a.Next();
+   auto b = a;
+   for (int i = N/2; i < N; ++i) if (a.Next() != i) return false;
+   for (int i = N/2; i < N; ++i) if (b.Next() != i) return false;
+   return true;
+}
+
+/// Large overlapping sets against std::set_union and friends
+template <class T> bool Test_LargeSetAlgebra()
+{
+   const int NA = 20000, NB = 15000;
+   auto a = [] (int i) { return (i * 7919) % 40000; };
+   auto b = [] (int i) { return (i * 104729) % 30000 + 10000; };
+   T ta = T::Construct(NA, a), tb = T::Construct(NB, b);
+
+   std::set<int> sa, sb;
+   for (int i = 0; i < NA; ++i) sa.insert(a(i));
+   for (int i = 0; i < NB; ++i) sb.insert(b(i));
+   std::vector<int> u, n, d;
+   std::set_union(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(u));
+   std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(n));
+   std::set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(d));
+
+   const T results[3] = { ta | tb, ta & tb, ta - tb };
+   const std::vector<int>* expected[3] = { &u, &n, &d };
+   for (int r = 0; r < 3; ++r)
+   {
+      if (results[r].Size() != int(expected[r]->size())) return false;
+      auto itr = results[r].GetIterator();
+      for (int x : *expected[r]) if (itr.Next() != x) return false;
+      for (int x : *expected[r]) if (!results[r].Contains(x)) return false;
+   }
+
+   if (!(ta & tb).IsSubsetOf(ta) || !(ta & tb).IsSubsetOf(tb)) return false;
+   if (!ta.IsSubsetOf(ta | tb) || ta.IsSubsetOf(tb) || (ta | tb).IsSubsetOf(ta)) return false;
+   return true;
+}
+
+template <class T> bool Test_Set()
+{
+   bool b = true;
+   cout << "Test_SetContains<"   << ToString<T>::value << "> ... " << ( (b &= Test_SetContains  <T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_ContainsIterator<" << ToString<T>::value << "> ... " << ( (b &= Test_ContainsIterator<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_IsSubsetOf<"    << ToString<T>::value << "> ... " << ( (b &= Test_IsSubsetOf   <T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Union<"         << ToString<T>::value << "> ... " << ( (b &= Test_Union        <T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Intersection<"  << ToString<T>::value << "> ... " << ( (b &= Test_Intersection <T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Difference<"    << ToString<T>::value << "> ... " << ( (b &= Test_Difference   <T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Insert<"        << ToString<T>::value << "> ... " << ( (b &= Test_Insert       <T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Remove<"        << ToString<T>::value << "> ... " << ( (b &= Test_Remove       <T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_LargeSetAlgebra<" << ToString<T>::value << "> ... " << ( (b &= Test_LargeSetAlgebra<T>()) ? "Passed" : "FAILED") << endl;
+   return b;  
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                              Map Unit Tests                               //
+///////////////////////////////////////////////////////////////////////////////
+
+/// Access
+template <class T> bool Test_Contains_Map() 
+{ 
+   typedef typename T::ElementType E;
+   const int N = 8; const E values[N] = { ToElement<T>(5), ToElement<T>(16), ToElement<T>(77), ToElement<T>(90), ToElement<T>(191), ToElement<T>(-249), ToElement<T>(-29), ToElement<T>(0) };
+   auto t = T::Construct(N, values);
+
+   bool b = true;
+   for (int i = 0; i < N; ++i) b &= t.Contains(values[i].key);
+   if (!b) return false;
+
+   if (t.Contains(-1)) return false;
+   if (T().Contains(100)) return false;
+
+   return true;
+}
+
+template <class T> bool Test_GetOrElse_Map() 
+{ 
+   typedef typename T::ElementType E; const int N = 8; 
+   const E values[N] = { ToElement<T>(5), ToElement<T>(16), ToElement<T>(77), ToElement<T>(90), ToElement<T>(191), ToElement<T>(-249), ToElement<T>(-29), ToElement<T>(0) };
+   auto t = T::Construct(N, values);
+
+   bool b = true;
+   for (int i = 0; i < N; ++i) 
+   {
+      b &= (t.GetOrElse(values[i].key, -3.14159f) == values[i].value);
+      b &= (t.GetOrElse(500, -3.14159f) == -3.14159f);
+   }
+   if (!b) return false;
+   if (T().GetOrElse(500, -3.14159f) != -3.14159f) return false;
+
+   return true;
+}
+
+
+/// Functional Updates. A new container is returned with the specified mapping
+/// added, removed, or updated as appropriate. 
+template <class T> bool Test_Insert_Map() 
+{ 
+   typedef typename T::ElementType E; const int N = 8; 
+   const E valuesA[N] = { ToElement<T>(5), ToElement<T>(16), ToElement<T>(77), ToElement<T>(90), ToElement<T>(191), ToElement<T>(-249), ToElement<T>(-29), ToElement<T>(0) };
+   const E valuesB[N] = { ToElement<T>(40), ToElement<T>(1), ToElement<T>(2), ToElement<T>(3), ToElement<T>(4), ToElement<T>(50), ToElement<T>(6), ToElement<T>(7) };
+   auto t = T::Construct(N, valuesA);
+
+   for (int i = 0; i < N; ++i)
+      if (!t.Contains(valuesA[i].key)) return false;
+
+   for (int i = 0; i < N; ++i)
+   {
+      t = t.Insert(valuesB[i].key, valuesB[i].value);
+      if (!t.Contains(valuesB[i].key)) return false;
+      if (!t.Contains(valuesA[i].key)) return false;
+      if (t.GetOrElse(valuesB[i].key, -100.0f) != valuesB[i].value) return false;
+   }
+
+   if (!T().Insert(10, 3.14159f).Contains(10)) 
+      return false;
+
+   return true;
+}
+
+template <class T> bool Test_Remove_Map() 
+{ 
+   typedef typename T::ElementType E; const int N = 8; 
+   const E valuesA[N] = { ToElement<T>(5), ToElement<T>(16), ToElement<T>(77), ToElement<T>(90), ToElement<T>(191), ToElement<T>(-249), ToElement<T>(-29), ToElement<T>(0) };
+   const E valuesB[N] = { ToElement<T>(40), ToElement<T>(1), ToElement<T>(2), ToElement<T>(3), ToElement<T>(4), ToElement<T>(50), ToElement<T>(6), ToElement<T>(7) };
+   auto t = T::Construct(N, valuesA);
+
+   for (int i = 0; i < N; ++i)
+   {
+      t = t.Remove(valuesA[i].key).Remove(valuesB[i].key);
+      if (t.Contains(valuesA[i].key)) return false;
+      for (int j = i+1; j < N; ++j)
+         if (!t.Contains(valuesA[j].key)) return false;
+   }
+
+   if (T().Remove(10).Size() != 0) return false;
+
+   return true;
+}
+
+/// Returns a set container containing only the keys in the map
 template <class T> bool Test_Keys_Map() 
 { 
    typedef typename T::ElementType E; const int N = 8; 
@@ -1254,31 +2487,764 @@ template <class T> bool Test_Map()
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//                         Flat Container Unit Tests                         //
+///////////////////////////////////////////////////////////////////////////////
+
+/// Element by element comparison of two containers of different types
+template <class A, class B> bool SameElements(const A& a, const B& b)
+{
+   if (a.Size() != b.Size()) return false;
+   auto itrA = a.GetIterator(); auto itrB = b.GetIterator();
+   while (itrA.HasNext()) if (itrA.Next() != itrB.Next()) return false;
+   return true;
+}
+
+/// Unsorted input with duplicates is sorted and made unique once, sorted
+/// input goes straight in
+template <class T> bool Test_FlatSetBuilder()
+{
+   const int N = 5000;
+   auto scattered = [] (int i) { return (i * 7919) % 1009 - 500; };
+   T t = T::Construct(N, scattered);
+   Immutable::TreeSet<int> reference = Immutable::TreeSet<int>::Construct(N, scattered);
+   if (!SameElements(t, reference)) return false;
+
+   T ascending = T::Construct(N, [] (int i) { return 2 * i; });
+   if (ascending.Size() != N) return false;
+   for (int i = 0; i < N; ++i) if (ascending[i] != 2 * i) return false;
+
+   for (int i = -600; i < 600; ++i)
+      if (bool(t.Contains(i)) != bool(reference.Contains(i))) return false;
+   if (T().Contains(0)) return false;
+   return true;
+}
+
+/// The linear merges agree with the tree's generic set algebra
+template <class T> bool Test_FlatSetAlgebra()
+{
+   typedef Immutable::TreeSet<int> Tree;
+   auto a = [] (int i) { return (i * 37) % 1000; };
+   auto b = [] (int i) { return (i * 53) % 1500 - 250; };
+   const int NA = 700, NB = 900;
+
+   T fa = T::Construct(NA, a), fb = T::Construct(NB, b);
+   Tree ta = Tree::Construct(NA, a), tb = Tree::Construct(NB, b);
+
+   if (!SameElements(fa | fb, ta | tb)) return false;
+   if (!SameElements(fa & fb, ta & tb)) return false;
+   if (!SameElements(fa - fb, ta - tb)) return false;
+   if (!SameElements(fb - fa, tb - ta)) return false;
+
+   if (!(fa & fb).IsSubsetOf(fa) || !(fa & fb).IsSubsetOf(fb)) return false;
+   if (fa.IsSubsetOf(fb) || !fa.IsSubsetOf(fa | fb)) return false;
+   return true;
+}
+
+/// Slices share the buffer, and lookups stay within the slice
+template <class T> bool Test_FlatSetSlices()
+{
+   const int N = 100;
+   T t = T::Construct(N, [] (int i) { return i; });
+
+   T middle = t.Drop(10).Take(50);
+   if (&middle[0] != &t[10]) return false;
+   if (middle.Size() != 50 || middle.Head() != 10 || middle.Last() != 59) return false;
+   if (middle.Contains(9) || middle.Contains(60) || !middle.Contains(30)) return false;
+
+   auto itr = middle.Contains(55);
+   for (int i = 55; i < 60; ++i) if (itr.Next() != i) return false;
+   if (itr.HasNext()) return false;
+
+   if (!SameElements(middle.Insert(200).Remove(10), T::Construct(50, [] (int i) { return i < 49 ? i + 11 : 200; })))
+      return false;
+   if (t.Drop(N).Size() != 0 || t.Take(0).Size() != 0 || t.Drop(N+5).Size() != 0) return false;
+   return true;
+}
+
+/// The first of several mappings for a key wins, as it does for the trees,
+/// whether the stable sort is a merge (small input) or radix (large input)
+template <class T> bool Test_FlatMapBuilder()
+{
+   for (int N = 100; N <= 10000; N *= 10)
+   {
+      auto scattered = [] (int i) { return Common::KeyValuePair<int, float>((i * 7919) % 97, float(i)); };
+      T t = T::Construct(N, scattered);
+      Immutable::TreeMap<int, float> reference = Immutable::TreeMap<int, float>::Construct(N, scattered);
+
+      if (t.Size() != 97 || reference.Size() != 97) return false;
+      auto itr = t.GetIterator(), rItr = reference.GetIterator();
+      while (itr.HasNext())
+      {
+         auto e = itr.Next(), r = rItr.Next();
+         if (e.key != r.key || e.value != r.value) return false;
+      }
+   }
+   return true;
+}
+
+/// Updating a key already present keeps the keys shared, Keys() is O(1)
+template <class T> bool Test_FlatMapUpdate()
+{
+   const int N = 64;
+   T t = T::Construct(N, [] (int i) { return ToElement<T>(i); });
+
+   T u = t.Insert(10, -1.0f);
+   if (&u.Keys()[0] != &t.Keys()[0] || u.Size() != N) return false;
+   if (u.GetOrElse(10, 0.0f) != -1.0f || t.GetOrElse(10, 0.0f) != 5.0f) return false;
+
+   T slice = t.Drop(8);
+   T v = slice.Insert(10, -1.0f);
+   if (v.Size() != N-8 || v.GetOrElse(10, 0.0f) != -1.0f || v.Contains(7)) return false;
+
+   auto keys = slice.Keys();
+   if (&keys[0] != &t.Keys()[8] || keys.Size() != N-8 || keys.Head() != 8) return false;
+   return true;
+}
+
+template <class T> bool Test_FlatSet()
+{
+   bool b = true;
+   cout << "Test_FlatSetBuilder<" << ToString<T>::value << "> ... " << ( (b &= Test_FlatSetBuilder<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_FlatSetAlgebra<" << ToString<T>::value << "> ... " << ( (b &= Test_FlatSetAlgebra<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_FlatSetSlices<"  << ToString<T>::value << "> ... " << ( (b &= Test_FlatSetSlices <T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+template <class T> bool Test_FlatMap()
+{
+   bool b = true;
+   cout << "Test_FlatMapBuilder<" << ToString<T>::value << "> ... " << ( (b &= Test_FlatMapBuilder<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_FlatMapUpdate<"  << ToString<T>::value << "> ... " << ( (b &= Test_FlatMapUpdate <T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                        B-Tree Container Unit Tests                        //
+///////////////////////////////////////////////////////////////////////////////
+
+
+/// Random inserts and removals, enough to split and merge nodes at every
+/// level, checked against std::set after each round
+template <class T> bool Test_BTreeSetChurn()
+{
+   const int KEYS = 20000, ROUNDS = 8;
+   T t;
+   std::set<int> expected;
+
+   unsigned int seed = 777;
+   for (int round = 0; round < ROUNDS; ++round)
+   {
+      /// Alternate between growing and shrinking rounds so that the tree
+      /// gains and loses levels
+      const bool grow = round % 2 == 0;
+      for (int i = 0; i < KEYS; ++i)
+      {
+         seed = seed * 1664525u + 1013904223u;
+         const int key = int((seed >> 8) % KEYS);
+         if (grow || (seed & 0x10)) { t += key; expected.insert(key); }
+         else                       { t -= key; expected.erase(key); }
+      }
+
+      if (t.Size() != int(expected.size())) return false;
+      auto itr = t.GetIterator();
+      for (int x : expected) if (!itr.HasNext() || itr.Next() != x) return false;
+      if (itr.HasNext()) return false;
+      for (int key = -1; key <= KEYS; key += 7)
+         if (bool(t.Contains(key)) != (expected.count(key) == 1)) return false;
+   }
+
+   /// Remove everything, in an order unrelated to the keys
+   for (int i = 0; i < KEYS; ++i) { const int key = (i * 7919) % KEYS; t -= key; expected.erase(key); }
+   if (!t.IsEmpty() || t.GetIterator().HasNext()) return false;
+   t += 5;
+   return t.Size() == 1 && t.Head() == 5 && t.Last() == 5;
+}
+
+/// Keys that fill many nodes with SIMD-searched blocks, plus the scalar tail
+/// of each node, are found at every position, and keys in between are not
+template <class T> bool Test_BTreeSearch()
+{
+   const int N = 5000;
+   T t, odd;
+   for (int i = 0; i < N; ++i) t += 2*i;
+   for (int i = 0; i < N; ++i) if (!t.Contains(2*i) || t.Contains(2*i + 1)) return false;
+   if (t.Contains(-1) || t.Contains(2*N)) return false;
+
+   /// A Contains iterator continues from the key it found
+   auto itr = t.Contains(2*(N-3));
+   if (!itr || itr.Next() != 2*(N-3) || itr.Next() != 2*(N-2) || itr.Next() != 2*(N-1) || itr.HasNext()) return false;
+
+   /// Negative keys go through the signed comparison
+   for (int i = 0; i < N; ++i) odd += -i;
+   return odd.Head() == -(N-1) && odd.Last() == 0 && odd.Contains(-77) && !odd.Contains(1);
+}
+
+/// The functional Insert and Remove leave the original untouched, as do
+/// updates through a Copy, while plain copies share their nodes
+template <class T> bool Test_BTreeSetSharing()
+{
+   const int N = 3000;
+   T t;
+   for (int i = 0; i < N; ++i) t += i;
+
+   T inserted = t.Insert(N), removed = t.Remove(N/2);
+   if (t.Size() != N || t.Contains(N) || !t.Contains(N/2)) return false;
+   if (inserted.Size() != N+1 || !inserted.Contains(N)) return false;
+   if (removed.Size() != N-1 || removed.Contains(N/2)) return false;
+
+   T copy = t.Copy();
+   for (int i = 0; i < N; i += 2) copy -= i;
+   if (t.Size() != N || copy.Size() != N/2 || !t.Contains(0)) return false;
+
+   T shared = t;
+   shared -= 1;
+   return !t.Contains(1);
+}
+
+/// Map values move with their keys when nodes split, merge and borrow
+template <class T> bool Test_BTreeMapChurn()
+{
+   const int KEYS = 20000;
+   T t;
+   std::map<int, float> expected;
+
+   unsigned int seed = 4242;
+   for (int i = 0; i < 4*KEYS; ++i)
+   {
+      seed = seed * 1664525u + 1013904223u;
+      const int key = int((seed >> 8) % KEYS);
+      if (i < 2*KEYS || (seed & 0x10)) { t += Common::KeyValuePair<int, float>(key, float(i)); expected.insert(std::make_pair(key, float(i))); }
+      else                             { t -= key; expected.erase(key); }
+   }
+
+   /// Insert replaces the value of a key already present
+   for (int key = 0; key < KEYS; key += 5) { t = t.Insert(key, -float(key)); expected[key] = -float(key); }
+
+   if (t.Size() != int(expected.size())) return false;
+   auto itr = t.GetIterator();
+   for (auto& kv : expected)
+   {
+      if (!itr.HasNext()) return false;
+      auto e = itr.Next();
+      if (e.key != kv.first || e.value != kv.second) return false;
+   }
+   for (int key = 0; key < KEYS; ++key)
+      if (t.GetOrElse(key, -1.0f) != (expected.count(key) ? expected[key] : -1.0f)) return false;
+
+   auto keys = t.Keys();
+   if (keys.Size() != t.Size() || keys.Head() != expected.begin()->first) return false;
+   return true;
+}
+
+template <class T> bool Test_MutableBTreeSet()
+{
+   bool b = true;
+   cout << "Test_DestructiveSetInsertElement<" << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetInsertElement<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveSetUnion<"         << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetUnion<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveSetRemove<"        << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetRemove<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveSetDifference<"    << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetDifference<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_BTreeSetChurn<"               << ToString<T>::value << "> ... " << ( (b &= Test_BTreeSetChurn<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_BTreeSearch<"                 << ToString<T>::value << "> ... " << ( (b &= Test_BTreeSearch<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_BTreeSetSharing<"             << ToString<T>::value << "> ... " << ( (b &= Test_BTreeSetSharing<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+template <class T> bool Test_MutableBTreeMap()
+{
+   bool b = true;
+   cout << "Test_BTreeMapChurn<" << ToString<T>::value << "> ... " << ( (b &= Test_BTreeMapChurn<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                         Hash Container Unit Tests                         //
+///////////////////////////////////////////////////////////////////////////////
+
+/// The elements of a container, whatever order it iterates in
+template <class T> std::set<int> ElementsOf(const T& t)
+{
+   std::set<int> elements;
+   auto itr = t.GetIterator();
+   while (itr.HasNext()) elements.insert(ToKey(itr.Next()));
+   return elements;
+}
+
+/// Random insertions and removals against std::set, on tables from a few
+/// slots, where probe windows wrap around the end, to many thousands
+template <class T> bool Test_HashSetChurn()
+{
+   const int sizes[] = { 12, 40, 20000 };
+   unsigned int seed = 777;
+   for (int keys : sizes)
+   {
+      T t;
+      std::set<int> expected;
+      for (int round = 0; round < 8; ++round)
+      {
+         const bool grow = round % 2 == 0;
+         for (int i = 0; i < 2*keys; ++i)
+         {
+            seed = seed * 1664525u + 1013904223u;
+            const int key = int((seed >> 8) % keys) - keys/2;
+            if (grow || (seed & 0x10)) { t += key; expected.insert(key); }
+            else                       { t -= key; expected.erase(key); }
+         }
+
+         if (t.Size() != int(expected.size()) || ElementsOf(t) != expected) return false;
+         for (int key = -keys/2 - 1; key <= keys; ++key)
+            if (bool(t.Contains(key)) != (expected.count(key) == 1)) return false;
+      }
+
+      for (int i = 0; i < keys; ++i) t -= i - keys/2;
+      if (!t.IsEmpty() || t.GetIterator().HasNext()) return false;
+   }
+   return true;
+}
+
+/// Union, Intersection and Difference against std::set, compared as sets
+template <class T> bool Test_HashSetAlgebra()
+{
+   const int NA = 20000, NB = 15000;
+   auto a = [] (int i) { return (i * 7919) % 40000; };
+   auto b = [] (int i) { return (i * 104729) % 30000 + 10000; };
+   const T ta = T::Construct(NA, a), tb = T::Construct(NB, b);
+
+   std::set<int> sa, sb, u, n, d;
+   for (int i = 0; i < NA; ++i) sa.insert(a(i));
+   for (int i = 0; i < NB; ++i) sb.insert(b(i));
+   std::set_union(sa.begin(), sa.end(), sb.begin(), sb.end(), std::inserter(u, u.end()));
+   std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(), std::inserter(n, n.end()));
+   std::set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(), std::inserter(d, d.end()));
+
+   if (ElementsOf(ta | tb) != u || ElementsOf(ta & tb) != n || ElementsOf(ta - tb) != d) return false;
+   if (!(ta & tb).IsSubsetOf(ta) || !(ta & tb).IsSubsetOf(tb) || ta.IsSubsetOf(tb)) return false;
+
+   T t = ta.Copy();
+   t += tb;
+   if (ElementsOf(t) != u) return false;
+   t -= tb;
+   if (ElementsOf(t) != d || ElementsOf(ta) != sa) return false;
+
+   /// A copy shares the table, so the union with it changes nothing, and
+   /// the difference with it empties both
+   T alias = t;
+   t += alias;
+   if (ElementsOf(t) != d) return false;
+   t -= alias;
+   return t.Size() == 0 && alias.Size() == 0 && !alias.GetIterator().HasNext() && ElementsOf(ta) == sa;
+}
+
+/// Plain copies share the table, even once it grows and rehashes, while
+/// the functional updates and Copy() leave the original untouched
+template <class T> bool Test_HashSetSharing()
+{
+   const int N = 3000;
+   T t;
+   for (int i = 0; i < N; ++i) t += i;
+
+   T inserted = t.Insert(N), removed = t.Remove(N/2);
+   if (t.Size() != N || t.Contains(N) || !t.Contains(N/2)) return false;
+   if (inserted.Size() != N+1 || !inserted.Contains(N)) return false;
+   if (removed.Size() != N-1 || removed.Contains(N/2)) return false;
+
+   T copy = t.Copy();
+   for (int i = 0; i < N; i += 2) copy -= i;
+   if (t.Size() != N || copy.Size() != N/2 || !t.Contains(0)) return false;
+
+   T shared = t;
+   for (int i = N; i < 4*N; ++i) shared += i;
+   shared -= 1;
+   if (t.Size() != 4*N - 1 || !t.Contains(4*N - 1) || t.Contains(1)) return false;
+
+   /// An iterator taken before the table grew carries on from its slot in
+   /// the grown table, and only ever reads elements that are there
+   T small;
+   for (int i = 0; i < 10; ++i) small += i;
+   auto itr = small.GetIterator();
+   small.Reserve(10000);
+   int seen = 0;
+   while (itr.HasNext()) { const int e = itr.Next(); if (e < 0 || e >= 10) return false; seen++; }
+   if (seen > 10 || small.Size() != 10 || ElementsOf(small).size() != 10) return false;
+
+   typedef typename T::template SwapElementType<std::string>::C Strings;
+   Strings words;
+   for (int i = 0; i < 10; ++i) words += std::to_string(i * 1000003);
+   auto witr = words.GetIterator();
+   words.Reserve(10000);
+   seen = 0;
+   while (witr.HasNext()) { if (!words.Contains(witr.Next())) return false; seen++; }
+   return seen <= 10 && words.Size() == 10;
+}
+
+/// Map values stay with their keys through growth and backward shifts
+template <class T> bool Test_HashMapChurn()
+{
+   const int KEYS = 20000;
+   T t;
+   t.Reserve(KEYS / 4);
+   std::map<int, float> expected;
+
+   unsigned int seed = 4242;
+   for (int i = 0; i < 4*KEYS; ++i)
+   {
+      seed = seed * 1664525u + 1013904223u;
+      const int key = int((seed >> 8) % KEYS);
+      if (i < 2*KEYS || (seed & 0x10)) { t += Common::KeyValuePair<int, float>(key, float(i)); expected.insert(std::make_pair(key, float(i))); }
+      else                             { t -= key; expected.erase(key); }
+   }
+
+   /// Insert replaces the value of a key already present
+   for (int key = 0; key < KEYS; key += 5) { t = t.Insert(key, -float(key)); expected[key] = -float(key); }
+
+   if (t.Size() != int(expected.size())) return false;
+   auto itr = t.GetIterator();
+   int count = 0;
+   while (itr.HasNext())
+   {
+      auto e = itr.Next();
+      auto found = expected.find(e.key);
+      if (found == expected.end() || found->second != e.value) return false;
+      count++;
+   }
+   if (count != t.Size()) return false;
+   for (int key = 0; key < KEYS; ++key)
+      if (t.GetOrElse(key, -1.0f) != (expected.count(key) ? expected[key] : -1.0f)) return false;
+
+   auto keys = t.Keys();
+   std::set<int> expectedKeys;
+   for (auto& kv : expected) expectedKeys.insert(kv.first);
+   if (ElementsOf(keys) != expectedKeys) return false;
+
+   T alias = t;
+   alias += t;
+   if (alias.Size() != int(expected.size())) return false;
+   t -= alias;
+   return t.Size() == 0 && alias.Size() == 0 && !alias.Contains(expected.begin()->first);
+}
+
+/// Random versions of a persistent set, each made from an earlier one,
+/// against std::set, compared as sets. Sets with the same elements have
+/// the same trie, however they were made, and so iterate in the same order.
+template <class T> bool Test_PersistentHashSet()
+{
+   const int VERSIONS = 3000, KEYS = 2000;
+   std::vector<T> versions(1);
+   std::vector<std::set<int> > expected(1);
+
+   unsigned int seed = 12345;
+   for (int i = 1; i < VERSIONS; ++i)
+   {
+      seed = seed * 1664525u + 1013904223u;
+      const int from = int((seed >> 8) % versions.size()), key = int((seed >> 4) % KEYS);
+      std::set<int> s = expected[from];
+      if (seed & 0x80000000u) { versions.push_back(versions[from].Remove(key)); s.erase(key); }
+      else                    { versions.push_back(versions[from].Insert(key)); s.insert(key); }
+      expected.push_back(s);
+   }
+
+   for (int v = 0; v < VERSIONS; ++v)
+   {
+      if (versions[v].Size() != int(expected[v].size()) || ElementsOf(versions[v]) != expected[v]) return false;
+      for (int key = 0; key < KEYS; key += 7)
+         if (bool(versions[v].Contains(key)) != (expected[v].count(key) == 1)) return false;
+   }
+
+   /// Built up and then pulled back down, against built directly
+   const int N = 5000;
+   T grown = T::Construct(2*N, [] (int i) { return i; });
+   for (int i = N; i < 2*N; ++i) grown = grown.Remove(i);
+   const T direct = T::Construct(N, [] (int i) { return N - 1 - i; });
+   auto a = grown.GetIterator(), b = direct.GetIterator();
+   while (a.HasNext()) if (!b.HasNext() || a.Next() != b.Next()) return false;
+   if (b.HasNext()) return false;
+
+   /// Contains leaves the iterator at the element, to carry on from
+   auto from = direct.Contains(N/2);
+   if (!from || from.Peek() != N/2) return false;
+   int rest = 0;
+   while (from.HasNext()) { from.Next(); rest++; }
+   return rest >= 1 && rest <= N && !direct.Contains(N);
+}
+
+/// Union, Intersection and Difference against std::set, with either side
+/// the larger, leaving both operands as they were
+template <class T> bool Test_PersistentHashSetAlgebra()
+{
+   const int NA = 20000, NB = 3000;
+   auto a = [] (int i) { return (i * 7919) % 40000; };
+   auto b = [] (int i) { return (i * 104729) % 30000 + 10000; };
+   const T ta = T::Construct(NA, a), tb = T::Construct(NB, b);
+
+   std::set<int> sa, sb, u, n, dab, dba;
+   for (int i = 0; i < NA; ++i) sa.insert(a(i));
+   for (int i = 0; i < NB; ++i) sb.insert(b(i));
+   std::set_union(sa.begin(), sa.end(), sb.begin(), sb.end(), std::inserter(u, u.end()));
+   std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(), std::inserter(n, n.end()));
+   std::set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(), std::inserter(dab, dab.end()));
+   std::set_difference(sb.begin(), sb.end(), sa.begin(), sa.end(), std::inserter(dba, dba.end()));
+
+   const T results[] = { ta | tb, tb | ta, ta & tb, tb & ta, ta - tb, tb - ta };
+   const std::set<int> * expected[] = { &u, &u, &n, &n, &dab, &dba };
+   for (int i = 0; i < 6; ++i)
+      if (results[i].Size() != int(expected[i]->size()) || ElementsOf(results[i]) != *expected[i]) return false;
+
+   return ElementsOf(ta) == sa && ElementsOf(tb) == sb && ta.Size() == int(sa.size()) && tb.Size() == int(sb.size());
+}
+
+/// A key whose hash is one of four values, so that most keys share their
+/// whole 64 bit hash with others and end up in collision nodes
+struct CollidingKey
+{
+   int k;
+   CollidingKey(int k = 0) : k(k) {}
+   bool operator == (const CollidingKey& rhs) const { return k == rhs.k; }
+};
+
+namespace Collections { namespace Common {
+   template <> struct Hash<CollidingKey> { static inline uint64_t Of(const CollidingKey& c) { return uint64_t(c.k & 3) << 58; } };
+} }
+
+/// Elements with equal hashes go all the way down the trie, and come back
+/// up into their parents as they are removed
+bool Test_HashTrieCollisions()
+{
+   const int N = 200;
+   Immutable::HashSet<CollidingKey> t;
+   std::vector<Immutable::HashSet<CollidingKey> > versions;
+   for (int i = 0; i < N; ++i) { t = t.Insert(CollidingKey(i)); versions.push_back(t); }
+   if (t.Size() != N || t.Insert(CollidingKey(7)).Size() != N) return false;
+
+   for (int i = 0; i < N; i += 2) t = t.Remove(CollidingKey(i));
+   if (t.Size() != N/2) return false;
+   for (int i = 0; i < N; ++i)
+      if (bool(t.Contains(CollidingKey(i))) != (i % 2 == 1) || !versions[N-1].Contains(CollidingKey(i))) return false;
+   for (int i = 0; i < N; ++i)
+      if (versions[i].Size() != i + 1 || !versions[i].Contains(CollidingKey(i)) || versions[i].Contains(CollidingKey(i + 1))) return false;
+
+   int count = 0;
+   auto itr = t.GetIterator();
+   while (itr.HasNext()) { if (itr.Next().k % 2 != 1) return false; count++; }
+   if (count != N/2) return false;
+
+   for (int i = 1; i < N; i += 2) t = t.Remove(CollidingKey(i));
+   if (t.Size() != 0 || t.GetIterator().HasNext()) return false;
+
+   /// Two keys, then one, folds the collision node away entirely
+   Immutable::HashMap<CollidingKey, int> m;
+   m = m.Insert(CollidingKey(1), 1).Insert(CollidingKey(5), 5).Insert(CollidingKey(2), 2);
+   m = m.Insert(CollidingKey(5), 50).Remove(CollidingKey(1));
+   return m.Size() == 2 && m.GetOrElse(CollidingKey(5), 0) == 50 && m.GetOrElse(CollidingKey(2), 0) == 2
+       && !m.Contains(CollidingKey(1)) && m.Keys().Size() == 2;
+}
+
+/// Batches of four and eight give the hashes that single keys do, and
+/// keys of 32 bits hash to distinct halves
+bool Test_HashBatches()
+{
+   const int N = 1003;
+   std::vector<int> keys(N);
+   std::vector<uint64_t> batched(N + 1, 0), high(N), low(N);
+   for (int i = 0; i < N; ++i) keys[i] = int(uint32_t(i) * 2654435761u);
+
+   for (int n : { 0, 1, 3, 4, 5, 8, 11, 12, 16, N })
+   {
+      batched.assign(N + 1, 0);
+      Common::HashKeys(keys.data(), n, batched.data());
+      for (int i = 0; i < n; ++i) if (batched[i] != Common::Hash<int>::Of(keys[i])) return false;
+      if (batched[n] != 0) return false;
+   }
+
+   uint64_t four[4], eight[8];
+   Common::HashBatch<int, 4>::Of(keys.data() + 1, four);
+   Common::HashBatch<int, 8>::Of(keys.data() + 5, eight);
+   for (int i = 0; i < 4; ++i) if (four[i] != Common::Hash<int>::Of(keys[1 + i])) return false;
+   for (int i = 0; i < 8; ++i) if (eight[i] != Common::Hash<int>::Of(keys[5 + i])) return false;
+
+   /// Keys with no lanes of their own take the scalar path
+   const double doubles[8] = { 0.5, -0.0, 0.0, 1e300, -3.25, 7.0, 1.0/3.0, 2.0 };
+   Common::HashBatch<double, 8>::Of(doubles, eight);
+   for (int i = 0; i < 8; ++i) if (eight[i] != Common::Hash<double>::Of(doubles[i])) return false;
+   if (eight[1] != eight[2]) return false;
+
+   for (int i = 0; i < N; ++i) { high[i] = batched[i] >> 32; low[i] = uint32_t(batched[i]); }
+   std::sort(high.begin(), high.end()); std::sort(low.begin(), low.end());
+   return std::unique(high.begin(), high.end()) == high.end() && std::unique(low.begin(), low.end()) == low.end();
+}
+
+/// The byte hash reads every byte at every length, wherever the bytes are
+bool Test_HashBytes()
+{
+   char buffer[300], moved[301];
+   for (int i = 0; i < 300; ++i) buffer[i] = char(i * 7 + 1);
+
+   std::set<uint64_t> seen;
+   for (int n = 0; n <= 200; ++n)
+   {
+      const uint64_t h = Common::HashBytes(buffer, n);
+      memcpy(moved + 1, buffer, n);
+      if (Common::HashBytes(moved + 1, n) != h || !seen.insert(h).second) return false;
+      if (Common::HashBytes(buffer, n, 1) == h) return false;
+
+      for (int i = 0; i < n; ++i)
+      {
+         buffer[i] ^= 0x20;
+         const bool changed = Common::HashBytes(buffer, n) != h;
+         buffer[i] ^= 0x20;
+         if (!changed) return false;
+      }
+   }
+
+   const std::string a = "vertex/position", b = std::string("vertex/") + "position";
+   return Common::Hash<std::string>::Of(a) == Common::Hash<std::string>::Of(b)
+       && Common::Hash<std::string>::Of(a) == Common::HashBytes(a.data(), a.size())
+       && Common::Hash<std::string>::Of(a) != Common::Hash<std::string>::Of("vertex/positioN");
+}
+
+/// Vertex positions, strings and pairs as keys of the hashed containers,
+/// with -0.0 and 0.0 the same key, and hashed element types setting the
+/// treaps' priorities
+bool Test_HashKeyTypes()
+{
+   Mutable::HashMap<Vector3f, int> positions;
+   Immutable::HashSet<Vector2f> corners;
+   for (int i = 0; i < 1000; ++i)
+   {
+      positions += Common::KeyValuePair<Vector3f, int>(Vector3f(float(i % 10), float(i / 10 % 10), float(i / 100)), i);
+      corners = corners.Insert(Vector2f(float(i % 7) - 3.0f, float(i % 11) * 0.5f));
+   }
+   if (positions.Size() != 1000 || corners.Size() != 77) return false;
+   if (positions.GetOrElse(Vector3f(-0.0f, 0.0f, -0.0f), -1) != 0 || positions.GetOrElse(Vector3f(3, 4, 5), -1) != 543) return false;
+   if (positions.Contains(Vector3f(0, 0, 10)) || !corners.Contains(Vector2f(-3, -0.0f)) || corners.Contains(Vector2f(4, 0))) return false;
+   if (Common::Hash<Vector4f>::Of(Vector4f(-0.0f, 1, 2, 3)) != Common::Hash<Vector4f>::Of(Vector4f(0.0f, 1, 2, 3))) return false;
+   if (Common::Hash<Vector4i>::Of(Vector4i(1, 2, 3, 4)) == Common::Hash<Vector4i>::Of(Vector4i(1, 2, 4, 3))) return false;
+
+   Immutable::HashMap<std::string, int> names;
+   names = names.Insert("alpha", 1).Insert("beta", 2).Insert(std::string("al") + "pha", 3);
+   if (names.Size() != 2 || names.GetOrElse("alpha", 0) != 3 || names.Contains("gamma")) return false;
+
+   Mutable::HashSet<Pair<int, int> > edges;
+   for (int i = 0; i < 100; ++i) edges += Pair<int, int>(i, (i + 1) % 100);
+   if (edges.Size() != 100 || !edges.Contains(Pair<int, int>(99, 0)) || edges.Contains(Pair<int, int>(0, 99))) return false;
+
+   const Common::KeyValuePair<int, float> kv(17, 2.0f);
+   if (Common::Hash<Common::KeyValuePair<int, float> >::Of(kv) != Common::Hash<int>::Of(17)) return false;
+
+   return Common::TreePriority<std::string>::Of("alpha") == Common::TreePriority<std::string>::Of(std::string("alpha"))
+       && Common::TreePriority<std::string>::Of("alpha") == int(uint32_t(Common::Hash<std::string>::Of("alpha")));
+}
+
+template <class T> bool Test_MutableHashSet()
+{
+   bool b = true;
+   cout << "Test_SetContains<"                 << ToString<T>::value << "> ... " << ( (b &= Test_SetContains<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_IsSubsetOf<"                  << ToString<T>::value << "> ... " << ( (b &= Test_IsSubsetOf<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Insert<"                      << ToString<T>::value << "> ... " << ( (b &= Test_Insert<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Remove<"                      << ToString<T>::value << "> ... " << ( (b &= Test_Remove<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveSetInsertElement<" << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetInsertElement<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_DestructiveSetRemove<"        << ToString<T>::value << "> ... " << ( (b &= Test_DestructiveSetRemove<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_HashSetChurn<"                << ToString<T>::value << "> ... " << ( (b &= Test_HashSetChurn<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_HashSetAlgebra<"              << ToString<T>::value << "> ... " << ( (b &= Test_HashSetAlgebra<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_HashSetSharing<"              << ToString<T>::value << "> ... " << ( (b &= Test_HashSetSharing<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+template <class T> bool Test_MutableHashMap()
+{
+   bool b = true;
+   cout << "Test_HashMapChurn<" << ToString<T>::value << "> ... " << ( (b &= Test_HashMapChurn<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
+template <class T> bool Test_ImmutableHashSet()
+{
+   bool b = true;
+   cout << "Test_SetContains<"              << ToString<T>::value << "> ... " << ( (b &= Test_SetContains<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_IsSubsetOf<"               << ToString<T>::value << "> ... " << ( (b &= Test_IsSubsetOf<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Insert<"                   << ToString<T>::value << "> ... " << ( (b &= Test_Insert<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_Remove<"                   << ToString<T>::value << "> ... " << ( (b &= Test_Remove<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_PersistentHashSet<"        << ToString<T>::value << "> ... " << ( (b &= Test_PersistentHashSet<T>()) ? "Passed" : "FAILED") << endl;
+   cout << "Test_PersistentHashSetAlgebra<" << ToString<T>::value << "> ... " << ( (b &= Test_PersistentHashSetAlgebra<T>()) ? "Passed" : "FAILED") << endl;
+   return b;
+}
+
 
 int main()
 {
+   cout << endl << "Testing Scheduler...." << endl << endl;
+
+   Test_Scheduler();
+
    cout << endl << "Testing Array Structure...." << endl << endl;
 
    Test_Traversable<Immutable::Array<int> >();       Test_Sequence<Immutable::Array<int> >();      
    Test_Traversable<Mutable::Array<int> >();         Test_Sequence<Mutable::Array<int> >();  
    Test_MutableArray<Mutable::Array<int> >();
+   cout << "Test_Selection<" << ToString<Collections::Vector<int> >::value << "> ... " << ( Test_Selection<Collections::Vector<int> >() ? "Passed" : "FAILED") << endl;
+   Test_ParallelArray<Immutable::Array<int> >();     Test_ParallelArray<Mutable::Array<int> >();
+   Test_ParallelArray<Collections::Vector<int> >();
+   Test_ArraySort<Immutable::Array<int> >();         Test_ArraySort<Mutable::Array<int> >();
    
    cout << endl << "Testing LinkedList Structure...." << endl << endl;
 
    Test_Traversable<Immutable::LinkedList<int> >();      Test_Sequence<Immutable::LinkedList<int> >();       
    Test_Traversable<Mutable::LinkedList<int> >();        Test_Sequence<Mutable::LinkedList<int> >();   
    Test_MutableLinkedList<Mutable::LinkedList<int> >();
+   cout << "Test_SortedList<" << ToString<Immutable::LinkedList<int> >::value << "> ... " << ( Test_SortedList<Immutable::LinkedList<int> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_SortedList<" << ToString<Mutable::LinkedList<int> >::value << "> ... " << ( Test_SortedList<Mutable::LinkedList<int> >() ? "Passed" : "FAILED") << endl;
 
    cout << endl << "Testing TreeSet Structure...." << endl << endl;
    
    Test_Traversable<Immutable::TreeSet<int> >();     Test_Set<Immutable::TreeSet<int> >();   
    Test_Traversable<Mutable::TreeSet<int> >();       Test_Set<Mutable::TreeSet<int> >(); 
    Test_MutableTreeSet<Mutable::TreeSet<int> >(); 
+   cout << "Test_PersistentTreeSet<" << ToString<Immutable::TreeSet<int> >::value << "> ... " << ( Test_PersistentTreeSet<Immutable::TreeSet<int> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_SharedPoolVersions<" << ToString<Immutable::TreeSet<int> >::value << "> ... " << ( Test_SharedPoolVersions<Immutable::TreeSet<int> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_SliceFootprint<" << ToString<Immutable::TreeSet<int> >::value << "> ... " << ( Test_SliceFootprint<Immutable::TreeSet<int> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_JoinFootprint<" << ToString<Immutable::TreeSet<int> >::value << "> ... " << ( Test_JoinFootprint<Immutable::TreeSet<int> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_OrderStatistics<" << ToString<Immutable::TreeSet<int> >::value << "> ... " << ( Test_OrderStatistics<Immutable::TreeSet<int> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_OrderStatistics<" << ToString<Mutable::TreeSet<int> >::value << "> ... " << ( Test_OrderStatistics<Mutable::TreeSet<int> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_RangeQueries<" << ToString<Immutable::TreeSet<int> >::value << "> ... " << ( Test_RangeQueries<Immutable::TreeSet<int> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_RangeQueries<" << ToString<Mutable::TreeSet<int> >::value << "> ... " << ( Test_RangeQueries<Mutable::TreeSet<int> >() ? "Passed" : "FAILED") << endl;
 
    cout << endl << "Testing TreeMap Structure ....." << endl << endl;
 
    Test_TraversableMap<Immutable::TreeMap<int, float> >();  Test_Map<Immutable::TreeMap<int, float> >();
    Test_TraversableMap<Mutable::TreeMap<int, float> >();    Test_Map<Mutable::TreeMap<int, float> >();
+   Test_MutableTreeMap<Mutable::TreeMap<int, float> >();
+   cout << "Test_PersistentTreeMap<" << ToString<Immutable::TreeMap<int, float> >::value << "> ... " << ( Test_PersistentTreeMap<Immutable::TreeMap<int, float> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_MapRangeQueries<" << ToString<Immutable::TreeMap<int, float> >::value << "> ... " << ( Test_MapRangeQueries<Immutable::TreeMap<int, float> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_MapRangeQueries<" << ToString<Mutable::TreeMap<int, float> >::value << "> ... " << ( Test_MapRangeQueries<Mutable::TreeMap<int, float> >() ? "Passed" : "FAILED") << endl;
+
+   cout << endl << "Testing Flat Structures ....." << endl << endl;
+
+   Test_Traversable<Immutable::FlatSet<int> >();            Test_Set<Immutable::FlatSet<int> >();
+   Test_FlatSet<Immutable::FlatSet<int> >();
+   Test_TraversableMap<Immutable::FlatMap<int, float> >();  Test_Map<Immutable::FlatMap<int, float> >();
+   Test_FlatMap<Immutable::FlatMap<int, float> >();
+
+   cout << endl << "Testing BTree Structures ....." << endl << endl;
+
+   Test_Traversable<Mutable::BTreeSet<int> >();             Test_Set<Mutable::BTreeSet<int> >();
+   Test_MutableBTreeSet<Mutable::BTreeSet<int> >();
+   Test_TraversableMap<Mutable::BTreeMap<int, float> >();   Test_Map<Mutable::BTreeMap<int, float> >();
+   Test_MutableBTreeMap<Mutable::BTreeMap<int, float> >();
+
+   cout << endl << "Testing Hash Structures ....." << endl << endl;
+
+   Test_MutableHashSet<Mutable::HashSet<int> >();
+   Test_Map<Mutable::HashMap<int, float> >();
+   Test_MutableHashMap<Mutable::HashMap<int, float> >();
+   Test_ImmutableHashSet<Immutable::HashSet<int> >();
+   Test_Map<Immutable::HashMap<int, float> >();
+   cout << "Test_PersistentTreeMap<" << ToString<Immutable::HashMap<int, float> >::value << "> ... " << ( Test_PersistentTreeMap<Immutable::HashMap<int, float> >() ? "Passed" : "FAILED") << endl;
+   cout << "Test_HashTrieCollisions ... " << ( Test_HashTrieCollisions() ? "Passed" : "FAILED") << endl;
+   cout << "Test_HashBatches ... " << ( Test_HashBatches() ? "Passed" : "FAILED") << endl;
+   cout << "Test_HashBytes ... " << ( Test_HashBytes() ? "Passed" : "FAILED") << endl;
+   cout << "Test_HashKeyTypes ... " << ( Test_HashKeyTypes() ? "Passed" : "FAILED") << endl;
 
    //cout << endl << "Testing Mutable Operations ....."
 